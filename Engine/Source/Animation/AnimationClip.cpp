@@ -0,0 +1,284 @@
+﻿#include "AnimationClip.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Reality {
+    namespace {
+        using Key = AnimationClip::Key;
+        using LowBits = AnimationClip::LowBits;
+        using Track = AnimationClip::Track;
+
+        // Smallest three: the largest component is dropped and rebuilt from
+        // the unit length, the other three lie in [-1/sqrt(2), 1/sqrt(2)] and
+        // get 15 bits each. The index of the dropped one takes the top bits of
+        // the first two values.
+        constexpr float RotationRange = 0.70710678f;
+        constexpr float RotationSteps = 32767.0f;
+        constexpr float VectorSteps = 65535.0f;
+        constexpr double WideVectorSteps = 4294967295.0;
+
+        // Source of AnimationClip generations, 0 is never handed out
+        std::atomic<uint64_t> g_nextGeneration = 1;
+
+        // Key of a 32-bit vector track while it is reduced
+        struct WideKey {
+            Key key;
+            LowBits low;
+        };
+
+        Key EncodeRotation(const Quaternion& rotation, uint32_t frame) {
+            const Quaternion q = rotation.Normalized();
+            const float c[4] = { q.x, q.y, q.z, q.w };
+            int largest = 0;
+            for (int i = 1; i < 4; i++) {
+                if (Abs(c[i]) > Abs(c[largest])) {
+                    largest = i;
+                }
+            }
+
+            // q and -q are the same rotation, the dropped component is stored positive
+            const float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+            Key key = { static_cast<uint16_t>(frame), {} };
+            int k = 0;
+            for (int i = 0; i < 4; i++) {
+                if (i != largest) {
+                    const float v = Clamp(c[i] * sign, -RotationRange, RotationRange);
+                    key.value[k++] = static_cast<uint16_t>(std::lround((v / RotationRange * 0.5f + 0.5f) * RotationSteps));
+                }
+            }
+            key.value[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+            key.value[1] |= static_cast<uint16_t>((largest & 1) << 15);
+            return key;
+        }
+
+        Key EncodeVector(const Vector3& v, const Track& track, uint32_t frame) {
+            Key key = { static_cast<uint16_t>(frame), {} };
+            for (int i = 0; i < 3; i++) {
+                if (track.extent[i] > 0.0f) {
+                    const float t = Clamp((v[i] - track.minimum[i]) / track.extent[i], 0.0f, 1.0f);
+                    key.value[i] = static_cast<uint16_t>(std::lround(t * VectorSteps));
+                }
+            }
+            return key;
+        }
+
+        WideKey EncodeWideVector(const Vector3& v, const Track& track, uint32_t frame) {
+            WideKey wide = { { static_cast<uint16_t>(frame), {} }, {} };
+            for (int i = 0; i < 3; i++) {
+                if (track.extent[i] > 0.0f) {
+                    const double t = std::clamp((static_cast<double>(v[i]) - track.minimum[i]) / track.extent[i], 0.0, 1.0);
+                    const uint32_t q = static_cast<uint32_t>(std::llround(t * WideVectorSteps));
+                    wide.key.value[i] = static_cast<uint16_t>(q >> 16);
+                    wide.low.value[i] = static_cast<uint16_t>(q);
+                }
+            }
+            return wide;
+        }
+
+        Vector3 DecodeVectorBits(const Track& track, const Key& key, const LowBits* low) {
+            if (!low) {
+                const float scale = 1.0f / VectorSteps;
+                return Vector3(track.minimum.x + track.extent.x * (key.value[0] * scale),
+                               track.minimum.y + track.extent.y * (key.value[1] * scale),
+                               track.minimum.z + track.extent.z * (key.value[2] * scale));
+            }
+            Vector3 v;
+            for (int i = 0; i < 3; i++) {
+                const uint32_t q = (static_cast<uint32_t>(key.value[i]) << 16) | low->value[i];
+                v[i] = static_cast<float>(track.minimum[i] + static_cast<double>(track.extent[i]) * (q / WideVectorSteps));
+            }
+            return v;
+        }
+
+        // The interpolation the sampler uses between two keys
+        Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+            const float s = a.Dot(b) < 0.0f ? -t : t;
+            return Quaternion(a.x + (b.x * s - a.x * t), a.y + (b.y * s - a.y * t),
+                              a.z + (b.z * s - a.z * t), a.w + (b.w * s - a.w * t)).Normalized();
+        }
+
+        // Greedy key reduction. Each key is placed as far after the previous
+        // one as interpolating between the two still reproduces every sample
+        // in between within tolerance. Errors are measured on decoded keys, so
+        // quantization counts against the tolerance. Fails when a key on its
+        // own misses its sample, the quantization being too coarse.
+        template<typename Value, typename KeyType, typename Encode, typename Decode, typename Interpolate, typename Error>
+        bool ReduceTrack(const std::vector<Value>& samples, float tolerance, const Encode& encode, const Decode& decode,
+                         const Interpolate& interpolate, const Error& error, std::vector<KeyType>& keys) {
+            const uint32_t last = static_cast<uint32_t>(samples.size() - 1);
+            const KeyType first = encode(samples[0], 0);
+            const Value firstValue = decode(first);
+            if (error(firstValue, samples[0]) > tolerance) {
+                return false;
+            }
+            keys.push_back(first);
+
+            // Constant tracks keep the single key
+            bool constant = true;
+            for (uint32_t f = 1; f <= last && constant; f++) {
+                constant = error(firstValue, samples[f]) <= tolerance;
+            }
+            if (constant) {
+                return true;
+            }
+
+            const auto segmentFits = [&](uint32_t start, const Value& a, uint32_t end, const Value& b) {
+                for (uint32_t f = start + 1; f <= end; f++) {
+                    const float t = static_cast<float>(f - start) / static_cast<float>(end - start);
+                    if (error(interpolate(a, b, t), samples[f]) > tolerance) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            uint32_t start = 0;
+            Value startValue = firstValue;
+            while (start < last) {
+                uint32_t end = start + 1;
+                KeyType endKey = encode(samples[end], end);
+                if (error(decode(endKey), samples[end]) > tolerance) {
+                    return false;
+                }
+                while (end < last) {
+                    const KeyType candidate = encode(samples[end + 1], end + 1);
+                    if (!segmentFits(start, startValue, end + 1, decode(candidate))) {
+                        break;
+                    }
+                    end++;
+                    endKey = candidate;
+                }
+                keys.push_back(endKey);
+                start = end;
+                startValue = decode(endKey);
+            }
+            return true;
+        }
+    }
+
+    void MakeAdditiveClip(AnimationClipDesc& desc, std::span<const Transform> referencePose) {
+        assert(referencePose.size() >= desc.boneCount);
+        for (uint32_t frame = 0; frame < desc.frameCount; frame++) {
+            for (uint32_t bone = 0; bone < desc.boneCount; bone++) {
+                Transform& sample = desc.samples[frame * desc.boneCount + bone];
+                const Transform& reference = referencePose[bone];
+                sample.rotation = reference.rotation.Conjugate() * sample.rotation;
+                sample.translation = sample.translation - reference.translation;
+                sample.scale = Vector3(sample.scale.x / reference.scale.x, sample.scale.y / reference.scale.y,
+                                       sample.scale.z / reference.scale.z);
+            }
+        }
+    }
+
+    bool AnimationClip::Initialize(const AnimationClipDesc& desc) {
+        if (desc.boneCount == 0 || desc.frameCount == 0 || desc.frameCount > 65536 || desc.sampleRate <= 0.0f ||
+            desc.samples.size() != static_cast<size_t>(desc.boneCount) * desc.frameCount) {
+            return false;
+        }
+
+        m_name = desc.name;
+        m_boneCount = desc.boneCount;
+        m_frameCount = desc.frameCount;
+        m_sampleRate = desc.sampleRate;
+        m_generation = g_nextGeneration.fetch_add(1, std::memory_order_relaxed);
+        m_tracks.assign(static_cast<size_t>(m_boneCount) * ChannelCount, Track());
+        m_keys.clear();
+        m_lowBits.clear();
+        const auto fail = [this]() {
+            m_boneCount = 0;
+            m_tracks.clear();
+            m_keys.clear();
+            m_lowBits.clear();
+            return false;
+        };
+
+        std::vector<Quaternion> rotations(m_frameCount);
+        std::vector<Vector3> vectors(m_frameCount);
+
+        const auto decodeRotation = [](const Key& key) { return DecodeRotation(key); };
+        // Rotation angle between a and b from the chord |a - b| = 2 sin(angle / 4),
+        // which unlike acos(dot) stays accurate for small angles
+        const auto rotationError = [](const Quaternion& a, const Quaternion& b) {
+            const Quaternion n = b.Normalized();
+            const float s = a.Dot(n) < 0.0f ? -1.0f : 1.0f;
+            const float dx = a.x - n.x * s;
+            const float dy = a.y - n.y * s;
+            const float dz = a.z - n.z * s;
+            const float dw = a.w - n.w * s;
+            return 4.0f * ASin(Min(0.5f * Sqrt(dx * dx + dy * dy + dz * dz + dw * dw), 1.0f));
+        };
+        const auto lerpVector = [](const Vector3& a, const Vector3& b, float t) { return a + (b - a) * t; };
+        const auto vectorError = [](const Vector3& a, const Vector3& b) { return (a - b).Length(); };
+
+        for (uint32_t bone = 0; bone < m_boneCount; bone++) {
+            Track& rotationTrack = m_tracks[bone * ChannelCount + Rotation];
+            for (uint32_t frame = 0; frame < m_frameCount; frame++) {
+                rotations[frame] = desc.samples[frame * m_boneCount + bone].rotation;
+            }
+            rotationTrack.firstKey = static_cast<uint32_t>(m_keys.size());
+            if (!ReduceTrack(rotations, desc.rotationTolerance, EncodeRotation, decodeRotation, Nlerp, rotationError, m_keys)) {
+                return fail();
+            }
+            rotationTrack.keyCount = static_cast<uint32_t>(m_keys.size()) - rotationTrack.firstKey;
+
+            for (Channel channel : { Translation, Scale }) {
+                Track& track = m_tracks[bone * ChannelCount + channel];
+                Vector3 minimum(FLT_MAX);
+                Vector3 maximum(-FLT_MAX);
+                for (uint32_t frame = 0; frame < m_frameCount; frame++) {
+                    const Transform& sample = desc.samples[frame * m_boneCount + bone];
+                    vectors[frame] = channel == Translation ? sample.translation : sample.scale;
+                    minimum = Vector3::Min(minimum, vectors[frame]);
+                    maximum = Vector3::Max(maximum, vectors[frame]);
+                }
+                track.minimum = minimum;
+                track.extent = maximum - minimum;
+
+                const float tolerance = channel == Translation ? desc.translationTolerance : desc.scaleTolerance;
+                track.firstKey = static_cast<uint32_t>(m_keys.size());
+                const bool narrow = ReduceTrack(vectors, tolerance,
+                    [&track](const Vector3& v, uint32_t frame) { return EncodeVector(v, track, frame); },
+                    [&track](const Key& key) { return DecodeVectorBits(track, key, nullptr); },
+                    lerpVector, vectorError, m_keys);
+                if (!narrow) {
+                    // Retried with 32-bit components
+                    m_keys.resize(track.firstKey);
+                    std::vector<WideKey> wideKeys;
+                    if (!ReduceTrack(vectors, tolerance,
+                            [&track](const Vector3& v, uint32_t frame) { return EncodeWideVector(v, track, frame); },
+                            [&track](const WideKey& wide) { return DecodeVectorBits(track, wide.key, &wide.low); },
+                            lerpVector, vectorError, wideKeys)) {
+                        return fail();
+                    }
+                    track.firstLowBits = static_cast<uint32_t>(m_lowBits.size());
+                    for (const WideKey& wide : wideKeys) {
+                        m_keys.push_back(wide.key);
+                        m_lowBits.push_back(wide.low);
+                    }
+                }
+                track.keyCount = static_cast<uint32_t>(m_keys.size()) - track.firstKey;
+            }
+        }
+        return true;
+    }
+
+    Quaternion AnimationClip::DecodeRotation(const Key& key) {
+        const int largest = ((key.value[0] >> 15) << 1) | (key.value[1] >> 15);
+        float c[4];
+        float lengthSq = 0.0f;
+        int k = 0;
+        for (int i = 0; i < 4; i++) {
+            if (i != largest) {
+                c[i] = ((key.value[k++] & 0x7FFF) / RotationSteps * 2.0f - 1.0f) * RotationRange;
+                lengthSq += c[i] * c[i];
+            }
+        }
+        c[largest] = Sqrt(std::max(1.0f - lengthSq, 0.0f));
+        return Quaternion(c[0], c[1], c[2], c[3]);
+    }
+
+    Vector3 AnimationClip::DecodeVector(const Track& track, uint32_t key) const {
+        const LowBits* low = track.firstLowBits != NoLowBits ? &m_lowBits[track.firstLowBits + key] : nullptr;
+        return DecodeVectorBits(track, m_keys[track.firstKey + key], low);
+    }
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Reality {
+    struct AnimationClipDesc {
+        std::string name;
+        uint32_t boneCount = 0;
+        uint32_t frameCount = 0;                // Samples per bone, at most 65536
+        float sampleRate = 30.0f;               // Samples per second
+        std::vector<Transform> samples;         // Local transforms, samples[frame * boneCount + bone]
+
+        // Largest error the compression may introduce, quantization included
+        float rotationTolerance = 0.001f;       // Radians
+        float translationTolerance = 0.0005f;   // Units
+        float scaleTolerance = 0.0005f;
+    };
+
+    // Rewrites the samples as deltas from a reference pose, for clips played on
+    // an additive layer. See MakeAdditivePose for the delta definition.
+    void MakeAdditiveClip(AnimationClipDesc& desc, std::span<const Transform> referencePose);
+
+    // AnimationClip - compressed keyframe animation. Every bone has a rotation,
+    // translation and scale track. Keys are 8 bytes: the frame plus three
+    // 16-bit components. Rotations use the smallest three encoding, vectors are
+    // quantized over the range of their track. Vector tracks too wide for 16-bit
+    // steps to stay within tolerance get 32-bit components, the low halves kept
+    // apart so keys stay 8 bytes. Keys that linear interpolation of their
+    // neighbours reproduces within tolerance are removed.
+    class AnimationClip {
+    public:
+        enum Channel {
+            Rotation,
+            Translation,
+            Scale,
+            ChannelCount
+        };
+
+        struct Key {
+            uint16_t frame;
+            uint16_t value[3];
+        };
+
+        // Low 16 bits of the components of a 32-bit vector key
+        struct LowBits {
+            uint16_t value[3];
+        };
+
+        static constexpr uint32_t NoLowBits = UINT32_MAX;
+
+        struct Track {
+            uint32_t firstKey = 0;
+            uint32_t keyCount = 0;
+            uint32_t firstLowBits = NoLowBits;  // Parallel to the keys of 32-bit vector tracks
+            Vector3 minimum;                    // Dequantization range of vector tracks
+            Vector3 extent;
+        };
+
+        AnimationClip() = default;
+
+        // Compresses the samples. Fails on an empty clip, more than 65536 frames,
+        // or a tolerance finer than the quantization can reach.
+        bool Initialize(const AnimationClipDesc& desc);
+
+        const std::string& GetName() const { return m_name; }
+        uint32_t GetBoneCount() const { return m_boneCount; }
+        uint32_t GetFrameCount() const { return m_frameCount; }
+        float GetSampleRate() const { return m_sampleRate; }
+        float GetDuration() const { return static_cast<float>(m_frameCount - 1) / m_sampleRate; }
+        // Changes on every Initialize, unique across clips, for caches of decoded keys
+        uint64_t GetGeneration() const { return m_generation; }
+
+        const Track& GetTrack(uint32_t bone, Channel channel) const { return m_tracks[bone * ChannelCount + channel]; }
+        std::span<const Key> GetKeys() const { return m_keys; }
+
+        // Size of the compressed keys and tracks in bytes
+        size_t GetCompressedSize() const {
+            return m_keys.size() * sizeof(Key) + m_lowBits.size() * sizeof(LowBits) + m_tracks.size() * sizeof(Track);
+        }
+
+        static Quaternion DecodeRotation(const Key& key);
+        // Key index relative to the track's first key
+        Vector3 DecodeVector(const Track& track, uint32_t key) const;
+
+    private:
+        std::string m_name;
+        uint32_t m_boneCount = 0;
+        uint32_t m_frameCount = 0;
+        float m_sampleRate = 30.0f;
+        uint64_t m_generation = 0;
+        std::vector<Track> m_tracks;
+        std::vector<Key> m_keys;
+        std::vector<LowBits> m_lowBits;
+    };
+}
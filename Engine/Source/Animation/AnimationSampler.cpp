@@ -0,0 +1,108 @@
+﻿#include "AnimationSampler.h"
+#include <algorithm>
+
+namespace Reality {
+    namespace {
+        // Cursor steps taken before a forward search falls back to binary search
+        constexpr uint32_t MaxCursorSteps = 4;
+
+        // Cursor value that forces the keys to be decoded
+        constexpr uint32_t InvalidCursor = UINT32_MAX;
+
+        // Index of the last key at or before frame, relative to the track start.
+        // Starts from the cached cursor, which stays valid while playback moves forward.
+        uint32_t FindKey(const AnimationClip::Key* keys, uint32_t keyCount, uint32_t& cursor, float frame) {
+            uint32_t k = cursor < keyCount && keys[cursor].frame <= frame ? cursor : 0;
+            uint32_t steps = 0;
+            while (k + 1 < keyCount && keys[k + 1].frame <= frame) {
+                if (++steps > MaxCursorSteps) {
+                    const AnimationClip::Key* next = std::upper_bound(keys + k + 1, keys + keyCount, frame,
+                        [](float f, const AnimationClip::Key& key) { return f < key.frame; });
+                    k = static_cast<uint32_t>(next - keys) - 1;
+                    break;
+                }
+                k++;
+            }
+            cursor = k;
+            return k;
+        }
+
+        // Weight between the key pair that brackets frame
+        float KeyWeight(const AnimationClip::Key& key0, const AnimationClip::Key& key1, float frame) {
+            if (key1.frame <= key0.frame) {
+                return 0.0f;
+            }
+            return Clamp((frame - key0.frame) / static_cast<float>(key1.frame - key0.frame), 0.0f, 1.0f);
+        }
+    }
+
+    void AnimationSampler::Reset() {
+        std::fill(m_cursors.begin(), m_cursors.end(), InvalidCursor);
+    }
+
+    void AnimationSampler::Bind(const AnimationClip& clip) {
+        m_clip = &clip;
+        m_generation = clip.GetGeneration();
+        m_cursors.assign(static_cast<size_t>(clip.GetBoneCount()) * AnimationClip::ChannelCount, InvalidCursor);
+        m_keys0.Resize(clip.GetBoneCount());
+        m_keys1.Resize(clip.GetBoneCount());
+        for (auto& weights : m_weights) {
+            // Padding bones keep weight 0 and their identity transforms
+            weights.assign(m_keys0.GetPaddedCount(), 0.0f);
+        }
+    }
+
+    void AnimationSampler::Sample(const AnimationClip& clip, float time, Pose& out) {
+        // A clip initialized again, or another one at the same address, has new keys
+        if (m_clip != &clip || m_generation != clip.GetGeneration()) {
+            Bind(clip);
+        }
+        if (out.GetBoneCount() != clip.GetBoneCount()) {
+            out.Resize(clip.GetBoneCount());
+        }
+
+        const float frame = Clamp(time * clip.GetSampleRate(), 0.0f, static_cast<float>(clip.GetFrameCount() - 1));
+        const AnimationClip::Key* keys = clip.GetKeys().data();
+
+        // The staging poses keep the decoded key pair of every track, so keys
+        // are only decoded when playback moves past them
+        for (uint32_t bone = 0; bone < clip.GetBoneCount(); bone++) {
+            uint32_t* cursors = m_cursors.data() + static_cast<size_t>(bone) * AnimationClip::ChannelCount;
+
+            const AnimationClip::Track& rotationTrack = clip.GetTrack(bone, AnimationClip::Rotation);
+            const AnimationClip::Key* rotationKeys = keys + rotationTrack.firstKey;
+            const uint32_t previousRotation = cursors[AnimationClip::Rotation];
+            const uint32_t r = FindKey(rotationKeys, rotationTrack.keyCount, cursors[AnimationClip::Rotation], frame);
+            const uint32_t rNext = std::min(r + 1, rotationTrack.keyCount - 1);
+            if (r != previousRotation) {
+                const Quaternion q0 = AnimationClip::DecodeRotation(rotationKeys[r]);
+                const Quaternion q1 = AnimationClip::DecodeRotation(rotationKeys[rNext]);
+                for (int c = 0; c < 4; c++) {
+                    m_keys0.GetRotations(c)[bone] = q0[c];
+                    m_keys1.GetRotations(c)[bone] = q1[c];
+                }
+            }
+            m_weights[AnimationClip::Rotation][bone] = KeyWeight(rotationKeys[r], rotationKeys[rNext], frame);
+
+            for (AnimationClip::Channel channel : { AnimationClip::Translation, AnimationClip::Scale }) {
+                const AnimationClip::Track& track = clip.GetTrack(bone, channel);
+                const AnimationClip::Key* trackKeys = keys + track.firstKey;
+                const uint32_t previous = cursors[channel];
+                const uint32_t k = FindKey(trackKeys, track.keyCount, cursors[channel], frame);
+                const uint32_t kNext = std::min(k + 1, track.keyCount - 1);
+                if (k != previous) {
+                    const bool translation = channel == AnimationClip::Translation;
+                    Vector3Stream& values0 = translation ? m_keys0.GetTranslations() : m_keys0.GetScales();
+                    Vector3Stream& values1 = translation ? m_keys1.GetTranslations() : m_keys1.GetScales();
+                    values0.Set(bone, clip.DecodeVector(track, k));
+                    values1.Set(bone, clip.DecodeVector(track, kNext));
+                }
+                m_weights[channel][bone] = KeyWeight(trackKeys[k], trackKeys[kNext], frame);
+            }
+        }
+
+        // Interpolate all bones at once
+        BlendPoses(m_keys0, m_keys1, m_weights[AnimationClip::Rotation], m_weights[AnimationClip::Translation],
+                   m_weights[AnimationClip::Scale], out);
+    }
+}
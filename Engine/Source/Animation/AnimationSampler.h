@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "AnimationClip.h"
+#include "Pose.h"
+
+namespace Reality {
+    // AnimationSampler - evaluates a whole AnimationClip pose at a time. Keys
+    // around the sample time are decoded into two structure-of-arrays poses,
+    // then a single BlendPoses pass interpolates every bone. A key cursor per
+    // track makes forward playback find its keys without searching, and keys
+    // stay decoded until playback moves past them.
+    // Holds per-instance state, so one sampler per playing clip and thread.
+    class AnimationSampler {
+    public:
+        AnimationSampler() = default;
+
+        // Samples the clip at time seconds, clamped to the clip duration.
+        // Resizes out to the clip bone count if needed.
+        void Sample(const AnimationClip& clip, float time, Pose& out);
+
+        // Forgets the cached key positions
+        void Reset();
+
+    private:
+        void Bind(const AnimationClip& clip);
+
+        const AnimationClip* m_clip = nullptr;
+        uint64_t m_generation = 0;
+        std::vector<uint32_t> m_cursors;
+        Pose m_keys0;
+        Pose m_keys1;
+        AlignedVector<float> m_weights[AnimationClip::ChannelCount];
+    };
+}
@@ -0,0 +1,79 @@
+﻿#include "Animator.h"
+#include <Core/JobSystem.h>
+#include <utility>
+
+namespace Reality {
+    bool Animator::Initialize(const Skeleton* skeleton) {
+        if (!skeleton || skeleton->GetBoneCount() == 0) {
+            return false;
+        }
+
+        m_skeleton = skeleton;
+        m_layers.clear();
+        m_pose = skeleton->GetBindPose();
+        m_layerPose.Resize(skeleton->GetBoneCount());
+        m_modelMatrices.resize(skeleton->GetBoneCount());
+        m_palette.resize(skeleton->GetBoneCount());
+        return true;
+    }
+
+    uint32_t Animator::AddLayer(const AnimationLayer& layer) {
+        assert(!layer.clip || layer.clip->GetBoneCount() == m_skeleton->GetBoneCount());
+        m_layers.push_back({ layer, AnimationSampler() });
+        return static_cast<uint32_t>(m_layers.size() - 1);
+    }
+
+    void Animator::Update(float deltaTime) {
+        for (LayerState& state : m_layers) {
+            AnimationLayer& layer = state.layer;
+            if (!layer.clip) {
+                continue;
+            }
+
+            const float duration = layer.clip->GetDuration();
+            layer.time += deltaTime * layer.speed;
+            if (layer.loop && duration > 0.0f) {
+                layer.time = std::fmod(layer.time, duration);
+                if (layer.time < 0.0f) {
+                    layer.time += duration;
+                }
+            } else {
+                layer.time = Clamp(layer.time, 0.0f, duration);
+            }
+        }
+    }
+
+    void Animator::Evaluate() {
+        assert(m_skeleton && "Animator::Initialize was not called");
+
+        m_pose = m_skeleton->GetBindPose();
+        for (LayerState& state : m_layers) {
+            const AnimationLayer& layer = state.layer;
+            if (!layer.clip || layer.weight <= 0.0f) {
+                continue;
+            }
+
+            state.sampler.Sample(*layer.clip, layer.time, m_layerPose);
+            if (layer.mode == AnimationBlendMode::Additive) {
+                AddPose(m_pose, m_layerPose, layer.weight, m_pose);
+            } else if (layer.weight >= 1.0f) {
+                std::swap(m_pose, m_layerPose);
+            } else {
+                BlendPoses(m_pose, m_layerPose, layer.weight, m_pose);
+            }
+        }
+
+        ComputeModelMatrices(*m_skeleton, m_pose, m_modelMatrices);
+        ComputeSkinningPalette(*m_skeleton, m_modelMatrices, m_palette);
+    }
+
+    void Animator::UpdateAll(std::span<Animator* const> animators, float deltaTime, uint32_t grainSize) {
+        JobSystem::GetInstance().ParallelFor(static_cast<uint32_t>(animators.size()), grainSize,
+            [animators, deltaTime](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    animators[i]->Update(deltaTime);
+                    animators[i]->Evaluate();
+                }
+            });
+    }
+}
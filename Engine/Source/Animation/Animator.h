@@ -0,0 +1,62 @@
+﻿#pragma once
+#include "AnimationSampler.h"
+#include "Skeleton.h"
+
+namespace Reality {
+    enum class AnimationBlendMode {
+        Override,   // Blends towards the clip by weight
+        Additive    // Adds a clip built with MakeAdditiveClip, scaled by weight
+    };
+
+    struct AnimationLayer {
+        const AnimationClip* clip = nullptr;
+        AnimationBlendMode mode = AnimationBlendMode::Override;
+        float weight = 1.0f;
+        float time = 0.0f;          // Seconds
+        float speed = 1.0f;
+        bool loop = true;
+    };
+
+    // Animator - animation state of one skinned character. Layers are applied
+    // in order on top of the bind pose, then the result goes through the model
+    // space and skinning palette passes.
+    class Animator {
+    public:
+        Animator() = default;
+
+        bool Initialize(const Skeleton* skeleton);
+
+        // The clip must animate the same number of bones as the skeleton
+        uint32_t AddLayer(const AnimationLayer& layer);
+        AnimationLayer& GetLayer(uint32_t index) { return m_layers[index].layer; }
+        uint32_t GetLayerCount() const { return static_cast<uint32_t>(m_layers.size()); }
+
+        // Advances the layer times, wrapping looped layers
+        void Update(float deltaTime);
+
+        // Samples and blends the layers, then builds the model matrices and palette
+        void Evaluate();
+
+        const Pose& GetPose() const { return m_pose; }
+        std::span<const Matrix4x4> GetModelMatrices() const { return m_modelMatrices; }
+        std::span<const Matrix4x4> GetSkinningPalette() const { return m_palette; }
+
+        // Update and Evaluate for many characters on the JobSystem workers,
+        // grainSize animators per job. Skeletons and clips are only read, so
+        // animators may share them.
+        static void UpdateAll(std::span<Animator* const> animators, float deltaTime, uint32_t grainSize = 4);
+
+    private:
+        struct LayerState {
+            AnimationLayer layer;
+            AnimationSampler sampler;
+        };
+
+        const Skeleton* m_skeleton = nullptr;
+        std::vector<LayerState> m_layers;
+        Pose m_pose;
+        Pose m_layerPose;
+        std::vector<Matrix4x4> m_modelMatrices;
+        std::vector<Matrix4x4> m_palette;
+    };
+}
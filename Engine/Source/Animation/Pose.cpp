@@ -0,0 +1,274 @@
+﻿#include "Pose.h"
+#include "Skeleton.h"
+#include <algorithm>
+
+namespace Reality {
+    namespace {
+        // Kernels are written once against Lane, SIMD::Width bones per
+        // iteration. Poses are padded, so there is no scalar tail.
+#if defined(REALITY_SIMD_SSE)
+        using Lane = SIMD::FloatN;
+
+        inline Lane LoadLane(const float* p) { return SIMD::LoadN(p); }
+        inline void StoreLane(float* p, Lane v) { SIMD::StoreUnaligned(p, v); }
+
+        // Hardware estimate refined by one Newton-Raphson step
+        constexpr Precision NormalizePrecision = Precision::Medium;
+#else
+        using Lane = float;
+
+        inline Lane LoadLane(const float* p) { return *p; }
+        inline void StoreLane(float* p, Lane v) { *p = v; }
+
+        // The bit-level estimate of scalar builds leaves 5e-6 of length error
+        constexpr Precision NormalizePrecision = Precision::Precise;
+#endif
+        constexpr uint32_t LaneWidth = SIMD::Width;
+
+        using Approx::Detail::Add;
+        using Approx::Detail::Sub;
+        using Approx::Detail::Mul;
+        using Approx::Detail::Div;
+        using Approx::Detail::MulAdd;
+        using Approx::Detail::MulSign;
+
+        inline Lane SplatLane(float s) { return Approx::Detail::Splat<Lane>(s); }
+
+        struct QuaternionLanes {
+            Lane x, y, z, w;
+        };
+
+        struct Vector3Lanes {
+            Lane x, y, z;
+        };
+
+        inline QuaternionLanes LoadRotations(const Pose& pose, uint32_t bone) {
+            return { LoadLane(pose.GetRotations(0) + bone), LoadLane(pose.GetRotations(1) + bone),
+                     LoadLane(pose.GetRotations(2) + bone), LoadLane(pose.GetRotations(3) + bone) };
+        }
+
+        inline void StoreRotations(Pose& pose, uint32_t bone, const QuaternionLanes& q) {
+            StoreLane(pose.GetRotations(0) + bone, q.x);
+            StoreLane(pose.GetRotations(1) + bone, q.y);
+            StoreLane(pose.GetRotations(2) + bone, q.z);
+            StoreLane(pose.GetRotations(3) + bone, q.w);
+        }
+
+        inline Vector3Lanes LoadVectors(const Vector3Stream& stream, uint32_t bone) {
+            return { LoadLane(stream.X() + bone), LoadLane(stream.Y() + bone), LoadLane(stream.Z() + bone) };
+        }
+
+        inline void StoreVectors(Vector3Stream& stream, uint32_t bone, const Vector3Lanes& v) {
+            StoreLane(stream.X() + bone, v.x);
+            StoreLane(stream.Y() + bone, v.y);
+            StoreLane(stream.Z() + bone, v.z);
+        }
+
+        inline Vector3Lanes Lerp(const Vector3Lanes& a, const Vector3Lanes& b, Lane t) {
+            return { MulAdd(Sub(b.x, a.x), t, a.x), MulAdd(Sub(b.y, a.y), t, a.y), MulAdd(Sub(b.z, a.z), t, a.z) };
+        }
+
+        inline QuaternionLanes Normalize(const QuaternionLanes& q) {
+            const Lane lengthSq = MulAdd(q.x, q.x, MulAdd(q.y, q.y, MulAdd(q.z, q.z, Mul(q.w, q.w))));
+            const Lane invLength = Approx::Detail::RSqrt<NormalizePrecision>(lengthSq);
+            return { Mul(q.x, invLength), Mul(q.y, invLength), Mul(q.z, invLength), Mul(q.w, invLength) };
+        }
+
+        // Normalized lerp along the shortest path. Matches Quaternion::Slerp at
+        // t = 0, 0.5 and 1 and stays close in between for nearby rotations.
+        inline QuaternionLanes Nlerp(const QuaternionLanes& a, QuaternionLanes b, Lane t) {
+            const Lane dot = MulAdd(a.x, b.x, MulAdd(a.y, b.y, MulAdd(a.z, b.z, Mul(a.w, b.w))));
+            b = { MulSign(b.x, dot), MulSign(b.y, dot), MulSign(b.z, dot), MulSign(b.w, dot) };
+            return Normalize({ MulAdd(Sub(b.x, a.x), t, a.x), MulAdd(Sub(b.y, a.y), t, a.y),
+                               MulAdd(Sub(b.z, a.z), t, a.z), MulAdd(Sub(b.w, a.w), t, a.w) });
+        }
+
+        // Hamilton product a * b, same as Quaternion::operator*
+        inline QuaternionLanes Multiply(const QuaternionLanes& a, const QuaternionLanes& b) {
+            return {
+                Sub(MulAdd(a.w, b.x, MulAdd(a.x, b.w, Mul(a.y, b.z))), Mul(a.z, b.y)),
+                Sub(MulAdd(a.w, b.y, MulAdd(a.y, b.w, Mul(a.z, b.x))), Mul(a.x, b.z)),
+                Sub(MulAdd(a.w, b.z, MulAdd(a.z, b.w, Mul(a.x, b.y))), Mul(a.y, b.x)),
+                Sub(Mul(a.w, b.w), MulAdd(a.x, b.x, MulAdd(a.y, b.y, Mul(a.z, b.z))))
+            };
+        }
+
+        template<typename RotationWeight, typename TranslationWeight, typename ScaleWeight>
+        void Blend(const Pose& a, const Pose& b, const RotationWeight& rotationWeight,
+                   const TranslationWeight& translationWeight, const ScaleWeight& scaleWeight, Pose& out) {
+            assert(a.GetBoneCount() == b.GetBoneCount() && a.GetBoneCount() == out.GetBoneCount());
+            for (uint32_t i = 0; i < a.GetPaddedCount(); i += LaneWidth) {
+                StoreRotations(out, i, Nlerp(LoadRotations(a, i), LoadRotations(b, i), rotationWeight(i)));
+                StoreVectors(out.GetTranslations(), i, Lerp(LoadVectors(a.GetTranslations(), i),
+                                                            LoadVectors(b.GetTranslations(), i), translationWeight(i)));
+                StoreVectors(out.GetScales(), i, Lerp(LoadVectors(a.GetScales(), i),
+                                                      LoadVectors(b.GetScales(), i), scaleWeight(i)));
+            }
+        }
+    }
+
+    void Pose::Resize(uint32_t boneCount) {
+        m_boneCount = boneCount;
+        const uint32_t paddedCount = GetPaddedCount(boneCount);
+        m_translations.Resize(paddedCount);
+        m_scales.Resize(paddedCount);
+        for (auto& component : m_rotations) {
+            component.resize(paddedCount);
+        }
+        SetIdentity();
+    }
+
+    void Pose::SetIdentity() {
+        const size_t paddedCount = m_translations.Size();
+        std::fill_n(m_translations.X(), paddedCount, 0.0f);
+        std::fill_n(m_translations.Y(), paddedCount, 0.0f);
+        std::fill_n(m_translations.Z(), paddedCount, 0.0f);
+        std::fill_n(m_scales.X(), paddedCount, 1.0f);
+        std::fill_n(m_scales.Y(), paddedCount, 1.0f);
+        std::fill_n(m_scales.Z(), paddedCount, 1.0f);
+        std::fill(m_rotations[0].begin(), m_rotations[0].end(), 0.0f);
+        std::fill(m_rotations[1].begin(), m_rotations[1].end(), 0.0f);
+        std::fill(m_rotations[2].begin(), m_rotations[2].end(), 0.0f);
+        std::fill(m_rotations[3].begin(), m_rotations[3].end(), 1.0f);
+    }
+
+    Transform Pose::GetTransform(uint32_t bone) const {
+        assert(bone < m_boneCount);
+        const Quaternion rotation(m_rotations[0][bone], m_rotations[1][bone], m_rotations[2][bone], m_rotations[3][bone]);
+        return Transform(m_translations.Get(bone), rotation, m_scales.Get(bone));
+    }
+
+    void Pose::SetTransform(uint32_t bone, const Transform& transform) {
+        assert(bone < m_boneCount);
+        m_translations.Set(bone, transform.translation);
+        m_scales.Set(bone, transform.scale);
+        m_rotations[0][bone] = transform.rotation.x;
+        m_rotations[1][bone] = transform.rotation.y;
+        m_rotations[2][bone] = transform.rotation.z;
+        m_rotations[3][bone] = transform.rotation.w;
+    }
+
+    void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out) {
+        const Lane t = SplatLane(weight);
+        const auto constant = [t](uint32_t) { return t; };
+        Blend(a, b, constant, constant, constant, out);
+    }
+
+    void BlendPoses(const Pose& a, const Pose& b, std::span<const float> rotationWeights,
+                    std::span<const float> translationWeights, std::span<const float> scaleWeights, Pose& out) {
+        assert(rotationWeights.size() >= a.GetPaddedCount() && translationWeights.size() >= a.GetPaddedCount() &&
+               scaleWeights.size() >= a.GetPaddedCount());
+        Blend(a, b,
+              [&](uint32_t i) { return LoadLane(rotationWeights.data() + i); },
+              [&](uint32_t i) { return LoadLane(translationWeights.data() + i); },
+              [&](uint32_t i) { return LoadLane(scaleWeights.data() + i); }, out);
+    }
+
+    void MakeAdditivePose(const Pose& source, const Pose& reference, Pose& out) {
+        assert(source.GetBoneCount() == reference.GetBoneCount() && source.GetBoneCount() == out.GetBoneCount());
+        const Lane zero = SplatLane(0.0f);
+        for (uint32_t i = 0; i < source.GetPaddedCount(); i += LaneWidth) {
+            const QuaternionLanes r = LoadRotations(reference, i);
+            const QuaternionLanes conjugate = { Sub(zero, r.x), Sub(zero, r.y), Sub(zero, r.z), r.w };
+            const Vector3Lanes st = LoadVectors(source.GetTranslations(), i);
+            const Vector3Lanes rt = LoadVectors(reference.GetTranslations(), i);
+            const Vector3Lanes ss = LoadVectors(source.GetScales(), i);
+            const Vector3Lanes rs = LoadVectors(reference.GetScales(), i);
+
+            StoreRotations(out, i, Multiply(conjugate, LoadRotations(source, i)));
+            StoreVectors(out.GetTranslations(), i, { Sub(st.x, rt.x), Sub(st.y, rt.y), Sub(st.z, rt.z) });
+            StoreVectors(out.GetScales(), i, { Div(ss.x, rs.x), Div(ss.y, rs.y), Div(ss.z, rs.z) });
+        }
+    }
+
+    void AddPose(const Pose& base, const Pose& additive, float weight, Pose& out) {
+        assert(base.GetBoneCount() == additive.GetBoneCount() && base.GetBoneCount() == out.GetBoneCount());
+        const Lane w = SplatLane(weight);
+        const Lane one = SplatLane(1.0f);
+        const Lane zero = SplatLane(0.0f);
+        const QuaternionLanes identity = { zero, zero, zero, one };
+        for (uint32_t i = 0; i < base.GetPaddedCount(); i += LaneWidth) {
+            const QuaternionLanes delta = Nlerp(identity, LoadRotations(additive, i), w);
+            const Vector3Lanes bt = LoadVectors(base.GetTranslations(), i);
+            const Vector3Lanes dt = LoadVectors(additive.GetTranslations(), i);
+            const Vector3Lanes bs = LoadVectors(base.GetScales(), i);
+            const Vector3Lanes ds = LoadVectors(additive.GetScales(), i);
+
+            StoreRotations(out, i, Multiply(LoadRotations(base, i), delta));
+            StoreVectors(out.GetTranslations(), i, { MulAdd(dt.x, w, bt.x), MulAdd(dt.y, w, bt.y), MulAdd(dt.z, w, bt.z) });
+            StoreVectors(out.GetScales(), i, { Mul(bs.x, MulAdd(Sub(ds.x, one), w, one)),
+                                               Mul(bs.y, MulAdd(Sub(ds.y, one), w, one)),
+                                               Mul(bs.z, MulAdd(Sub(ds.z, one), w, one)) });
+        }
+    }
+
+    void ComputeModelMatrices(const Skeleton& skeleton, const Pose& pose, std::span<Matrix4x4> modelMatrices) {
+        const uint32_t boneCount = pose.GetBoneCount();
+        assert(skeleton.GetBoneCount() == boneCount && modelMatrices.size() >= boneCount);
+
+        // Local matrices, Transform::ToMatrix4x4 for LaneWidth bones at once,
+        // transposed into the output through a small staging block
+        alignas(32) float elements[12][LaneWidth];
+        for (uint32_t i = 0; i < boneCount; i += LaneWidth) {
+            const QuaternionLanes q = LoadRotations(pose, i);
+            const Vector3Lanes t = LoadVectors(pose.GetTranslations(), i);
+            const Vector3Lanes s = LoadVectors(pose.GetScales(), i);
+
+            const Lane x2 = Add(q.x, q.x);
+            const Lane y2 = Add(q.y, q.y);
+            const Lane z2 = Add(q.z, q.z);
+            const Lane xx = Mul(q.x, x2);
+            const Lane yy = Mul(q.y, y2);
+            const Lane zz = Mul(q.z, z2);
+            const Lane xy = Mul(q.x, y2);
+            const Lane xz = Mul(q.x, z2);
+            const Lane yz = Mul(q.y, z2);
+            const Lane wx = Mul(q.w, x2);
+            const Lane wy = Mul(q.w, y2);
+            const Lane wz = Mul(q.w, z2);
+            const Lane one = SplatLane(1.0f);
+
+            StoreLane(elements[0], Mul(Sub(one, Add(yy, zz)), s.x));
+            StoreLane(elements[1], Mul(Sub(xy, wz), s.y));
+            StoreLane(elements[2], Mul(Add(xz, wy), s.z));
+            StoreLane(elements[3], t.x);
+            StoreLane(elements[4], Mul(Add(xy, wz), s.x));
+            StoreLane(elements[5], Mul(Sub(one, Add(xx, zz)), s.y));
+            StoreLane(elements[6], Mul(Sub(yz, wx), s.z));
+            StoreLane(elements[7], t.y);
+            StoreLane(elements[8], Mul(Sub(xz, wy), s.x));
+            StoreLane(elements[9], Mul(Add(yz, wx), s.y));
+            StoreLane(elements[10], Mul(Sub(one, Add(xx, yy)), s.z));
+            StoreLane(elements[11], t.z);
+
+            const uint32_t count = std::min(LaneWidth, boneCount - i);
+            for (uint32_t lane = 0; lane < count; lane++) {
+                Matrix4x4& local = modelMatrices[i + lane];
+                for (int e = 0; e < 12; e++) {
+                    local.m[e / 4][e % 4] = elements[e][lane];
+                }
+                local.m[3][0] = 0.0f;
+                local.m[3][1] = 0.0f;
+                local.m[3][2] = 0.0f;
+                local.m[3][3] = 1.0f;
+            }
+        }
+
+        // Parents precede their children, so model[parent] is final by the time it is read
+        const std::span<const int32_t> parents = skeleton.GetParents();
+        for (uint32_t i = 0; i < boneCount; i++) {
+            if (parents[i] >= 0) {
+                modelMatrices[i] = modelMatrices[parents[i]] * modelMatrices[i];
+            }
+        }
+    }
+
+    void ComputeSkinningPalette(const Skeleton& skeleton, std::span<const Matrix4x4> modelMatrices,
+                                std::span<Matrix4x4> palette) {
+        const std::span<const Matrix4x4> inverseBind = skeleton.GetInverseBindMatrices();
+        assert(modelMatrices.size() >= inverseBind.size() && palette.size() >= inverseBind.size());
+        for (size_t i = 0; i < inverseBind.size(); i++) {
+            palette[i] = modelMatrices[i] * inverseBind[i];
+        }
+    }
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <Core/MathBatch.h>
+#include <span>
+
+namespace Reality {
+    class Skeleton;
+
+    // Pose - local transform of every bone stored as structure-of-arrays, so
+    // blending processes SIMD::Width bones per instruction. Arrays are padded to
+    // a multiple of SIMD::Width with identity transforms.
+    class Pose {
+    public:
+        Pose() = default;
+        explicit Pose(uint32_t boneCount) { Resize(boneCount); }
+
+        // Bone count rounded up to a whole number of SIMD registers
+        static uint32_t GetPaddedCount(uint32_t boneCount) {
+            return (boneCount + SIMD::Width - 1) / SIMD::Width * SIMD::Width;
+        }
+
+        // Resizes and resets every bone to identity
+        void Resize(uint32_t boneCount);
+        void SetIdentity();
+
+        uint32_t GetBoneCount() const { return m_boneCount; }
+        uint32_t GetPaddedCount() const { return static_cast<uint32_t>(m_translations.Size()); }
+
+        Transform GetTransform(uint32_t bone) const;
+        void SetTransform(uint32_t bone, const Transform& transform);
+
+        Vector3Stream& GetTranslations() { return m_translations; }
+        Vector3Stream& GetScales() { return m_scales; }
+        const Vector3Stream& GetTranslations() const { return m_translations; }
+        const Vector3Stream& GetScales() const { return m_scales; }
+
+        // Rotation components, 0 to 3 for x, y, z and w
+        float* GetRotations(int component) { return m_rotations[component].data(); }
+        const float* GetRotations(int component) const { return m_rotations[component].data(); }
+
+    private:
+        uint32_t m_boneCount = 0;
+        Vector3Stream m_translations;
+        Vector3Stream m_scales;
+        AlignedVector<float> m_rotations[4];
+    };
+
+    // Pose kernels. Inputs must have the same bone count, out may alias any input.
+
+    // out = lerp(a, b, weight), rotations are nlerped along the shortest path
+    void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out);
+
+    // Per-bone weights for each channel, padded to a.GetPaddedCount(). Used by
+    // the clip sampler, where every track has its own keys, and for bone masks.
+    void BlendPoses(const Pose& a, const Pose& b, std::span<const float> rotationWeights,
+                    std::span<const float> translationWeights, std::span<const float> scaleWeights, Pose& out);
+
+    // Difference that AddPose applies on top of a base pose:
+    // rotation conj(ref) * source, translation source - ref, scale source / ref
+    void MakeAdditivePose(const Pose& source, const Pose& reference, Pose& out);
+
+    // Applies an additive pose scaled by weight: rotation base * nlerp(identity, delta, weight),
+    // translation base + weight * delta, scale base * lerp(1, delta, weight)
+    void AddPose(const Pose& base, const Pose& additive, float weight, Pose& out);
+
+    // Local to model space. Local matrices are built SIMD::Width bones at a
+    // time, then each bone is concatenated with its parent, which precedes it.
+    void ComputeModelMatrices(const Skeleton& skeleton, const Pose& pose, std::span<Matrix4x4> modelMatrices);
+
+    // palette[i] = model[i] * inverseBind[i], the matrices uploaded for skinning
+    void ComputeSkinningPalette(const Skeleton& skeleton, std::span<const Matrix4x4> modelMatrices,
+                                std::span<Matrix4x4> palette);
+}
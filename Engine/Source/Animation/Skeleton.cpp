@@ -0,0 +1,38 @@
+﻿#include "Skeleton.h"
+
+namespace Reality {
+    bool Skeleton::Initialize(std::span<const BoneDesc> bones) {
+        for (size_t i = 0; i < bones.size(); i++) {
+            if (bones[i].parent >= static_cast<int32_t>(i) || bones[i].parent < -1) {
+                return false;
+            }
+        }
+
+        const uint32_t boneCount = static_cast<uint32_t>(bones.size());
+        m_names.resize(boneCount);
+        m_parents.resize(boneCount);
+        m_bindPose.Resize(boneCount);
+        for (uint32_t i = 0; i < boneCount; i++) {
+            m_names[i] = bones[i].name;
+            m_parents[i] = bones[i].parent;
+            m_bindPose.SetTransform(i, bones[i].bindPose);
+        }
+
+        // Bind poses may carry scale, so the affine inverse rather than the rigid one
+        m_inverseBindMatrices.resize(boneCount);
+        ComputeModelMatrices(*this, m_bindPose, m_inverseBindMatrices);
+        for (Matrix4x4& matrix : m_inverseBindMatrices) {
+            matrix = matrix.InverseAffine();
+        }
+        return true;
+    }
+
+    int32_t Skeleton::FindBone(std::string_view name) const {
+        for (size_t i = 0; i < m_names.size(); i++) {
+            if (m_names[i] == name) {
+                return static_cast<int32_t>(i);
+            }
+        }
+        return -1;
+    }
+}
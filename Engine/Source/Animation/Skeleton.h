@@ -0,0 +1,39 @@
+﻿#pragma once
+#include "Pose.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Reality {
+    struct BoneDesc {
+        std::string name;
+        int32_t parent = -1;        // -1 for roots
+        Transform bindPose = Transform::Identity();     // Local transform relative to the parent
+    };
+
+    // Skeleton - bone hierarchy sorted so every parent precedes its children,
+    // which lets the model space pass run as a single forward loop
+    class Skeleton {
+    public:
+        Skeleton() = default;
+
+        // Fails if a parent index does not precede its bone
+        bool Initialize(std::span<const BoneDesc> bones);
+
+        uint32_t GetBoneCount() const { return static_cast<uint32_t>(m_parents.size()); }
+        std::span<const int32_t> GetParents() const { return m_parents; }
+        const std::string& GetBoneName(uint32_t bone) const { return m_names[bone]; }
+
+        // Returns -1 if no bone has this name
+        int32_t FindBone(std::string_view name) const;
+
+        const Pose& GetBindPose() const { return m_bindPose; }
+        std::span<const Matrix4x4> GetInverseBindMatrices() const { return m_inverseBindMatrices; }
+
+    private:
+        std::vector<std::string> m_names;
+        std::vector<int32_t> m_parents;
+        Pose m_bindPose;
+        std::vector<Matrix4x4> m_inverseBindMatrices;
+    };
+}
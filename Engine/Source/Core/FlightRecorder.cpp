@@ -0,0 +1,354 @@
+﻿#include "FlightRecorder.h"
+#include "Log.h"
+#include <algorithm>
+#include <bit>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Reality {
+    std::atomic<FlightRecorder*> FlightRecorder::s_active{nullptr};
+
+    namespace {
+        constexpr int CrashSignals[] = { SIGSEGV, SIGABRT };
+
+        // Handlers replaced by the recorder, restored when it stops and
+        // before a crash signal is raised again
+#ifdef _WIN32
+        using SignalHandler = void (*)(int);
+        SignalHandler PreviousHandlers[std::size(CrashSignals)];
+#else
+        struct sigaction PreviousActions[std::size(CrashSignals)];
+
+        // Stack the handler runs on, so a stack overflow still dumps. Only
+        // the thread that starts the recorder gets it, and keeps it.
+        constexpr size_t SignalStackSize = 64 << 10;
+        alignas(16) char SignalStack[SignalStackSize];
+
+        void InstallSignalStack() {
+            stack_t current{};
+            if (sigaltstack(nullptr, &current) != 0 || !(current.ss_flags & SS_DISABLE)) {
+                return;
+            }
+            stack_t stack{};
+            stack.ss_sp = SignalStack;
+            stack.ss_size = SignalStackSize;
+            sigaltstack(&stack, nullptr);
+        }
+#endif
+
+        void InstallSignalHandlers(void (*handler)(int)) {
+#ifndef _WIN32
+            InstallSignalStack();
+#endif
+            for (size_t index = 0; index < std::size(CrashSignals); index++) {
+#ifdef _WIN32
+                PreviousHandlers[index] = signal(CrashSignals[index], handler);
+#else
+                struct sigaction action{};
+                action.sa_handler = handler;
+                sigemptyset(&action.sa_mask);
+                action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+                sigaction(CrashSignals[index], &action, &PreviousActions[index]);
+#endif
+            }
+        }
+
+        void RestoreSignalHandler(const size_t index) {
+#ifdef _WIN32
+            signal(CrashSignals[index], PreviousHandlers[index] == SIG_ERR ? SIG_DFL : PreviousHandlers[index]);
+#else
+            sigaction(CrashSignals[index], &PreviousActions[index], nullptr);
+#endif
+        }
+
+        // Days since 1970-01-01 and back, so Dump needs no localtime
+        int64_t DaysFromCivil(int64_t year, const int64_t month, const int64_t day) {
+            year -= month <= 2;
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const int64_t yearOfEra = year - era * 400;
+            const int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + dayOfEra - 719468;
+        }
+
+        void CivilFromDays(int64_t days, int64_t& year, int64_t& month, int64_t& day) {
+            days += 719468;
+            const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const int64_t dayOfEra = days - era * 146097;
+            const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            const int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+            day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+            month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+            year = yearOfEra + era * 400 + (month <= 2);
+        }
+
+        // "[YYYY-MM-DD HH:MM:SS.mmm]" in local time
+        int FormatDumpTime(char* text, const int capacity, const int64_t nanoseconds, const int64_t utcOffset) {
+            int64_t second = nanoseconds / 1000000000;
+            int64_t remainder = nanoseconds % 1000000000;
+            if (remainder < 0) {
+                remainder += 1000000000;
+                second--;
+            }
+            const int64_t localTime = second + utcOffset;
+            int64_t days = localTime / 86400;
+            int64_t daySecond = localTime % 86400;
+            if (daySecond < 0) {
+                daySecond += 86400;
+                days--;
+            }
+
+            int64_t year, month, day;
+            CivilFromDays(days, year, month, day);
+            return stbsp_snprintf(text, capacity, "[%04d-%02d-%02d %02d:%02d:%02d.%03d]",
+                                  static_cast<int>(year), static_cast<int>(month), static_cast<int>(day),
+                                  static_cast<int>(daySecond / 3600), static_cast<int>(daySecond / 60 % 60),
+                                  static_cast<int>(daySecond % 60), static_cast<int>(remainder / 1000000));
+        }
+
+        int64_t GetUtcOffset() {
+            const std::time_t now = std::time(nullptr);
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &now);
+#else
+            localtime_r(&now, &local);
+#endif
+            const int64_t localSeconds = DaysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 86400 +
+                                         local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+            return localSeconds - now;
+        }
+
+        // Dump output, collected on the stack and written with the system
+        // calls, which stay usable in a signal handler. Small enough for the
+        // signal stack with the rest of Dump.
+        class DumpWriter {
+        public:
+            explicit DumpWriter(const char* path) {
+#ifdef _WIN32
+                m_file = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+                m_file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+            }
+
+            ~DumpWriter() {
+                if (m_file < 0) {
+                    return;
+                }
+                Flush();
+#ifdef _WIN32
+                _close(m_file);
+#else
+                close(m_file);
+#endif
+            }
+
+            DumpWriter(const DumpWriter&) = delete;
+            DumpWriter& operator=(const DumpWriter&) = delete;
+
+            [[nodiscard]] bool IsOpen() const { return m_file >= 0; }
+
+            void Append(const char* data, size_t size) {
+                while (size != 0) {
+                    const size_t part = std::min(size, sizeof(m_buffer) - m_used);
+                    memcpy(m_buffer + m_used, data, part);
+                    m_used += static_cast<uint32_t>(part);
+                    data += part;
+                    size -= part;
+                    if (m_used == sizeof(m_buffer)) {
+                        Flush();
+                    }
+                }
+            }
+
+        private:
+            void Flush() {
+                const char* data = m_buffer;
+                while (m_used != 0) {
+#ifdef _WIN32
+                    const int written = _write(m_file, data, m_used);
+#else
+                    const ssize_t written = write(m_file, data, m_used);
+#endif
+                    if (written <= 0) {
+                        break;
+                    }
+                    data += written;
+                    m_used -= static_cast<uint32_t>(written);
+                }
+                m_used = 0;
+            }
+
+            int m_file = -1;
+            char m_buffer[4096];
+            uint32_t m_used = 0;
+        };
+    }
+
+    FlightRecorder::FlightRecorder(const FlightRecorderDesc& desc) {
+        const uint32_t count = std::bit_ceil(std::max(desc.recordCount, 2u));
+        m_records = std::make_unique<Slot[]>(count);
+        m_mask = count - 1;
+
+        const size_t pathLength = std::min(desc.dumpPath.size(), sizeof(m_dumpPath) - 1);
+        memcpy(m_dumpPath, desc.dumpPath.data(), pathLength);
+        m_dumpPath[pathLength] = '\0';
+
+        // Fixed at start, a daylight saving change later shifts the dump times
+        m_utcOffset = GetUtcOffset();
+
+        s_active.store(this, std::memory_order_release);
+        if (desc.installSignalHandlers) {
+            InstallSignalHandlers(&FlightRecorder::HandleCrashSignal);
+            m_signalHandlers = true;
+        }
+    }
+
+    FlightRecorder::~FlightRecorder() {
+        if (m_signalHandlers) {
+            for (size_t index = 0; index < std::size(CrashSignals); index++) {
+                RestoreSignalHandler(index);
+            }
+        }
+        FlightRecorder* self = this;
+        s_active.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+    }
+
+    FlightRecorder::Slot& FlightRecorder::Begin(uint64_t& index, const RecordKind kind, const LogLevel level, const char* format) {
+        // The odd sequence tells Dump the slot is being written
+        index = m_next.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = m_records[index & m_mask];
+        slot.header.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        slot.header.format = format;
+        slot.header.duration = 0;
+        slot.header.thread = GetLogThreadId();
+        slot.header.kind = kind;
+        slot.header.level = static_cast<uint8_t>(level);
+        slot.header.size = 0;
+        slot.header.fieldOffset = 0;
+        return slot;
+    }
+
+    void FlightRecorder::Publish(Slot& slot, const uint64_t index) {
+        slot.header.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    void FlightRecorder::RecordText(const LogLevel level, const std::string_view text, const uint8_t* fields, const uint32_t fieldsSize) {
+        uint64_t index;
+        Slot& slot = Begin(index, RecordKind::Message, level, nullptr);
+        const uint32_t textSize = static_cast<uint32_t>(std::min<size_t>(text.size(), PayloadSize));
+        const uint32_t size = std::min(textSize + fieldsSize, PayloadSize);
+        memcpy(slot.payload, text.data(), textSize);
+        if (size > textSize) {
+            memcpy(slot.payload + textSize, fields, size - textSize);
+        }
+        slot.header.size = static_cast<uint16_t>(size);
+        slot.header.fieldOffset = static_cast<uint16_t>(textSize);
+        Publish(slot, index);
+    }
+
+    void FlightRecorder::RecordEvent(const char* name, const std::chrono::nanoseconds duration) {
+        FlightRecorder* recorder = s_active.load(std::memory_order_acquire);
+        if (!recorder) {
+            return;
+        }
+
+        uint64_t index;
+        Slot& slot = recorder->Begin(index, RecordKind::Event, LogLevel::Info, name);
+        slot.header.duration = duration.count();
+        recorder->Publish(slot, index);
+    }
+
+    void FlightRecorder::Dump() {
+        // One dump at a time, a crash during a dump keeps the first one
+        if (m_dumping.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+
+        if (DumpWriter writer(m_dumpPath); writer.IsOpen()) {
+            const uint64_t end = m_next.load(std::memory_order_acquire);
+            const uint64_t count = std::min<uint64_t>(end, m_mask + 1);
+
+            char line[256];
+            int length = stbsp_snprintf(line, sizeof(line), "Flight recorder, last %llu records\n",
+                                        static_cast<unsigned long long>(count));
+            writer.Append(line, length);
+
+            Header header;
+            uint8_t payload[PayloadSize];
+            char text[Log::MessageCapacity];
+            for (uint64_t index = end - count; index < end; index++) {
+                // Records still being written, or overwritten meanwhile, are skipped
+                const Slot& slot = m_records[index & m_mask];
+                const uint64_t sequence = slot.header.sequence.load(std::memory_order_acquire);
+                if (sequence != 2 * index + 2) {
+                    continue;
+                }
+                header.time = slot.header.time;
+                header.format = slot.header.format;
+                header.duration = slot.header.duration;
+                header.thread = slot.header.thread;
+                header.kind = slot.header.kind;
+                header.level = slot.header.level;
+                header.size = std::min<uint16_t>(slot.header.size, PayloadSize);
+                header.fieldOffset = std::min(slot.header.fieldOffset, header.size);
+                memcpy(payload, slot.payload, header.size);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.header.sequence.load(std::memory_order_relaxed) != sequence) {
+                    continue;
+                }
+
+                const char* levelName = header.kind == RecordKind::Event ? "EVENT" : Log::GetLevelName(static_cast<LogLevel>(header.level));
+                length = FormatDumpTime(line, sizeof(line), header.time, m_utcOffset);
+                length += stbsp_snprintf(line + length, static_cast<int>(sizeof(line)) - length, " [%s] [thread %u] ",
+                                         levelName, header.thread);
+                writer.Append(line, length);
+
+                if (header.kind == RecordKind::Event) {
+                    length = stbsp_snprintf(text, sizeof(text), "%s %.3f ms", header.format, static_cast<double>(header.duration) / 1e6);
+                    writer.Append(text, length);
+                } else if (header.format) {
+                    writer.Append(text, FormatLogArguments(text, sizeof(text), header.format, payload, header.fieldOffset));
+                } else {
+                    writer.Append(reinterpret_cast<const char*>(payload), header.fieldOffset);
+                }
+                if (header.fieldOffset < header.size) {
+                    writer.Append(text, FormatLogFields(text, sizeof(text), payload + header.fieldOffset,
+                                                        header.size - header.fieldOffset, LogFieldStyle::Text));
+                }
+                writer.Append("\n", 1);
+            }
+        }
+
+        m_dumping.store(false, std::memory_order_release);
+    }
+
+    void FlightRecorder::HandleCrashSignal(const int signal) {
+        if (FlightRecorder* recorder = s_active.load(std::memory_order_acquire)) {
+            recorder->Dump();
+        }
+
+        // Hand the signal to whoever handled it before, by default a crash
+        for (size_t index = 0; index < std::size(CrashSignals); index++) {
+            if (CrashSignals[index] == signal) {
+                RestoreSignalHandler(index);
+            }
+        }
+        raise(signal);
+    }
+}
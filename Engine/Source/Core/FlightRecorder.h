@@ -0,0 +1,103 @@
+﻿#pragma once
+#include "LogRecord.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+namespace Reality {
+    enum class LogLevel;
+    struct FlightRecorderDesc;
+
+    // Fixed ring of the most recent log records and timed events, kept in
+    // memory for postmortems. Writers claim a slot with one fetch_add and
+    // overwrite the oldest record, so recording never waits. Messages are
+    // stored like deferred records, format pointer and raw arguments, and
+    // only formatted when the ring is dumped. Dump is async-signal-safe: it
+    // formats into stack buffers and writes with the system calls directly.
+    // Log::StartFlightRecorder owns the instance.
+    class FlightRecorder {
+    public:
+        static constexpr uint32_t RecordSize = 256;
+
+        explicit FlightRecorder(const FlightRecorderDesc& desc);
+        ~FlightRecorder();
+
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        template<typename... Args>
+        void Record(LogLevel level, const char* format, const Args&... args);
+        // fields are encoded with EncodeLogFields
+        void RecordText(LogLevel level, std::string_view text, const uint8_t* fields = nullptr, uint32_t fieldsSize = 0);
+
+        // Writes the records, oldest first, to the dump path
+        void Dump();
+
+        // Timed event, kept if a flight recorder is running. name must
+        // outlive the recorder, as string literals do.
+        static void RecordEvent(const char* name, std::chrono::nanoseconds duration);
+
+    private:
+        enum class RecordKind : uint8_t {
+            Message,        // format is null for plain text
+            Event           // format is the event name
+        };
+
+        struct Header {
+            std::atomic<uint64_t> sequence{0};      // 2 * index + 1 while written, 2 * index + 2 once complete
+            int64_t time;                           // Nanoseconds since epoch
+            const char* format;
+            int64_t duration;                       // Nanoseconds, events only
+            uint32_t thread;
+            RecordKind kind;
+            uint8_t level;
+            uint16_t size;
+            uint16_t fieldOffset;                   // Start of the fields in the payload
+        };
+
+        static constexpr uint32_t PayloadSize = RecordSize - sizeof(Header);
+
+        struct alignas(64) Slot {
+            Header header;
+            uint8_t payload[PayloadSize];
+        };
+
+        Slot& Begin(uint64_t& index, RecordKind kind, LogLevel level, const char* format);
+        static void Publish(Slot& slot, uint64_t index);
+        static void HandleCrashSignal(int signal);
+
+        std::unique_ptr<Slot[]> m_records;
+        uint32_t m_mask = 0;
+        char m_dumpPath[260] = {};
+        int64_t m_utcOffset = 0;                    // Seconds, for local times without localtime in Dump
+        bool m_signalHandlers = false;
+        std::atomic<bool> m_dumping{false};
+        alignas(64) std::atomic<uint64_t> m_next{0};
+
+        static std::atomic<FlightRecorder*> s_active;
+    };
+
+    template<typename... Args>
+    void FlightRecorder::Record(const LogLevel level, const char* format, const Args&... args) {
+        uint64_t index;
+        Slot& slot = Begin(index, RecordKind::Message, level, format);
+        slot.header.size = static_cast<uint16_t>(EncodeLogArguments(slot.payload, PayloadSize, args...));
+        slot.header.fieldOffset = slot.header.size;
+        Publish(slot, index);
+    }
+
+    // Records the time from construction to destruction as an event
+    class FlightRecorderScope {
+    public:
+        explicit FlightRecorderScope(const char* name) : m_name(name), m_start(std::chrono::steady_clock::now()) {}
+        ~FlightRecorderScope() { FlightRecorder::RecordEvent(m_name, std::chrono::steady_clock::now() - m_start); }
+
+        FlightRecorderScope(const FlightRecorderScope&) = delete;
+        FlightRecorderScope& operator=(const FlightRecorderScope&) = delete;
+
+    private:
+        const char* m_name;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
@@ -0,0 +1,159 @@
+﻿#include "JobSystem.h"
+#include <algorithm>
+
+namespace Reality {
+    namespace {
+        thread_local uint32_t t_threadIndex = 0;
+    }
+
+    // A ParallelFor in flight. Workers and the submitting thread pull chunk
+    // indices from the same counter until the range is exhausted.
+    struct JobSystem::Batch {
+        const RangeFunction* function = nullptr;
+        uint32_t count = 0;
+        uint32_t grainSize = 1;
+        uint32_t chunkCount = 0;
+        std::atomic<uint32_t> nextChunk{0};
+        std::atomic<uint32_t> completedChunks{0};
+    };
+
+    JobSystem& JobSystem::GetInstance() {
+        static JobSystem instance;
+        return instance;
+    }
+
+    JobSystem::~JobSystem() {
+        Shutdown();
+    }
+
+    void JobSystem::Initialize(uint32_t threadCount) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) {
+            return;
+        }
+
+        if (threadCount == 0) {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        m_running = true;
+        m_workers.reserve(threadCount - 1);
+        for (uint32_t i = 1; i < threadCount; i++) {
+            m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+        }
+    }
+
+    void JobSystem::Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                return;
+            }
+            m_running = false;
+        }
+
+        m_wakeCondition.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+        m_queue.clear();
+    }
+
+    uint32_t JobSystem::GetThreadCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<uint32_t>(m_workers.size()) + 1;
+    }
+
+    uint32_t JobSystem::GetCurrentThreadIndex() {
+        return t_threadIndex;
+    }
+
+    void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function) {
+        if (count == 0) {
+            return;
+        }
+
+        grainSize = std::max(grainSize, 1u);
+        const uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+
+        Initialize();
+
+        uint32_t helperCount;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            helperCount = std::min(static_cast<uint32_t>(m_workers.size()), chunkCount - 1);
+        }
+
+        // Not worth waking anyone up
+        if (helperCount == 0) {
+            for (uint32_t begin = 0; begin < count; begin += grainSize) {
+                function(begin, std::min(begin + grainSize, count));
+            }
+            return;
+        }
+
+        auto batch = std::make_shared<Batch>();
+        batch->function = &function;
+        batch->count = count;
+        batch->grainSize = grainSize;
+        batch->chunkCount = chunkCount;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (uint32_t i = 0; i < helperCount; i++) {
+                m_queue.push_back(batch);
+            }
+        }
+        if (helperCount == 1) {
+            m_wakeCondition.notify_one();
+        } else {
+            m_wakeCondition.notify_all();
+        }
+
+        // Work on our own batch, then wait for chunks still running elsewhere
+        RunChunks(*batch);
+
+        uint32_t completed = batch->completedChunks.load(std::memory_order_acquire);
+        while (completed < chunkCount) {
+            batch->completedChunks.wait(completed, std::memory_order_acquire);
+            completed = batch->completedChunks.load(std::memory_order_acquire);
+        }
+    }
+
+    void JobSystem::RunChunks(Batch& batch) {
+        while (true) {
+            const uint32_t chunk = batch.nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= batch.chunkCount) {
+                return;
+            }
+
+            const uint32_t begin = chunk * batch.grainSize;
+            const uint32_t end = std::min(begin + batch.grainSize, batch.count);
+            (*batch.function)(begin, end);
+
+            if (batch.completedChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == batch.chunkCount) {
+                batch.completedChunks.notify_all();
+            }
+        }
+    }
+
+    void JobSystem::WorkerLoop(uint32_t threadIndex) {
+        t_threadIndex = threadIndex;
+
+        while (true) {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeCondition.wait(lock, [this] { return !m_running || !m_queue.empty(); });
+                if (!m_running) {
+                    return;
+                }
+                batch = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            RunChunks(*batch);
+        }
+    }
+}
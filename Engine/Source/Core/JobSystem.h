@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Reality {
+    // Fixed pool of worker threads, one per hardware core. The calling thread
+    // always takes part in the work it submits, so nested ParallelFor calls
+    // from inside a job cannot deadlock.
+    class JobSystem {
+    public:
+        // Range callback, invoked with [begin, end) sub-ranges of the full range
+        using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+        static JobSystem& GetInstance();
+
+        // Delete copy constructor and assignment operator
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Starts the workers. 0 means one thread per hardware core, counting the caller.
+        // Called lazily by the first ParallelFor if not done explicitly.
+        void Initialize(uint32_t threadCount = 0);
+        void Shutdown();
+
+        // Number of threads that execute jobs, including the calling thread
+        [[nodiscard]] uint32_t GetThreadCount() const;
+
+        // Splits [0, count) into chunks of at most grainSize elements and runs them
+        // across the workers. Returns when every chunk has completed.
+        void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunction& function);
+
+        // Index of the current thread in [0, GetThreadCount()), 0 for any non-worker thread
+        [[nodiscard]] static uint32_t GetCurrentThreadIndex();
+
+    private:
+        JobSystem() = default;
+        ~JobSystem();
+
+        struct Batch;
+
+        void WorkerLoop(uint32_t threadIndex);
+        static void RunChunks(Batch& batch);
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::shared_ptr<Batch>> m_queue;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wakeCondition;
+        bool m_running = false;
+    };
+}
@@ -1,27 +1,87 @@
 ﻿#include "Log.h"
+#include "LogFileSink.h"
+#include "LogRingBuffer.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <ctime>
 
+#define STB_SPRINTF_IMPLEMENTATION
+#include <stb_sprintf.h>
+
 namespace Reality {
-    Log& Log::GetInstance() {
-        static Log instance;
-        return instance;
+    namespace {
+        // Batches stay short enough for the configuration calls to get m_mutex
+        constexpr uint32_t MaxBatchRecords = 256;
+
+        // Longest the sink sleeps between checks, if a wake-up is ever missed
+        constexpr auto IdleWait = std::chrono::milliseconds(100);
+
+        constexpr const char* LevelNames[] = { "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL" };
+
+        // Longest "[timestamp] [LEVEL] " prefix
+        constexpr uint32_t LinePrefixCapacity = 64;
+
+        // Room for an escaped message and the fields
+        constexpr uint32_t JsonLineCapacity = 2 * Log::MessageCapacity;
+
+        // Formatting scratch of one thread. The timestamp up to the seconds
+        // is kept, and only reformatted when the second changes.
+        struct ThreadBuffers {
+            char message[Log::MessageCapacity];
+            char line[LinePrefixCapacity + Log::MessageCapacity];
+            char json[JsonLineCapacity];
+            int64_t second = INT64_MIN;
+            char secondPrefix[32];          // "[YYYY-MM-DD HH:MM:SS."
+            uint32_t secondPrefixLength = 0;
+        };
+
+        thread_local ThreadBuffers t_buffers;
+
+        constexpr char SuppressedFormat[] = "Suppressed %llu repeats of the message from %s:%d";
+
+        // The file name is enough to find a call site
+        const char* GetFileName(const char* path) {
+            const char* name = path;
+            for (const char* c = path; *c; c++) {
+                if (*c == '/' || *c == '\\') {
+                    name = c + 1;
+                }
+            }
+            return name;
+        }
+
+        std::tm ToLocalTime(std::time_t time) {
+            // Platform-safe localtime conversion
+            std::tm tm_info{};
+#ifdef _WIN32
+            localtime_s(&tm_info, &time);
+#else
+            localtime_r(&time, &tm_info);
+#endif
+            return tm_info;
+        }
     }
 
     Log::Log()
         : m_currentLevel(LogLevel::Info)
+        , m_enabledLevel(LogLevel::Info)
         , m_consoleEnabled(true)
         , m_fileEnabled(false)
         , m_colorsEnabled(true)
-        , m_logFilename("engine.log")
+        , m_fileSink(std::make_unique<LogFileSink>())
+        , m_jsonSink(std::make_unique<LogFileSink>())
     {
         InitializeConsole();
     }
 
     Log::~Log() {
-        if (m_logFile.is_open()) {
-            m_logFile.close();
+        StopAsync();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteSuppressedSites(true);
         }
+        m_fileSink->Close();
     }
 
     void Log::InitializeConsole() {
@@ -46,7 +106,62 @@ namespace Reality {
 
     void Log::SetLevel(const LogLevel level) {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_currentLevel = level;
+        m_currentLevel.store(level, std::memory_order_relaxed);
+        UpdateEnabledLevel();
+    }
+
+    void Log::UpdateEnabledLevel() {
+        LogLevel level = m_currentLevel.load(std::memory_order_relaxed);
+        if (m_recorder) {
+            level = std::min(level, m_recordLevel);
+        }
+        m_enabledLevel.store(level, std::memory_order_relaxed);
+    }
+
+    void Log::SetRateLimit(const uint32_t messages, const uint32_t intervalMs) {
+        m_rateLimitMessages.store(messages, std::memory_order_relaxed);
+        m_rateLimitIntervalMs.store(intervalMs, std::memory_order_relaxed);
+    }
+
+    void Log::ReportSuppressed(const LogLevel level, const char* file, const int line, const uint64_t count) {
+        Write(level, SuppressedFormat, static_cast<unsigned long long>(count), GetFileName(file), line);
+    }
+
+    void Log::AddSuppressedSite(LogRateLimiter& limiter, const LogLevel level, const char* file, const int line,
+                                const uint32_t intervalMs) {
+        std::lock_guard<std::mutex> lock(m_suppressedMutex);
+        m_suppressedSites.push_back({ &limiter, level, file, line, intervalMs });
+        m_hasSuppressedSites.store(true, std::memory_order_relaxed);
+    }
+
+    bool Log::WriteSuppressedSites(const bool all) {
+        if (!m_hasSuppressedSites.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        bool wrote = false;
+        std::lock_guard<std::mutex> lock(m_suppressedMutex);
+        std::erase_if(m_suppressedSites, [this, all, &wrote](const SuppressedSite& site) {
+            uint64_t count;
+            if (!site.limiter->TakePending(site.intervalMs, all, count)) {
+                return false;
+            }
+            // The site may have reported the count with its next message already
+            if (count != 0) {
+                char message[256];
+                const int size = std::min<int>(stbsp_snprintf(message, sizeof(message), SuppressedFormat,
+                                                              static_cast<unsigned long long>(count), GetFileName(site.file), site.line),
+                                               sizeof(message) - 1);
+                const RecordHeader header = { std::chrono::system_clock::now().time_since_epoch().count(), nullptr,
+                                              m_frame.load(std::memory_order_relaxed), GetLogThreadId(),
+                                              static_cast<uint32_t>(size), site.level };
+                WriteRecord(header, reinterpret_cast<const uint8_t*>(message), static_cast<uint32_t>(size));
+                wrote = true;
+            }
+            return true;
+        });
+        m_hasSuppressedSites.store(!m_suppressedSites.empty(), std::memory_order_relaxed);
+        return wrote;
     }
 
     void Log::EnableConsoleOutput(const bool enabled) {
@@ -58,24 +173,31 @@ namespace Reality {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_fileEnabled = enabled;
 
-        if (enabled && !m_logFile.is_open()) {
-            m_logFile.open(m_logFilename, std::ios::out | std::ios::app);
-        } else if (!enabled && m_logFile.is_open()) {
-            m_logFile.close();
+        if (enabled && !m_fileSink->IsOpen()) {
+            m_fileSink->Open(m_fileDesc);
+        } else if (!enabled) {
+            m_fileSink->Close();
         }
     }
 
     void Log::SetLogFile(const std::string& filename) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if (m_logFile.is_open()) {
-            m_logFile.close();
+        LogFileDesc desc;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            desc = m_fileDesc;
         }
+        desc.path = filename;
+        SetLogFile(desc);
+    }
+
+    void Log::SetLogFile(const LogFileDesc& desc) {
+        std::lock_guard<std::mutex> lock(m_mutex);
 
-        m_logFilename = filename;
+        m_fileSink->Close();
+        m_fileDesc = desc;
 
         if (m_fileEnabled) {
-            m_logFile.open(m_logFilename, std::ios::out | std::ios::app);
+            m_fileSink->Open(m_fileDesc);
         }
     }
 
@@ -84,31 +206,306 @@ namespace Reality {
         m_colorsEnabled = enabled;
     }
 
-    void Log::LogMessage(const LogLevel level, const std::string& message) {
-        if (level < m_currentLevel) {
+    void Log::LogMessage(const LogLevel level, std::string_view message) {
+        if (!IsEnabled(level)) {
             return; // Skip messages below current log level
         }
 
+        if (m_recorder && level >= m_recordLevel) {
+            m_recorder->RecordText(level, message);
+        }
+        if (level < m_currentLevel.load(std::memory_order_relaxed)) {
+            return;
+        }
+        WriteMessage(level, message);
+    }
+
+    void Log::WriteMessage(const LogLevel level, const std::string_view message) {
+        if (IsAsync()) {
+            PushRecord(level, nullptr, message.data(), static_cast<uint32_t>(message.size()), static_cast<uint32_t>(message.size()));
+            if (level == LogLevel::Fatal) {
+                Flush();
+                DumpFlightRecorder();
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Format the message with timestamp and log level
+            WriteLine(level, FormatLine(std::chrono::system_clock::now(), level, message));
+            WriteSuppressedSites(false);
+            FlushOutputs();
+        }
+
+        if (level == LogLevel::Fatal) {
+            DumpFlightRecorder();
+        }
+    }
+
+    void Log::WriteStructured(const LogLevel level, const uint8_t* payload, const uint32_t fieldOffset, const uint32_t size) {
+        const std::string_view text(reinterpret_cast<const char*>(payload), fieldOffset);
+        if (m_recorder && level >= m_recordLevel) {
+            m_recorder->RecordText(level, text, payload + fieldOffset, size - fieldOffset);
+        }
+        if (level < m_currentLevel.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (IsAsync()) {
+            PushRecord(level, nullptr, payload, size, fieldOffset);
+            if (level == LogLevel::Fatal) {
+                Flush();
+                DumpFlightRecorder();
+            }
+            return;
+        }
+
+        char* message = GetMessageBuffer();
+        memcpy(message, text.data(), text.size());
+        const uint32_t length = fieldOffset + FormatLogFields(message + fieldOffset, MessageCapacity - fieldOffset,
+                                                              payload + fieldOffset, size - fieldOffset, LogFieldStyle::Text);
+        WriteMessage(level, std::string_view(message, length));
+    }
+
+    void Log::StartFlightRecorder(const FlightRecorderDesc& desc) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recorder.reset();
+        m_recorder = std::make_unique<FlightRecorder>(desc);
+        m_recordLevel = desc.level;
+        UpdateEnabledLevel();
+    }
+
+    void Log::StopFlightRecorder() {
         std::lock_guard<std::mutex> lock(m_mutex);
+        m_recorder.reset();
+        UpdateEnabledLevel();
+    }
 
-        // Format the message with timestamp and log level
-        std::ostringstream formattedMessage;
-        formattedMessage << "[" << GetTimestamp() << "] [" << GetLevelString(level) << "] " << message;
+    void Log::DumpFlightRecorder() {
+        if (m_recorder) {
+            m_recorder->Dump();
+        }
+    }
 
-        if (m_consoleEnabled) {
-            WriteToConsole(level, formattedMessage.str());
+    void Log::StartAsync(const LogAsyncDesc& desc) {
+        StopAsync();
+
+        m_ring = std::make_unique<LogRingBuffer>(desc.bufferSize);
+        m_overflowPolicy = desc.overflowPolicy;
+        m_writtenPosition.store(0, std::memory_order_relaxed);
+
+        m_binaryFormats.clear();
+        if (!desc.binaryFile.empty()) {
+            m_binaryFile.open(desc.binaryFile, std::ios::out | std::ios::binary | std::ios::trunc);
+            m_binaryFile.write(LogFileMagic, sizeof(LogFileMagic));
+        }
+        if (!desc.jsonFile.empty()) {
+            LogFileDesc jsonDesc;
+            jsonDesc.path = desc.jsonFile;
+            jsonDesc.append = false;
+            m_jsonSink->Open(jsonDesc);
         }
 
-        if (m_fileEnabled) {
-            // Ensure file is open before writing
-            if (!m_logFile.is_open()) {
-                m_logFile.open(m_logFilename, std::ios::out | std::ios::app);
+        m_sinkRunning = true;
+        m_sinkThread = std::thread(&Log::SinkLoop, this);
+        m_deferFormatting.store(desc.deferFormatting, std::memory_order_relaxed);
+        m_async.store(true, std::memory_order_release);
+    }
+
+    void Log::StopAsync() {
+        if (!m_sinkThread.joinable()) {
+            return;
+        }
+
+        // The sink drains the ring before it exits
+        m_deferFormatting.store(false, std::memory_order_relaxed);
+        m_async.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_sinkMutex);
+            m_sinkRunning = false;
+            m_sinkCondition.notify_one();
+        }
+        m_sinkThread.join();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteSuppressedSites(true);
+            FlushOutputs();
+        }
+        if (m_binaryFile.is_open()) {
+            m_binaryFile.close();
+        }
+        m_jsonSink->Close();
+    }
+
+    void Log::Flush() {
+        {
+            std::unique_lock<std::mutex> lock(m_sinkMutex);
+            if (m_sinkRunning) {
+                const uint64_t target = m_ring->GetWritePosition();
+                m_sinkCondition.notify_one();
+                m_flushCondition.wait(lock, [this, target] { return m_writtenPosition.load(std::memory_order_acquire) >= target; });
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        WriteSuppressedSites(true);
+        m_fileSink->Flush();
+        m_jsonSink->Flush();
+    }
+
+    void Log::PushRecord(const LogLevel level, const char* format, const void* payload, uint32_t size, const uint32_t fieldOffset) {
+        size = std::min<uint32_t>(size, m_ring->GetMaxRecordSize() - sizeof(RecordHeader));
+        const RecordHeader header = { std::chrono::system_clock::now().time_since_epoch().count(), format,
+                                      m_frame.load(std::memory_order_relaxed), GetLogThreadId(), std::min(fieldOffset, size), level };
+
+        while (!m_ring->TryPush(&header, sizeof(header), payload, size)) {
+            if (m_overflowPolicy != LogOverflowPolicy::Block && level != LogLevel::Fatal) {
+                m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            WakeSink();
+            std::this_thread::yield();
+        }
+        WakeSink();
+    }
+
+    void Log::WakeSink() {
+        // Pairs with the fence in SinkLoop: either the sink sees the record
+        // before it sleeps, or this thread sees it sleeping. Only the thread
+        // that clears the flag takes the lock.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sinkSleeping.load(std::memory_order_relaxed) && m_sinkSleeping.exchange(false)) {
+            std::lock_guard<std::mutex> lock(m_sinkMutex);
+            m_sinkCondition.notify_one();
+        }
+    }
+
+    void Log::SinkLoop() {
+        std::vector<uint8_t> record;
+        record.reserve(m_ring->GetMaxRecordSize());
+        uint64_t reportedDrops = 0;
+
+        for (;;) {
+            bool wrote = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (uint32_t count = 0; count < MaxBatchRecords && m_ring->TryPop(record); count++) {
+                    RecordHeader header;
+                    memcpy(&header, record.data(), sizeof(header));
+                    WriteRecord(header, record.data() + sizeof(header), static_cast<uint32_t>(record.size() - sizeof(header)));
+                    wrote = true;
+                }
+
+                const uint64_t dropped = m_droppedCount.load(std::memory_order_relaxed);
+                if (m_overflowPolicy == LogOverflowPolicy::Count && dropped != reportedDrops) {
+                    char message[96];
+                    const int size = stbsp_snprintf(message, sizeof(message), "%llu log messages dropped, the asynchronous buffer was full",
+                                                    static_cast<unsigned long long>(dropped - reportedDrops));
+                    const RecordHeader header = { std::chrono::system_clock::now().time_since_epoch().count(), nullptr,
+                                                  m_frame.load(std::memory_order_relaxed), GetLogThreadId(),
+                                                  static_cast<uint32_t>(size), LogLevel::Warning };
+                    WriteRecord(header, reinterpret_cast<const uint8_t*>(message), static_cast<uint32_t>(size));
+                    reportedDrops = dropped;
+                    wrote = true;
+                }
+                wrote |= WriteSuppressedSites(false);
+
+                if (wrote) {
+                    FlushOutputs();
+                    if (m_binaryFile.is_open()) {
+                        m_binaryFile.flush();
+                    }
+                } else {
+                    // Idle wake-ups write out lines that have waited long enough
+                    m_fileSink->FlushIfDue();
+                    m_jsonSink->FlushIfDue();
+                }
+            }
+
+            if (wrote) {
+                m_writtenPosition.store(m_ring->GetReadPosition(), std::memory_order_release);
+                std::lock_guard<std::mutex> lock(m_sinkMutex);
+                m_flushCondition.notify_all();
+                continue;
+            }
+
+            // Nothing left, exit if stopping or sleep until WakeSink
+            std::unique_lock<std::mutex> lock(m_sinkMutex);
+            if (!m_sinkRunning) {
+                break;
+            }
+            m_sinkSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_ring->IsEmpty()) {
+                m_sinkCondition.wait_for(lock, IdleWait);
+            }
+            m_sinkSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void Log::WriteRecord(const RecordHeader& header, const uint8_t* payload, const uint32_t size) {
+        const std::chrono::system_clock::time_point time{std::chrono::system_clock::duration(header.time)};
+        const bool text = m_consoleEnabled || m_fileEnabled;
+        m_jsonSink->Reopen();
+        if (text || m_jsonSink->IsOpen()) {
+            char* buffer = GetMessageBuffer();
+            std::string_view message(reinterpret_cast<const char*>(payload), header.fieldOffset);
+            if (header.format) {
+                message = std::string_view(buffer, FormatLogArguments(buffer, MessageCapacity, header.format, payload, header.fieldOffset));
+            }
+
+            const uint8_t* fields = payload + header.fieldOffset;
+            const uint32_t fieldsSize = size - header.fieldOffset;
+            if (m_jsonSink->IsOpen()) {
+                m_jsonSink->Write(header.level, FormatJsonLine(time, header.level, header.frame, header.thread, message, fields, fieldsSize));
             }
 
-            if (m_logFile.is_open()) {
-                WriteToFile(level, formattedMessage.str());
+            if (text) {
+                if (fieldsSize != 0) {
+                    // Text records sit in the payload, the fields follow them in the buffer
+                    const uint32_t length = static_cast<uint32_t>(std::min<size_t>(message.size(), MessageCapacity - 1));
+                    memmove(buffer, message.data(), length);
+                    message = std::string_view(buffer, length + FormatLogFields(buffer + length, MessageCapacity - length,
+                                                                                fields, fieldsSize, LogFieldStyle::Text));
+                }
+                WriteLine(header.level, FormatLine(time, header.level, message));
             }
         }
+
+        if (m_binaryFile.is_open()) {
+            WriteBinaryRecord(header, payload, size);
+        }
+    }
+
+    void Log::WriteBinaryRecord(const RecordHeader& header, const uint8_t* payload, const uint32_t size) {
+        // Formats are identified by their address, and written the first time they are used
+        const char* format = header.format;
+        const uint64_t formatId = reinterpret_cast<uintptr_t>(format);
+        if (format && m_binaryFormats.insert(format).second) {
+            const auto kind = static_cast<uint8_t>(LogFileRecord::Format);
+            const auto length = static_cast<uint32_t>(strlen(format));
+            m_binaryFile.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+            m_binaryFile.write(reinterpret_cast<const char*>(&formatId), sizeof(formatId));
+            m_binaryFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            m_binaryFile.write(format, length);
+        }
+
+        const auto kind = static_cast<uint8_t>(LogFileRecord::Message);
+        const std::chrono::system_clock::time_point time{std::chrono::system_clock::duration(header.time)};
+        const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        const auto levelValue = static_cast<uint8_t>(header.level);
+        m_binaryFile.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+        m_binaryFile.write(reinterpret_cast<const char*>(&nanoseconds), sizeof(nanoseconds));
+        m_binaryFile.write(reinterpret_cast<const char*>(&levelValue), sizeof(levelValue));
+        m_binaryFile.write(reinterpret_cast<const char*>(&header.frame), sizeof(header.frame));
+        m_binaryFile.write(reinterpret_cast<const char*>(&header.thread), sizeof(header.thread));
+        m_binaryFile.write(reinterpret_cast<const char*>(&formatId), sizeof(formatId));
+        m_binaryFile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_binaryFile.write(reinterpret_cast<const char*>(&header.fieldOffset), sizeof(header.fieldOffset));
+        m_binaryFile.write(reinterpret_cast<const char*>(payload), size);
     }
 
     // String versions of logging methods
@@ -137,62 +534,113 @@ namespace Reality {
     }
 
     std::string Log::GetLevelString(const LogLevel level) {
-        switch (level) {
-            case LogLevel::Trace:   return "TRACE";
-            case LogLevel::Debug:   return "DEBUG";
-            case LogLevel::Info:    return "INFO";
-            case LogLevel::Warning: return "WARNING";
-            case LogLevel::Error:   return "ERROR";
-            case LogLevel::Fatal:   return "FATAL";
-            default:                return "UNKNOWN";
-        }
+        return GetLevelName(level);
+    }
+
+    const char* Log::GetLevelName(const LogLevel level) {
+        const auto index = static_cast<size_t>(level);
+        return index < std::size(LevelNames) ? LevelNames[index] : "UNKNOWN";
     }
 
     std::string Log::GetTimestamp() {
-        const auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
+        return FormatTimestamp(std::chrono::system_clock::now());
+    }
+
+    std::string Log::FormatTimestamp(const std::chrono::system_clock::time_point time) {
+        const std::tm tm_info = ToLocalTime(std::chrono::system_clock::to_time_t(time));
         const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
+            time.time_since_epoch()) % 1000;
 
-        std::ostringstream ss;
+        char buffer[32];
+        const size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm_info);
+        stbsp_snprintf(buffer + length, static_cast<int>(sizeof(buffer) - length), ".%03d", static_cast<int>(ms.count()));
+        return buffer;
+    }
 
-        // Platform-safe localtime conversion
-        std::tm tm_info{};
+    std::string_view Log::FormatLine(const std::chrono::system_clock::time_point time, const LogLevel level,
+                                     const std::string_view message) {
+        ThreadBuffers& buffers = t_buffers;
+
+        const auto second = std::chrono::floor<std::chrono::seconds>(time);
+        const auto ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(time - second).count());
+        if (second.time_since_epoch().count() != buffers.second) {
+            const std::tm tm_info = ToLocalTime(std::chrono::system_clock::to_time_t(second));
+            buffers.secondPrefixLength = static_cast<uint32_t>(strftime(buffers.secondPrefix, sizeof(buffers.secondPrefix),
+                                                                        "[%Y-%m-%d %H:%M:%S.", &tm_info));
+            buffers.second = second.time_since_epoch().count();
+        }
 
-#ifdef _WIN32
-        // Use localtime_s for Windows
-        localtime_s(&tm_info, &time_t);
-#else
-        // Use localtime_r for POSIX systems
-        localtime_r(&time_t, &tm_info);
-#endif
+        char* line = buffers.line;
+        memcpy(line, buffers.secondPrefix, buffers.secondPrefixLength);
+        uint32_t length = buffers.secondPrefixLength;
+        line[length++] = static_cast<char>('0' + ms / 100);
+        line[length++] = static_cast<char>('0' + ms / 10 % 10);
+        line[length++] = static_cast<char>('0' + ms % 10);
+
+        length += stbsp_snprintf(line + length, static_cast<int>(LinePrefixCapacity - length), "] [%s] ", GetLevelName(level));
+
+        const size_t messageSize = std::min<size_t>(message.size(), MessageCapacity);
+        memcpy(line + length, message.data(), messageSize);
+        return { line, length + messageSize };
+    }
+
+    std::string_view Log::FormatJsonLine(const std::chrono::system_clock::time_point time, const LogLevel level, const uint64_t frame,
+                                         const uint32_t thread, const std::string_view message, const uint8_t* fields,
+                                         const uint32_t fieldsSize) {
+        char* line = t_buffers.json;
+        const long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        uint32_t length = stbsp_snprintf(line, JsonLineCapacity, "{\"time\":%lld,\"level\":\"%s\",\"frame\":%llu,\"thread\":%u,\"message\":",
+                                         nanoseconds, GetLevelName(level), static_cast<unsigned long long>(frame), thread);
+        // Room is kept for the closing brace, the message and fields are cut before it
+        length += FormatLogJsonString(line + length, JsonLineCapacity - length - 1, message);
+        length += FormatLogFields(line + length, JsonLineCapacity - length - 1, fields, fieldsSize, LogFieldStyle::Json);
+        line[length++] = '}';
+        return { line, length };
+    }
+
+    char* Log::GetMessageBuffer() {
+        return t_buffers.message;
+    }
+
+    void Log::WriteLine(const LogLevel level, const std::string_view line) {
+        if (m_consoleEnabled) {
+            WriteToConsole(level, line);
+        }
 
-        ss << std::put_time(&tm_info, "%Y-%m-%d %H:%M:%S");
-        ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+        // A file that failed to open or rotate is retried once per flush interval
+        if (m_fileEnabled && m_fileSink->Reopen()) {
+            WriteToFile(level, line);
+        }
+    }
 
-        return ss.str();
+    void Log::FlushOutputs() {
+        if (m_consoleEnabled) {
+            std::cout.flush();
+        }
+        m_fileSink->FlushIfDue();
+        m_jsonSink->FlushIfDue();
     }
 
-    void Log::WriteToConsole(const LogLevel level, const std::string& message) const {
+    void Log::WriteToConsole(const LogLevel level, const std::string_view message) const {
         if (m_colorsEnabled) {
             SetConsoleColor(level);
         }
 
-        std::cout << message << std::endl;
+        std::cout.write(message.data(), static_cast<std::streamsize>(message.size()));
+        std::cout.put('\n');
 
         if (m_colorsEnabled) {
+#ifdef _WIN32
+            // Console attributes only apply to text already written
+            std::cout.flush();
+#endif
             ResetConsoleColor();
         }
     }
 
-    void Log::WriteToFile(LogLevel level, const std::string& message) {
-        // Double-check that the file is open
-        if (!m_logFile.is_open()) {
-            return;
-        }
-
-        m_logFile << message << std::endl;
-        m_logFile.flush(); // Ensure immediate write to file
+    void Log::WriteToFile(LogLevel level, const std::string_view message) {
+        // Buffered, urgent levels are written at once
+        m_fileSink->Write(level, message);
     }
 
     void Log::SetConsoleColor(LogLevel level) const {
@@ -237,26 +685,4 @@ namespace Reality {
         std::cout << "\033[0m"; // Reset ANSI color
 #endif
     }
-
-    std::string Log::FormatString(const char *format, va_list args) {
-        // Create a copy of va_list in case we need to retry
-        va_list args_copy;
-        va_copy(args_copy, args);
-
-        // Calculate required buffer size
-        std::string::size_type size = vsnprintf(nullptr, 0, format, args_copy);
-        va_end(args_copy);
-
-        if (size <= 0) {
-            return "";
-        }
-
-        // Allocate buffer with space for null terminator
-        std::vector<char> buffer(size + 1);
-
-        // Format the string
-        vsnprintf(buffer.data(), buffer.size(), format, args);
-
-        return {buffer.data(), size};
-    }
-}
\ No newline at end of file
+}
@@ -1,8 +1,17 @@
 ﻿#pragma once
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <cstdarg>
+#include <cstdio>
 #include <fstream>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #ifdef _WIN32
@@ -11,6 +20,18 @@
 #include <unistd.h>
 #endif
 
+#include "FlightRecorder.h"
+#include "LogFormat.h"
+#include "LogRateLimiter.h"
+#include "LogRecord.h"
+#include <stb_sprintf.h>
+
+// Lowest level the RLOG_* macros compile in, set from REALITY_LOG_LEVEL in
+// CMake. Calls below it are removed along with their arguments.
+#ifndef REALITY_LOG_MIN_LEVEL
+#define REALITY_LOG_MIN_LEVEL 0
+#endif
+
 namespace Reality {
     enum class LogLevel {
         Trace,
@@ -21,16 +42,76 @@ namespace Reality {
         Fatal
     };
 
+    // What a logging thread does when the asynchronous buffer is full.
+    // Fatal messages always wait.
+    enum class LogOverflowPolicy {
+        Block,          // Wait for the sink thread to make room
+        Drop,           // Discard the message
+        Count           // Discard the message, the sink then logs how many were lost
+    };
+
+    struct LogAsyncDesc {
+        uint32_t bufferSize = 1 << 20;          // Bytes, messages beyond a quarter of it are truncated
+        LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Block;
+
+        // Formatted messages keep the format pointer and the raw arguments,
+        // and only the sink thread formats them. Only formats checked at
+        // compile time get here, and those are constants that outlive it.
+        bool deferFormatting = false;
+
+        // If set, the sink also writes every record unformatted to this file,
+        // for Tools/LogDecoder. Disable console and file output to leave the
+        // formatting entirely to the decoder. Each StartAsync starts the file
+        // empty.
+        std::string binaryFile;
+
+        // If set, the sink also writes every record to this file as a line
+        // of JSON: time in nanoseconds since epoch, level, frame, thread,
+        // message and the fields of structured records. Started empty like
+        // binaryFile.
+        std::string jsonFile;
+    };
+
+    struct LogFileDesc {
+        std::string path = "engine.log";
+        uint32_t bufferSize = 256 << 10;            // Bytes collected before a write
+        uint32_t flushIntervalMs = 1000;            // Longest a line waits in the buffer, checked when
+                                                    // lines are logged and by the asynchronous sink
+        LogLevel flushLevel = LogLevel::Error;      // Lines at or above it are written at once
+        uint64_t maxFileSize = 0;                   // Bytes before the file rotates, 0 for no limit
+        bool rotateDaily = false;                   // Rotate at local midnight
+        uint32_t maxFiles = 5;                      // Rotated files kept, older ones are deleted
+        bool append = true;                         // Keep what the file holds, or start it empty
+    };
+
+    struct FlightRecorderDesc {
+        uint32_t recordCount = 4096;                // Rounded up to a power of two
+        LogLevel level = LogLevel::Debug;           // Recorded whatever the level set with SetLevel
+        std::string dumpPath = "flight_recorder.log";
+        bool installSignalHandlers = true;          // Dump on SIGSEGV and SIGABRT, stack overflows
+                                                    // included on the thread that starts the recorder
+    };
+
+    class LogRingBuffer;
+    class LogFileSink;
+
     class Log {
     public:
-        static Log& GetInstance();
+        // Inline, so the RLOG_* level check does not call into the library
+        static Log& GetInstance() {
+            static Log instance;
+            return instance;
+        }
+
+        // Longest message, longer ones are cut
+        static constexpr uint32_t MessageCapacity = 4096;
 
         // Delete copy constructor and assignment operator
         Log(const Log&) = delete;
         Log& operator=(const Log&) = delete;
 
         // Core logging methods with string input
-        void LogMessage(LogLevel level, const std::string& message);
+        void LogMessage(LogLevel level, std::string_view message);
 
         // Convenience methods for different log levels (string version)
         void Trace(const std::string& message);
@@ -40,67 +121,214 @@ namespace Reality {
         void Error(const std::string& message);
         void Fatal(const std::string& message);
 
-        // Convenience methods for different log levels (formatted version)
+        // Formatted message with the format checked against args at compile
+        // time. The RLOG_* macros log through this.
+        template<typename... Args>
+        void Write(LogLevel level, LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+            LogFormatted(level, format.Get(), args...);
+        }
+
+        // Structured record: message followed by key/value fields, which the
+        // console and file print as " key=value" and the JSON sink as
+        // properties. The RLOG_FIELDS macro logs through this.
+        template<typename... Fields>
+        void WriteFields(LogLevel level, std::string_view message, const LogField<Fields>&... fields);
+
+        // Convenience methods for different log levels (formatted version).
+        // Formats are checked like Write's, and only constants convert, so
+        // deferred records never point at a temporary.
         template<typename... Args>
-        void Trace(const char* format, Args&&... args);
+        void Trace(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         template<typename... Args>
-        void Debug(const char* format, Args&&... args);
+        void Debug(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         template<typename... Args>
-        void Info(const char* format, Args&&... args);
+        void Info(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         template<typename... Args>
-        void Warning(const char* format, Args&&... args);
+        void Warning(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         template<typename... Args>
-        void Error(const char* format, Args&&... args);
+        void Error(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         template<typename... Args>
-        void Fatal(const char* format, Args&&... args);
+        void Fatal(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args);
 
         // Configuration methods
         void SetLevel(LogLevel level);
+        // True if the console, the file or the flight recorder takes level
+        [[nodiscard]] bool IsEnabled(LogLevel level) const { return level >= m_enabledLevel.load(std::memory_order_relaxed); }
+
+        // Each RLOG_* call site logs at most messages times per intervalMs,
+        // Fatal excepted. 0 messages turns the limit off.
+        void SetRateLimit(uint32_t messages, uint32_t intervalMs);
+        [[nodiscard]] uint32_t GetRateLimitMessages() const { return m_rateLimitMessages.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint32_t GetRateLimitInterval() const { return m_rateLimitIntervalMs.load(std::memory_order_relaxed); }
+
+        // Logged by a rate limited call site before its next message
+        void ReportSuppressed(LogLevel level, const char* file, int line, uint64_t count);
+
+        // Rate limited call site that suppressed a message. If it does not
+        // log again, its count is reported once its window ends, checked
+        // when messages are written and by the asynchronous sink, or by
+        // Flush and StopAsync.
+        void AddSuppressedSite(LogRateLimiter& limiter, LogLevel level, const char* file, int line, uint32_t intervalMs);
         void EnableConsoleOutput(bool enabled);
         void EnableFileOutput(bool enabled);
         void SetLogFile(const std::string& filename);
+        void SetLogFile(const LogFileDesc& desc);
         void EnableColors(bool enabled);
 
+        // Frame number records carry, Timer::Update sets it
+        void SetFrame(uint64_t frame) { m_frame.store(frame, std::memory_order_relaxed); }
+
+        // Asynchronous mode: logging threads copy messages into a lock-free
+        // ring buffer and return, a sink thread formats and writes them in
+        // batches. Fatal messages and StopAsync wait until everything logged
+        // before them is written. Call both while no other thread logs.
+        void StartAsync(const LogAsyncDesc& desc = LogAsyncDesc());
+        void StopAsync();
+        [[nodiscard]] bool IsAsync() const { return m_async.load(std::memory_order_acquire); }
+
+        // Returns once every message logged before the call is written, and
+        // the log file has written its buffer
+        void Flush();
+
+        // Messages discarded by the Drop and Count policies
+        [[nodiscard]] uint64_t GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+        // Flight recorder: the last desc.recordCount messages at or above
+        // desc.level, and the events of FlightRecorder::RecordEvent, kept in
+        // memory even when the console and the file filter them out. Written
+        // to desc.dumpPath on Fatal messages, on crashes and by
+        // DumpFlightRecorder. Call Start and Stop while no other thread logs.
+        void StartFlightRecorder(const FlightRecorderDesc& desc = FlightRecorderDesc());
+        void StopFlightRecorder();
+        void DumpFlightRecorder();
+
         // Helper methods
         [[nodiscard]] static std::string GetLevelString(LogLevel level);
+        [[nodiscard]] static const char* GetLevelName(LogLevel level);
         [[nodiscard]] static std::string GetTimestamp();
 
+        // "[timestamp] [LEVEL] message", in a buffer of the calling thread that
+        // the next call reuses
+        static std::string_view FormatLine(std::chrono::system_clock::time_point time, LogLevel level, std::string_view message);
+
+        // JSON line of a record, in another buffer of the calling thread.
+        // fields are encoded with EncodeLogFields.
+        static std::string_view FormatJsonLine(std::chrono::system_clock::time_point time, LogLevel level, uint64_t frame,
+                                               uint32_t thread, std::string_view message, const uint8_t* fields,
+                                               uint32_t fieldsSize);
+
     private:
+        // Fixed part of an asynchronous record, followed by the payload
+        struct RecordHeader {
+            std::chrono::system_clock::rep time;
+            const char* format;         // Null for plain text
+            uint64_t frame;
+            uint32_t thread;
+            uint32_t fieldOffset;       // Start of the fields in the payload
+            LogLevel level;
+        };
+
         Log();
         ~Log();
 
         // Platform-specific initialization
         void InitializeConsole();
 
-        // Output methods
-        void WriteToConsole(LogLevel level, const std::string& message) const;
-        void WriteToFile(LogLevel level, const std::string& message);
+        // Output methods. FlushOutputs flushes the console, and the log file
+        // once its flush interval has passed.
+        void WriteLine(LogLevel level, std::string_view line);
+        void WriteToConsole(LogLevel level, std::string_view message) const;
+        void WriteToFile(LogLevel level, std::string_view message);
+        void FlushOutputs();
+
+        // LogMessage past the flight recorder
+        void WriteMessage(LogLevel level, std::string_view message);
+
+        // Writes the suppressed counts of sites whose window has ended, or
+        // of every site if all is set. Returns true if any was written.
+        // Needs m_mutex.
+        bool WriteSuppressedSites(bool all);
+
+        // WriteFields with the record encoded, text up to fieldOffset
+        void WriteStructured(LogLevel level, const uint8_t* payload, uint32_t fieldOffset, uint32_t size);
+        void UpdateEnabledLevel();
+
+        static std::string FormatTimestamp(std::chrono::system_clock::time_point time);
+
+        // Formats, or defers the formatting to the sink thread
+        template<typename... Args>
+        void LogFormatted(LogLevel level, const char* format, const Args&... args);
+
+        // Asynchronous mode. Records without a format hold the message text,
+        // the others the encoded arguments, either followed by the encoded
+        // fields from fieldOffset.
+        void PushRecord(LogLevel level, const char* format, const void* payload, uint32_t size, uint32_t fieldOffset);
+        void WakeSink();
+        void SinkLoop();
+        void WriteRecord(const RecordHeader& header, const uint8_t* payload, uint32_t size);
+        void WriteBinaryRecord(const RecordHeader& header, const uint8_t* payload, uint32_t size);
 
         // Color handling
         void SetConsoleColor(LogLevel level) const;
         void ResetConsoleColor() const;
 
-        // Formatting helper
-        static std::string FormatString(const char* format, va_list args);
-
-        // Template formatting helper
-        template<typename... Args>
-        static std::string FormatString(const char* format, Args&&... args);
+        // MessageCapacity bytes owned by the calling thread, so formatting
+        // does not allocate
+        static char* GetMessageBuffer();
 
         // Member variables
-        LogLevel m_currentLevel;
+        std::atomic<LogLevel> m_currentLevel;
+        std::atomic<LogLevel> m_enabledLevel;           // Lower of m_currentLevel and m_recordLevel
+        std::atomic<uint32_t> m_rateLimitMessages{20};
+        std::atomic<uint32_t> m_rateLimitIntervalMs{1000};
+        std::atomic<uint64_t> m_frame{0};
         bool m_consoleEnabled;
         bool m_fileEnabled;
         bool m_colorsEnabled;
-        std::string m_logFilename;
-        std::ofstream m_logFile;
+        LogFileDesc m_fileDesc;
+        std::unique_ptr<LogFileSink> m_fileSink;
         std::mutex m_mutex;
 
+        // Asynchronous mode. The sink thread holds m_mutex while it writes a
+        // batch, and sleeps and signals flushes on m_sinkMutex.
+        std::unique_ptr<LogRingBuffer> m_ring;
+        std::thread m_sinkThread;
+        LogOverflowPolicy m_overflowPolicy = LogOverflowPolicy::Block;
+        std::atomic<bool> m_async{false};
+        std::atomic<bool> m_deferFormatting{false};
+        std::mutex m_sinkMutex;
+        std::condition_variable m_sinkCondition;
+        std::condition_variable m_flushCondition;
+        bool m_sinkRunning = false;
+        std::atomic<bool> m_sinkSleeping{false};
+        std::atomic<uint64_t> m_writtenPosition{0};     // Ring position the sink has written up to
+        std::atomic<uint64_t> m_droppedCount{0};
+
+        // Sink thread only, Flush also writes out the JSON file under m_mutex
+        std::unique_ptr<LogFileSink> m_jsonSink;
+        std::ofstream m_binaryFile;
+        std::unordered_set<const char*> m_binaryFormats;       // Formats already in m_binaryFile
+
+        std::unique_ptr<FlightRecorder> m_recorder;
+        LogLevel m_recordLevel = LogLevel::Fatal;
+
+        // Rate limited call sites with suppressed messages not yet reported
+        struct SuppressedSite {
+            LogRateLimiter* limiter;
+            LogLevel level;
+            const char* file;
+            int line;
+            uint32_t intervalMs;
+        };
+        std::mutex m_suppressedMutex;
+        std::vector<SuppressedSite> m_suppressedSites;
+        std::atomic<bool> m_hasSuppressedSites{false};
+
 #ifdef _WIN32
         HANDLE m_consoleHandle{};
         WORD m_defaultConsoleAttributes{};
@@ -109,63 +337,127 @@ namespace Reality {
 
     // Template definitions must be in the header
     template<typename... Args>
-    std::string Log::FormatString(const char* format, Args&&... args) {
-        // Calculate required buffer size
-        std::string::size_type size = snprintf(nullptr, 0, format, args...);
-        if (size <= 0) {
-            return "";
+    void Log::LogFormatted(const LogLevel level, const char* format, const Args&... args) {
+        if (!IsEnabled(level)) {
+            return;
         }
 
-        // Allocate buffer with space for null terminator
-        std::vector<char> buffer(size + 1);
+        if (m_recorder && level >= m_recordLevel) {
+            m_recorder->Record(level, format, args...);
+        }
+        if (level < m_currentLevel.load(std::memory_order_relaxed)) {
+            return;
+        }
 
-        // Format the string
-        snprintf(buffer.data(), buffer.size(), format, args...);
+        if (m_deferFormatting.load(std::memory_order_relaxed)) {
+            if constexpr (sizeof...(Args) == 0) {
+                PushRecord(level, format, nullptr, 0, 0);
+            } else {
+                // Arguments beyond this are dropped, see EncodeLogArguments
+                uint8_t arguments[512];
+                const uint32_t size = EncodeLogArguments(arguments, sizeof(arguments), args...);
+                PushRecord(level, format, arguments, size, size);
+            }
+            if (level == LogLevel::Fatal) {
+                Flush();
+                DumpFlightRecorder();
+            }
+            return;
+        }
+
+        char* message = GetMessageBuffer();
+        const int size = stbsp_snprintf(message, MessageCapacity, format, Detail::ToPrintfArgument(args)...);
+        WriteMessage(level, std::string_view(message, std::min<uint32_t>(size, MessageCapacity - 1)));
+    }
+
+    template<typename... Fields>
+    void Log::WriteFields(const LogLevel level, const std::string_view message, const LogField<Fields>&... fields) {
+        if (!IsEnabled(level)) {
+            return;
+        }
 
-        return {buffer.data(), size};
+        // Longer messages are cut, fields past the end are dropped
+        uint8_t payload[1024];
+        const uint32_t textSize = static_cast<uint32_t>(std::min<size_t>(message.size(), sizeof(payload) / 2));
+        memcpy(payload, message.data(), textSize);
+        const uint32_t size = textSize + EncodeLogFields(payload + textSize, sizeof(payload) - textSize, fields...);
+        WriteStructured(level, payload, textSize, size);
     }
 
     template<typename... Args>
-    void Log::Trace(const char* format, Args&&... args) {
-        const std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Trace, message);
+    void Log::Trace(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Trace, format.Get(), args...);
     }
 
     template<typename... Args>
-    void Log::Debug(const char* format, Args&&... args) {
-        const std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Debug, message);
+    void Log::Debug(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Debug, format.Get(), args...);
     }
 
     template<typename... Args>
-    void Log::Info(const char* format, Args&&... args) {
-        const std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Info, message);
+    void Log::Info(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Info, format.Get(), args...);
     }
 
     template<typename... Args>
-    void Log::Warning(const char* format, Args&&... args) {
-        std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Warning, message);
+    void Log::Warning(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Warning, format.Get(), args...);
     }
 
     template<typename... Args>
-    void Log::Error(const char* format, Args&&... args) {
-        const std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Error, message);
+    void Log::Error(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Error, format.Get(), args...);
     }
 
     template<typename... Args>
-    void Log::Fatal(const char* format, Args&&... args) {
-        const std::string message = FormatString(format, std::forward<Args>(args)...);
-        LogMessage(LogLevel::Fatal, message);
+    void Log::Fatal(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+        LogFormatted(LogLevel::Fatal, format.Get(), args...);
     }
 
-    // Convenience macros for logging
-    #define RLOG_TRACE(...) Reality::Log::GetInstance().Trace(__VA_ARGS__)
-    #define RLOG_DEBUG(...) Reality::Log::GetInstance().Debug(__VA_ARGS__)
-    #define RLOG_INFO(...) Reality::Log::GetInstance().Info(__VA_ARGS__)
-    #define RLOG_WARNING(...) Reality::Log::GetInstance().Warning(__VA_ARGS__)
-    #define RLOG_ERROR(...) Reality::Log::GetInstance().Error(__VA_ARGS__)
-    #define RLOG_FATAL(...) Reality::Log::GetInstance().Fatal(__VA_ARGS__)
+    // Convenience macros for logging. The first argument is a printf format
+    // literal, checked against the rest at compile time. Levels below
+    // REALITY_LOG_MIN_LEVEL compile to nothing, and the arguments of
+    // messages below the runtime level are not evaluated. Each call site is
+    // rate limited, RLOG_AT_RATE sets its own limit instead of the one from
+    // Log::SetRateLimit.
+    #define RLOG_DETAIL_AT_RATE(level, messages, intervalMs, method, ...) \
+        do { \
+            if constexpr (static_cast<int>(level) >= REALITY_LOG_MIN_LEVEL) { \
+                Reality::Log& rlogLog = Reality::Log::GetInstance(); \
+                if (rlogLog.IsEnabled(level)) { \
+                    static Reality::LogRateLimiter rlogLimiter; \
+                    uint64_t rlogSuppressed = 0; \
+                    const uint32_t rlogInterval = (intervalMs); \
+                    if ((level) == Reality::LogLevel::Fatal || rlogLimiter.Allow(messages, rlogInterval, rlogSuppressed)) { \
+                        if (rlogSuppressed != 0) { \
+                            rlogLog.ReportSuppressed(level, __FILE__, __LINE__, rlogSuppressed); \
+                        } \
+                        rlogLog.method(level, __VA_ARGS__); \
+                    } else if (rlogLimiter.MarkPending()) { \
+                        rlogLog.AddSuppressedSite(rlogLimiter, level, __FILE__, __LINE__, rlogInterval); \
+                    } \
+                } \
+            } \
+        } while (false)
+
+    #define RLOG_AT_RATE(level, messages, intervalMs, ...) \
+        RLOG_DETAIL_AT_RATE(level, messages, intervalMs, Write, __VA_ARGS__)
+
+    #define RLOG_AT(level, ...) \
+        RLOG_AT_RATE(level, Reality::Log::GetInstance().GetRateLimitMessages(), \
+                     Reality::Log::GetInstance().GetRateLimitInterval(), __VA_ARGS__)
+
+    #define RLOG_TRACE(...) RLOG_AT(Reality::LogLevel::Trace, __VA_ARGS__)
+    #define RLOG_DEBUG(...) RLOG_AT(Reality::LogLevel::Debug, __VA_ARGS__)
+    #define RLOG_INFO(...) RLOG_AT(Reality::LogLevel::Info, __VA_ARGS__)
+    #define RLOG_WARNING(...) RLOG_AT(Reality::LogLevel::Warning, __VA_ARGS__)
+    #define RLOG_ERROR(...) RLOG_AT(Reality::LogLevel::Error, __VA_ARGS__)
+    #define RLOG_FATAL(...) RLOG_AT(Reality::LogLevel::Fatal, __VA_ARGS__)
+
+    // Structured record, rate limited like the others:
+    //   RLOG_FIELDS(Reality::LogLevel::Info, "Frame submitted",
+    //               Reality::LogField("subsystem", "Render"), Reality::LogField("duration", milliseconds));
+    #define RLOG_FIELDS(level, ...) \
+        RLOG_DETAIL_AT_RATE(level, Reality::Log::GetInstance().GetRateLimitMessages(), \
+                            Reality::Log::GetInstance().GetRateLimitInterval(), WriteFields, __VA_ARGS__)
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+﻿#include "LogFileSink.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace Reality {
+    namespace {
+        // Page size full chunks are aligned to
+        constexpr uint64_t ChunkAlignment = 4096;
+    }
+
+    LogFileSink::~LogFileSink() {
+        Close();
+    }
+
+    bool LogFileSink::Open(const LogFileDesc& desc) {
+        Close();
+        m_desc = desc;
+        m_desc.bufferSize = std::max(desc.bufferSize, 4096u);
+        m_buffer = std::make_unique_for_overwrite<char[]>(m_desc.bufferSize);
+        m_used = 0;
+        return OpenFile(m_desc.append);
+    }
+
+    void LogFileSink::Close() {
+        m_failed = false;
+        if (!m_file) {
+            return;
+        }
+        WriteBuffer();
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool LogFileSink::OpenFile(const bool append) {
+        std::error_code error;
+        const uintmax_t size = std::filesystem::file_size(m_desc.path, error);
+        m_fileSize = error || !append ? 0 : size;
+        m_fileOffset = m_fileSize;
+
+        m_file = fopen(m_desc.path.c_str(), append ? "ab" : "wb");
+        if (!m_file) {
+            // Reported once, Reopen retries quietly
+            if (!m_failed) {
+                fprintf(stderr, "Log: cannot open %s, retrying every %u ms\n", m_desc.path.c_str(), m_desc.flushIntervalMs);
+                m_failed = true;
+            }
+            m_nextAttempt = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_desc.flushIntervalMs);
+            return false;
+        }
+        m_failed = false;
+
+        // Chunks go straight to the system, stdio would copy them again
+        setvbuf(m_file, nullptr, _IONBF, 0);
+
+        if (m_desc.rotateDaily) {
+            m_nextRotation = GetNextMidnight(std::time(nullptr));
+        }
+        return true;
+    }
+
+    bool LogFileSink::Reopen() {
+        if (m_file || !m_failed) {
+            return m_file != nullptr;
+        }
+        if (std::chrono::steady_clock::now() < m_nextAttempt) {
+            return false;
+        }
+        return OpenFile();
+    }
+
+    void LogFileSink::Write(const LogLevel level, std::string_view line) {
+        if (!m_file) {
+            return;
+        }
+
+        // Rotation keeps lines whole, a line never spans two files
+        const uint64_t lineSize = line.size() + 1;
+        if ((m_desc.maxFileSize != 0 && m_fileSize != 0 && m_fileSize + lineSize > m_desc.maxFileSize) ||
+            (m_desc.rotateDaily && std::time(nullptr) >= m_nextRotation)) {
+            Rotate();
+            if (!m_file) {
+                return;
+            }
+        }
+
+        if (m_used == 0) {
+            m_pendingSince = std::chrono::steady_clock::now();
+        }
+
+        // Lines continue in the next chunk
+        const char newline = '\n';
+        for (std::string_view part : { line, std::string_view(&newline, 1) }) {
+            while (!part.empty()) {
+                const uint32_t size = static_cast<uint32_t>(std::min<size_t>(part.size(), m_desc.bufferSize - m_used));
+                memcpy(m_buffer.get() + m_used, part.data(), size);
+                m_used += size;
+                part.remove_prefix(size);
+                if (m_used == m_desc.bufferSize) {
+                    WriteBuffer(true);
+                }
+            }
+        }
+        m_fileSize += lineSize;
+
+        if (level >= m_desc.flushLevel) {
+            WriteBuffer();
+        }
+    }
+
+    void LogFileSink::FlushIfDue() {
+        if (m_used != 0 &&
+            std::chrono::steady_clock::now() - m_pendingSince >= std::chrono::milliseconds(m_desc.flushIntervalMs)) {
+            WriteBuffer();
+        }
+    }
+
+    void LogFileSink::Flush() {
+        WriteBuffer();
+    }
+
+    void LogFileSink::WriteBuffer(const bool aligned) {
+        if (m_used == 0 || !m_file) {
+            return;
+        }
+        // Bytes past the last page boundary wait for the next chunk. The buffer
+        // is at least a page, so some of it is always written.
+        const uint32_t tail = aligned ? static_cast<uint32_t>((m_fileOffset + m_used) % ChunkAlignment) : 0;
+        const uint32_t size = tail < m_used ? m_used - tail : m_used;
+        fwrite(m_buffer.get(), 1, size, m_file);
+        m_fileOffset += size;
+        memmove(m_buffer.get(), m_buffer.get() + size, m_used - size);
+        m_used -= size;
+        m_pendingSince = std::chrono::steady_clock::now();
+    }
+
+    void LogFileSink::Rotate() {
+        WriteBuffer();
+        fclose(m_file);
+        m_file = nullptr;
+
+        // engine.log -> engine.1.log -> engine.2.log, the last one is deleted
+        std::error_code error;
+        if (m_desc.maxFiles == 0) {
+            std::filesystem::remove(m_desc.path, error);
+        } else {
+            std::filesystem::remove(GetRotatedPath(m_desc.maxFiles), error);
+            for (uint32_t index = m_desc.maxFiles; index > 1; index--) {
+                std::filesystem::rename(GetRotatedPath(index - 1), GetRotatedPath(index), error);
+            }
+            std::filesystem::rename(m_desc.path, GetRotatedPath(1), error);
+        }
+
+        OpenFile();
+    }
+
+    std::string LogFileSink::GetRotatedPath(const uint32_t index) const {
+        const std::filesystem::path path(m_desc.path);
+        std::filesystem::path rotated = path;
+        rotated.replace_filename(path.stem().string() + "." + std::to_string(index) + path.extension().string());
+        return rotated.string();
+    }
+
+    std::time_t LogFileSink::GetNextMidnight(const std::time_t time) {
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &time);
+#else
+        localtime_r(&time, &local);
+#endif
+        local.tm_mday++;
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+        return std::mktime(&local);
+    }
+}
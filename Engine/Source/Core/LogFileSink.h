@@ -0,0 +1,63 @@
+﻿#pragma once
+#include "Log.h"
+#include <cstdio>
+#include <ctime>
+
+namespace Reality {
+    // Log file that collects lines in memory and writes them in buffer-size
+    // chunks, so a write reaches the system once per chunk rather than once
+    // per line. A full buffer is written up to the last 4 KiB boundary of the
+    // file, the rest kept for the next chunk, so chunks cover whole pages.
+    // Buffered lines are written when the buffer fills, when they
+    // are older than the flush interval or when an urgent line arrives.
+    // Rotated files are numbered, engine.log becomes engine.1.log and so on.
+    // A file that fails to open is reported once on stderr, see Reopen.
+    class LogFileSink {
+    public:
+        LogFileSink() = default;
+        ~LogFileSink();
+
+        LogFileSink(const LogFileSink&) = delete;
+        LogFileSink& operator=(const LogFileSink&) = delete;
+
+        // Appends to desc.path, or empties it first if desc.append is off.
+        // False if it cannot be opened.
+        bool Open(const LogFileDesc& desc);
+        void Close();
+        [[nodiscard]] bool IsOpen() const { return m_file != nullptr; }
+
+        // Appends to the file again after Open or a rotation failed to open
+        // it, at most once per flush interval. False while it stays closed,
+        // and after Close.
+        bool Reopen();
+
+        // Buffers line and a newline. Lines at or above desc.flushLevel are
+        // written at once, together with everything buffered before them.
+        void Write(LogLevel level, std::string_view line);
+
+        // Writes buffered lines if the oldest has waited the flush interval
+        void FlushIfDue();
+
+        // Writes buffered lines
+        void Flush();
+
+    private:
+        // Writes the whole buffer, or only up to a page boundary of the file
+        void WriteBuffer(bool aligned = false);
+        void Rotate();
+        bool OpenFile(bool append = true);
+        std::string GetRotatedPath(uint32_t index) const;
+        static std::time_t GetNextMidnight(std::time_t time);
+
+        LogFileDesc m_desc;
+        FILE* m_file = nullptr;
+        std::unique_ptr<char[]> m_buffer;
+        uint32_t m_used = 0;
+        uint64_t m_fileSize = 0;                                    // Written and buffered bytes
+        uint64_t m_fileOffset = 0;                                  // Written bytes
+        std::chrono::steady_clock::time_point m_pendingSince;      // When the oldest buffered line arrived
+        std::time_t m_nextRotation = 0;                             // Local midnight, for daily rotation
+        bool m_failed = false;                                      // Closed because the file did not open
+        std::chrono::steady_clock::time_point m_nextAttempt;       // Earliest Reopen attempt
+    };
+}
@@ -0,0 +1,158 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Reality {
+    namespace Detail {
+        enum class LogArgumentKind : uint8_t {
+            Integer,
+            Floating,
+            String,
+            Pointer,
+            Other
+        };
+
+        // What printf receives for an argument, after the default promotions
+        struct LogArgumentInfo {
+            LogArgumentKind kind;
+            size_t size;
+        };
+
+        template<typename T>
+        consteval LogArgumentInfo GetLogArgumentInfo() {
+            using Type = std::decay_t<T>;
+            if constexpr (std::is_same_v<Type, char*> || std::is_same_v<Type, const char*>) {
+                return { LogArgumentKind::String, sizeof(Type) };
+            } else if constexpr (std::is_floating_point_v<Type> && !std::is_same_v<Type, long double>) {
+                return { LogArgumentKind::Floating, sizeof(double) };
+            } else if constexpr (std::is_enum_v<Type>) {
+                return GetLogArgumentInfo<std::underlying_type_t<Type>>();
+            } else if constexpr (std::is_integral_v<Type>) {
+                return { LogArgumentKind::Integer, sizeof(Type) < sizeof(int) ? sizeof(int) : sizeof(Type) };
+            } else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+                return { LogArgumentKind::Pointer, sizeof(void*) };
+            } else {
+                return { LogArgumentKind::Other, 0 };
+            }
+        }
+
+        // Scoped enums do not promote through varargs
+        template<typename T>
+        decltype(auto) ToPrintfArgument(const T& value) {
+            if constexpr (std::is_enum_v<T>) {
+                return static_cast<std::underlying_type_t<T>>(value);
+            } else {
+                return (value);
+            }
+        }
+
+        // Never defined. Reaching one while checking a format is the compile error.
+        void LogFormatHasTooFewArguments();
+        void LogFormatHasTooManyArguments();
+        void LogFormatArgumentDoesNotMatch();
+        void LogFormatConversionNotSupported();
+
+        constexpr bool IsLogFormatDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        // Matches each conversion of format against the next argument. Integer
+        // arguments must have the size the length modifier asks for, so every
+        // format that passes is safe to hand to stb_sprintf, which has no
+        // long double and no %F.
+        constexpr void CheckLogFormat(const char* format, const LogArgumentInfo* arguments, size_t count) {
+            size_t next = 0;
+            const auto take = [&](LogArgumentKind kind, size_t size) {
+                if (next == count) {
+                    LogFormatHasTooFewArguments();
+                }
+                const LogArgumentInfo& argument = arguments[next++];
+                if (argument.kind != kind || (size != 0 && argument.size != size)) {
+                    LogFormatArgumentDoesNotMatch();
+                }
+            };
+
+            for (const char* c = format; *c; c++) {
+                if (*c != '%') {
+                    continue;
+                }
+                if (*++c == '%') {
+                    continue;
+                }
+
+                while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') {
+                    c++;
+                }
+                for (int part = 0; part < 2; part++) {
+                    if (part == 1) {
+                        if (*c != '.') {
+                            break;
+                        }
+                        c++;
+                    }
+                    if (*c == '*') {
+                        take(LogArgumentKind::Integer, sizeof(int));
+                        c++;
+                    }
+                    while (IsLogFormatDigit(*c)) {
+                        c++;
+                    }
+                }
+
+                size_t size = sizeof(int);
+                switch (*c) {
+                    case 'h': c += c[1] == 'h' ? 2 : 1; break;
+                    case 'l': size = c[1] == 'l' ? sizeof(long long) : sizeof(long); c += c[1] == 'l' ? 2 : 1; break;
+                    case 'j': size = sizeof(intmax_t); c++; break;
+                    case 'z': size = sizeof(size_t); c++; break;
+                    case 't': size = sizeof(ptrdiff_t); c++; break;
+                    default: break;
+                }
+
+                switch (*c) {
+                    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                        take(LogArgumentKind::Integer, size);
+                        break;
+                    case 'c':
+                        take(LogArgumentKind::Integer, sizeof(int));
+                        break;
+                    case 'f': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                        take(LogArgumentKind::Floating, 0);
+                        break;
+                    case 's':
+                        take(LogArgumentKind::String, 0);
+                        break;
+                    case 'p':
+                        take(LogArgumentKind::Pointer, 0);
+                        break;
+                    default:
+                        // %n, %F, long double, wide characters and incomplete conversions
+                        LogFormatConversionNotSupported();
+                        return;
+                }
+            }
+
+            if (next != count) {
+                LogFormatHasTooManyArguments();
+            }
+        }
+    }
+
+    // A printf format checked against Args at compile time, the way
+    // std::format_string is. Only constant formats convert, which also
+    // keeps them alive for deferred formatting.
+    template<typename... Args>
+    class LogFormatString {
+    public:
+        consteval LogFormatString(const char* format) : m_format(format) {
+            constexpr Detail::LogArgumentInfo arguments[] = { Detail::GetLogArgumentInfo<Args>()..., { Detail::LogArgumentKind::Other, 0 } };
+            Detail::CheckLogFormat(format, arguments, sizeof...(Args));
+        }
+
+        [[nodiscard]] const char* Get() const { return m_format; }
+
+    private:
+        const char* m_format;
+    };
+}
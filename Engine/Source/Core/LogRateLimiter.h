@@ -0,0 +1,84 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Reality {
+    // Per call site state of the RLOG_* macros. A site may log messages
+    // times per window of intervalMs, further calls are counted and the
+    // count is handed to the site's next message, or reported by Log once
+    // the window ends if the site stays quiet. The window starts with its
+    // first message, and only calls past the limit read the clock. Calls
+    // past the limit only read the message count, so threads sharing a busy
+    // site do not all write it. Constant initialized, so a function-local
+    // static has no guard.
+    class LogRateLimiter {
+    public:
+        constexpr LogRateLimiter() = default;
+
+        LogRateLimiter(const LogRateLimiter&) = delete;
+        LogRateLimiter& operator=(const LogRateLimiter&) = delete;
+
+        // True if the call may log. suppressed is set to the calls dropped
+        // since the last one allowed. 0 messages lets everything through.
+        bool Allow(uint32_t messages, uint32_t intervalMs, uint64_t& suppressed) {
+            if (messages == 0) {
+                return true;
+            }
+            if (m_count.load(std::memory_order_relaxed) < messages) {
+                const uint64_t count = m_count.fetch_add(1, std::memory_order_relaxed);
+                if (count < messages) {
+                    if (count == 0) {
+                        m_windowStart.store(GetTime(), std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+            }
+            return AllowPastLimit(intervalMs, suppressed);
+        }
+
+        // After Allow returns false: true for the first of a run of
+        // suppressed calls, which hands the site to Log::AddSuppressedSite
+        bool MarkPending() {
+            return !m_pending.load(std::memory_order_relaxed) && !m_pending.exchange(true);
+        }
+
+        // For Log: takes the suppressed count once the window has ended,
+        // or at once if force is set. False if the window is still open.
+        bool TakePending(uint32_t intervalMs, bool force, uint64_t& suppressed) {
+            if (!force && GetTime() - m_windowStart.load(std::memory_order_relaxed) < intervalMs) {
+                return false;
+            }
+            // Cleared first, so calls suppressed from here on mark the site again
+            m_pending.store(false);
+            suppressed = m_suppressed.exchange(0);
+            return true;
+        }
+
+    private:
+        static int64_t GetTime() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        bool AllowPastLimit(uint32_t intervalMs, uint64_t& suppressed) {
+            // One caller starts the next window, the others are counted
+            const int64_t now = GetTime();
+            int64_t windowStart = m_windowStart.load(std::memory_order_relaxed);
+            if (now - windowStart >= intervalMs &&
+                m_windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+                m_count.store(1, std::memory_order_relaxed);
+                suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+                return true;
+            }
+            // Ordered against the m_pending load in MarkPending, see TakePending
+            m_suppressed.fetch_add(1);
+            return false;
+        }
+
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<int64_t> m_windowStart{0};
+        std::atomic<uint64_t> m_suppressed{0};
+        std::atomic<bool> m_pending{false};         // Registered with Log, not yet reported
+    };
+}
@@ -0,0 +1,392 @@
+﻿#include "LogRecord.h"
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <stb_sprintf.h>
+
+namespace Reality {
+    namespace {
+        struct LogArgument {
+            LogArgumentType type;
+            uint32_t size;          // Bytes the writer passed, 8 for all but integers
+            uint64_t bits;
+            std::string_view string;
+
+            [[nodiscard]] long long AsInt() const {
+                if (type == LogArgumentType::Double) {
+                    return static_cast<long long>(AsDouble());
+                }
+                return static_cast<long long>(bits);
+            }
+
+            // The integer read at the size it was passed with, the way
+            // printf reads it
+            [[nodiscard]] unsigned long long AsUnsigned() const {
+                const auto value = static_cast<unsigned long long>(AsInt());
+                return size < 8 ? value & ((1ull << size * 8) - 1) : value;
+            }
+
+            [[nodiscard]] long long AsSigned() const {
+                const uint32_t shift = 64 - 8 * size;
+                return static_cast<long long>(AsUnsigned() << shift) >> shift;
+            }
+
+            [[nodiscard]] double AsDouble() const {
+                if (type == LogArgumentType::Double) {
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    return value;
+                }
+                return type == LogArgumentType::Int ? static_cast<double>(static_cast<int64_t>(bits)) : static_cast<double>(bits);
+            }
+        };
+
+        class LogArgumentReader {
+        public:
+            LogArgumentReader(const uint8_t* data, uint32_t size) : m_cursor(data), m_end(data + size) {}
+
+            // Records may end mid-argument if they were cut short, which ends them
+            bool Read(LogArgument& argument) {
+                if (m_end - m_cursor < 1) {
+                    return false;
+                }
+                argument.type = static_cast<LogArgumentType>(*m_cursor & 0x0F);
+                argument.size = *m_cursor >> 4;
+                if (argument.size == 0 || argument.size > 8) {
+                    argument.size = 8;
+                }
+                if (argument.type == LogArgumentType::String) {
+                    uint32_t length;
+                    if (m_end - m_cursor < 5) {
+                        return false;
+                    }
+                    memcpy(&length, m_cursor + 1, sizeof(length));
+                    if (length > static_cast<size_t>(m_end - m_cursor - 5)) {
+                        return false;
+                    }
+                    argument.bits = 0;
+                    argument.string = std::string_view(reinterpret_cast<const char*>(m_cursor + 5), length);
+                    m_cursor += 5 + length;
+                    return true;
+                }
+                if (m_end - m_cursor < 9 || argument.type > LogArgumentType::Pointer) {
+                    return false;
+                }
+                memcpy(&argument.bits, m_cursor + 1, sizeof(argument.bits));
+                argument.string = {};
+                m_cursor += 9;
+                return true;
+            }
+
+        private:
+            const uint8_t* m_cursor;
+            const uint8_t* m_end;
+        };
+
+        // Fills a fixed buffer, and keeps room for its terminator. Text that
+        // does not fit is cut and marks the writer truncated.
+        class TextWriter {
+        public:
+            TextWriter(char* text, uint32_t capacity) : m_text(text), m_capacity(capacity) {}
+
+            void Append(std::string_view value) {
+                const uint32_t size = value.size() < GetRoom() ? static_cast<uint32_t>(value.size()) : GetRoom();
+                m_truncated |= size < value.size();
+                memcpy(m_text + m_length, value.data(), size);
+                m_length += size;
+            }
+
+            template<typename... Args>
+            void AppendFormatted(const char* specification, Args... args) {
+                const int size = stbsp_snprintf(m_text + m_length, static_cast<int>(m_capacity - m_length), specification, args...);
+                if (size > 0) {
+                    m_truncated |= static_cast<uint32_t>(size) > GetRoom();
+                    m_length += static_cast<uint32_t>(size) < GetRoom() ? static_cast<uint32_t>(size) : GetRoom();
+                }
+            }
+
+            // Always closed: a value that does not fit is cut before the
+            // first escape or UTF-8 character that would not fit whole.
+            // Nothing is written if the quotes do not fit.
+            void AppendJsonString(std::string_view value) {
+                if (GetRoom() < 2) {
+                    m_truncated = true;
+                    return;
+                }
+                m_text[m_length++] = '"';
+                const uint32_t limit = m_capacity - 2;      // Keeps room for the closing quote
+
+                for (size_t start = 0; start < value.size();) {
+                    size_t end = start;
+                    while (end < value.size() && value[end] != '"' && value[end] != '\\' &&
+                           static_cast<unsigned char>(value[end]) >= 0x20) {
+                        end++;
+                    }
+                    size_t run = end - start;
+                    if (run > limit - m_length) {
+                        run = limit - m_length;
+                        while (run > 0 && (static_cast<unsigned char>(value[start + run]) & 0xC0) == 0x80) {
+                            run--;
+                        }
+                        m_truncated = true;
+                    }
+                    memcpy(m_text + m_length, value.data() + start, run);
+                    m_length += static_cast<uint32_t>(run);
+                    if (m_truncated || end == value.size()) {
+                        break;
+                    }
+
+                    char escape[8];
+                    uint32_t size = 2;
+                    escape[0] = '\\';
+                    switch (value[end]) {
+                        case '"':  escape[1] = '"'; break;
+                        case '\\': escape[1] = '\\'; break;
+                        case '\n': escape[1] = 'n'; break;
+                        case '\r': escape[1] = 'r'; break;
+                        case '\t': escape[1] = 't'; break;
+                        default:   size = stbsp_snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(value[end])); break;
+                    }
+                    if (size > limit - m_length) {
+                        m_truncated = true;
+                        break;
+                    }
+                    memcpy(m_text + m_length, escape, size);
+                    m_length += size;
+                    start = end + 1;
+                }
+                m_text[m_length++] = '"';
+            }
+
+            [[nodiscard]] uint32_t GetLength() const { return m_length; }
+            [[nodiscard]] bool IsTruncated() const { return m_truncated; }
+
+            // Drops what was written past length
+            void Rewind(uint32_t length) {
+                m_length = length;
+            }
+
+            [[nodiscard]] uint32_t Finish() const {
+                m_text[m_length] = '\0';
+                return m_length;
+            }
+
+        private:
+            [[nodiscard]] uint32_t GetRoom() const { return m_capacity - 1 - m_length; }
+
+            char* m_text;
+            uint32_t m_capacity;
+            uint32_t m_length = 0;
+            bool m_truncated = false;
+        };
+    }
+
+    uint32_t GetLogThreadId() {
+        // Small ids are easier to follow than system thread ids
+        static std::atomic<uint32_t> nextThreadId{1};
+        thread_local const uint32_t t_threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return t_threadId;
+    }
+
+    uint32_t FormatLogArguments(char* text, uint32_t capacity, std::string_view format, const uint8_t* data, uint32_t size) {
+        assert(capacity > 0);
+        TextWriter writer(text, capacity);
+        LogArgumentReader reader(data, size);
+        LogArgument argument;
+
+        size_t i = 0;
+        while (i < format.size()) {
+            const size_t percent = format.find('%', i);
+            if (percent == std::string_view::npos) {
+                writer.Append(format.substr(i));
+                break;
+            }
+            writer.Append(format.substr(i, percent - i));
+            if (percent + 1 < format.size() && format[percent + 1] == '%') {
+                writer.Append("%");
+                i = percent + 2;
+                continue;
+            }
+
+            // %[flags][width][.precision][length]conversion. Starred widths
+            // are resolved into the specification, the length is replaced by
+            // the one matching the stored argument.
+            char specification[64] = "%";
+            size_t length = 1;
+            size_t precisionStart = 0;
+            int precision = -1;
+            bool missing = false;
+            size_t j = percent + 1;
+            while (j < format.size() && format[j] != '\0' && strchr("-+ #0", format[j]) && length < 8) {
+                specification[length++] = format[j++];
+            }
+            for (int part = 0; part < 2 && j < format.size(); part++) {
+                if (part == 1) {
+                    if (format[j] != '.') {
+                        break;
+                    }
+                    precisionStart = length;
+                    precision = 0;
+                    specification[length++] = format[j++];
+                }
+                int value = 0;
+                if (j < format.size() && format[j] == '*') {
+                    missing |= !reader.Read(argument);
+                    value = missing ? 0 : static_cast<int>(argument.AsInt());
+                    j++;
+                } else {
+                    for (uint32_t digits = 0; j < format.size() && format[j] >= '0' && format[j] <= '9' && digits < 9; digits++) {
+                        value = value * 10 + (format[j++] - '0');
+                    }
+                }
+                if (part == 1) {
+                    // A negative precision is taken as if it were omitted
+                    if (value < 0) {
+                        length = precisionStart;
+                        precisionStart = 0;
+                        precision = -1;
+                        break;
+                    }
+                    precision = value;
+                }
+                if (part == 1 || value != 0 || format[j - 1] == '*') {
+                    length += stbsp_snprintf(specification + length, 12, "%d", value);
+                }
+            }
+            // Checked formats have lengths matching the argument sizes, but
+            // for h and hh, which stb_sprintf ignores
+            while (j < format.size() && format[j] != '\0' && strchr("hlLqjzt", format[j])) {
+                j++;
+            }
+            if (j >= format.size()) {
+                writer.Append(format.substr(percent));
+                break;
+            }
+
+            const char conversion = format[j++];
+            missing |= !reader.Read(argument);
+            if (missing) {
+                writer.Append(format.substr(percent, j - percent));
+                i = j;
+                continue;
+            }
+
+            switch (conversion) {
+                case 'd':
+                case 'i':
+                    memcpy(specification + length, "lld", 4);
+                    writer.AppendFormatted(specification, argument.AsSigned());
+                    break;
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    specification[length] = 'l';
+                    specification[length + 1] = 'l';
+                    specification[length + 2] = conversion;
+                    specification[length + 3] = '\0';
+                    writer.AppendFormatted(specification, argument.AsUnsigned());
+                    break;
+                case 'c':
+                    memcpy(specification + length, "c", 2);
+                    writer.AppendFormatted(specification, static_cast<int>(argument.AsInt()));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    specification[length] = conversion == 'F' ? 'f' : conversion;
+                    specification[length + 1] = '\0';
+                    writer.AppendFormatted(specification, argument.AsDouble());
+                    break;
+                case 's': {
+                    // Stored strings are not terminated, the precision bounds them
+                    const int stringLength = static_cast<int>(argument.string.size());
+                    if (length == 1) {
+                        writer.Append(argument.string);
+                    } else {
+                        memcpy(specification + (precisionStart ? precisionStart : length), ".*s", 4);
+                        writer.AppendFormatted(specification, precision >= 0 && precision < stringLength ? precision : stringLength,
+                                               argument.string.data());
+                    }
+                    break;
+                }
+                case 'p':
+                    memcpy(specification + length, "p", 2);
+                    writer.AppendFormatted(specification, reinterpret_cast<const void*>(static_cast<uintptr_t>(argument.bits)));
+                    break;
+                default:
+                    // %n and unknown conversions print nothing but use their argument
+                    break;
+            }
+            i = j;
+        }
+        return writer.Finish();
+    }
+
+    uint32_t FormatLogFields(char* text, uint32_t capacity, const uint8_t* data, uint32_t size, const LogFieldStyle style) {
+        assert(capacity > 0);
+        TextWriter writer(text, capacity);
+        LogArgumentReader reader(data, size);
+        LogArgument key;
+        LogArgument value;
+        const bool json = style == LogFieldStyle::Json;
+        while (reader.Read(key) && key.type == LogArgumentType::String && reader.Read(value)) {
+            const uint32_t fieldStart = writer.GetLength();
+            if (json) {
+                writer.Append(",");
+                writer.AppendJsonString(key.string);
+                writer.Append(":");
+            } else {
+                writer.Append(" ");
+                writer.Append(key.string);
+                writer.Append("=");
+            }
+
+            switch (value.type) {
+                case LogArgumentType::Int:
+                    writer.AppendFormatted("%lld", static_cast<long long>(value.bits));
+                    break;
+                case LogArgumentType::UInt:
+                    writer.AppendFormatted("%llu", static_cast<unsigned long long>(value.bits));
+                    break;
+                case LogArgumentType::Double:
+                    // JSON has no NaN or infinity
+                    if (json && !std::isfinite(value.AsDouble())) {
+                        writer.Append("null");
+                    } else {
+                        writer.AppendFormatted("%.15g", value.AsDouble());
+                    }
+                    break;
+                case LogArgumentType::String:
+                    if (json) {
+                        writer.AppendJsonString(value.string);
+                    } else {
+                        writer.Append(value.string);
+                    }
+                    break;
+                case LogArgumentType::Pointer:
+                    writer.AppendFormatted(json ? "\"0x%llx\"" : "0x%llx", static_cast<unsigned long long>(value.bits));
+                    break;
+            }
+
+            // A JSON field that does not fit whole is dropped with the rest
+            if (json && writer.IsTruncated()) {
+                writer.Rewind(fieldStart);
+                break;
+            }
+        }
+        return writer.Finish();
+    }
+
+    uint32_t FormatLogJsonString(char* text, const uint32_t capacity, const std::string_view value) {
+        assert(capacity > 0);
+        TextWriter writer(text, capacity);
+        writer.AppendJsonString(value);
+        return writer.Finish();
+    }
+}
@@ -0,0 +1,141 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace Reality {
+    // Deferred log records keep the format string pointer and the raw
+    // arguments, each a type byte followed by its value. Strings are copied
+    // with a 32-bit length, everything else is widened to 8 bytes. Integers
+    // keep their size after promotion in the high four bits of the type
+    // byte, so unsigned conversions print them as immediate formatting does.
+    enum class LogArgumentType : uint8_t {
+        Int,
+        UInt,
+        Double,
+        String,
+        Pointer
+    };
+
+    // Binary log files start with LogFileMagic, then hold records that each
+    // start with a LogFileRecord byte. Values are in the writer's byte order.
+    //   Format:  uint64 id, uint32 length, characters
+    //   Message: int64 nanoseconds since epoch, uint8 level, uint64 frame,
+    //            uint32 thread, uint64 format id (0 for a plain text
+    //            message), uint32 size, uint32 field offset, then size bytes:
+    //            text or arguments up to the field offset, fields after it
+    // Each format is written once, before the first message that uses it.
+    inline constexpr char LogFileMagic[8] = { 'R', 'L', 'O', 'G', 'B', 'I', 'N', '3' };
+
+    enum class LogFileRecord : uint8_t {
+        Format,
+        Message
+    };
+
+    // Key/value pair of a structured record, see Log::WriteFields. Keys and
+    // values are encoded like arguments, a string key followed by the value.
+    template<typename T>
+    struct LogField {
+        LogField(const char* key, const T& value) : key(key), value(value) {}
+
+        const char* key;
+        const T& value;
+    };
+
+    enum class LogFieldStyle : uint8_t {
+        Text,           // " key=value"
+        Json            // ",\"key\":value", strings quoted and escaped
+    };
+
+    // Small number of the calling thread, assigned on its first record
+    uint32_t GetLogThreadId();
+
+    namespace Detail {
+        template<typename T>
+        inline constexpr bool IsLogArgument = false;
+
+        inline void EncodeLogValue(uint8_t*& cursor, uint8_t* end, LogArgumentType type, const void* value, uint8_t size = 8) {
+            // Arguments that do not fit end the record, the rest are dropped
+            if (end - cursor < 9) {
+                cursor = end;
+                return;
+            }
+            *cursor = static_cast<uint8_t>(static_cast<uint8_t>(type) | size << 4);
+            memcpy(cursor + 1, value, 8);
+            cursor += 9;
+        }
+
+        inline void EncodeLogString(uint8_t*& cursor, uint8_t* end, const char* value) {
+            if (end - cursor < 5) {
+                cursor = end;
+                return;
+            }
+            if (!value) {
+                value = "null";
+            }
+            const size_t length = strlen(value);
+            const uint32_t size = static_cast<uint32_t>(length < static_cast<size_t>(end - cursor - 5) ? length : end - cursor - 5);
+            *cursor = static_cast<uint8_t>(LogArgumentType::String);
+            memcpy(cursor + 1, &size, sizeof(size));
+            memcpy(cursor + 5, value, size);
+            cursor += 5 + size;
+        }
+
+        template<typename T>
+        void EncodeLogArgument(uint8_t*& cursor, uint8_t* end, const T& value) {
+            using Type = std::decay_t<T>;
+            if constexpr (std::is_same_v<Type, char*> || std::is_same_v<Type, const char*>) {
+                EncodeLogString(cursor, end, value);
+            } else if constexpr (std::is_floating_point_v<Type>) {
+                const double converted = static_cast<double>(value);
+                EncodeLogValue(cursor, end, LogArgumentType::Double, &converted);
+            } else if constexpr (std::is_enum_v<Type>) {
+                EncodeLogArgument(cursor, end, static_cast<std::underlying_type_t<Type>>(value));
+            } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+                const int64_t converted = value;
+                EncodeLogValue(cursor, end, LogArgumentType::Int, &converted, sizeof(Type) < sizeof(int) ? sizeof(int) : sizeof(Type));
+            } else if constexpr (std::is_integral_v<Type>) {
+                const uint64_t converted = value;
+                EncodeLogValue(cursor, end, LogArgumentType::UInt, &converted, sizeof(Type) < sizeof(int) ? sizeof(int) : sizeof(Type));
+            } else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+                const uint64_t converted = reinterpret_cast<uintptr_t>(static_cast<const void*>(value));
+                EncodeLogValue(cursor, end, LogArgumentType::Pointer, &converted);
+            } else {
+                static_assert(IsLogArgument<Type>, "Only printf argument types can be logged");
+            }
+        }
+    }
+
+    // Encodes args into data and returns the bytes used. Arguments past
+    // capacity are dropped, a string that does not fit is cut short.
+    template<typename... Args>
+    uint32_t EncodeLogArguments(uint8_t* data, uint32_t capacity, const Args&... args) {
+        uint8_t* cursor = data;
+        (Detail::EncodeLogArgument(cursor, data + capacity, args), ...);
+        return static_cast<uint32_t>(cursor - data);
+    }
+
+    template<typename... Fields>
+    uint32_t EncodeLogFields(uint8_t* data, uint32_t capacity, const LogField<Fields>&... fields) {
+        uint8_t* cursor = data;
+        ((Detail::EncodeLogString(cursor, data + capacity, fields.key), Detail::EncodeLogArgument(cursor, data + capacity, fields.value)), ...);
+        return static_cast<uint32_t>(cursor - data);
+    }
+
+    // Writes format expanded with the encoded arguments to text, as
+    // snprintf would, and returns the length. The result is cut to fit
+    // capacity, terminator included. Conversions without an argument are
+    // copied as is.
+    uint32_t FormatLogArguments(char* text, uint32_t capacity, std::string_view format, const uint8_t* data, uint32_t size);
+
+    // Writes the encoded fields to text in style and returns the length,
+    // cut to fit capacity like FormatLogArguments. JSON fields that do not
+    // fit whole are left out.
+    uint32_t FormatLogFields(char* text, uint32_t capacity, const uint8_t* data, uint32_t size, LogFieldStyle style);
+
+    // Writes value to text as a quoted JSON string and returns the length.
+    // A value that does not fit is cut at a whole escape or character and
+    // still closed.
+    uint32_t FormatLogJsonString(char* text, uint32_t capacity, std::string_view value);
+}
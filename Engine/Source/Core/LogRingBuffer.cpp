@@ -0,0 +1,112 @@
+﻿#include "LogRingBuffer.h"
+#include <cassert>
+#include <cstring>
+
+namespace Reality {
+    namespace {
+        // Records start with their size, so the consumer knows how many cells to take
+        using RecordSize = uint32_t;
+
+        constexpr uint32_t MinCellCount = 16;
+    }
+
+    LogRingBuffer::LogRingBuffer(uint32_t capacity) {
+        m_cellCount = MinCellCount;
+        while (static_cast<uint64_t>(m_cellCount) * CellSize < capacity) {
+            m_cellCount <<= 1;
+        }
+        m_mask = m_cellCount - 1;
+
+        // A quarter of the ring, so one large record cannot stall every producer
+        m_maxRecordSize = m_cellCount / 4 * CellSize - sizeof(RecordSize);
+
+        // Cell i is free for the record at position i on the first lap
+        m_sequences = std::make_unique<std::atomic<uint64_t>[]>(m_cellCount);
+        for (uint32_t i = 0; i < m_cellCount; i++) {
+            m_sequences[i].store(i, std::memory_order_relaxed);
+        }
+        m_data = std::make_unique_for_overwrite<uint8_t[]>(static_cast<size_t>(m_cellCount) * CellSize);
+    }
+
+    bool LogRingBuffer::TryPush(const void* header, uint32_t headerSize, const void* payload, uint32_t payloadSize) {
+        assert(headerSize + payloadSize <= m_maxRecordSize && "Record does not fit the ring");
+        const RecordSize size = sizeof(RecordSize) + headerSize + payloadSize;
+        const uint32_t cellCount = (size + CellSize - 1) / CellSize;
+
+        uint64_t position = m_writePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            // Every cell of the run must be free on this lap. An older sequence
+            // means the consumer has not reached it yet, a newer one that
+            // another producer claimed it since position was read.
+            int64_t difference = 0;
+            for (uint32_t i = 0; i < cellCount && difference == 0; i++) {
+                const uint64_t sequence = m_sequences[(position + i) & m_mask].load(std::memory_order_acquire);
+                difference = static_cast<int64_t>(sequence - (position + i));
+            }
+            if (difference < 0) {
+                return false;
+            }
+            if (difference > 0) {
+                position = m_writePosition.load(std::memory_order_relaxed);
+            } else if (m_writePosition.compare_exchange_weak(position, position + cellCount, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        CopyIn(position, reinterpret_cast<const uint8_t*>(&size), sizeof(size), 0);
+        CopyIn(position, static_cast<const uint8_t*>(header), headerSize, sizeof(size));
+        CopyIn(position, static_cast<const uint8_t*>(payload), payloadSize, sizeof(size) + headerSize);
+
+        // Publishing the first cell releases the whole record
+        m_sequences[position & m_mask].store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool LogRingBuffer::TryPop(std::vector<uint8_t>& record) {
+        const uint64_t position = m_readPosition.load(std::memory_order_relaxed);
+        if (m_sequences[position & m_mask].load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        RecordSize size;
+        CopyOut(position, reinterpret_cast<uint8_t*>(&size), sizeof(size), 0);
+        record.resize(size - sizeof(size));
+        CopyOut(position, record.data(), size - sizeof(size), sizeof(size));
+
+        // Free the cells for the producers of the next lap
+        const uint32_t cellCount = (size + CellSize - 1) / CellSize;
+        for (uint32_t i = 0; i < cellCount; i++) {
+            m_sequences[(position + i) & m_mask].store(position + i + m_cellCount, std::memory_order_release);
+        }
+        m_readPosition.store(position + cellCount, std::memory_order_release);
+        return true;
+    }
+
+    bool LogRingBuffer::IsEmpty() const {
+        const uint64_t position = m_readPosition.load(std::memory_order_relaxed);
+        return m_sequences[position & m_mask].load(std::memory_order_acquire) != position + 1;
+    }
+
+    // Records are contiguous bytes that may wrap around the end of the data
+    void LogRingBuffer::CopyIn(uint64_t position, const uint8_t* source, uint32_t size, uint32_t offset) {
+        if (size == 0) {
+            return;
+        }
+        const size_t dataSize = static_cast<size_t>(m_cellCount) * CellSize;
+        const size_t start = ((position & m_mask) * CellSize + offset) & (dataSize - 1);
+        const size_t first = size < dataSize - start ? size : dataSize - start;
+        memcpy(m_data.get() + start, source, first);
+        memcpy(m_data.get(), source + first, size - first);
+    }
+
+    void LogRingBuffer::CopyOut(uint64_t position, uint8_t* destination, uint32_t size, uint32_t offset) const {
+        if (size == 0) {
+            return;
+        }
+        const size_t dataSize = static_cast<size_t>(m_cellCount) * CellSize;
+        const size_t start = ((position & m_mask) * CellSize + offset) & (dataSize - 1);
+        const size_t first = size < dataSize - start ? size : dataSize - start;
+        memcpy(destination, m_data.get() + start, first);
+        memcpy(destination + first, m_data.get(), size - first);
+    }
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Reality {
+    // Bounded lock-free ring of variable-size records with any number of
+    // producers and a single consumer. Records occupy whole cells, and each
+    // cell carries a sequence number that tells whose turn it is: producers
+    // claim a run of free cells with one compare-and-swap on the write
+    // position, copy the record in and publish its first cell, the consumer
+    // copies it out and hands the cells back for the next lap.
+    class LogRingBuffer {
+    public:
+        static constexpr uint32_t CellSize = 64;
+
+        // capacity is in bytes, rounded up to a power of two number of cells
+        explicit LogRingBuffer(uint32_t capacity);
+
+        LogRingBuffer(const LogRingBuffer&) = delete;
+        LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+        // Any thread. Copies header then payload in as one record, fails if
+        // the ring has no room. Records are at most GetMaxRecordSize() bytes.
+        bool TryPush(const void* header, uint32_t headerSize, const void* payload, uint32_t payloadSize);
+
+        // Consumer thread only. Copies the oldest published record into record.
+        bool TryPop(std::vector<uint8_t>& record);
+
+        // Consumer thread only. True if no record is ready to pop.
+        [[nodiscard]] bool IsEmpty() const;
+
+        // Positions count cells since creation. Everything claimed before
+        // GetWritePosition() returned a value has been popped once
+        // GetReadPosition() reaches it.
+        [[nodiscard]] uint64_t GetWritePosition() const { return m_writePosition.load(std::memory_order_acquire); }
+        [[nodiscard]] uint64_t GetReadPosition() const { return m_readPosition.load(std::memory_order_acquire); }
+
+        [[nodiscard]] uint32_t GetMaxRecordSize() const { return m_maxRecordSize; }
+
+    private:
+        void CopyIn(uint64_t position, const uint8_t* source, uint32_t size, uint32_t offset);
+        void CopyOut(uint64_t position, uint8_t* destination, uint32_t size, uint32_t offset) const;
+
+        uint32_t m_cellCount = 0;
+        uint32_t m_mask = 0;
+        uint32_t m_maxRecordSize = 0;
+        std::unique_ptr<std::atomic<uint64_t>[]> m_sequences;
+        std::unique_ptr<uint8_t[]> m_data;
+
+        // Apart, so producers claiming cells do not slow the consumer down
+        alignas(64) std::atomic<uint64_t> m_writePosition{0};
+        alignas(64) std::atomic<uint64_t> m_readPosition{0};
+    };
+}
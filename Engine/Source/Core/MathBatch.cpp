@@ -0,0 +1,403 @@
+﻿#include "MathBatch.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Reality {
+    namespace {
+        // Every kernel runs a loop over full SIMD::FloatN registers, then
+        // finishes the remainder with scalar code
+#if defined(REALITY_SIMD_SSE)
+        using Lane = SIMD::FloatN;
+        constexpr size_t LaneWidth = SIMD::Width;
+
+        inline Lane LoadLane(const float* p) { return SIMD::LoadN(p); }
+        inline Lane SplatLane(float s) { return SIMD::SplatN(s); }
+
+        // Splatted rows of a matrix, loaded once per batch
+        struct MatrixLanes {
+            Lane m[3][4];
+
+            explicit MatrixLanes(const Matrix4x4& matrix) {
+                for (int r = 0; r < 3; r++) {
+                    for (int c = 0; c < 4; c++) {
+                        m[r][c] = SplatLane(matrix.m[r][c]);
+                    }
+                }
+            }
+        };
+#endif
+
+#if defined(REALITY_SIMD_SSE)
+        // Splatted frustum planes, |normal| gives the projected box radius
+        struct PlaneLanes {
+            Lane nx, ny, nz, d;
+            Lane ax, ay, az;
+        };
+
+        void LoadPlanes(const Frustum& frustum, PlaneLanes (&lanes)[Frustum::PlaneCount]) {
+            for (int p = 0; p < Frustum::PlaneCount; p++) {
+                const Plane& plane = frustum.planes[p];
+                lanes[p].nx = SplatLane(plane.normal.x);
+                lanes[p].ny = SplatLane(plane.normal.y);
+                lanes[p].nz = SplatLane(plane.normal.z);
+                lanes[p].d = SplatLane(plane.d);
+                lanes[p].ax = SplatLane(Abs(plane.normal.x));
+                lanes[p].ay = SplatLane(Abs(plane.normal.y));
+                lanes[p].az = SplatLane(Abs(plane.normal.z));
+            }
+        }
+
+        // Volumes tested per culling iteration: one AVX register or two SSE
+        // registers, interleaved so the plane tests of both overlap
+        constexpr uint32_t CullGroupSize = 8;
+        constexpr uint32_t CullGroupLanes = CullGroupSize / LaneWidth;
+
+        // Appends the volumes set in mask without branching on them. Every one
+        // is written, only the visible ones advance the output position.
+        inline uint32_t AppendVisible(uint32_t mask, uint32_t index, uint32_t* out, uint32_t visible) {
+            for (uint32_t k = 0; k < CullGroupSize; k++) {
+                out[visible] = index + k;
+                visible += (mask >> k) & 1u;
+            }
+            return visible;
+        }
+#endif
+
+        // Runs cullRange over grainSize ranges in parallel. Each range writes
+        // its indices at its own offset, then the ranges are packed in order.
+        template<typename CullRange>
+        uint32_t ParallelCull(uint32_t count, uint32_t grainSize, std::span<uint32_t> visibleIndices,
+                              const CullRange& cullRange) {
+            grainSize = std::max(grainSize, 1u);
+            const uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+            if (chunkCount <= 1) {
+                return cullRange(0, count, visibleIndices.data());
+            }
+
+            std::vector<uint32_t> chunkVisible(chunkCount);
+            JobSystem::GetInstance().ParallelFor(count, grainSize, [&](uint32_t begin, uint32_t end) {
+                chunkVisible[begin / grainSize] = cullRange(begin, end, visibleIndices.data() + begin);
+            });
+
+            uint32_t visible = chunkVisible[0];
+            for (uint32_t chunk = 1; chunk < chunkCount; chunk++) {
+                memmove(visibleIndices.data() + visible, visibleIndices.data() + chunk * grainSize,
+                        chunkVisible[chunk] * sizeof(uint32_t));
+                visible += chunkVisible[chunk];
+            }
+            return visible;
+        }
+
+        // out = m * (in, w) for the first three rows, written lane by lane so
+        // in-place calls read each element before overwriting it
+        void TransformStream(const Matrix4x4& m, ConstVector3Span in, Vector3Span out, bool translate) {
+            assert(in.size == out.size && "Batch streams must have the same size");
+            const size_t count = in.size;
+            const float w = translate ? 1.0f : 0.0f;
+            size_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+            const MatrixLanes lanes(m);
+            const Lane tx = SplatLane(m.m[0][3] * w);
+            const Lane ty = SplatLane(m.m[1][3] * w);
+            const Lane tz = SplatLane(m.m[2][3] * w);
+
+            for (; i + LaneWidth <= count; i += LaneWidth) {
+                const Lane x = LoadLane(in.x + i);
+                const Lane y = LoadLane(in.y + i);
+                const Lane z = LoadLane(in.z + i);
+
+                const Lane rx = SIMD::MulAdd(lanes.m[0][2], z, SIMD::MulAdd(lanes.m[0][1], y, SIMD::MulAdd(lanes.m[0][0], x, tx)));
+                const Lane ry = SIMD::MulAdd(lanes.m[1][2], z, SIMD::MulAdd(lanes.m[1][1], y, SIMD::MulAdd(lanes.m[1][0], x, ty)));
+                const Lane rz = SIMD::MulAdd(lanes.m[2][2], z, SIMD::MulAdd(lanes.m[2][1], y, SIMD::MulAdd(lanes.m[2][0], x, tz)));
+
+                SIMD::StoreUnaligned(out.x + i, rx);
+                SIMD::StoreUnaligned(out.y + i, ry);
+                SIMD::StoreUnaligned(out.z + i, rz);
+            }
+#endif
+
+            for (; i < count; i++) {
+                const float x = in.x[i];
+                const float y = in.y[i];
+                const float z = in.z[i];
+                out.x[i] = m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z + m.m[0][3] * w;
+                out.y[i] = m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z + m.m[1][3] * w;
+                out.z[i] = m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z + m.m[2][3] * w;
+            }
+        }
+    }
+
+    void TransformPoints(const Matrix4x4& m, ConstVector3Span in, Vector3Span out) {
+        TransformStream(m, in, out, true);
+    }
+
+    void TransformVectors(const Matrix4x4& m, ConstVector3Span in, Vector3Span out) {
+        TransformStream(m, in, out, false);
+    }
+
+    void TransformNormals(const Matrix3x3& normalMatrix, ConstVector3Span in, Vector3Span out) {
+        const Matrix3x3& n = normalMatrix;
+        const Matrix4x4 m(
+            n.m[0][0], n.m[0][1], n.m[0][2], 0.0f,
+            n.m[1][0], n.m[1][1], n.m[1][2], 0.0f,
+            n.m[2][0], n.m[2][1], n.m[2][2], 0.0f,
+            0.0f,      0.0f,      0.0f,      1.0f
+        );
+        TransformStream(m, in, out, false);
+        Normalize(out, out);
+    }
+
+    void TransformNormals(const Matrix4x4& m, ConstVector3Span in, Vector3Span out) {
+        TransformNormals(NormalMatrix(m), in, out);
+    }
+
+    void TransformPoints(ConstMatrix4x4Span matrices, ConstVector3Span in, Vector3Span out) {
+        assert(matrices.size == in.size && in.size == out.size && "Batch streams must have the same size");
+        const size_t count = in.size;
+        size_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        for (; i + LaneWidth <= count; i += LaneWidth) {
+            const Lane x = LoadLane(in.x + i);
+            const Lane y = LoadLane(in.y + i);
+            const Lane z = LoadLane(in.z + i);
+
+            Lane result[3];
+            for (int r = 0; r < 3; r++) {
+                const float* const* row = matrices.m + r * 4;
+                Lane value = LoadLane(row[3] + i);
+                value = SIMD::MulAdd(LoadLane(row[0] + i), x, value);
+                value = SIMD::MulAdd(LoadLane(row[1] + i), y, value);
+                result[r] = SIMD::MulAdd(LoadLane(row[2] + i), z, value);
+            }
+
+            SIMD::StoreUnaligned(out.x + i, result[0]);
+            SIMD::StoreUnaligned(out.y + i, result[1]);
+            SIMD::StoreUnaligned(out.z + i, result[2]);
+        }
+#endif
+
+        for (; i < count; i++) {
+            const float x = in.x[i];
+            const float y = in.y[i];
+            const float z = in.z[i];
+            float result[3];
+            for (int r = 0; r < 3; r++) {
+                const float* const* row = matrices.m + r * 4;
+                result[r] = row[0][i] * x + row[1][i] * y + row[2][i] * z + row[3][i];
+            }
+            out.x[i] = result[0];
+            out.y[i] = result[1];
+            out.z[i] = result[2];
+        }
+    }
+
+    void Normalize(ConstVector3Span in, Vector3Span out) {
+        assert(in.size == out.size && "Batch streams must have the same size");
+        const size_t count = in.size;
+        size_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        const Lane epsilon = SplatLane(EPSILON);
+        const Lane one = SplatLane(1.0f);
+
+        for (; i + LaneWidth <= count; i += LaneWidth) {
+            const Lane x = LoadLane(in.x + i);
+            const Lane y = LoadLane(in.y + i);
+            const Lane z = LoadLane(in.z + i);
+
+            const Lane len = SIMD::Sqrt(SIMD::MulAdd(z, z, SIMD::MulAdd(y, y, SIMD::Mul(x, x))));
+            // Vectors at or below EPSILON become zero, like Vector3::Normalized
+            const Lane valid = SIMD::Greater(len, epsilon);
+            const Lane invLen = SIMD::And(SIMD::Div(one, len), valid);
+
+            SIMD::StoreUnaligned(out.x + i, SIMD::Mul(x, invLen));
+            SIMD::StoreUnaligned(out.y + i, SIMD::Mul(y, invLen));
+            SIMD::StoreUnaligned(out.z + i, SIMD::Mul(z, invLen));
+        }
+#endif
+
+        for (; i < count; i++) {
+            const float x = in.x[i];
+            const float y = in.y[i];
+            const float z = in.z[i];
+            const float len = Sqrt(x * x + y * y + z * z);
+            const float invLen = len > EPSILON ? 1.0f / len : 0.0f;
+            out.x[i] = x * invLen;
+            out.y[i] = y * invLen;
+            out.z[i] = z * invLen;
+        }
+    }
+
+    void Dot(ConstVector3Span a, ConstVector3Span b, std::span<float> out) {
+        assert(a.size == b.size && a.size == out.size() && "Batch streams must have the same size");
+        const size_t count = a.size;
+        size_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        for (; i + LaneWidth <= count; i += LaneWidth) {
+            Lane dot = SIMD::Mul(LoadLane(a.x + i), LoadLane(b.x + i));
+            dot = SIMD::MulAdd(LoadLane(a.y + i), LoadLane(b.y + i), dot);
+            dot = SIMD::MulAdd(LoadLane(a.z + i), LoadLane(b.z + i), dot);
+            SIMD::StoreUnaligned(out.data() + i, dot);
+        }
+#endif
+
+        for (; i < count; i++) {
+            out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+        }
+    }
+
+    void Cross(ConstVector3Span a, ConstVector3Span b, Vector3Span out) {
+        assert(a.size == b.size && a.size == out.size && "Batch streams must have the same size");
+        const size_t count = a.size;
+        size_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        for (; i + LaneWidth <= count; i += LaneWidth) {
+            const Lane ax = LoadLane(a.x + i);
+            const Lane ay = LoadLane(a.y + i);
+            const Lane az = LoadLane(a.z + i);
+            const Lane bx = LoadLane(b.x + i);
+            const Lane by = LoadLane(b.y + i);
+            const Lane bz = LoadLane(b.z + i);
+
+            SIMD::StoreUnaligned(out.x + i, SIMD::Sub(SIMD::Mul(ay, bz), SIMD::Mul(az, by)));
+            SIMD::StoreUnaligned(out.y + i, SIMD::Sub(SIMD::Mul(az, bx), SIMD::Mul(ax, bz)));
+            SIMD::StoreUnaligned(out.z + i, SIMD::Sub(SIMD::Mul(ax, by), SIMD::Mul(ay, bx)));
+        }
+#endif
+
+        for (; i < count; i++) {
+            const float ax = a.x[i], ay = a.y[i], az = a.z[i];
+            const float bx = b.x[i], by = b.y[i], bz = b.z[i];
+            out.x[i] = ay * bz - az * by;
+            out.y[i] = az * bx - ax * bz;
+            out.z[i] = ax * by - ay * bx;
+        }
+    }
+
+    uint32_t CullBoxes(const Frustum& frustum, ConstVector3Span centers, ConstVector3Span extents,
+                       std::span<uint32_t> visibleIndices, uint32_t baseIndex) {
+        assert(centers.size == extents.size && visibleIndices.size() >= centers.size && "Batch streams must have the same size");
+        const uint32_t count = static_cast<uint32_t>(centers.size);
+        uint32_t* out = visibleIndices.data();
+        uint32_t visible = 0;
+        uint32_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        PlaneLanes planes[Frustum::PlaneCount];
+        LoadPlanes(frustum, planes);
+        const Lane zero = SplatLane(0.0f);
+
+        for (; i + CullGroupSize <= count; i += CullGroupSize) {
+            Lane cx[CullGroupLanes], cy[CullGroupLanes], cz[CullGroupLanes];
+            Lane ex[CullGroupLanes], ey[CullGroupLanes], ez[CullGroupLanes];
+            for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                const uint32_t offset = i + g * static_cast<uint32_t>(LaneWidth);
+                cx[g] = LoadLane(centers.x + offset);
+                cy[g] = LoadLane(centers.y + offset);
+                cz[g] = LoadLane(centers.z + offset);
+                ex[g] = LoadLane(extents.x + offset);
+                ey[g] = LoadLane(extents.y + offset);
+                ez[g] = LoadLane(extents.z + offset);
+            }
+
+            // Smallest distance + projected radius over all planes, negative when fully outside one
+            Lane margin[CullGroupLanes];
+            for (int p = 0; p < Frustum::PlaneCount; p++) {
+                const PlaneLanes& plane = planes[p];
+                for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                    const Lane distance = SIMD::MulAdd(plane.nz, cz[g], SIMD::MulAdd(plane.ny, cy[g], SIMD::MulAdd(plane.nx, cx[g], plane.d)));
+                    const Lane radius = SIMD::MulAdd(plane.az, ez[g], SIMD::MulAdd(plane.ay, ey[g], SIMD::Mul(plane.ax, ex[g])));
+                    const Lane planeMargin = SIMD::Add(distance, radius);
+                    margin[g] = p == 0 ? planeMargin : SIMD::Min(margin[g], planeMargin);
+                }
+            }
+
+            uint32_t mask = 0;
+            for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                mask |= static_cast<uint32_t>(SIMD::MoveMask(SIMD::GreaterEqual(margin[g], zero))) << (g * LaneWidth);
+            }
+            visible = AppendVisible(mask, baseIndex + i, out, visible);
+        }
+#endif
+
+        for (; i < count; i++) {
+            if (frustum.IntersectsCenterExtents(centers.Get(i), Vector3(extents.x[i], extents.y[i], extents.z[i]))) {
+                out[visible++] = baseIndex + i;
+            }
+        }
+        return visible;
+    }
+
+    uint32_t CullSpheres(const Frustum& frustum, ConstVector3Span centers, std::span<const float> radii,
+                         std::span<uint32_t> visibleIndices, uint32_t baseIndex) {
+        assert(centers.size == radii.size() && visibleIndices.size() >= centers.size && "Batch streams must have the same size");
+        const uint32_t count = static_cast<uint32_t>(centers.size);
+        uint32_t* out = visibleIndices.data();
+        uint32_t visible = 0;
+        uint32_t i = 0;
+
+#if defined(REALITY_SIMD_SSE)
+        PlaneLanes planes[Frustum::PlaneCount];
+        LoadPlanes(frustum, planes);
+
+        for (; i + CullGroupSize <= count; i += CullGroupSize) {
+            Lane cx[CullGroupLanes], cy[CullGroupLanes], cz[CullGroupLanes], negRadius[CullGroupLanes];
+            for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                const uint32_t offset = i + g * static_cast<uint32_t>(LaneWidth);
+                cx[g] = LoadLane(centers.x + offset);
+                cy[g] = LoadLane(centers.y + offset);
+                cz[g] = LoadLane(centers.z + offset);
+                negRadius[g] = SIMD::Negate(LoadLane(radii.data() + offset));
+            }
+
+            // Smallest plane distance, below -radius when fully outside one
+            Lane distance[CullGroupLanes];
+            for (int p = 0; p < Frustum::PlaneCount; p++) {
+                const PlaneLanes& plane = planes[p];
+                for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                    const Lane planeDistance = SIMD::MulAdd(plane.nz, cz[g], SIMD::MulAdd(plane.ny, cy[g], SIMD::MulAdd(plane.nx, cx[g], plane.d)));
+                    distance[g] = p == 0 ? planeDistance : SIMD::Min(distance[g], planeDistance);
+                }
+            }
+
+            uint32_t mask = 0;
+            for (uint32_t g = 0; g < CullGroupLanes; g++) {
+                mask |= static_cast<uint32_t>(SIMD::MoveMask(SIMD::GreaterEqual(distance[g], negRadius[g]))) << (g * LaneWidth);
+            }
+            visible = AppendVisible(mask, baseIndex + i, out, visible);
+        }
+#endif
+
+        for (; i < count; i++) {
+            if (frustum.Intersects(BoundingSphere(centers.Get(i), radii[i]))) {
+                out[visible++] = baseIndex + i;
+            }
+        }
+        return visible;
+    }
+
+    uint32_t ParallelCullBoxes(const Frustum& frustum, ConstVector3Span centers, ConstVector3Span extents,
+                               std::span<uint32_t> visibleIndices, uint32_t grainSize) {
+        assert(visibleIndices.size() >= centers.size && "Output must have room for every element");
+        return ParallelCull(static_cast<uint32_t>(centers.size), grainSize, visibleIndices,
+            [&](uint32_t begin, uint32_t end, uint32_t* out) {
+                return CullBoxes(frustum, centers.Subspan(begin, end - begin), extents.Subspan(begin, end - begin),
+                                 std::span<uint32_t>(out, end - begin), begin);
+            });
+    }
+
+    uint32_t ParallelCullSpheres(const Frustum& frustum, ConstVector3Span centers, std::span<const float> radii,
+                                 std::span<uint32_t> visibleIndices, uint32_t grainSize) {
+        assert(visibleIndices.size() >= centers.size && "Output must have room for every element");
+        return ParallelCull(static_cast<uint32_t>(centers.size), grainSize, visibleIndices,
+            [&](uint32_t begin, uint32_t end, uint32_t* out) {
+                return CullSpheres(frustum, centers.Subspan(begin, end - begin), radii.subspan(begin, end - begin),
+                                   std::span<uint32_t>(out, end - begin), begin);
+            });
+    }
+}
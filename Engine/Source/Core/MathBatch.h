@@ -0,0 +1,292 @@
+﻿#pragma once
+#include "MathF.h"
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace Reality {
+    // Allocator for storage that is loaded with the widest SIMD registers
+    template<typename T, size_t Alignment = 32>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T* pointer, size_t) {
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    };
+
+    template<typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+    // Non-owning view over structure-of-arrays Vector3 data. Subspan hands
+    // contiguous ranges to workers without copying.
+    struct Vector3Span {
+        float* x = nullptr;
+        float* y = nullptr;
+        float* z = nullptr;
+        size_t size = 0;
+
+        Vector3Span Subspan(size_t offset, size_t count) const {
+            assert(offset + count <= size);
+            return { x + offset, y + offset, z + offset, count };
+        }
+
+        Vector3 Get(size_t index) const { return Vector3(x[index], y[index], z[index]); }
+
+        void Set(size_t index, const Vector3& v) const {
+            x[index] = v.x;
+            y[index] = v.y;
+            z[index] = v.z;
+        }
+    };
+
+    struct ConstVector3Span {
+        const float* x = nullptr;
+        const float* y = nullptr;
+        const float* z = nullptr;
+        size_t size = 0;
+
+        ConstVector3Span() = default;
+        ConstVector3Span(const float* x, const float* y, const float* z, size_t size) : x(x), y(y), z(z), size(size) {}
+        ConstVector3Span(const Vector3Span& span) : x(span.x), y(span.y), z(span.z), size(span.size) {}
+
+        ConstVector3Span Subspan(size_t offset, size_t count) const {
+            assert(offset + count <= size);
+            return { x + offset, y + offset, z + offset, count };
+        }
+
+        Vector3 Get(size_t index) const { return Vector3(x[index], y[index], z[index]); }
+    };
+
+    // Vector3Stream - Vector3 array stored as separate x, y and z arrays, so
+    // batch kernels load 4 or 8 consecutive components per instruction
+    class Vector3Stream {
+    public:
+        Vector3Stream() = default;
+        explicit Vector3Stream(size_t count) { Resize(count); }
+        explicit Vector3Stream(std::span<const Vector3> values) { Assign(values); }
+
+        size_t Size() const { return m_x.size(); }
+        bool Empty() const { return m_x.empty(); }
+
+        void Resize(size_t count) {
+            m_x.resize(count);
+            m_y.resize(count);
+            m_z.resize(count);
+        }
+
+        void Reserve(size_t count) {
+            m_x.reserve(count);
+            m_y.reserve(count);
+            m_z.reserve(count);
+        }
+
+        void Clear() {
+            m_x.clear();
+            m_y.clear();
+            m_z.clear();
+        }
+
+        void PushBack(const Vector3& v) {
+            m_x.push_back(v.x);
+            m_y.push_back(v.y);
+            m_z.push_back(v.z);
+        }
+
+        Vector3 Get(size_t index) const { return Vector3(m_x[index], m_y[index], m_z[index]); }
+
+        void Set(size_t index, const Vector3& v) {
+            m_x[index] = v.x;
+            m_y[index] = v.y;
+            m_z[index] = v.z;
+        }
+
+        // Conversion from and to array-of-structures data
+        void Assign(std::span<const Vector3> values) {
+            Resize(values.size());
+            for (size_t i = 0; i < values.size(); i++) {
+                Set(i, values[i]);
+            }
+        }
+
+        void CopyTo(std::span<Vector3> out) const {
+            assert(out.size() >= Size());
+            for (size_t i = 0; i < Size(); i++) {
+                out[i] = Get(i);
+            }
+        }
+
+        float* X() { return m_x.data(); }
+        float* Y() { return m_y.data(); }
+        float* Z() { return m_z.data(); }
+        const float* X() const { return m_x.data(); }
+        const float* Y() const { return m_y.data(); }
+        const float* Z() const { return m_z.data(); }
+
+        Vector3Span AsSpan() { return { m_x.data(), m_y.data(), m_z.data(), m_x.size() }; }
+        ConstVector3Span AsSpan() const { return { m_x.data(), m_y.data(), m_z.data(), m_x.size() }; }
+
+    private:
+        AlignedVector<float> m_x;
+        AlignedVector<float> m_y;
+        AlignedVector<float> m_z;
+    };
+
+    // Non-owning views over Matrix4x4Stream data, element (row, column) lives in m[row * 4 + column]
+    struct Matrix4x4Span {
+        float* m[16] = {};
+        size_t size = 0;
+
+        Matrix4x4 Get(size_t index) const {
+            Matrix4x4 result;
+            for (int e = 0; e < 16; e++) {
+                result.m[e / 4][e % 4] = m[e][index];
+            }
+            return result;
+        }
+
+        void Set(size_t index, const Matrix4x4& matrix) const {
+            for (int e = 0; e < 16; e++) {
+                m[e][index] = matrix.m[e / 4][e % 4];
+            }
+        }
+    };
+
+    struct ConstMatrix4x4Span {
+        const float* m[16] = {};
+        size_t size = 0;
+
+        ConstMatrix4x4Span() = default;
+        ConstMatrix4x4Span(const Matrix4x4Span& span) : size(span.size) {
+            for (int e = 0; e < 16; e++) {
+                m[e] = span.m[e];
+            }
+        }
+
+        ConstMatrix4x4Span Subspan(size_t offset, size_t count) const {
+            assert(offset + count <= size);
+            ConstMatrix4x4Span result;
+            for (int e = 0; e < 16; e++) {
+                result.m[e] = m[e] + offset;
+            }
+            result.size = count;
+            return result;
+        }
+
+        Matrix4x4 Get(size_t index) const {
+            Matrix4x4 result;
+            for (int e = 0; e < 16; e++) {
+                result.m[e / 4][e % 4] = m[e][index];
+            }
+            return result;
+        }
+    };
+
+    // Matrix4x4Stream - one matrix per element stored as 16 element arrays,
+    // for kernels where every point has its own transform (skinning, particles)
+    class Matrix4x4Stream {
+    public:
+        Matrix4x4Stream() = default;
+        explicit Matrix4x4Stream(size_t count) { Resize(count); }
+
+        size_t Size() const { return m_elements[0].size(); }
+
+        void Resize(size_t count) {
+            for (auto& element : m_elements) {
+                element.resize(count);
+            }
+        }
+
+        void Clear() {
+            for (auto& element : m_elements) {
+                element.clear();
+            }
+        }
+
+        void PushBack(const Matrix4x4& matrix) {
+            for (int e = 0; e < 16; e++) {
+                m_elements[e].push_back(matrix.m[e / 4][e % 4]);
+            }
+        }
+
+        Matrix4x4 Get(size_t index) const { return AsSpan().Get(index); }
+        void Set(size_t index, const Matrix4x4& matrix) { AsSpan().Set(index, matrix); }
+
+        Matrix4x4Span AsSpan() {
+            Matrix4x4Span span;
+            for (int e = 0; e < 16; e++) {
+                span.m[e] = m_elements[e].data();
+            }
+            span.size = Size();
+            return span;
+        }
+
+        ConstMatrix4x4Span AsSpan() const {
+            ConstMatrix4x4Span span;
+            for (int e = 0; e < 16; e++) {
+                span.m[e] = m_elements[e].data();
+            }
+            span.size = Size();
+            return span;
+        }
+
+    private:
+        AlignedVector<float> m_elements[16];
+    };
+
+    // Batch kernels. Each processes SIMD::Width elements per instruction with a
+    // scalar tail, and matches the single-element functions in MathF.h. Output
+    // may alias input. Split large streams with Subspan to run them on workers.
+
+    // out[i] = TransformPoint(m, in[i])
+    void TransformPoints(const Matrix4x4& m, ConstVector3Span in, Vector3Span out);
+    // out[i] = TransformPoint(matrices[i], in[i])
+    void TransformPoints(ConstMatrix4x4Span matrices, ConstVector3Span in, Vector3Span out);
+    // out[i] = TransformVector(m, in[i])
+    void TransformVectors(const Matrix4x4& m, ConstVector3Span in, Vector3Span out);
+    // out[i] = TransformNormal(normalMatrix, in[i])
+    void TransformNormals(const Matrix3x3& normalMatrix, ConstVector3Span in, Vector3Span out);
+    // out[i] = TransformNormal(m, in[i]), NormalMatrix is computed once for the batch
+    void TransformNormals(const Matrix4x4& m, ConstVector3Span in, Vector3Span out);
+
+    // out[i] = in[i].Normalized()
+    void Normalize(ConstVector3Span in, Vector3Span out);
+    // out[i] = a[i].Dot(b[i])
+    void Dot(ConstVector3Span a, ConstVector3Span b, std::span<float> out);
+    // out[i] = a[i].Cross(b[i])
+    void Cross(ConstVector3Span a, ConstVector3Span b, Vector3Span out);
+
+    // Frustum culling over structure-of-arrays bounds, same results as
+    // Frustum::Intersects. Writes baseIndex + i for every volume that may be
+    // visible to visibleIndices in increasing order and returns the count.
+    // visibleIndices must have room for every input element.
+    uint32_t CullBoxes(const Frustum& frustum, ConstVector3Span centers, ConstVector3Span extents,
+                       std::span<uint32_t> visibleIndices, uint32_t baseIndex = 0);
+    uint32_t CullSpheres(const Frustum& frustum, ConstVector3Span centers, std::span<const float> radii,
+                         std::span<uint32_t> visibleIndices, uint32_t baseIndex = 0);
+
+    // The same kernels split into grainSize ranges on the JobSystem workers.
+    // Ranges are compacted in order, so the output matches the serial kernels.
+    uint32_t ParallelCullBoxes(const Frustum& frustum, ConstVector3Span centers, ConstVector3Span extents,
+                               std::span<uint32_t> visibleIndices, uint32_t grainSize = 16384);
+    uint32_t ParallelCullSpheres(const Frustum& frustum, ConstVector3Span centers, std::span<const float> radii,
+                                 std::span<uint32_t> visibleIndices, uint32_t grainSize = 16384);
+}
@@ -1,7 +1,11 @@
 ﻿#pragma once
+#include <cfloat>
 #include <cmath>
 #include <cstring>
 #include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "SIMD.h"
 
 namespace Reality {
     // Forward declarations
@@ -20,79 +24,400 @@ namespace Reality {
     constexpr float RAD_TO_DEG = 180.0f / PI;
     constexpr float EPSILON = 1e-6f;
 
-    // Math utility functions
-    inline float Sqrt(float x) {
-        return std::sqrtf(x);
+    namespace Detail {
+        // Compile-time versions of the std functions below, which are not
+        // constexpr. Evaluated in double, only used in constant expressions.
+        constexpr double Sqrt(double x) {
+            if (!(x > 0.0) || x == INFINITY) {
+                return x == 0.0 || x == INFINITY ? x : NAN;
+            }
+            // Newton-Raphson from above decreases until it converges
+            double y = x > 1.0 ? x : 1.0;
+            for (;;) {
+                const double next = 0.5 * (y + x / y);
+                if (next >= y) {
+                    return y;
+                }
+                y = next;
+            }
+        }
+
+        // Taylor series of sin (term = x, k = 2) or cos (term = 1, k = 1)
+        // after reducing x to [-pi, pi], summed until it stops changing
+        constexpr double SinCosSeries(double x, bool sine) {
+            constexpr double TwoPi = 6.28318530717958647692;
+            x -= TwoPi * static_cast<double>(static_cast<int64_t>(x / TwoPi));
+            x = x > TwoPi * 0.5 ? x - TwoPi : (x < -TwoPi * 0.5 ? x + TwoPi : x);
+            double term = sine ? x : 1.0;
+            double sum = term;
+            for (double k = sine ? 2.0 : 1.0;; k += 2.0) {
+                term *= -x * x / (k * (k + 1.0));
+                if (sum + term == sum) {
+                    return sum;
+                }
+                sum += term;
+            }
+        }
     }
 
-    inline float Sin(float x) {
-        return std::sinf(x);
+    // Math utility functions. Sqrt, Sin, Cos and Tan also evaluate at compile
+    // time, for projections and constant tables.
+    constexpr float Sqrt(float x) {
+        if (std::is_constant_evaluated()) {
+            return static_cast<float>(Detail::Sqrt(x));
+        }
+        return std::sqrt(x);
+    }
+
+    constexpr float Sin(float x) {
+        if (std::is_constant_evaluated()) {
+            return static_cast<float>(Detail::SinCosSeries(x, true));
+        }
+        return std::sin(x);
     }
 
-    inline float Cos(float x) {
-        return std::cosf(x);
+    constexpr float Cos(float x) {
+        if (std::is_constant_evaluated()) {
+            return static_cast<float>(Detail::SinCosSeries(x, false));
+        }
+        return std::cos(x);
     }
 
-    inline float Tan(float x) {
-        return std::tanf(x);
+    constexpr float Tan(float x) {
+        if (std::is_constant_evaluated()) {
+            return static_cast<float>(Detail::SinCosSeries(x, true) / Detail::SinCosSeries(x, false));
+        }
+        return std::tan(x);
     }
 
     inline float ASin(float x) {
-        return std::asinf(x);
+        return std::asin(x);
     }
 
     inline float ACos(float x) {
-        return std::acosf(x);
+        return std::acos(x);
     }
 
     inline float ATan(float x) {
-        return std::atanf(x);
+        return std::atan(x);
     }
 
     inline float ATan2(float y, float x) {
-        return std::atan2f(y, x);
+        return std::atan2(y, x);
     }
 
-    inline float Abs(float x) {
-        return std::fabsf(x);
+    constexpr float Abs(float x) {
+        if (std::is_constant_evaluated()) {
+            return x < 0.0f ? -x : x;
+        }
+        return std::abs(x);
     }
 
-    inline float Min(float a, float b) {
+    constexpr float Min(float a, float b) {
         return a < b ? a : b;
     }
 
-    inline float Max(float a, float b) {
+    constexpr float Max(float a, float b) {
         return a > b ? a : b;
     }
 
-    inline float Clamp(float value, float min, float max) {
+    constexpr float Clamp(float value, float min, float max) {
         return Min(Max(value, min), max);
     }
 
-    inline float Lerp(float a, float b, float t) {
+    constexpr float Lerp(float a, float b, float t) {
         return a + (b - a) * t;
     }
 
-    inline bool IsApproximatelyEqual(float a, float b, float epsilon = EPSILON) {
+    constexpr bool IsApproximatelyEqual(float a, float b, float epsilon = EPSILON) {
         return Abs(a - b) < epsilon;
     }
 
-    inline float DegreesToRadians(float degrees) {
+    constexpr float DegreesToRadians(float degrees) {
         return degrees * DEG_TO_RAD;
     }
 
-    inline float RadiansToDegrees(float radians) {
+    constexpr float RadiansToDegrees(float radians) {
         return radians * RAD_TO_DEG;
     }
 
+    // Accuracy tiers of the polynomial approximations in Approx
+    enum class Precision {
+        Fast,
+        Medium,
+        Precise
+    };
+
+    // Polynomial approximations of the std wrappers above. Every function has
+    // a float version plus SIMD::Float4 and SIMD::Float8 versions for batch
+    // kernels. All three share one implementation and give the same result per
+    // lane. Measured maximum errors over the valid range:
+    //
+    //                  Fast        Medium      Precise
+    //  Sin             1.3e-6      2.4e-7      2.3e-7      absolute, |x| <= 8192
+    //  Cos             7.0e-6      3.0e-7      2.6e-7      absolute, |x| <= 8192
+    //  ACos            8.6e-5      1.6e-6      4.2e-7      absolute, |x| <= 1
+    //  RSqrt           3.3e-4      2.8e-7      9.0e-8      relative, x > 0
+    //  Sqrt            3.3e-4      3.1e-7      6.0e-8      relative, x >= 0
+    //
+    // Sin and Cos reduce the argument to [-pi/2, pi/2] and evaluate an odd
+    // (even) minimax polynomial of degree 7/9/11 (6/8/10). ACos evaluates
+    // sqrt(1 - |x|) * P(|x|) with P of degree 3/5/7. Fast and Medium RSqrt
+    // refine the hardware estimate with 0/1 Newton-Raphson steps, Sqrt is
+    // x * RSqrt(x). Scalar builds without SSE start from a bit-level estimate
+    // instead, 1.8e-3 for Fast and 4.8e-6 for Medium.
+    namespace Approx {
+        namespace Detail {
+            // Operations overloaded for float and the SIMD types, so each
+            // approximation below is written once
+            template<typename V> V Splat(float s);
+            template<> inline float Splat<float>(float s) { return s; }
+
+            inline float Add(float a, float b) { return a + b; }
+            inline float Sub(float a, float b) { return a - b; }
+            inline float Mul(float a, float b) { return a * b; }
+            inline float Div(float a, float b) { return a / b; }
+            inline float Min(float a, float b) { return a < b ? a : b; }
+            inline float MulAdd(float a, float b, float c) {
+#if defined(REALITY_SIMD_FMA)
+                return std::fma(a, b, c);
+#else
+                return a * b + c;
+#endif
+            }
+            inline float Abs(float v) { return std::fabs(v); }
+            inline float Round(float v) { return std::nearbyint(v); }
+            inline float Sqrt(float v) { return std::sqrt(v); }
+            // v negated where source is negative
+            inline float MulSign(float v, float source) { return std::signbit(source) ? -v : v; }
+            // a > b ? ifTrue : ifFalse
+            inline float SelectGreater(float a, float b, float ifTrue, float ifFalse) { return a > b ? ifTrue : ifFalse; }
+
+            inline float RSqrtEstimate(float v) {
+#if defined(REALITY_SIMD_SSE)
+                return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(v)));
+#else
+                // Bit-level initial guess plus one Newton-Raphson step
+                uint32_t bits;
+                memcpy(&bits, &v, sizeof(bits));
+                bits = 0x5F375A86u - (bits >> 1);
+                float y;
+                memcpy(&y, &bits, sizeof(y));
+                return y * (1.5f - 0.5f * v * y * y);
+#endif
+            }
+
+#if defined(REALITY_SIMD_SSE)
+            template<> inline SIMD::Float4 Splat<SIMD::Float4>(float s) { return SIMD::Splat(s); }
+
+            using SIMD::Add;
+            using SIMD::Sub;
+            using SIMD::Mul;
+            using SIMD::Div;
+            using SIMD::Min;
+            using SIMD::MulAdd;
+            using SIMD::Abs;
+            using SIMD::Round;
+            using SIMD::Sqrt;
+            using SIMD::RSqrtEstimate;
+
+            template<typename V>
+            inline V MulSign(V v, V source) {
+                return SIMD::Xor(v, SIMD::And(source, Splat<V>(-0.0f)));
+            }
+
+            template<typename V>
+            inline V SelectGreater(V a, V b, V ifTrue, V ifFalse) {
+                return SIMD::Select(ifFalse, ifTrue, SIMD::Greater(a, b));
+            }
+#endif
+#if defined(REALITY_SIMD_AVX2)
+            template<> inline SIMD::Float8 Splat<SIMD::Float8>(float s) { return SIMD::Splat8(s); }
+#endif
+
+            // Minimax coefficients, lowest degree first
+            template<Precision P> struct SinCoefficients;
+            template<> struct SinCoefficients<Precision::Fast> {
+                static constexpr float c[] = { 9.999992371e-01f, -1.666567650e-01f, 8.313191414e-03f, -1.852253932e-04f };
+            };
+            template<> struct SinCoefficients<Precision::Medium> {
+                static constexpr float c[] = { 9.999999957e-01f, -1.666665795e-01f, 8.333050171e-03f, -1.980901741e-04f,
+                                               2.605107635e-06f };
+            };
+            template<> struct SinCoefficients<Precision::Precise> {
+                static constexpr float c[] = { 1.0f, -1.666666662e-01f, 8.333330974e-03f, -1.984086118e-04f,
+                                               2.752526981e-06f, -2.388921777e-08f };
+            };
+
+            template<Precision P> struct CosCoefficients;
+            template<> struct CosCoefficients<Precision::Fast> {
+                static constexpr float c[] = { 9.999932021e-01f, -4.999117604e-01f, 4.148701414e-02f, -1.271011233e-03f };
+            };
+            template<> struct CosCoefficients<Precision::Medium> {
+                static constexpr float c[] = { 9.999999530e-01f, -4.999990478e-01f, 4.166357316e-02f, -1.385362954e-03f,
+                                               2.315241666e-05f };
+            };
+            template<> struct CosCoefficients<Precision::Precise> {
+                static constexpr float c[] = { 1.0f, -4.999999936e-01f, 4.166663616e-02f, -1.388836028e-03f,
+                                               2.476010967e-05f, -2.605065749e-07f };
+            };
+
+            template<Precision P> struct ACosCoefficients;
+            template<> struct ACosCoefficients<Precision::Fast> {
+                static constexpr float c[] = { 1.570710695e+00f, -2.118035710e-01f, 7.344754368e-02f, -1.819285264e-02f };
+            };
+            template<> struct ACosCoefficients<Precision::Medium> {
+                static constexpr float c[] = { 1.570794876e+00f, -2.144962540e-01f, 8.774994875e-02f, -4.460982332e-02f,
+                                               1.895494936e-02f, -4.180968543e-03f };
+            };
+            template<> struct ACosCoefficients<Precision::Precise> {
+                static constexpr float c[] = { 1.570796298e+00f, -2.145981556e-01f, 8.896885320e-02f, -5.011430310e-02f,
+                                               3.072212242e-02f, -1.684105242e-02f, 6.491521428e-03f, -1.211737770e-03f };
+            };
+
+            // Horner evaluation of c[0] + c[1] * x + c[2] * x^2 + ...
+            template<typename V, size_t N>
+            inline V Polynomial(const float (&c)[N], V x) {
+                V result = Splat<V>(c[N - 1]);
+                for (size_t i = N - 1; i > 0; i--) {
+                    result = MulAdd(result, x, Splat<V>(c[i - 1]));
+                }
+                return result;
+            }
+
+            // pi - x without the rounding error of PI itself
+            template<typename V>
+            inline V PiMinus(V x) {
+                return Add(Sub(Splat<V>(PI), x), Splat<V>(-8.742278e-8f));
+            }
+
+            // x - k * 2pi with k = round(x / 2pi), in two steps so the product
+            // with the leading part of 2pi is exact
+            template<typename V>
+            inline V ReduceAngle(V x) {
+                const V k = Round(Mul(x, Splat<V>(1.0f / TWO_PI)));
+                x = MulAdd(k, Splat<V>(-6.28125f), x);
+                return MulAdd(k, Splat<V>(-1.9353071795864769e-3f), x);
+            }
+
+            template<Precision P, typename V>
+            inline V Sin(V x) {
+                x = ReduceAngle(x);
+                // sin(pi - x) == sin(x) folds [-pi, pi] onto [-pi/2, pi/2]
+                const V ax = Abs(x);
+                const V folded = SelectGreater(ax, Splat<V>(HALF_PI), PiMinus(ax), ax);
+                x = MulSign(folded, x);
+                return Mul(x, Polynomial(SinCoefficients<P>::c, Mul(x, x)));
+            }
+
+            template<Precision P, typename V>
+            inline V Cos(V x) {
+                const V ax = Abs(ReduceAngle(x));
+                // cos(pi - x) == -cos(x)
+                const V folded = SelectGreater(ax, Splat<V>(HALF_PI), PiMinus(ax), ax);
+                const V result = Polynomial(CosCoefficients<P>::c, Mul(folded, folded));
+                return SelectGreater(ax, Splat<V>(HALF_PI), Sub(Splat<V>(0.0f), result), result);
+            }
+
+            template<Precision P, typename V>
+            inline V ACos(V x) {
+                const V ax = Min(Abs(x), Splat<V>(1.0f));
+                const V result = Mul(Sqrt(Sub(Splat<V>(1.0f), ax)), Polynomial(ACosCoefficients<P>::c, ax));
+                // acos(-x) == pi - acos(x)
+                return SelectGreater(Splat<V>(0.0f), x, PiMinus(result), result);
+            }
+
+            template<Precision P, typename V>
+            inline V RSqrt(V x) {
+                if constexpr (P == Precision::Precise) {
+                    return Div(Splat<V>(1.0f), Sqrt(x));
+                } else {
+                    V y = RSqrtEstimate(x);
+                    if constexpr (P == Precision::Medium) {
+                        // y * (1.5 - 0.5 * x * y * y)
+                        const V halfX = Mul(x, Splat<V>(0.5f));
+                        y = Mul(y, MulAdd(Mul(halfX, y), Sub(Splat<V>(0.0f), y), Splat<V>(1.5f)));
+                    }
+                    return y;
+                }
+            }
+
+            template<Precision P, typename V>
+            inline V Sqrt(V x) {
+                if constexpr (P == Precision::Precise) {
+                    return Detail::Sqrt(x);
+                } else {
+                    // x * rsqrt(x), with 0 instead of 0 * inf for x == 0
+                    const V zero = Splat<V>(0.0f);
+                    return SelectGreater(x, zero, Mul(x, RSqrt<P>(x)), zero);
+                }
+            }
+        }
+
+        template<Precision P = Precision::Medium>
+        inline float Sin(float x) { return Detail::Sin<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline float Cos(float x) { return Detail::Cos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline float ACos(float x) { return Detail::ACos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline float RSqrt(float x) { return Detail::RSqrt<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline float Sqrt(float x) { return Detail::Sqrt<P>(x); }
+
+#if defined(REALITY_SIMD_SSE)
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float4 Sin(SIMD::Float4 x) { return Detail::Sin<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float4 Cos(SIMD::Float4 x) { return Detail::Cos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float4 ACos(SIMD::Float4 x) { return Detail::ACos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float4 RSqrt(SIMD::Float4 x) { return Detail::RSqrt<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float4 Sqrt(SIMD::Float4 x) { return Detail::Sqrt<P>(x); }
+#endif
+
+#if defined(REALITY_SIMD_AVX2)
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float8 Sin(SIMD::Float8 x) { return Detail::Sin<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float8 Cos(SIMD::Float8 x) { return Detail::Cos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float8 ACos(SIMD::Float8 x) { return Detail::ACos<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float8 RSqrt(SIMD::Float8 x) { return Detail::RSqrt<P>(x); }
+
+        template<Precision P = Precision::Medium>
+        inline SIMD::Float8 Sqrt(SIMD::Float8 x) { return Detail::Sqrt<P>(x); }
+#endif
+    }
+
+    // The types below are trivially default-constructible, so large arrays of
+    // them cost nothing to allocate: "T value;" leaves the components
+    // uninitialized, "T value{}" zeroes them. Use Zero() and Identity() for
+    // explicit values. Operations are constexpr apart from those that go
+    // through SIMD registers or component pointers.
+
     // Vector2 - 2D vector
     struct Vector2 {
         float x, y;
 
         // Constructors
-        Vector2() : x(0), y(0) {}
-        explicit Vector2(float s) : x(s), y(s) {}
-        Vector2(float x, float y) : x(x), y(y) {}
+        Vector2() = default;
+        constexpr explicit Vector2(float s) : x(s), y(s) {}
+        constexpr Vector2(float x, float y) : x(x), y(y) {}
 
         // Access operators
         float& operator[](int index) {
@@ -106,93 +431,93 @@ namespace Reality {
         }
 
         // Unary operators
-        Vector2 operator-() const {
+        constexpr Vector2 operator-() const {
             return Vector2(-x, -y);
         }
 
         // Binary operators
-        Vector2 operator+(const Vector2& v) const {
+        constexpr Vector2 operator+(const Vector2& v) const {
             return Vector2(x + v.x, y + v.y);
         }
 
-        Vector2 operator-(const Vector2& v) const {
+        constexpr Vector2 operator-(const Vector2& v) const {
             return Vector2(x - v.x, y - v.y);
         }
 
-        Vector2 operator*(float s) const {
+        constexpr Vector2 operator*(float s) const {
             return Vector2(x * s, y * s);
         }
 
-        Vector2 operator/(float s) const {
+        constexpr Vector2 operator/(float s) const {
             float inv = 1.0f / s;
             return Vector2(x * inv, y * inv);
         }
 
-        Vector2 operator*(const Vector2& v) const {
+        constexpr Vector2 operator*(const Vector2& v) const {
             return Vector2(x * v.x, y * v.y);
         }
 
-        Vector2 operator/(const Vector2& v) const {
+        constexpr Vector2 operator/(const Vector2& v) const {
             return Vector2(x / v.x, y / v.y);
         }
 
         // Assignment operators
-        Vector2& operator+=(const Vector2& v) {
+        constexpr Vector2& operator+=(const Vector2& v) {
             x += v.x;
             y += v.y;
             return *this;
         }
 
-        Vector2& operator-=(const Vector2& v) {
+        constexpr Vector2& operator-=(const Vector2& v) {
             x -= v.x;
             y -= v.y;
             return *this;
         }
 
-        Vector2& operator*=(float s) {
+        constexpr Vector2& operator*=(float s) {
             x *= s;
             y *= s;
             return *this;
         }
 
-        Vector2& operator/=(float s) {
+        constexpr Vector2& operator/=(float s) {
             float inv = 1.0f / s;
             x *= inv;
             y *= inv;
             return *this;
         }
 
-        Vector2& operator*=(const Vector2& v) {
+        constexpr Vector2& operator*=(const Vector2& v) {
             x *= v.x;
             y *= v.y;
             return *this;
         }
 
-        Vector2& operator/=(const Vector2& v) {
+        constexpr Vector2& operator/=(const Vector2& v) {
             x /= v.x;
             y /= v.y;
             return *this;
         }
 
         // Comparison operators
-        bool operator==(const Vector2& v) const {
+        constexpr bool operator==(const Vector2& v) const {
             return x == v.x && y == v.y;
         }
 
-        bool operator!=(const Vector2& v) const {
+        constexpr bool operator!=(const Vector2& v) const {
             return !(*this == v);
         }
 
         // Vector operations
-        float Length() const {
+        constexpr float Length() const {
             return Sqrt(x * x + y * y);
         }
 
-        float LengthSquared() const {
+        constexpr float LengthSquared() const {
             return x * x + y * y;
         }
 
-        Vector2 Normalized() const {
+        constexpr Vector2 Normalized() const {
             float len = Length();
             if (len > EPSILON) {
                 float inv = 1.0f / len;
@@ -201,7 +526,7 @@ namespace Reality {
             return Vector2(0, 0);
         }
 
-        Vector2& Normalize() {
+        constexpr Vector2& Normalize() {
             float len = Length();
             if (len > EPSILON) {
                 float inv = 1.0f / len;
@@ -211,15 +536,15 @@ namespace Reality {
             return *this;
         }
 
-        float Dot(const Vector2& v) const {
+        constexpr float Dot(const Vector2& v) const {
             return x * v.x + y * v.y;
         }
 
         // Static methods
-        static Vector2 Zero() { return Vector2(0, 0); }
-        static Vector2 One() { return Vector2(1, 1); }
-        static Vector2 UnitX() { return Vector2(1, 0); }
-        static Vector2 UnitY() { return Vector2(0, 1); }
+        static constexpr Vector2 Zero() { return Vector2(0, 0); }
+        static constexpr Vector2 One() { return Vector2(1, 1); }
+        static constexpr Vector2 UnitX() { return Vector2(1, 0); }
+        static constexpr Vector2 UnitY() { return Vector2(0, 1); }
     };
 
     // Vector3 - 3D vector
@@ -227,10 +552,10 @@ namespace Reality {
         float x, y, z;
 
         // Constructors
-        Vector3() : x(0), y(0), z(0) {}
-        explicit Vector3(float s) : x(s), y(s), z(s) {}
-        Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
-        explicit Vector3(const Vector2& v, float z) : x(v.x), y(v.y), z(z) {}
+        Vector3() = default;
+        constexpr explicit Vector3(float s) : x(s), y(s), z(s) {}
+        constexpr Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+        constexpr explicit Vector3(const Vector2& v, float z) : x(v.x), y(v.y), z(z) {}
 
         // Access operators
         float& operator[](int index) {
@@ -244,59 +569,59 @@ namespace Reality {
         }
 
         // Unary operators
-        Vector3 operator-() const {
+        constexpr Vector3 operator-() const {
             return Vector3(-x, -y, -z);
         }
 
         // Binary operators
-        Vector3 operator+(const Vector3& v) const {
+        constexpr Vector3 operator+(const Vector3& v) const {
             return Vector3(x + v.x, y + v.y, z + v.z);
         }
 
-        Vector3 operator-(const Vector3& v) const {
+        constexpr Vector3 operator-(const Vector3& v) const {
             return Vector3(x - v.x, y - v.y, z - v.z);
         }
 
-        Vector3 operator*(float s) const {
+        constexpr Vector3 operator*(float s) const {
             return Vector3(x * s, y * s, z * s);
         }
 
-        Vector3 operator/(float s) const {
+        constexpr Vector3 operator/(float s) const {
             float inv = 1.0f / s;
             return Vector3(x * inv, y * inv, z * inv);
         }
 
-        Vector3 operator*(const Vector3& v) const {
+        constexpr Vector3 operator*(const Vector3& v) const {
             return Vector3(x * v.x, y * v.y, z * v.z);
         }
 
-        Vector3 operator/(const Vector3& v) const {
+        constexpr Vector3 operator/(const Vector3& v) const {
             return Vector3(x / v.x, y / v.y, z / v.z);
         }
 
         // Assignment operators
-        Vector3& operator+=(const Vector3& v) {
+        constexpr Vector3& operator+=(const Vector3& v) {
             x += v.x;
             y += v.y;
             z += v.z;
             return *this;
         }
 
-        Vector3& operator-=(const Vector3& v) {
+        constexpr Vector3& operator-=(const Vector3& v) {
             x -= v.x;
             y -= v.y;
             z -= v.z;
             return *this;
         }
 
-        Vector3& operator*=(float s) {
+        constexpr Vector3& operator*=(float s) {
             x *= s;
             y *= s;
             z *= s;
             return *this;
         }
 
-        Vector3& operator/=(float s) {
+        constexpr Vector3& operator/=(float s) {
             float inv = 1.0f / s;
             x *= inv;
             y *= inv;
@@ -304,14 +629,14 @@ namespace Reality {
             return *this;
         }
 
-        Vector3& operator*=(const Vector3& v) {
+        constexpr Vector3& operator*=(const Vector3& v) {
             x *= v.x;
             y *= v.y;
             z *= v.z;
             return *this;
         }
 
-        Vector3& operator/=(const Vector3& v) {
+        constexpr Vector3& operator/=(const Vector3& v) {
             x /= v.x;
             y /= v.y;
             z /= v.z;
@@ -319,24 +644,24 @@ namespace Reality {
         }
 
         // Comparison operators
-        bool operator==(const Vector3& v) const {
+        constexpr bool operator==(const Vector3& v) const {
             return x == v.x && y == v.y && z == v.z;
         }
 
-        bool operator!=(const Vector3& v) const {
+        constexpr bool operator!=(const Vector3& v) const {
             return !(*this == v);
         }
 
         // Vector operations
-        float Length() const {
+        constexpr float Length() const {
             return Sqrt(x * x + y * y + z * z);
         }
 
-        float LengthSquared() const {
+        constexpr float LengthSquared() const {
             return x * x + y * y + z * z;
         }
 
-        Vector3 Normalized() const {
+        constexpr Vector3 Normalized() const {
             float len = Length();
             if (len > EPSILON) {
                 float inv = 1.0f / len;
@@ -345,7 +670,7 @@ namespace Reality {
             return Vector3(0, 0, 0);
         }
 
-        Vector3& Normalize() {
+        constexpr Vector3& Normalize() {
             float len = Length();
             if (len > EPSILON) {
                 float inv = 1.0f / len;
@@ -356,11 +681,11 @@ namespace Reality {
             return *this;
         }
 
-        float Dot(const Vector3& v) const {
+        constexpr float Dot(const Vector3& v) const {
             return x * v.x + y * v.y + z * v.z;
         }
 
-        Vector3 Cross(const Vector3& v) const {
+        constexpr Vector3 Cross(const Vector3& v) const {
             return Vector3(
                 y * v.z - z * v.y,
                 z * v.x - x * v.z,
@@ -369,29 +694,43 @@ namespace Reality {
         }
 
         // Static methods
-        static Vector3 Zero() { return Vector3(0, 0, 0); }
-        static Vector3 One() { return Vector3(1, 1, 1); }
-        static Vector3 UnitX() { return Vector3(1, 0, 0); }
-        static Vector3 UnitY() { return Vector3(0, 1, 0); }
-        static Vector3 UnitZ() { return Vector3(0, 0, 1); }
-        static Vector3 Up() { return Vector3(0, 1, 0); }
-        static Vector3 Down() { return Vector3(0, -1, 0); }
-        static Vector3 Left() { return Vector3(-1, 0, 0); }
-        static Vector3 Right() { return Vector3(1, 0, 0); }
-        static Vector3 Forward() { return Vector3(0, 0, 1); }
-        static Vector3 Backward() { return Vector3(0, 0, -1); }
+        static constexpr Vector3 Zero() { return Vector3(0, 0, 0); }
+        static constexpr Vector3 One() { return Vector3(1, 1, 1); }
+        static constexpr Vector3 UnitX() { return Vector3(1, 0, 0); }
+        static constexpr Vector3 UnitY() { return Vector3(0, 1, 0); }
+        static constexpr Vector3 UnitZ() { return Vector3(0, 0, 1); }
+        static constexpr Vector3 Up() { return Vector3(0, 1, 0); }
+        static constexpr Vector3 Down() { return Vector3(0, -1, 0); }
+        static constexpr Vector3 Left() { return Vector3(-1, 0, 0); }
+        static constexpr Vector3 Right() { return Vector3(1, 0, 0); }
+        static constexpr Vector3 Forward() { return Vector3(0, 0, 1); }
+        static constexpr Vector3 Backward() { return Vector3(0, 0, -1); }
+
+        // Component-wise minimum and maximum
+        static constexpr Vector3 Min(const Vector3& a, const Vector3& b) {
+            return Vector3(Reality::Min(a.x, b.x), Reality::Min(a.y, b.y), Reality::Min(a.z, b.z));
+        }
+
+        static constexpr Vector3 Max(const Vector3& a, const Vector3& b) {
+            return Vector3(Reality::Max(a.x, b.x), Reality::Max(a.y, b.y), Reality::Max(a.z, b.z));
+        }
     };
 
-    // Vector4 - 4D vector
-    struct Vector4 {
+    // Vector4 - 4D vector, 16-byte aligned for SIMD loads
+    struct alignas(16) Vector4 {
         float x, y, z, w;
 
         // Constructors
-        Vector4() : x(0), y(0), z(0), w(0) {}
-        explicit Vector4(float s) : x(s), y(s), z(s), w(s) {}
-        Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
-        explicit Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
-        explicit Vector4(const Vector2& v, float z, float w) : x(v.x), y(v.y), z(z), w(w) {}
+        Vector4() = default;
+        constexpr explicit Vector4(float s) : x(s), y(s), z(s), w(s) {}
+        constexpr Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+        constexpr explicit Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+        constexpr explicit Vector4(const Vector2& v, float z, float w) : x(v.x), y(v.y), z(z), w(w) {}
+
+#if defined(REALITY_SIMD_SSE)
+        explicit Vector4(SIMD::Float4 v) { SIMD::Store(&x, v); }
+        SIMD::Float4 ToSIMD() const { return SIMD::Load(&x); }
+#endif
 
         // Access operators
         float& operator[](int index) {
@@ -405,136 +744,151 @@ namespace Reality {
         }
 
         // Unary operators
-        Vector4 operator-() const {
+        constexpr Vector4 operator-() const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Negate(ToSIMD()));
+            }
+#endif
             return Vector4(-x, -y, -z, -w);
         }
 
         // Binary operators
-        Vector4 operator+(const Vector4& v) const {
+        constexpr Vector4 operator+(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Add(ToSIMD(), v.ToSIMD()));
+            }
+#endif
             return Vector4(x + v.x, y + v.y, z + v.z, w + v.w);
         }
 
-        Vector4 operator-(const Vector4& v) const {
+        constexpr Vector4 operator-(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Sub(ToSIMD(), v.ToSIMD()));
+            }
+#endif
             return Vector4(x - v.x, y - v.y, z - v.z, w - v.w);
         }
 
-        Vector4 operator*(float s) const {
+        constexpr Vector4 operator*(float s) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Mul(ToSIMD(), SIMD::Splat(s)));
+            }
+#endif
             return Vector4(x * s, y * s, z * s, w * s);
         }
 
-        Vector4 operator/(float s) const {
-            float inv = 1.0f / s;
-            return Vector4(x * inv, y * inv, z * inv, w * inv);
+        constexpr Vector4 operator/(float s) const {
+            return *this * (1.0f / s);
         }
 
-        Vector4 operator*(const Vector4& v) const {
+        constexpr Vector4 operator*(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Mul(ToSIMD(), v.ToSIMD()));
+            }
+#endif
             return Vector4(x * v.x, y * v.y, z * v.z, w * v.w);
         }
 
-        Vector4 operator/(const Vector4& v) const {
+        constexpr Vector4 operator/(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Vector4(SIMD::Div(ToSIMD(), v.ToSIMD()));
+            }
+#endif
             return Vector4(x / v.x, y / v.y, z / v.z, w / v.w);
         }
 
         // Assignment operators
-        Vector4& operator+=(const Vector4& v) {
-            x += v.x;
-            y += v.y;
-            z += v.z;
-            w += v.w;
+        constexpr Vector4& operator+=(const Vector4& v) {
+            *this = *this + v;
             return *this;
         }
 
-        Vector4& operator-=(const Vector4& v) {
-            x -= v.x;
-            y -= v.y;
-            z -= v.z;
-            w -= v.w;
+        constexpr Vector4& operator-=(const Vector4& v) {
+            *this = *this - v;
             return *this;
         }
 
-        Vector4& operator*=(float s) {
-            x *= s;
-            y *= s;
-            z *= s;
-            w *= s;
+        constexpr Vector4& operator*=(float s) {
+            *this = *this * s;
             return *this;
         }
 
-        Vector4& operator/=(float s) {
-            float inv = 1.0f / s;
-            x *= inv;
-            y *= inv;
-            z *= inv;
-            w *= inv;
+        constexpr Vector4& operator/=(float s) {
+            *this = *this / s;
             return *this;
         }
 
-        Vector4& operator*=(const Vector4& v) {
-            x *= v.x;
-            y *= v.y;
-            z *= v.z;
-            w *= v.w;
+        constexpr Vector4& operator*=(const Vector4& v) {
+            *this = *this * v;
             return *this;
         }
 
-        Vector4& operator/=(const Vector4& v) {
-            x /= v.x;
-            y /= v.y;
-            z /= v.z;
-            w /= v.w;
+        constexpr Vector4& operator/=(const Vector4& v) {
+            *this = *this / v;
             return *this;
         }
 
         // Comparison operators
-        bool operator==(const Vector4& v) const {
+        constexpr bool operator==(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return SIMD::AllEqual(ToSIMD(), v.ToSIMD());
+            }
+#endif
             return x == v.x && y == v.y && z == v.z && w == v.w;
         }
 
-        bool operator!=(const Vector4& v) const {
+        constexpr bool operator!=(const Vector4& v) const {
             return !(*this == v);
         }
 
         // Vector operations
-        float Length() const {
-            return Sqrt(x * x + y * y + z * z + w * w);
+        constexpr float Length() const {
+            return Sqrt(LengthSquared());
         }
 
-        float LengthSquared() const {
-            return x * x + y * y + z * z + w * w;
+        constexpr float LengthSquared() const {
+            return Dot(*this);
         }
 
-        Vector4 Normalized() const {
+        constexpr Vector4 Normalized() const {
             float len = Length();
             if (len > EPSILON) {
-                float inv = 1.0f / len;
-                return Vector4(x * inv, y * inv, z * inv, w * inv);
+                return *this * (1.0f / len);
             }
             return Vector4(0, 0, 0, 0);
         }
 
-        Vector4& Normalize() {
+        constexpr Vector4& Normalize() {
             float len = Length();
             if (len > EPSILON) {
-                float inv = 1.0f / len;
-                x *= inv;
-                y *= inv;
-                z *= inv;
-                w *= inv;
+                *this *= 1.0f / len;
             }
             return *this;
         }
 
-        float Dot(const Vector4& v) const {
+        constexpr float Dot(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return SIMD::GetX(SIMD::Dot4(ToSIMD(), v.ToSIMD()));
+            }
+#endif
             return x * v.x + y * v.y + z * v.z + w * v.w;
         }
 
         // Static methods
-        static Vector4 Zero() { return Vector4(0, 0, 0, 0); }
-        static Vector4 One() { return Vector4(1, 1, 1, 1); }
-        static Vector4 UnitX() { return Vector4(1, 0, 0, 0); }
-        static Vector4 UnitY() { return Vector4(0, 1, 0, 0); }
-        static Vector4 UnitZ() { return Vector4(0, 0, 1, 0); }
-        static Vector4 UnitW() { return Vector4(0, 0, 0, 1); }
+        static constexpr Vector4 Zero() { return Vector4(0, 0, 0, 0); }
+        static constexpr Vector4 One() { return Vector4(1, 1, 1, 1); }
+        static constexpr Vector4 UnitX() { return Vector4(1, 0, 0, 0); }
+        static constexpr Vector4 UnitY() { return Vector4(0, 1, 0, 0); }
+        static constexpr Vector4 UnitZ() { return Vector4(0, 0, 1, 0); }
+        static constexpr Vector4 UnitW() { return Vector4(0, 0, 0, 1); }
     };
 
     // Matrix3x3 - 3x3 matrix
@@ -542,11 +896,9 @@ namespace Reality {
         float m[3][3];
 
         // Constructors
-        Matrix3x3() {
-            memset(m, 0, sizeof(m));
-        }
+        Matrix3x3() = default;
 
-        explicit Matrix3x3(float s) {
+        constexpr explicit Matrix3x3(float s) {
             for (int i = 0; i < 3; i++) {
                 for (int j = 0; j < 3; j++) {
                     m[i][j] = (i == j) ? s : 0.0f;
@@ -554,7 +906,7 @@ namespace Reality {
             }
         }
 
-        Matrix3x3(
+        constexpr Matrix3x3(
             float m00, float m01, float m02,
             float m10, float m11, float m12,
             float m20, float m21, float m22) {
@@ -564,18 +916,26 @@ namespace Reality {
         }
 
         // Access operators
-        float* operator[](int row) {
+        constexpr float* operator[](int row) {
             assert(row >= 0 && row < 3);
             return m[row];
         }
 
-        const float* operator[](int row) const {
+        constexpr const float* operator[](int row) const {
             assert(row >= 0 && row < 3);
             return m[row];
         }
 
+        constexpr Vector3 operator*(const Vector3& v) const {
+            return Vector3(
+                m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z
+            );
+        }
+
         // Matrix operations
-        Matrix3x3 Transposed() const {
+        constexpr Matrix3x3 Transposed() const {
             return Matrix3x3(
                 m[0][0], m[1][0], m[2][0],
                 m[0][1], m[1][1], m[2][1],
@@ -583,7 +943,7 @@ namespace Reality {
             );
         }
 
-        Matrix3x3& Transpose() {
+        constexpr Matrix3x3& Transpose() {
             float tmp;
             tmp = m[0][1]; m[0][1] = m[1][0]; m[1][0] = tmp;
             tmp = m[0][2]; m[0][2] = m[2][0]; m[2][0] = tmp;
@@ -591,16 +951,16 @@ namespace Reality {
             return *this;
         }
 
-        float Determinant() const {
+        constexpr float Determinant() const {
             return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
                    m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
                    m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
         }
 
-        Matrix3x3 Inverse() const {
+        constexpr Matrix3x3 Inverse() const {
             float det = Determinant();
             if (Abs(det) < EPSILON) {
-                return Matrix3x3(); // Return zero matrix if not invertible
+                return Zero(); // Return zero matrix if not invertible
             }
 
             float invDet = 1.0f / det;
@@ -618,16 +978,16 @@ namespace Reality {
         }
 
         // Static methods
-        static Matrix3x3 Zero() {
-            return Matrix3x3();
+        static constexpr Matrix3x3 Zero() {
+            return Matrix3x3(0.0f);
         }
 
-        static Matrix3x3 Identity() {
+        static constexpr Matrix3x3 Identity() {
             return Matrix3x3(1.0f);
         }
 
         // Factory methods
-        static Matrix3x3 RotationX(float angle) {
+        static constexpr Matrix3x3 RotationX(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix3x3(
@@ -637,7 +997,7 @@ namespace Reality {
             );
         }
 
-        static Matrix3x3 RotationY(float angle) {
+        static constexpr Matrix3x3 RotationY(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix3x3(
@@ -647,7 +1007,7 @@ namespace Reality {
             );
         }
 
-        static Matrix3x3 RotationZ(float angle) {
+        static constexpr Matrix3x3 RotationZ(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix3x3(
@@ -657,7 +1017,7 @@ namespace Reality {
             );
         }
 
-        static Matrix3x3 RotationAxis(const Vector3& axis, float angle) {
+        static constexpr Matrix3x3 RotationAxis(const Vector3& axis, float angle) {
             Vector3 a = axis.Normalized();
             float c = Cos(angle);
             float s = Sin(angle);
@@ -670,7 +1030,7 @@ namespace Reality {
             );
         }
 
-        static Matrix3x3 Scale(float s) {
+        static constexpr Matrix3x3 Scale(float s) {
             return Matrix3x3(
                 s, 0.0f, 0.0f,
                 0.0f, s, 0.0f,
@@ -678,7 +1038,7 @@ namespace Reality {
             );
         }
 
-        static Matrix3x3 Scale(const Vector3& s) {
+        static constexpr Matrix3x3 Scale(const Vector3& s) {
             return Matrix3x3(
                 s.x, 0.0f, 0.0f,
                 0.0f, s.y, 0.0f,
@@ -687,16 +1047,14 @@ namespace Reality {
         }
     };
 
-    // Matrix4x4 - 4x4 matrix
-    struct Matrix4x4 {
+    // Matrix4x4 - 4x4 matrix, rows are 16-byte aligned for SIMD loads
+    struct alignas(16) Matrix4x4 {
         float m[4][4];
 
         // Constructors
-        Matrix4x4() {
-            memset(m, 0, sizeof(m));
-        }
+        Matrix4x4() = default;
 
-        explicit Matrix4x4(float s) {
+        constexpr explicit Matrix4x4(float s) {
             for (int i = 0; i < 4; i++) {
                 for (int j = 0; j < 4; j++) {
                     m[i][j] = (i == j) ? s : 0.0f;
@@ -704,7 +1062,7 @@ namespace Reality {
             }
         }
 
-        Matrix4x4(
+        constexpr Matrix4x4(
             float m00, float m01, float m02, float m03,
             float m10, float m11, float m12, float m13,
             float m20, float m21, float m22, float m23,
@@ -716,18 +1074,52 @@ namespace Reality {
         }
 
         // Access operators
-        float* operator[](int row) {
+        constexpr float* operator[](int row) {
             assert(row >= 0 && row < 4);
             return m[row];
         }
 
-        const float* operator[](int row) const {
+        constexpr const float* operator[](int row) const {
             assert(row >= 0 && row < 4);
             return m[row];
         }
 
         // Binary operators
-        Matrix4x4 operator*(const Matrix4x4& other) const {
+        constexpr Matrix4x4 operator*(const Matrix4x4& other) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                Matrix4x4 result;
+#if defined(REALITY_SIMD_AVX2)
+                // Two result rows per iteration, each a sum of broadcast elements times rows of other
+                const SIMD::Float8 b0 = SIMD::Broadcast4(other.m[0]);
+                const SIMD::Float8 b1 = SIMD::Broadcast4(other.m[1]);
+                const SIMD::Float8 b2 = SIMD::Broadcast4(other.m[2]);
+                const SIMD::Float8 b3 = SIMD::Broadcast4(other.m[3]);
+                for (int i = 0; i < 4; i += 2) {
+                    const SIMD::Float8 rows = SIMD::LoadUnaligned8(m[i]);
+                    SIMD::Float8 r = SIMD::Mul(SIMD::Swizzle<0, 0, 0, 0>(rows), b0);
+                    r = SIMD::MulAdd(SIMD::Swizzle<1, 1, 1, 1>(rows), b1, r);
+                    r = SIMD::MulAdd(SIMD::Swizzle<2, 2, 2, 2>(rows), b2, r);
+                    r = SIMD::MulAdd(SIMD::Swizzle<3, 3, 3, 3>(rows), b3, r);
+                    SIMD::StoreUnaligned(result.m[i], r);
+                }
+#else
+                const SIMD::Float4 b0 = SIMD::Load(other.m[0]);
+                const SIMD::Float4 b1 = SIMD::Load(other.m[1]);
+                const SIMD::Float4 b2 = SIMD::Load(other.m[2]);
+                const SIMD::Float4 b3 = SIMD::Load(other.m[3]);
+                for (int i = 0; i < 4; i++) {
+                    const SIMD::Float4 row = SIMD::Load(m[i]);
+                    SIMD::Float4 r = SIMD::Mul(SIMD::Swizzle<0, 0, 0, 0>(row), b0);
+                    r = SIMD::MulAdd(SIMD::Swizzle<1, 1, 1, 1>(row), b1, r);
+                    r = SIMD::MulAdd(SIMD::Swizzle<2, 2, 2, 2>(row), b2, r);
+                    r = SIMD::MulAdd(SIMD::Swizzle<3, 3, 3, 3>(row), b3, r);
+                    SIMD::Store(result.m[i], r);
+                }
+#endif
+                return result;
+            }
+#endif
             Matrix4x4 result;
             for (int i = 0; i < 4; i++) {
                 for (int j = 0; j < 4; j++) {
@@ -740,7 +1132,19 @@ namespace Reality {
             return result;
         }
 
-        Vector4 operator*(const Vector4& v) const {
+        constexpr Vector4 operator*(const Vector4& v) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                // Multiply every row by v, then transpose so the four horizontal sums become one add chain
+                const SIMD::Float4 vec = v.ToSIMD();
+                SIMD::Float4 r0 = SIMD::Mul(SIMD::Load(m[0]), vec);
+                SIMD::Float4 r1 = SIMD::Mul(SIMD::Load(m[1]), vec);
+                SIMD::Float4 r2 = SIMD::Mul(SIMD::Load(m[2]), vec);
+                SIMD::Float4 r3 = SIMD::Mul(SIMD::Load(m[3]), vec);
+                SIMD::Transpose(r0, r1, r2, r3);
+                return Vector4(SIMD::Add(SIMD::Add(r0, r1), SIMD::Add(r2, r3)));
+            }
+#endif
             return Vector4(
                 m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3] * v.w,
                 m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3] * v.w,
@@ -749,13 +1153,28 @@ namespace Reality {
             );
         }
 
-        Vector3 operator*(const Vector3& v) const {
+        constexpr Vector3 operator*(const Vector3& v) const {
             Vector4 result = *this * Vector4(v, 1.0f);
             return Vector3(result.x, result.y, result.z);
         }
 
         // Matrix operations
-        Matrix4x4 Transposed() const {
+        constexpr Matrix4x4 Transposed() const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                SIMD::Float4 r0 = SIMD::Load(m[0]);
+                SIMD::Float4 r1 = SIMD::Load(m[1]);
+                SIMD::Float4 r2 = SIMD::Load(m[2]);
+                SIMD::Float4 r3 = SIMD::Load(m[3]);
+                SIMD::Transpose(r0, r1, r2, r3);
+                Matrix4x4 result;
+                SIMD::Store(result.m[0], r0);
+                SIMD::Store(result.m[1], r1);
+                SIMD::Store(result.m[2], r2);
+                SIMD::Store(result.m[3], r3);
+                return result;
+            }
+#endif
             return Matrix4x4(
                 m[0][0], m[1][0], m[2][0], m[3][0],
                 m[0][1], m[1][1], m[2][1], m[3][1],
@@ -764,83 +1183,167 @@ namespace Reality {
             );
         }
 
-        Matrix4x4& Transpose() {
-            float tmp;
-            for (int i = 0; i < 4; i++) {
-                for (int j = i + 1; j < 4; j++) {
-                    tmp = m[i][j];
-                    m[i][j] = m[j][i];
-                    m[j][i] = tmp;
-                }
-            }
+        constexpr Matrix4x4& Transpose() {
+            *this = Transposed();
             return *this;
         }
 
-        Matrix4x4 Inverse() const {
-            // Compute the inverse of a 4x4 matrix using Gaussian elimination
-            Matrix4x4 result = Matrix4x4::Identity();
-            Matrix4x4 temp = *this;
-
-            for (int i = 0; i < 4; i++) {
-                // Find pivot
-                int pivot = i;
-                for (int j = i + 1; j < 4; j++) {
-                    if (Abs(temp.m[j][i]) > Abs(temp.m[pivot][i])) {
-                        pivot = j;
-                    }
+        // General inverse from the adjugate, without pivot search or
+        // data-dependent branches. Returns identity if the matrix is singular.
+        constexpr Matrix4x4 Inverse() const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                // Block-wise over the 2x2 sub-matrices | A B |
+                //                                      | C D |
+                const SIMD::Float4 r0 = SIMD::Load(m[0]);
+                const SIMD::Float4 r1 = SIMD::Load(m[1]);
+                const SIMD::Float4 r2 = SIMD::Load(m[2]);
+                const SIMD::Float4 r3 = SIMD::Load(m[3]);
+                const SIMD::Float4 A = SIMD::Shuffle<0, 1, 0, 1>(r0, r1);
+                const SIMD::Float4 B = SIMD::Shuffle<2, 3, 2, 3>(r0, r1);
+                const SIMD::Float4 C = SIMD::Shuffle<0, 1, 0, 1>(r2, r3);
+                const SIMD::Float4 D = SIMD::Shuffle<2, 3, 2, 3>(r2, r3);
+
+                // (|A|, |B|, |C|, |D|)
+                const SIMD::Float4 detSub = SIMD::Sub(
+                    SIMD::Mul(SIMD::Shuffle<0, 2, 0, 2>(r0, r2), SIMD::Shuffle<1, 3, 1, 3>(r1, r3)),
+                    SIMD::Mul(SIMD::Shuffle<1, 3, 1, 3>(r0, r2), SIMD::Shuffle<0, 2, 0, 2>(r1, r3)));
+                const SIMD::Float4 detA = SIMD::Swizzle<0, 0, 0, 0>(detSub);
+                const SIMD::Float4 detB = SIMD::Swizzle<1, 1, 1, 1>(detSub);
+                const SIMD::Float4 detC = SIMD::Swizzle<2, 2, 2, 2>(detSub);
+                const SIMD::Float4 detD = SIMD::Swizzle<3, 3, 3, 3>(detSub);
+
+                // Inverse = 1/|M| * | X Y |, computed as the adjugates of X, Y, Z and W
+                //                   | Z W |
+                const SIMD::Float4 DC = SIMD::Mat2AdjMul(D, C);
+                const SIMD::Float4 AB = SIMD::Mat2AdjMul(A, B);
+                SIMD::Float4 X = SIMD::Sub(SIMD::Mul(detD, A), SIMD::Mat2Mul(B, DC));
+                SIMD::Float4 W = SIMD::Sub(SIMD::Mul(detA, D), SIMD::Mat2Mul(C, AB));
+                SIMD::Float4 Y = SIMD::Sub(SIMD::Mul(detB, C), SIMD::Mat2MulAdj(D, AB));
+                SIMD::Float4 Z = SIMD::Sub(SIMD::Mul(detC, B), SIMD::Mat2MulAdj(A, DC));
+
+                // |M| = |A||D| + |B||C| - tr(Adj(A)B Adj(D)C)
+                SIMD::Float4 tr = SIMD::Mul(AB, SIMD::Swizzle<0, 2, 1, 3>(DC));
+                tr = SIMD::Add(tr, SIMD::Swizzle<1, 0, 3, 2>(tr));
+                tr = SIMD::Add(tr, SIMD::Swizzle<2, 3, 0, 1>(tr));
+                const SIMD::Float4 det = SIMD::Sub(SIMD::Add(SIMD::Mul(detA, detD), SIMD::Mul(detB, detC)), tr);
+                if (Abs(SIMD::GetX(det)) < FLT_MIN) {
+                    return Matrix4x4::Identity();
                 }
 
-                // Swap rows if needed
-                if (pivot != i) {
-                    for (int j = 0; j < 4; j++) {
-                        float tmp = temp.m[i][j];
-                        temp.m[i][j] = temp.m[pivot][j];
-                        temp.m[pivot][j] = tmp;
-
-                        tmp = result.m[i][j];
-                        result.m[i][j] = result.m[pivot][j];
-                        result.m[pivot][j] = tmp;
-                    }
-                }
+                const SIMD::Float4 invDet = SIMD::Div(SIMD::Set(1.0f, -1.0f, -1.0f, 1.0f), det);
+                X = SIMD::Mul(X, invDet);
+                Y = SIMD::Mul(Y, invDet);
+                Z = SIMD::Mul(Z, invDet);
+                W = SIMD::Mul(W, invDet);
+
+                // The adjugate shuffle and the block layout fold into one shuffle per row
+                Matrix4x4 result;
+                SIMD::Store(result.m[0], SIMD::Shuffle<3, 1, 3, 1>(X, Y));
+                SIMD::Store(result.m[1], SIMD::Shuffle<2, 0, 2, 0>(X, Y));
+                SIMD::Store(result.m[2], SIMD::Shuffle<3, 1, 3, 1>(Z, W));
+                SIMD::Store(result.m[3], SIMD::Shuffle<2, 0, 2, 0>(Z, W));
+                return result;
+            }
+#endif
+            // 2x2 determinants of the top two rows (s) and the bottom two rows (c)
+            const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+            const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+            const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+            const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+            const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+            const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+            const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+            const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+            const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+            const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+            const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+            const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+            const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            if (Abs(det) < FLT_MIN) {
+                return Matrix4x4::Identity();
+            }
 
-                // Singular matrix
-                if (Abs(temp.m[i][i]) < EPSILON) {
-                    return Matrix4x4::Identity(); // Return identity if not invertible
-                }
+            const float invDet = 1.0f / det;
+            return Matrix4x4(
+                ( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * invDet,
+                (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * invDet,
+                ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * invDet,
+                (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * invDet,
+
+                (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * invDet,
+                ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * invDet,
+                (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * invDet,
+                ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * invDet,
+
+                ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * invDet,
+                (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * invDet,
+                ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * invDet,
+                (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * invDet,
+
+                (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * invDet,
+                ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * invDet,
+                (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * invDet,
+                ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * invDet
+            );
+        }
 
-                // Normalize pivot row
-                float invPivot = 1.0f / temp.m[i][i];
-                for (int j = 0; j < 4; j++) {
-                    temp.m[i][j] *= invPivot;
-                    result.m[i][j] *= invPivot;
-                }
+        // Inverse of a matrix whose last row is (0, 0, 0, 1): rotation, scale
+        // and shear plus translation. Returns identity if the 3x3 part is singular.
+        constexpr Matrix4x4 InverseAffine() const {
+            const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+            const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+            const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
 
-                // Eliminate other rows
-                for (int j = 0; j < 4; j++) {
-                    if (j != i && Abs(temp.m[j][i]) > EPSILON) {
-                        float factor = temp.m[j][i];
-                        for (int k = 0; k < 4; k++) {
-                            temp.m[j][k] -= factor * temp.m[i][k];
-                            result.m[j][k] -= factor * result.m[i][k];
-                        }
-                    }
-                }
+            const float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+            if (Abs(det) < FLT_MIN) {
+                return Matrix4x4::Identity();
             }
 
-            return result;
+            const float invDet = 1.0f / det;
+            const float i00 = c00 * invDet;
+            const float i01 = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+            const float i02 = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+            const float i10 = c01 * invDet;
+            const float i11 = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+            const float i12 = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+            const float i20 = c02 * invDet;
+            const float i21 = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+            const float i22 = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+            const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+            return Matrix4x4(
+                i00, i01, i02, -(i00 * tx + i01 * ty + i02 * tz),
+                i10, i11, i12, -(i10 * tx + i11 * ty + i12 * tz),
+                i20, i21, i22, -(i20 * tx + i21 * ty + i22 * tz),
+                0.0f, 0.0f, 0.0f, 1.0f
+            );
+        }
+
+        // Inverse of an orthonormal rotation plus translation (cameras, rigid
+        // bodies): transposes the rotation and rotates the translation back.
+        constexpr Matrix4x4 InverseRigid() const {
+            const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+            return Matrix4x4(
+                m[0][0], m[1][0], m[2][0], -(m[0][0] * tx + m[1][0] * ty + m[2][0] * tz),
+                m[0][1], m[1][1], m[2][1], -(m[0][1] * tx + m[1][1] * ty + m[2][1] * tz),
+                m[0][2], m[1][2], m[2][2], -(m[0][2] * tx + m[1][2] * ty + m[2][2] * tz),
+                0.0f,    0.0f,    0.0f,    1.0f
+            );
         }
 
         // Static methods
-        static Matrix4x4 Zero() {
-            return Matrix4x4();
+        static constexpr Matrix4x4 Zero() {
+            return Matrix4x4(0.0f);
         }
 
-        static Matrix4x4 Identity() {
+        static constexpr Matrix4x4 Identity() {
             return Matrix4x4(1.0f);
         }
 
         // Factory methods
-        static Matrix4x4 Translation(const Vector3& t) {
+        static constexpr Matrix4x4 Translation(const Vector3& t) {
             return Matrix4x4(
                 1.0f, 0.0f, 0.0f, t.x,
                 0.0f, 1.0f, 0.0f, t.y,
@@ -849,7 +1352,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 RotationX(float angle) {
+        static constexpr Matrix4x4 RotationX(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix4x4(
@@ -860,7 +1363,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 RotationY(float angle) {
+        static constexpr Matrix4x4 RotationY(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix4x4(
@@ -871,7 +1374,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 RotationZ(float angle) {
+        static constexpr Matrix4x4 RotationZ(float angle) {
             float c = Cos(angle);
             float s = Sin(angle);
             return Matrix4x4(
@@ -882,7 +1385,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 RotationAxis(const Vector3& axis, float angle) {
+        static constexpr Matrix4x4 RotationAxis(const Vector3& axis, float angle) {
             Vector3 a = axis.Normalized();
             float c = Cos(angle);
             float s = Sin(angle);
@@ -896,7 +1399,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 Scale(float s) {
+        static constexpr Matrix4x4 Scale(float s) {
             return Matrix4x4(
                 s, 0.0f, 0.0f, 0.0f,
                 0.0f, s, 0.0f, 0.0f,
@@ -905,7 +1408,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 Scale(const Vector3& s) {
+        static constexpr Matrix4x4 Scale(const Vector3& s) {
             return Matrix4x4(
                 s.x, 0.0f, 0.0f, 0.0f,
                 0.0f, s.y, 0.0f, 0.0f,
@@ -915,7 +1418,7 @@ namespace Reality {
         }
 
         // Projection matrices
-        static Matrix4x4 Perspective(float fovy, float aspect, float nearPlane, float farPlane) {
+        static constexpr Matrix4x4 Perspective(float fovy, float aspect, float nearPlane, float farPlane) {
             float f = 1.0f / Tan(fovy * 0.5f);
             float nf = 1.0f / (nearPlane - farPlane);
 
@@ -927,7 +1430,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 Orthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane) {
+        static constexpr Matrix4x4 Orthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane) {
             float rl = 1.0f / (right - left);
             float tb = 1.0f / (top - bottom);
             float fn = 1.0f / (farPlane - nearPlane);
@@ -940,7 +1443,7 @@ namespace Reality {
             );
         }
 
-        static Matrix4x4 LookAt(const Vector3& eye, const Vector3& target, const Vector3& up) {
+        static constexpr Matrix4x4 LookAt(const Vector3& eye, const Vector3& target, const Vector3& up) {
             Vector3 zAxis = (eye - target).Normalized();
             Vector3 xAxis = up.Cross(zAxis).Normalized();
             Vector3 yAxis = zAxis.Cross(xAxis);
@@ -954,14 +1457,14 @@ namespace Reality {
         }
     };
 
-    // Quaternion - for rotations
-    struct Quaternion {
+    // Quaternion - for rotations, 16-byte aligned for SIMD loads
+    struct alignas(16) Quaternion {
         float x, y, z, w;
 
         // Constructors
-        Quaternion() : x(0), y(0), z(0), w(1) {}
-        Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
-        explicit Quaternion(const Vector3& axis, float angle) {
+        Quaternion() = default;
+        constexpr Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+        constexpr explicit Quaternion(const Vector3& axis, float angle) {
             Vector3 a = axis.Normalized();
             float s = Sin(angle * 0.5f);
             x = a.x * s;
@@ -970,6 +1473,11 @@ namespace Reality {
             w = Cos(angle * 0.5f);
         }
 
+#if defined(REALITY_SIMD_SSE)
+        explicit Quaternion(SIMD::Float4 v) { SIMD::Store(&x, v); }
+        SIMD::Float4 ToSIMD() const { return SIMD::Load(&x); }
+#endif
+
         // Access operators
         float& operator[](int index) {
             assert(index >= 0 && index < 4);
@@ -982,20 +1490,48 @@ namespace Reality {
         }
 
         // Unary operators
-        Quaternion operator-() const {
+        constexpr Quaternion operator-() const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Quaternion(SIMD::Negate(ToSIMD()));
+            }
+#endif
             return Quaternion(-x, -y, -z, -w);
         }
 
         // Binary operators
-        Quaternion operator+(const Quaternion& q) const {
+        constexpr Quaternion operator+(const Quaternion& q) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Quaternion(SIMD::Add(ToSIMD(), q.ToSIMD()));
+            }
+#endif
             return Quaternion(x + q.x, y + q.y, z + q.z, w + q.w);
         }
 
-        Quaternion operator-(const Quaternion& q) const {
+        constexpr Quaternion operator-(const Quaternion& q) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Quaternion(SIMD::Sub(ToSIMD(), q.ToSIMD()));
+            }
+#endif
             return Quaternion(x - q.x, y - q.y, z - q.z, w - q.w);
         }
 
-        Quaternion operator*(const Quaternion& q) const {
+        constexpr Quaternion operator*(const Quaternion& q) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                // Same four terms as the scalar path, one lane per component
+                const SIMD::Float4 a = ToSIMD();
+                const SIMD::Float4 b = q.ToSIMD();
+                const SIMD::Float4 wSign = SIMD::SignMask(false, false, false, true);
+                SIMD::Float4 r = SIMD::Mul(SIMD::Swizzle<3, 3, 3, 3>(a), b);
+                r = SIMD::Add(r, SIMD::FlipSign(SIMD::Mul(SIMD::Swizzle<0, 1, 2, 0>(a), SIMD::Swizzle<3, 3, 3, 0>(b)), wSign));
+                r = SIMD::Add(r, SIMD::FlipSign(SIMD::Mul(SIMD::Swizzle<1, 2, 0, 1>(a), SIMD::Swizzle<2, 0, 1, 1>(b)), wSign));
+                r = SIMD::Sub(r, SIMD::Mul(SIMD::Swizzle<2, 0, 1, 2>(a), SIMD::Swizzle<1, 2, 0, 2>(b)));
+                return Quaternion(r);
+            }
+#endif
             return Quaternion(
                 w * q.x + x * q.w + y * q.z - z * q.y,
                 w * q.y + y * q.w + z * q.x - x * q.z,
@@ -1004,94 +1540,96 @@ namespace Reality {
             );
         }
 
-        Quaternion operator*(float s) const {
+        constexpr Quaternion operator*(float s) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Quaternion(SIMD::Mul(ToSIMD(), SIMD::Splat(s)));
+            }
+#endif
             return Quaternion(x * s, y * s, z * s, w * s);
         }
 
-        Vector3 operator*(const Vector3& v) const {
-            // Convert quaternion to matrix and multiply
-            return ToMatrix4x4() * v;
+        constexpr Vector3 operator*(const Vector3& v) const {
+            // v + 2w(u x v) + 2u x (u x v), without building a matrix
+            Vector3 u(x, y, z);
+            Vector3 t = u.Cross(v) * 2.0f;
+            return v + t * w + u.Cross(t);
         }
 
         // Assignment operators
-        Quaternion& operator+=(const Quaternion& q) {
-            x += q.x;
-            y += q.y;
-            z += q.z;
-            w += q.w;
+        constexpr Quaternion& operator+=(const Quaternion& q) {
+            *this = *this + q;
             return *this;
         }
 
-        Quaternion& operator-=(const Quaternion& q) {
-            x -= q.x;
-            y -= q.y;
-            z -= q.z;
-            w -= q.w;
+        constexpr Quaternion& operator-=(const Quaternion& q) {
+            *this = *this - q;
             return *this;
         }
 
-        Quaternion& operator*=(const Quaternion& q) {
+        constexpr Quaternion& operator*=(const Quaternion& q) {
             *this = *this * q;
             return *this;
         }
 
-        Quaternion& operator*=(float s) {
-            x *= s;
-            y *= s;
-            z *= s;
-            w *= s;
+        constexpr Quaternion& operator*=(float s) {
+            *this = *this * s;
             return *this;
         }
 
         // Quaternion operations
-        float Length() const {
-            return Sqrt(x * x + y * y + z * z + w * w);
+        constexpr float Length() const {
+            return Sqrt(LengthSquared());
         }
 
-        float LengthSquared() const {
-            return x * x + y * y + z * z + w * w;
+        constexpr float LengthSquared() const {
+            return Dot(*this);
         }
 
-        Quaternion Normalized() const {
+        constexpr Quaternion Normalized() const {
             float len = Length();
             if (len > EPSILON) {
-                float inv = 1.0f / len;
-                return Quaternion(x * inv, y * inv, z * inv, w * inv);
+                return *this * (1.0f / len);
             }
             return Quaternion(0, 0, 0, 1);
         }
 
-        Quaternion& Normalize() {
+        constexpr Quaternion& Normalize() {
             float len = Length();
             if (len > EPSILON) {
-                float inv = 1.0f / len;
-                x *= inv;
-                y *= inv;
-                z *= inv;
-                w *= inv;
+                *this *= 1.0f / len;
             }
             return *this;
         }
 
-        Quaternion Conjugate() const {
+        constexpr Quaternion Conjugate() const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return Quaternion(SIMD::FlipSign(ToSIMD(), SIMD::SignMask(true, true, true, false)));
+            }
+#endif
             return Quaternion(-x, -y, -z, w);
         }
 
-        Quaternion Inverse() const {
+        constexpr Quaternion Inverse() const {
             float lenSq = LengthSquared();
             if (lenSq > EPSILON) {
-                float inv = 1.0f / lenSq;
-                return Quaternion(-x * inv, -y * inv, -z * inv, w * inv);
+                return Conjugate() * (1.0f / lenSq);
             }
             return Quaternion(0, 0, 0, 1);
         }
 
-        float Dot(const Quaternion& q) const {
+        constexpr float Dot(const Quaternion& q) const {
+#if defined(REALITY_SIMD_SSE)
+            if (!std::is_constant_evaluated()) {
+                return SIMD::GetX(SIMD::Dot4(ToSIMD(), q.ToSIMD()));
+            }
+#endif
             return x * q.x + y * q.y + z * q.z + w * q.w;
         }
 
         // Conversion functions
-        Matrix3x3 ToMatrix3x3() const {
+        constexpr Matrix3x3 ToMatrix3x3() const {
             float xx = x * x;
             float xy = x * y;
             float xz = x * z;
@@ -1110,7 +1648,7 @@ namespace Reality {
             );
         }
 
-        Matrix4x4 ToMatrix4x4() const {
+        constexpr Matrix4x4 ToMatrix4x4() const {
             float xx = x * x;
             float xy = x * y;
             float xz = x * z;
@@ -1131,12 +1669,12 @@ namespace Reality {
         }
 
         // Static methods
-        static Quaternion Identity() {
+        static constexpr Quaternion Identity() {
             return Quaternion(0, 0, 0, 1);
         }
 
         // Factory methods
-        static Quaternion FromEulerAngles(float pitch, float yaw, float roll) {
+        static constexpr Quaternion FromEulerAngles(float pitch, float yaw, float roll) {
             float cp = Cos(pitch * 0.5f);
             float sp = Sin(pitch * 0.5f);
             float cy = Cos(yaw * 0.5f);
@@ -1152,7 +1690,7 @@ namespace Reality {
             );
         }
 
-        static Quaternion FromMatrix3x3(const Matrix3x3& m) {
+        static constexpr Quaternion FromMatrix3x3(const Matrix3x3& m) {
             float trace = m[0][0] + m[1][1] + m[2][2];
             Quaternion q;
 
@@ -1183,7 +1721,7 @@ namespace Reality {
             return q;
         }
 
-        static Quaternion FromMatrix4x4(const Matrix4x4& m) {
+        static constexpr Quaternion FromMatrix4x4(const Matrix4x4& m) {
             return FromMatrix3x3(Matrix3x3(
                 m[0][0], m[0][1], m[0][2],
                 m[1][0], m[1][1], m[1][2],
@@ -1205,42 +1743,338 @@ namespace Reality {
                 return (a * (1.0f - t) + b * t).Normalized();
             }
 
-            float theta = ACos(cosTheta);
-            float sinTheta = Sin(theta);
-            float t1 = Sin((1.0f - t) * theta) / sinTheta;
-            float t2 = Sin(t * theta) / sinTheta;
+            const float theta = Approx::ACos<Precision::Precise>(cosTheta);
+#if defined(REALITY_SIMD_SSE)
+            // sin(theta), sin((1 - t) * theta) and sin(t * theta) in one call
+            alignas(16) float sines[4];
+            SIMD::Store(sines, Approx::Sin<Precision::Precise>(
+                SIMD::Mul(SIMD::Set(1.0f, 1.0f - t, t, 0.0f), SIMD::Splat(theta))));
+            const float invSinTheta = 1.0f / sines[0];
+            const float t1 = sines[1] * invSinTheta;
+            const float t2 = sines[2] * invSinTheta;
+#else
+            const float invSinTheta = 1.0f / Approx::Sin<Precision::Precise>(theta);
+            const float t1 = Approx::Sin<Precision::Precise>((1.0f - t) * theta) * invSinTheta;
+            const float t2 = Approx::Sin<Precision::Precise>(t * theta) * invSinTheta;
+#endif
 
             return a * t1 + b * t2;
         }
     };
 
     // Utility functions
-    inline Vector3 TransformPoint(const Matrix4x4& m, const Vector3& p) {
+    constexpr Vector3 TransformPoint(const Matrix4x4& m, const Vector3& p) {
         Vector4 result = m * Vector4(p, 1.0f);
         return Vector3(result.x, result.y, result.z);
     }
 
-    inline Vector3 TransformVector(const Matrix4x4& m, const Vector3& v) {
+    constexpr Vector3 TransformVector(const Matrix4x4& m, const Vector3& v) {
         Vector4 result = m * Vector4(v, 0.0f);
         return Vector3(result.x, result.y, result.z);
     }
 
-    inline Vector3 TransformNormal(const Matrix4x4& m, const Vector3& n) {
-        // Use inverse transpose for normal transformation
-        Matrix4x4 invTrans = m.Inverse().Transposed();
-        Vector4 result = invTrans * Vector4(n, 0.0f);
-        return Vector3(result.x, result.y, result.z).Normalized();
+    // Inverse transpose of the upper 3x3 part, which keeps normals
+    // perpendicular to transformed surfaces. Compute it once per transform
+    // and reuse it for every normal. If the transform flattens an axis the
+    // undivided cofactors are returned, they still map normals onto it.
+    constexpr Matrix3x3 NormalMatrix(const Matrix4x4& m) {
+        const Matrix3x3 cofactors(
+            m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1],
+            m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2],
+            m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0],
+            m.m[0][2] * m.m[2][1] - m.m[0][1] * m.m[2][2],
+            m.m[0][0] * m.m[2][2] - m.m[0][2] * m.m[2][0],
+            m.m[0][1] * m.m[2][0] - m.m[0][0] * m.m[2][1],
+            m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1],
+            m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2],
+            m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0]
+        );
+
+        const float det = m.m[0][0] * cofactors.m[0][0] + m.m[0][1] * cofactors.m[0][1] + m.m[0][2] * cofactors.m[0][2];
+        if (Abs(det) < FLT_MIN) {
+            return cofactors;
+        }
+
+        const float invDet = 1.0f / det;
+        Matrix3x3 result;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                result.m[i][j] = cofactors.m[i][j] * invDet;
+            }
+        }
+        return result;
+    }
+
+    constexpr Vector3 TransformNormal(const Matrix3x3& normalMatrix, const Vector3& n) {
+        return (normalMatrix * n).Normalized();
+    }
+
+    constexpr Vector3 TransformNormal(const Matrix4x4& m, const Vector3& n) {
+        return TransformNormal(NormalMatrix(m), n);
     }
 
-    // Matrix layout conversion utilities
+    // Transform - translation, rotation and scale, applied scale first
+    struct Transform {
+        Vector3 translation;
+        Quaternion rotation;
+        Vector3 scale;
+
+        // Constructors
+        Transform() = default;
+        constexpr Transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+            : translation(translation), rotation(rotation), scale(scale) {}
+
+        // Translation(t) * rotation * Scale(s), built without the two multiplies
+        constexpr Matrix4x4 ToMatrix4x4() const {
+            Matrix4x4 result = rotation.ToMatrix4x4();
+            for (int row = 0; row < 3; row++) {
+                result.m[row][0] *= scale.x;
+                result.m[row][1] *= scale.y;
+                result.m[row][2] *= scale.z;
+            }
+            result.m[0][3] = translation.x;
+            result.m[1][3] = translation.y;
+            result.m[2][3] = translation.z;
+            return result;
+        }
+
+        constexpr Vector3 TransformPoint(const Vector3& p) const {
+            return translation + rotation * (scale * p);
+        }
+
+        static constexpr Transform Identity() {
+            return Transform(Vector3::Zero(), Quaternion::Identity(), Vector3::One());
+        }
+    };
+
+    // AABB - axis-aligned bounding box
+    struct AABB {
+        Vector3 min;
+        Vector3 max;
+
+        // Constructors
+        AABB() = default;
+        constexpr AABB(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+        static constexpr AABB FromCenterExtents(const Vector3& center, const Vector3& extents) {
+            return AABB(center - extents, center + extents);
+        }
+
+        // Inverted box that any Expand call replaces
+        static constexpr AABB Empty() {
+            return AABB(Vector3(INFINITY, INFINITY, INFINITY), Vector3(-INFINITY, -INFINITY, -INFINITY));
+        }
+
+        constexpr Vector3 Center() const { return (min + max) * 0.5f; }
+        constexpr Vector3 Extents() const { return (max - min) * 0.5f; }
+        constexpr Vector3 Size() const { return max - min; }
+
+        constexpr bool IsValid() const {
+            return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+        }
+
+        constexpr bool Contains(const Vector3& p) const {
+            return p.x >= min.x && p.x <= max.x &&
+                   p.y >= min.y && p.y <= max.y &&
+                   p.z >= min.z && p.z <= max.z;
+        }
+
+        constexpr bool Intersects(const AABB& other) const {
+            return min.x <= other.max.x && max.x >= other.min.x &&
+                   min.y <= other.max.y && max.y >= other.min.y &&
+                   min.z <= other.max.z && max.z >= other.min.z;
+        }
+
+        constexpr AABB& Expand(const Vector3& p) {
+            min = Vector3::Min(min, p);
+            max = Vector3::Max(max, p);
+            return *this;
+        }
+
+        constexpr AABB& Expand(const AABB& other) {
+            min = Vector3::Min(min, other.min);
+            max = Vector3::Max(max, other.max);
+            return *this;
+        }
+
+        // Box enclosing this box after an affine transform
+        constexpr AABB Transformed(const Matrix4x4& m) const {
+            const Vector3 center = TransformPoint(m, Center());
+            const Vector3 extents = Extents();
+            const Vector3 newExtents(
+                Abs(m.m[0][0]) * extents.x + Abs(m.m[0][1]) * extents.y + Abs(m.m[0][2]) * extents.z,
+                Abs(m.m[1][0]) * extents.x + Abs(m.m[1][1]) * extents.y + Abs(m.m[1][2]) * extents.z,
+                Abs(m.m[2][0]) * extents.x + Abs(m.m[2][1]) * extents.y + Abs(m.m[2][2]) * extents.z
+            );
+            return FromCenterExtents(center, newExtents);
+        }
+    };
+
+    // Ray - distances along the ray are in units of the direction's length
+    struct Ray {
+        Vector3 origin;
+        Vector3 direction;
+
+        // Constructors
+        Ray() = default;
+        constexpr Ray(const Vector3& origin, const Vector3& direction) : origin(origin), direction(direction) {}
+
+        constexpr Vector3 GetPoint(float distance) const {
+            return origin + direction * distance;
+        }
+
+        // Reciprocal direction for slab tests. Zero components map to a huge
+        // finite value instead of infinity, so a ray running inside a slab plane
+        // gives 0 * x rather than NaN.
+        Vector3 GetInverseDirection() const {
+            const auto inverse = [](float d) { return 1.0f / (Abs(d) > 1e-30f ? d : std::copysign(1e-30f, d)); };
+            return Vector3(inverse(direction.x), inverse(direction.y), inverse(direction.z));
+        }
+
+        // Slab test against a box. distance is where the ray enters it, 0 if the
+        // origin is inside.
+        bool Intersects(const AABB& box, float maxDistance, float& distance) const {
+            const Vector3 inverse = GetInverseDirection();
+            const Vector3 t0 = (box.min - origin) * inverse;
+            const Vector3 t1 = (box.max - origin) * inverse;
+            const float tNear = Max(Max(Min(t0.x, t1.x), Min(t0.y, t1.y)), Max(Min(t0.z, t1.z), 0.0f));
+            const float tFar = Min(Min(Max(t0.x, t1.x), Max(t0.y, t1.y)), Min(Max(t0.z, t1.z), maxDistance));
+            distance = tNear;
+            return tNear <= tFar;
+        }
+    };
+
+    // BoundingSphere
+    struct BoundingSphere {
+        Vector3 center;
+        float radius;
+
+        // Constructors
+        BoundingSphere() = default;
+        constexpr BoundingSphere(const Vector3& center, float radius) : center(center), radius(radius) {}
+
+        // Sphere enclosing the box
+        static constexpr BoundingSphere FromAABB(const AABB& box) {
+            return BoundingSphere(box.Center(), box.Extents().Length());
+        }
+
+        constexpr bool Contains(const Vector3& p) const {
+            return (p - center).LengthSquared() <= radius * radius;
+        }
+
+        constexpr bool Intersects(const BoundingSphere& other) const {
+            const float r = radius + other.radius;
+            return (other.center - center).LengthSquared() <= r * r;
+        }
+
+        constexpr bool Intersects(const AABB& box) const {
+            const Vector3 closest = Vector3::Min(Vector3::Max(center, box.min), box.max);
+            return (closest - center).LengthSquared() <= radius * radius;
+        }
+    };
+
+    // Plane - points p with normal.Dot(p) + d == 0, normal points to the positive side
+    struct Plane {
+        Vector3 normal;
+        float d;
+
+        // Constructors
+        Plane() = default;
+        constexpr Plane(const Vector3& normal, float d) : normal(normal), d(d) {}
+        constexpr Plane(float a, float b, float c, float d) : normal(a, b, c), d(d) {}
+
+        constexpr float Distance(const Vector3& p) const {
+            return normal.Dot(p) + d;
+        }
+
+        constexpr Plane Normalized() const {
+            const float len = normal.Length();
+            if (len > EPSILON) {
+                const float inv = 1.0f / len;
+                return Plane(normal * inv, d * inv);
+            }
+            return *this;
+        }
+    };
+
+    // Frustum - six inward-facing planes
+    struct Frustum {
+        enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+        Plane planes[PlaneCount];
+
+        // Extracts the planes of a view-projection matrix (column vectors,
+        // clip = viewProjection * p). zeroToOneDepth selects the D3D clip depth
+        // range, the default matches Matrix4x4::Perspective (-w to w).
+        static constexpr Frustum FromViewProjection(const Matrix4x4& viewProjection, bool zeroToOneDepth = false) {
+            const auto& m = viewProjection.m;
+            auto combine = [&m](int row, float sign) {
+                return Plane(m[3][0] + sign * m[row][0], m[3][1] + sign * m[row][1],
+                             m[3][2] + sign * m[row][2], m[3][3] + sign * m[row][3]).Normalized();
+            };
+
+            Frustum frustum;
+            frustum.planes[Left] = combine(0, 1.0f);
+            frustum.planes[Right] = combine(0, -1.0f);
+            frustum.planes[Bottom] = combine(1, 1.0f);
+            frustum.planes[Top] = combine(1, -1.0f);
+            frustum.planes[Near] = zeroToOneDepth
+                ? Plane(m[2][0], m[2][1], m[2][2], m[2][3]).Normalized()
+                : combine(2, 1.0f);
+            frustum.planes[Far] = combine(2, -1.0f);
+            return frustum;
+        }
+
+        constexpr bool Contains(const Vector3& p) const {
+            for (const Plane& plane : planes) {
+                if (plane.Distance(p) < 0.0f) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Conservative tests, true when the volume may be inside
+        constexpr bool Intersects(const BoundingSphere& sphere) const {
+            for (const Plane& plane : planes) {
+                if (plane.Distance(sphere.center) < -sphere.radius) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        constexpr bool Intersects(const AABB& box) const {
+            return IntersectsCenterExtents(box.Center(), box.Extents());
+        }
+
+        // Box given as center and half size, the layout the batch kernels use
+        constexpr bool IntersectsCenterExtents(const Vector3& center, const Vector3& extents) const {
+            for (const Plane& plane : planes) {
+                const float radius = Abs(plane.normal.x) * extents.x +
+                                     Abs(plane.normal.y) * extents.y +
+                                     Abs(plane.normal.z) * extents.z;
+                if (plane.Distance(center) < -radius) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Matrix layout conversion utilities, superseded by PackedMatrix4x4 and
+    // BackendMatrix4x4, which keep the storage order in the type and write
+    // uploads without an intermediate transposed copy.
     namespace MatrixLayout {
         // Convert from column-major (GLM/Vulkan style) to row-major (D3D style)
-        inline Matrix4x4 ColumnMajorToRowMajor(const Matrix4x4& m) {
+        [[deprecated("Use PackedMatrix4x4<MatrixStorage::ColumnMajor>::ToMatrix")]]
+        constexpr Matrix4x4 ColumnMajorToRowMajor(const Matrix4x4& m) {
             return m.Transposed();
         }
 
         // Convert from row-major (D3D style) to column-major (GLM/Vulkan style)
-        inline Matrix4x4 RowMajorToColumnMajor(const Matrix4x4& m) {
+        [[deprecated("Use PackedMatrix4x4<MatrixStorage::ColumnMajor> or BackendMatrix4x4")]]
+        constexpr Matrix4x4 RowMajorToColumnMajor(const Matrix4x4& m) {
             return m.Transposed();
         }
     }
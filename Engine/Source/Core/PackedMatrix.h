@@ -0,0 +1,179 @@
+﻿#pragma once
+#include "MathF.h"
+#include <span>
+
+namespace Reality {
+    // Memory order of a matrix shared with shaders. RowMajor is Matrix4x4's
+    // own order, ColumnMajor is the default packing of HLSL, GLSL and MSL.
+    enum class MatrixStorage {
+        RowMajor,
+        ColumnMajor
+    };
+
+    // PackedMatrix4x4 - a Matrix4x4 stored in the order a backend's shaders
+    // read it, so it copies into constant memory as is. Rows of vectors
+    // hold rows for RowMajor and columns for ColumnMajor, and products are
+    // computed in that order directly: with column vectors, a product's
+    // columns are sums of the left matrix's columns, its rows sums of the
+    // right matrix's rows. Left uninitialized by the default constructor.
+    template<MatrixStorage Storage>
+    struct alignas(16) PackedMatrix4x4 {
+        float vectors[4][4];
+
+        PackedMatrix4x4() = default;
+
+        explicit PackedMatrix4x4(const Matrix4x4& matrix) {
+            Pack(matrix, vectors[0]);
+        }
+
+        float Get(int row, int column) const {
+            return Storage == MatrixStorage::RowMajor ? vectors[row][column] : vectors[column][row];
+        }
+
+        void Set(int row, int column, float value) {
+            (Storage == MatrixStorage::RowMajor ? vectors[row][column] : vectors[column][row]) = value;
+        }
+
+        Matrix4x4 ToMatrix() const {
+            Matrix4x4 result;
+            if constexpr (Storage == MatrixStorage::RowMajor) {
+                memcpy(result.m, vectors, sizeof(vectors));
+            } else {
+                Transpose(vectors[0], result.m[0]);
+            }
+            return result;
+        }
+
+        // this * other, both packed
+        PackedMatrix4x4 operator*(const PackedMatrix4x4& other) const {
+            PackedMatrix4x4 result;
+            if constexpr (Storage == MatrixStorage::RowMajor) {
+                Combine<false>(vectors, other.vectors, result.vectors);
+            } else {
+                Combine<false>(other.vectors, vectors, result.vectors);
+            }
+            return result;
+        }
+
+        // this * other with other in Matrix4x4's order, as in a view-projection
+        // packed once per frame times each object's world matrix
+        PackedMatrix4x4 operator*(const Matrix4x4& other) const {
+            PackedMatrix4x4 result;
+            Multiply(*this, other, result.vectors[0]);
+            return result;
+        }
+
+        // Writes a * b to destination, which needs no alignment
+        static void Multiply(const PackedMatrix4x4& a, const Matrix4x4& b, float* destination) {
+            float (*out)[4] = reinterpret_cast<float (*)[4]>(destination);
+            if constexpr (Storage == MatrixStorage::RowMajor) {
+                // Row i is the sum of b's rows weighted by a's row i
+                Combine<false>(a.vectors, b.m, out);
+            } else {
+                // Column j is the sum of a's columns weighted by b's column j
+                Combine<true>(b.m, a.vectors, out);
+            }
+        }
+
+        // Writes matrix in Storage order to destination, which needs no alignment
+        static void Pack(const Matrix4x4& matrix, float* destination) {
+            if constexpr (Storage == MatrixStorage::RowMajor) {
+                memcpy(destination, matrix.m, sizeof(matrix.m));
+            } else {
+                Transpose(matrix.m[0], destination);
+            }
+        }
+
+    private:
+        // out[i] = sum over k of weights(i, k) * basis[k], with weights(i, k)
+        // read from weights[k][i] when TransposedWeights is set
+        template<bool TransposedWeights>
+        static void Combine(const float (*weights)[4], const float (*basis)[4], float (*out)[4]) {
+#if defined(REALITY_SIMD_SSE)
+            const SIMD::Float4 v0 = SIMD::LoadUnaligned(basis[0]);
+            const SIMD::Float4 v1 = SIMD::LoadUnaligned(basis[1]);
+            const SIMD::Float4 v2 = SIMD::LoadUnaligned(basis[2]);
+            const SIMD::Float4 v3 = SIMD::LoadUnaligned(basis[3]);
+            for (int i = 0; i < 4; i++) {
+                const auto weight = [weights, i](int k) { return TransposedWeights ? weights[k][i] : weights[i][k]; };
+                SIMD::Float4 r = SIMD::Mul(SIMD::Splat(weight(0)), v0);
+                r = SIMD::MulAdd(SIMD::Splat(weight(1)), v1, r);
+                r = SIMD::MulAdd(SIMD::Splat(weight(2)), v2, r);
+                r = SIMD::MulAdd(SIMD::Splat(weight(3)), v3, r);
+                SIMD::StoreUnaligned(out[i], r);
+            }
+#else
+            for (int i = 0; i < 4; i++) {
+                float r[4] = {};
+                for (int k = 0; k < 4; k++) {
+                    const float weight = TransposedWeights ? weights[k][i] : weights[i][k];
+                    for (int j = 0; j < 4; j++) {
+                        r[j] += weight * basis[k][j];
+                    }
+                }
+                memcpy(out[i], r, sizeof(r));
+            }
+#endif
+        }
+
+        static void Transpose(const float* source, float* destination) {
+#if defined(REALITY_SIMD_SSE)
+            SIMD::Float4 r0 = SIMD::LoadUnaligned(source);
+            SIMD::Float4 r1 = SIMD::LoadUnaligned(source + 4);
+            SIMD::Float4 r2 = SIMD::LoadUnaligned(source + 8);
+            SIMD::Float4 r3 = SIMD::LoadUnaligned(source + 12);
+            SIMD::Transpose(r0, r1, r2, r3);
+            SIMD::StoreUnaligned(destination, r0);
+            SIMD::StoreUnaligned(destination + 4, r1);
+            SIMD::StoreUnaligned(destination + 8, r2);
+            SIMD::StoreUnaligned(destination + 12, r3);
+#else
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    destination[j * 4 + i] = source[i * 4 + j];
+                }
+            }
+#endif
+        }
+    };
+
+    using RowMajorMatrix4x4 = PackedMatrix4x4<MatrixStorage::RowMajor>;
+    using ColumnMajorMatrix4x4 = PackedMatrix4x4<MatrixStorage::ColumnMajor>;
+
+    // Zero-copy writes into mapped constant memory, with no staging matrix.
+    // destination needs no alignment.
+
+    template<MatrixStorage Storage>
+    void WriteMatrix(void* destination, const PackedMatrix4x4<Storage>& matrix) {
+        memcpy(destination, matrix.vectors, sizeof(matrix.vectors));
+    }
+
+    template<MatrixStorage Storage>
+    void WriteMatrix(void* destination, const Matrix4x4& matrix) {
+        PackedMatrix4x4<Storage>::Pack(matrix, static_cast<float*>(destination));
+    }
+
+    // For code that picks its backend at run time
+    inline void WriteMatrix(MatrixStorage storage, void* destination, const Matrix4x4& matrix) {
+        if (storage == MatrixStorage::RowMajor) {
+            WriteMatrix<MatrixStorage::RowMajor>(destination, matrix);
+        } else {
+            WriteMatrix<MatrixStorage::ColumnMajor>(destination, matrix);
+        }
+    }
+
+    // Writes a * b, for example a packed view-projection times a world matrix
+    template<MatrixStorage Storage>
+    void WriteMatrixProduct(void* destination, const PackedMatrix4x4<Storage>& a, const Matrix4x4& b) {
+        PackedMatrix4x4<Storage>::Multiply(a, b, static_cast<float*>(destination));
+    }
+
+    // Writes a * b[i] at destination + i * stride bytes, one per object
+    template<MatrixStorage Storage>
+    void WriteMatrixProducts(void* destination, size_t stride, const PackedMatrix4x4<Storage>& a, std::span<const Matrix4x4> b) {
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        for (size_t i = 0; i < b.size(); i++) {
+            PackedMatrix4x4<Storage>::Multiply(a, b[i], reinterpret_cast<float*>(out + i * stride));
+        }
+    }
+}
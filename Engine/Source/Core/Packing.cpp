@@ -0,0 +1,317 @@
+﻿#include "Packing.h"
+
+namespace Reality {
+    namespace {
+        inline uint8_t* Element(void* base, size_t stride, size_t index) {
+            return static_cast<uint8_t*>(base) + index * stride;
+        }
+
+        inline const uint8_t* Element(const void* base, size_t stride, size_t index) {
+            return static_cast<const uint8_t*>(base) + index * stride;
+        }
+
+        template<typename T, size_t N>
+        inline void WriteElement(void* base, size_t stride, size_t index, const T (&values)[N]) {
+            memcpy(Element(base, stride, index), values, sizeof(values));
+        }
+
+        template<typename T, size_t N>
+        inline void ReadElement(const void* base, size_t stride, size_t index, T (&values)[N]) {
+            memcpy(values, Element(base, stride, index), sizeof(values));
+        }
+
+#if defined(REALITY_SIMD_SSE)
+        using Int4 = __m128i;
+
+        // mask ? b : a
+        inline Int4 SelectInt(Int4 a, Int4 b, Int4 mask) {
+            return _mm_or_si128(_mm_andnot_si128(mask, a), _mm_and_si128(mask, b));
+        }
+
+        // 32-bit lane k of v
+        template<int K>
+        inline uint32_t Lane32(Int4 v) {
+            return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, K * 4)));
+        }
+
+        // Four halves in the low 64 bits, same bits as FloatToHalf
+        inline Int4 FloatToHalf4(SIMD::Float4 v) {
+#if defined(REALITY_SIMD_F16C)
+            return _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+#else
+            const Int4 bits = _mm_castps_si128(v);
+            const Int4 sign = _mm_and_si128(bits, _mm_set1_epi32(INT32_MIN));
+            const Int4 magnitude = _mm_xor_si128(bits, sign);
+
+            const Int4 isNaN = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7F800000));
+            const Int4 special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+            const Int4 isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(0x47800000), magnitude);
+            const Int4 isDenormal = _mm_cmpgt_epi32(_mm_set1_epi32(0x38800000), magnitude);
+
+            const SIMD::Float4 shifted = _mm_add_ps(_mm_castsi128_ps(magnitude), _mm_set1_ps(0.5f));
+            const Int4 denormal = _mm_sub_epi32(_mm_castps_si128(shifted), _mm_set1_epi32(0x3F000000));
+            const Int4 oddMantissa = _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+            const Int4 rebiased = _mm_add_epi32(magnitude, _mm_set1_epi32(static_cast<int32_t>(0xC8000FFFu)));
+            const Int4 normal = _mm_srli_epi32(_mm_add_epi32(rebiased, oddMantissa), 13);
+
+            Int4 result = SelectInt(special, SelectInt(normal, denormal, isDenormal), isRegular);
+            result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+#if defined(REALITY_SIMD_SSE41)
+            return _mm_packus_epi32(result, result);
+#else
+            result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+            return _mm_packs_epi32(result, result);
+#endif
+#endif
+        }
+
+        // Four halves from the low 64 bits, same values as HalfToFloat
+        inline SIMD::Float4 HalfToFloat4(Int4 halves) {
+#if defined(REALITY_SIMD_F16C)
+            return _mm_cvtph_ps(halves);
+#else
+            const Int4 h = _mm_unpacklo_epi16(halves, _mm_setzero_si128());
+            const Int4 magnitude = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+            const Int4 sign = _mm_slli_epi32(_mm_xor_si128(h, magnitude), 16);
+            const SIMD::Float4 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+                                                   _mm_set1_ps(5.192296858534828e+33f));
+            const Int4 isInfNaN = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7BFF));
+            const Int4 exponent = _mm_and_si128(isInfNaN, _mm_set1_epi32(0x7F800000));
+            return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, exponent)));
+#endif
+        }
+
+        // Clamped, scaled and rounded to nearest even, NaN lanes give 0
+        inline Int4 Quantize(SIMD::Float4 v, float minimum, float scale) {
+            const Int4 ordered = _mm_castps_si128(_mm_cmpord_ps(v, v));
+            v = SIMD::Min(SIMD::Max(v, SIMD::Splat(minimum)), SIMD::Splat(1.0f));
+            return _mm_and_si128(_mm_cvtps_epi32(SIMD::Mul(v, SIMD::Splat(scale))), ordered);
+        }
+
+        // Eight int32 to uint16 with unsigned saturation
+        inline Int4 PackUnsigned16(Int4 a, Int4 b) {
+#if defined(REALITY_SIMD_SSE41)
+            return _mm_packus_epi32(a, b);
+#else
+            const Int4 bias = _mm_set1_epi32(32768);
+            const Int4 packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+            return _mm_xor_si128(packed, _mm_set1_epi16(INT16_MIN));
+#endif
+        }
+#endif
+    }
+
+    void PackHalf(std::span<const Vector2> in, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 2 <= in.size(); i += 2) {
+            const Int4 halves = FloatToHalf4(SIMD::LoadUnaligned(&in[i].x));
+            const uint32_t values[2] = { Lane32<0>(halves), Lane32<1>(halves) };
+            memcpy(Element(out, stride, i), &values[0], sizeof(uint32_t));
+            memcpy(Element(out, stride, i + 1), &values[1], sizeof(uint32_t));
+        }
+#endif
+        for (; i < in.size(); i++) {
+            const uint16_t values[2] = { FloatToHalf(in[i].x), FloatToHalf(in[i].y) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void PackHalf(std::span<const Vector4> in, void* out, size_t stride) {
+        for (size_t i = 0; i < in.size(); i++) {
+#if defined(REALITY_SIMD_SSE)
+            _mm_storel_epi64(reinterpret_cast<Int4*>(Element(out, stride, i)), FloatToHalf4(in[i].ToSIMD()));
+#else
+            const uint16_t values[4] = { FloatToHalf(in[i].x), FloatToHalf(in[i].y), FloatToHalf(in[i].z),
+                                         FloatToHalf(in[i].w) };
+            WriteElement(out, stride, i, values);
+#endif
+        }
+    }
+
+    void PackUnorm8(std::span<const Vector4> in, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 4 <= in.size(); i += 4) {
+            const Int4 low = _mm_packs_epi32(Quantize(in[i].ToSIMD(), 0.0f, 255.0f), Quantize(in[i + 1].ToSIMD(), 0.0f, 255.0f));
+            const Int4 high = _mm_packs_epi32(Quantize(in[i + 2].ToSIMD(), 0.0f, 255.0f), Quantize(in[i + 3].ToSIMD(), 0.0f, 255.0f));
+            const Int4 bytes = _mm_packus_epi16(low, high);
+            const uint32_t values[4] = { Lane32<0>(bytes), Lane32<1>(bytes), Lane32<2>(bytes), Lane32<3>(bytes) };
+            for (size_t k = 0; k < 4; k++) {
+                memcpy(Element(out, stride, i + k), &values[k], sizeof(uint32_t));
+            }
+        }
+#endif
+        for (; i < in.size(); i++) {
+            const uint8_t values[4] = { Reality::PackUnorm8(in[i].x), Reality::PackUnorm8(in[i].y),
+                                        Reality::PackUnorm8(in[i].z), Reality::PackUnorm8(in[i].w) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void PackSnorm8(std::span<const Vector4> in, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 4 <= in.size(); i += 4) {
+            const Int4 low = _mm_packs_epi32(Quantize(in[i].ToSIMD(), -1.0f, 127.0f), Quantize(in[i + 1].ToSIMD(), -1.0f, 127.0f));
+            const Int4 high = _mm_packs_epi32(Quantize(in[i + 2].ToSIMD(), -1.0f, 127.0f), Quantize(in[i + 3].ToSIMD(), -1.0f, 127.0f));
+            const Int4 bytes = _mm_packs_epi16(low, high);
+            const uint32_t values[4] = { Lane32<0>(bytes), Lane32<1>(bytes), Lane32<2>(bytes), Lane32<3>(bytes) };
+            for (size_t k = 0; k < 4; k++) {
+                memcpy(Element(out, stride, i + k), &values[k], sizeof(uint32_t));
+            }
+        }
+#endif
+        for (; i < in.size(); i++) {
+            const int8_t values[4] = { Reality::PackSnorm8(in[i].x), Reality::PackSnorm8(in[i].y),
+                                       Reality::PackSnorm8(in[i].z), Reality::PackSnorm8(in[i].w) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void PackUnorm16(std::span<const Vector2> in, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 4 <= in.size(); i += 4) {
+            const Int4 packed = PackUnsigned16(Quantize(SIMD::LoadUnaligned(&in[i].x), 0.0f, 65535.0f),
+                                               Quantize(SIMD::LoadUnaligned(&in[i + 2].x), 0.0f, 65535.0f));
+            const uint32_t values[4] = { Lane32<0>(packed), Lane32<1>(packed), Lane32<2>(packed), Lane32<3>(packed) };
+            for (size_t k = 0; k < 4; k++) {
+                memcpy(Element(out, stride, i + k), &values[k], sizeof(uint32_t));
+            }
+        }
+#endif
+        for (; i < in.size(); i++) {
+            const uint16_t values[2] = { Reality::PackUnorm16(in[i].x), Reality::PackUnorm16(in[i].y) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void PackSnorm16(std::span<const Vector2> in, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 4 <= in.size(); i += 4) {
+            const Int4 packed = _mm_packs_epi32(Quantize(SIMD::LoadUnaligned(&in[i].x), -1.0f, 32767.0f),
+                                                Quantize(SIMD::LoadUnaligned(&in[i + 2].x), -1.0f, 32767.0f));
+            const uint32_t values[4] = { Lane32<0>(packed), Lane32<1>(packed), Lane32<2>(packed), Lane32<3>(packed) };
+            for (size_t k = 0; k < 4; k++) {
+                memcpy(Element(out, stride, i + k), &values[k], sizeof(uint32_t));
+            }
+        }
+#endif
+        for (; i < in.size(); i++) {
+            const int16_t values[2] = { Reality::PackSnorm16(in[i].x), Reality::PackSnorm16(in[i].y) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void PackOctahedral(ConstVector3Span normals, void* out, size_t stride) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        // Four normals per iteration from the structure-of-arrays input
+        const SIMD::Float4 one = SIMD::Splat(1.0f);
+        const SIMD::Float4 signBit = SIMD::Splat(-0.0f);
+        for (; i + 4 <= normals.size; i += 4) {
+            const SIMD::Float4 x = SIMD::LoadUnaligned(normals.x + i);
+            const SIMD::Float4 y = SIMD::LoadUnaligned(normals.y + i);
+            const SIMD::Float4 z = SIMD::LoadUnaligned(normals.z + i);
+            const SIMD::Float4 invLength = SIMD::Div(one, SIMD::Add(SIMD::Add(SIMD::Abs(x), SIMD::Abs(y)), SIMD::Abs(z)));
+            const SIMD::Float4 px = SIMD::Mul(x, invLength);
+            const SIMD::Float4 py = SIMD::Mul(y, invLength);
+            const SIMD::Float4 lower = SIMD::Less(SIMD::Mul(z, invLength), SIMD::Zero());
+
+            const SIMD::Float4 foldedX = SIMD::Xor(SIMD::Sub(one, SIMD::Abs(py)), SIMD::And(px, signBit));
+            const SIMD::Float4 foldedY = SIMD::Xor(SIMD::Sub(one, SIMD::Abs(px)), SIMD::And(py, signBit));
+            const Int4 u = Quantize(SIMD::Select(px, foldedX, lower), -1.0f, 32767.0f);
+            const Int4 v = Quantize(SIMD::Select(py, foldedY, lower), -1.0f, 32767.0f);
+
+            // (u0..u3, v0..v3) interleaved to (u0, v0, u1, v1, ...)
+            const Int4 packed = _mm_packs_epi32(u, v);
+            const Int4 pairs = _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8));
+            const uint32_t values[4] = { Lane32<0>(pairs), Lane32<1>(pairs), Lane32<2>(pairs), Lane32<3>(pairs) };
+            for (size_t k = 0; k < 4; k++) {
+                memcpy(Element(out, stride, i + k), &values[k], sizeof(uint32_t));
+            }
+        }
+#endif
+        for (; i < normals.size; i++) {
+            const Vector2 encoded = EncodeOctahedral(normals.Get(i));
+            const int16_t values[2] = { Reality::PackSnorm16(encoded.x), Reality::PackSnorm16(encoded.y) };
+            WriteElement(out, stride, i, values);
+        }
+    }
+
+    void UnpackHalf(const void* in, size_t stride, std::span<Vector2> out) {
+        size_t i = 0;
+#if defined(REALITY_SIMD_SSE)
+        for (; i + 2 <= out.size(); i += 2) {
+            uint32_t values[2];
+            memcpy(&values[0], Element(in, stride, i), sizeof(uint32_t));
+            memcpy(&values[1], Element(in, stride, i + 1), sizeof(uint32_t));
+            const Int4 halves = _mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(values[0])),
+                                                   _mm_cvtsi32_si128(static_cast<int>(values[1])));
+            SIMD::StoreUnaligned(&out[i].x, HalfToFloat4(halves));
+        }
+#endif
+        for (; i < out.size(); i++) {
+            uint16_t values[2];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector2(HalfToFloat(values[0]), HalfToFloat(values[1]));
+        }
+    }
+
+    void UnpackHalf(const void* in, size_t stride, std::span<Vector4> out) {
+        for (size_t i = 0; i < out.size(); i++) {
+#if defined(REALITY_SIMD_SSE)
+            const Int4 halves = _mm_loadl_epi64(reinterpret_cast<const Int4*>(Element(in, stride, i)));
+            out[i] = Vector4(HalfToFloat4(halves));
+#else
+            uint16_t values[4];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector4(HalfToFloat(values[0]), HalfToFloat(values[1]), HalfToFloat(values[2]), HalfToFloat(values[3]));
+#endif
+        }
+    }
+
+    void UnpackUnorm8(const void* in, size_t stride, std::span<Vector4> out) {
+        for (size_t i = 0; i < out.size(); i++) {
+            uint8_t values[4];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector4(Reality::UnpackUnorm8(values[0]), Reality::UnpackUnorm8(values[1]),
+                             Reality::UnpackUnorm8(values[2]), Reality::UnpackUnorm8(values[3]));
+        }
+    }
+
+    void UnpackSnorm8(const void* in, size_t stride, std::span<Vector4> out) {
+        for (size_t i = 0; i < out.size(); i++) {
+            int8_t values[4];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector4(Reality::UnpackSnorm8(values[0]), Reality::UnpackSnorm8(values[1]),
+                             Reality::UnpackSnorm8(values[2]), Reality::UnpackSnorm8(values[3]));
+        }
+    }
+
+    void UnpackUnorm16(const void* in, size_t stride, std::span<Vector2> out) {
+        for (size_t i = 0; i < out.size(); i++) {
+            uint16_t values[2];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector2(Reality::UnpackUnorm16(values[0]), Reality::UnpackUnorm16(values[1]));
+        }
+    }
+
+    void UnpackSnorm16(const void* in, size_t stride, std::span<Vector2> out) {
+        for (size_t i = 0; i < out.size(); i++) {
+            int16_t values[2];
+            ReadElement(in, stride, i, values);
+            out[i] = Vector2(Reality::UnpackSnorm16(values[0]), Reality::UnpackSnorm16(values[1]));
+        }
+    }
+
+    void UnpackOctahedral(const void* in, size_t stride, Vector3Span normals) {
+        for (size_t i = 0; i < normals.size; i++) {
+            int16_t values[2];
+            ReadElement(in, stride, i, values);
+            normals.Set(i, DecodeOctahedral(Vector2(Reality::UnpackSnorm16(values[0]), Reality::UnpackSnorm16(values[1]))));
+        }
+    }
+}
@@ -0,0 +1,149 @@
+﻿#pragma once
+#include "MathBatch.h"
+#include <cmath>
+#include <cstring>
+
+namespace Reality {
+    // Conversions to the compact vertex and texture formats of GraphicsTypes.h.
+    // Normalized formats round to nearest even and clamp, like the GPU does on
+    // write. NaN packs to 0. SNORM decodes -128 and -32768 to -1.
+
+    // IEEE half precision, round to nearest even. Overflow gives infinity,
+    // NaN stays NaN.
+    inline uint16_t FloatToHalf(float value) {
+#if defined(REALITY_SIMD_F16C)
+        return static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint32_t result;
+        if (bits >= 0x47800000u) {
+            // 65536 and above, infinity or NaN
+            result = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+        } else if (bits < 0x38800000u) {
+            // Below the smallest normal half. Adding 0.5 aligns the mantissa
+            // so the FPU does the rounding to a denormal.
+            float shifted;
+            memcpy(&shifted, &bits, sizeof(shifted));
+            shifted += 0.5f;
+            memcpy(&result, &shifted, sizeof(result));
+            result -= 0x3F000000u;
+        } else {
+            // Rebias the exponent, then round the 13 dropped mantissa bits to even
+            const uint32_t oddMantissa = (bits >> 13) & 1u;
+            bits += 0xC8000FFFu + oddMantissa;
+            result = bits >> 13;
+        }
+        return static_cast<uint16_t>(result | (sign >> 16));
+#endif
+    }
+
+    inline float HalfToFloat(uint16_t value) {
+#if defined(REALITY_SIMD_F16C)
+        return _cvtsh_ss(value);
+#else
+        // Shift into a float and scale the exponent by 2^112, which also
+        // normalizes denormals. Infinity and NaN keep an all-ones exponent.
+        const uint32_t magnitude = static_cast<uint32_t>(value & 0x7FFFu) << 13;
+        float result;
+        memcpy(&result, &magnitude, sizeof(result));
+        result *= 5.192296858534828e+33f;
+        uint32_t bits;
+        memcpy(&bits, &result, sizeof(bits));
+        if ((value & 0x7C00u) == 0x7C00u) {
+            bits |= 0x7F800000u;
+        }
+        bits |= static_cast<uint32_t>(value & 0x8000u) << 16;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+#endif
+    }
+
+    namespace Detail {
+        // Clamped, scaled and rounded. NaN is caught first, converting it to
+        // an integer is undefined.
+        inline int32_t Quantize(float value, float minimum, float scale) {
+            if (std::isnan(value)) {
+                return 0;
+            }
+            return static_cast<int32_t>(std::nearbyint(Clamp(value, minimum, 1.0f) * scale));
+        }
+    }
+
+    inline uint8_t PackUnorm8(float value) {
+        return static_cast<uint8_t>(Detail::Quantize(value, 0.0f, 255.0f));
+    }
+
+    inline int8_t PackSnorm8(float value) {
+        return static_cast<int8_t>(Detail::Quantize(value, -1.0f, 127.0f));
+    }
+
+    inline uint16_t PackUnorm16(float value) {
+        return static_cast<uint16_t>(Detail::Quantize(value, 0.0f, 65535.0f));
+    }
+
+    inline int16_t PackSnorm16(float value) {
+        return static_cast<int16_t>(Detail::Quantize(value, -1.0f, 32767.0f));
+    }
+
+    inline float UnpackUnorm8(uint8_t value) { return value * (1.0f / 255.0f); }
+    inline float UnpackSnorm8(int8_t value) { return Max(value * (1.0f / 127.0f), -1.0f); }
+    inline float UnpackUnorm16(uint16_t value) { return value * (1.0f / 65535.0f); }
+    inline float UnpackSnorm16(int16_t value) { return Max(value * (1.0f / 32767.0f), -1.0f); }
+
+    // Octahedral normal encoding: the unit sphere is projected onto the
+    // octahedron |x| + |y| + |z| = 1 and the lower half folded over the
+    // diagonals into the [-1, 1] square. Two SNORM16 components keep the
+    // angular error below 7e-5 radians.
+    inline Vector2 EncodeOctahedral(const Vector3& normal) {
+        const float invLength = 1.0f / (Abs(normal.x) + Abs(normal.y) + Abs(normal.z));
+        const float x = normal.x * invLength;
+        const float y = normal.y * invLength;
+        if (normal.z * invLength >= 0.0f) {
+            return Vector2(x, y);
+        }
+        return Vector2(std::signbit(x) ? Abs(y) - 1.0f : 1.0f - Abs(y),
+                       std::signbit(y) ? Abs(x) - 1.0f : 1.0f - Abs(x));
+    }
+
+    inline Vector3 DecodeOctahedral(const Vector2& encoded) {
+        Vector3 normal(encoded.x, encoded.y, 1.0f - Abs(encoded.x) - Abs(encoded.y));
+        // Unfolds the lower half, a no-op where z >= 0
+        const float t = Max(-normal.z, 0.0f);
+        normal.x += normal.x >= 0.0f ? -t : t;
+        normal.y += normal.y >= 0.0f ? -t : t;
+        return normal.Normalized();
+    }
+
+    // Batch kernels writing interleaved vertex data: element i is written to
+    // out + i * stride, so a stream can be packed straight into its vertex
+    // attribute. Half conversions use F16C when available, SSE2 integer code
+    // otherwise, and give the same bits as FloatToHalf.
+
+    // R16G16_FLOAT
+    void PackHalf(std::span<const Vector2> in, void* out, size_t stride);
+    // R16G16B16A16_FLOAT
+    void PackHalf(std::span<const Vector4> in, void* out, size_t stride);
+    // R8G8B8A8_UNORM, colors
+    void PackUnorm8(std::span<const Vector4> in, void* out, size_t stride);
+    // R8G8B8A8_SNORM, tangents with the bitangent sign in w
+    void PackSnorm8(std::span<const Vector4> in, void* out, size_t stride);
+    // R16G16_UNORM, texture coordinates in [0, 1]
+    void PackUnorm16(std::span<const Vector2> in, void* out, size_t stride);
+    // R16G16_SNORM
+    void PackSnorm16(std::span<const Vector2> in, void* out, size_t stride);
+    // R16G16_SNORM, EncodeOctahedral of unit normals
+    void PackOctahedral(ConstVector3Span normals, void* out, size_t stride);
+
+    // Decoders, reading element i from in + i * stride
+    void UnpackHalf(const void* in, size_t stride, std::span<Vector2> out);
+    void UnpackHalf(const void* in, size_t stride, std::span<Vector4> out);
+    void UnpackUnorm8(const void* in, size_t stride, std::span<Vector4> out);
+    void UnpackSnorm8(const void* in, size_t stride, std::span<Vector4> out);
+    void UnpackUnorm16(const void* in, size_t stride, std::span<Vector2> out);
+    void UnpackSnorm16(const void* in, size_t stride, std::span<Vector2> out);
+    void UnpackOctahedral(const void* in, size_t stride, Vector3Span normals);
+}
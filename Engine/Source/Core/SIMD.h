@@ -0,0 +1,234 @@
+﻿#pragma once
+#include <cstdint>
+
+// Compile-time instruction set selection for the math library.
+//
+// REALITY_SIMD_SSE   - SSE2, baseline on every x64 target
+// REALITY_SIMD_SSE41 - SSE4.1 (dot products, blends, rounding)
+// REALITY_SIMD_AVX2  - AVX2, 8-wide kernels
+// REALITY_SIMD_FMA   - fused multiply-add
+// REALITY_SIMD_F16C  - half-precision conversion instructions
+//
+// Define REALITY_MATH_SCALAR to force the scalar fallback everywhere. The
+// Engine target sets these from the REALITY_SIMD CMake option, they must be
+// the same in every translation unit since the math types are header-only.
+#if !defined(REALITY_MATH_SCALAR)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define REALITY_SIMD_SSE 1
+    #endif
+    #if defined(REALITY_SIMD_SSE) && (defined(__SSE4_1__) || defined(__AVX__))
+        #define REALITY_SIMD_SSE41 1
+    #endif
+    #if defined(REALITY_SIMD_SSE41) && defined(__AVX2__)
+        #define REALITY_SIMD_AVX2 1
+    #endif
+    #if defined(REALITY_SIMD_AVX2) && (defined(__FMA__) || defined(_MSC_VER))
+        #define REALITY_SIMD_FMA 1
+    #endif
+    #if defined(REALITY_SIMD_AVX2) && (defined(__F16C__) || defined(_MSC_VER))
+        #define REALITY_SIMD_F16C 1
+    #endif
+#endif
+
+#if defined(REALITY_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(REALITY_SIMD_SSE41)
+#include <smmintrin.h>
+#elif defined(REALITY_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace Reality {
+    namespace SIMD {
+        // Width of the widest float vector available, used by batch kernels
+#if defined(REALITY_SIMD_AVX2)
+        constexpr uint32_t Width = 8;
+#elif defined(REALITY_SIMD_SSE)
+        constexpr uint32_t Width = 4;
+#else
+        constexpr uint32_t Width = 1;
+#endif
+
+        // Name of the selected instruction set, for logs
+        inline const char* GetInstructionSetName() {
+#if defined(REALITY_SIMD_AVX2)
+            return "AVX2";
+#elif defined(REALITY_SIMD_SSE41)
+            return "SSE4.1";
+#elif defined(REALITY_SIMD_SSE)
+            return "SSE2";
+#else
+            return "Scalar";
+#endif
+        }
+
+#if defined(REALITY_SIMD_SSE)
+        // Thin wrappers over the 4-wide intrinsics used by MathF.h
+        using Float4 = __m128;
+
+        inline Float4 Load(const float* p) { return _mm_load_ps(p); }
+        inline Float4 LoadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+        inline void Store(float* p, Float4 v) { _mm_store_ps(p, v); }
+        inline void StoreUnaligned(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+        inline Float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+        inline Float4 Splat(float s) { return _mm_set1_ps(s); }
+        inline Float4 Zero() { return _mm_setzero_ps(); }
+
+        inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+        inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+        inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+        inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+        inline Float4 Sqrt(Float4 v) { return _mm_sqrt_ps(v); }
+
+        // a * b + c, fused when the target has FMA
+        inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) {
+#if defined(REALITY_SIMD_FMA)
+            return _mm_fmadd_ps(a, b, c);
+#else
+            return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+        }
+
+        // Flips the sign of the lanes whose mask bit is set
+        inline Float4 FlipSign(Float4 v, Float4 signMask) { return _mm_xor_ps(v, signMask); }
+        inline Float4 SignMask(bool x, bool y, bool z, bool w) {
+            return _mm_castsi128_ps(_mm_setr_epi32(x ? INT32_MIN : 0, y ? INT32_MIN : 0,
+                                                   z ? INT32_MIN : 0, w ? INT32_MIN : 0));
+        }
+        inline Float4 Negate(Float4 v) { return FlipSign(v, _mm_set1_ps(-0.0f)); }
+        inline Float4 Abs(Float4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+        inline Float4 Xor(Float4 a, Float4 b) { return _mm_xor_ps(a, b); }
+
+        // Round to nearest even, SSE2 goes through int32 and needs |v| < 2^31
+        inline Float4 Round(Float4 v) {
+#if defined(REALITY_SIMD_SSE41)
+            return _mm_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#else
+            return _mm_cvtepi32_ps(_mm_cvtps_epi32(v));
+#endif
+        }
+
+        // Hardware reciprocal square root estimate, relative error below 1.5 * 2^-12
+        inline Float4 RSqrtEstimate(Float4 v) { return _mm_rsqrt_ps(v); }
+
+        template<int X, int Y, int Z, int W>
+        inline Float4 Swizzle(Float4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+        // (a[X], a[Y], b[Z], b[W])
+        template<int X, int Y, int Z, int W>
+        inline Float4 Shuffle(Float4 a, Float4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X)); }
+
+        // Dot product of all four lanes, broadcast to every lane
+        inline Float4 Dot4(Float4 a, Float4 b) {
+#if defined(REALITY_SIMD_SSE41)
+            return _mm_dp_ps(a, b, 0xFF);
+#else
+            Float4 t = _mm_mul_ps(a, b);
+            t = _mm_add_ps(t, Swizzle<1, 0, 3, 2>(t));
+            return _mm_add_ps(t, Swizzle<2, 3, 0, 1>(t));
+#endif
+        }
+
+        inline float GetX(Float4 v) { return _mm_cvtss_f32(v); }
+
+        // Lane masks: all bits set where the comparison holds
+        inline Float4 Greater(Float4 a, Float4 b) { return _mm_cmpgt_ps(a, b); }
+        inline Float4 GreaterEqual(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+        inline Float4 Less(Float4 a, Float4 b) { return _mm_cmplt_ps(a, b); }
+        inline Float4 Equal(Float4 a, Float4 b) { return _mm_cmpeq_ps(a, b); }
+        inline Float4 SplatMask(bool set) { return _mm_castsi128_ps(_mm_set1_epi32(set ? -1 : 0)); }
+        inline Float4 And(Float4 a, Float4 b) { return _mm_and_ps(a, b); }
+        inline Float4 Or(Float4 a, Float4 b) { return _mm_or_ps(a, b); }
+        inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+        inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+        inline int MoveMask(Float4 mask) { return _mm_movemask_ps(mask); }
+
+        // mask ? b : a
+        inline Float4 Select(Float4 a, Float4 b, Float4 mask) {
+#if defined(REALITY_SIMD_SSE41)
+            return _mm_blendv_ps(a, b, mask);
+#else
+            return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+#endif
+        }
+
+        // True when all four lanes compare equal
+        inline bool AllEqual(Float4 a, Float4 b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)) == 0xF; }
+
+        inline void Transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+
+        // 2x2 row-major matrices packed as (m00, m01, m10, m11), used by the
+        // block-wise Matrix4x4 inverse. Adj is the adjugate.
+        // a * b
+        inline Float4 Mat2Mul(Float4 a, Float4 b) {
+            return Add(Mul(a, Swizzle<0, 3, 0, 3>(b)), Mul(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+        }
+        // Adj(a) * b
+        inline Float4 Mat2AdjMul(Float4 a, Float4 b) {
+            return Sub(Mul(Swizzle<3, 3, 0, 0>(a), b), Mul(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+        }
+        // a * Adj(b)
+        inline Float4 Mat2MulAdj(Float4 a, Float4 b) {
+            return Sub(Mul(a, Swizzle<3, 0, 3, 0>(b)), Mul(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+        }
+#endif
+
+#if defined(REALITY_SIMD_AVX2)
+        // 8-wide overloads of the same operations
+        using Float8 = __m256;
+
+        inline Float8 Load8(const float* p) { return _mm256_load_ps(p); }
+        inline Float8 LoadUnaligned8(const float* p) { return _mm256_loadu_ps(p); }
+        inline void Store(float* p, Float8 v) { _mm256_store_ps(p, v); }
+        inline void StoreUnaligned(float* p, Float8 v) { _mm256_storeu_ps(p, v); }
+        inline Float8 Splat8(float s) { return _mm256_set1_ps(s); }
+        // Same 4 floats in both halves
+        inline Float8 Broadcast4(const float* p) { return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p)); }
+
+        inline Float8 Add(Float8 a, Float8 b) { return _mm256_add_ps(a, b); }
+        inline Float8 Sub(Float8 a, Float8 b) { return _mm256_sub_ps(a, b); }
+        inline Float8 Mul(Float8 a, Float8 b) { return _mm256_mul_ps(a, b); }
+        inline Float8 Div(Float8 a, Float8 b) { return _mm256_div_ps(a, b); }
+        inline Float8 Sqrt(Float8 v) { return _mm256_sqrt_ps(v); }
+        inline Float8 Negate(Float8 v) { return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f)); }
+        inline Float8 Abs(Float8 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+        inline Float8 Xor(Float8 a, Float8 b) { return _mm256_xor_ps(a, b); }
+        inline Float8 Round(Float8 v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        inline Float8 RSqrtEstimate(Float8 v) { return _mm256_rsqrt_ps(v); }
+
+        inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) {
+#if defined(REALITY_SIMD_FMA)
+            return _mm256_fmadd_ps(a, b, c);
+#else
+            return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+        }
+
+        inline Float8 Greater(Float8 a, Float8 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        inline Float8 GreaterEqual(Float8 a, Float8 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        inline Float8 Less(Float8 a, Float8 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        inline Float8 And(Float8 a, Float8 b) { return _mm256_and_ps(a, b); }
+        inline Float8 Or(Float8 a, Float8 b) { return _mm256_or_ps(a, b); }
+        inline Float8 Min(Float8 a, Float8 b) { return _mm256_min_ps(a, b); }
+        inline Float8 Max(Float8 a, Float8 b) { return _mm256_max_ps(a, b); }
+        inline int MoveMask(Float8 mask) { return _mm256_movemask_ps(mask); }
+        inline Float8 Select(Float8 a, Float8 b, Float8 mask) { return _mm256_blendv_ps(a, b, mask); }
+
+        // Swizzle within each 128-bit half
+        template<int X, int Y, int Z, int W>
+        inline Float8 Swizzle(Float8 v) { return _mm256_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+#endif
+
+        // FloatN - the widest register, Width lanes. Batch kernels are written
+        // once against it and run 8 lanes on AVX2, 4 on SSE.
+#if defined(REALITY_SIMD_AVX2)
+        using FloatN = Float8;
+        inline FloatN LoadN(const float* p) { return LoadUnaligned8(p); }
+        inline FloatN SplatN(float s) { return Splat8(s); }
+#elif defined(REALITY_SIMD_SSE)
+        using FloatN = Float4;
+        inline FloatN LoadN(const float* p) { return LoadUnaligned(p); }
+        inline FloatN SplatN(float s) { return Splat(s); }
+#endif
+    }
+}
@@ -1,4 +1,6 @@
 ﻿#include "Timer.h"
+#include "FlightRecorder.h"
+#include "Log.h"
 #include <algorithm>
 namespace Reality {
     // Initialize static members
@@ -36,6 +38,7 @@ namespace Reality {
         Duration delta = s_CurrentFrameTime - s_LastFrameTime;
         s_DeltaTimeMS = delta.count();
         s_DeltaTime = s_DeltaTimeMS * 0.001f; // Convert to seconds
+        FlightRecorder::RecordEvent("Frame", std::chrono::duration_cast<std::chrono::nanoseconds>(delta));
 
         // Clamp to avoid extreme values (e.g., during debugging)
         constexpr float MAX_DELTA_MS = 100.0f; // 100ms max frame time
@@ -59,6 +62,7 @@ namespace Reality {
         s_SmoothedFrameTimeMS = total / FRAME_TIME_WINDOW;
 
         s_FrameCount++;
+        Log::GetInstance().SetFrame(s_FrameCount);
     }
 
     float Timer::GetTime() {
@@ -0,0 +1,77 @@
+﻿#include "MeshLod.h"
+#include "MeshOptimizer.h"
+#include <Core/JobSystem.h>
+
+namespace Reality {
+    namespace {
+        // A level must drop at least this fraction of the previous one's triangles
+        constexpr float MinReduction = 0.05f;
+    }
+
+    uint32_t MeshLodChain::SelectLod(float distance, float projectionScale, float pixelError) const {
+        if (lods.empty() || !(distance > 0.0f)) {
+            return 0;
+        }
+        const float errorLimit = pixelError * distance / projectionScale;
+        for (uint32_t i = static_cast<uint32_t>(lods.size()) - 1; i > 0; i--) {
+            if (lods[i].error <= errorLimit) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    float GetLodProjectionScale(float fovY, uint32_t viewportHeight) {
+        return static_cast<float>(viewportHeight) * 0.5f / std::tan(fovY * 0.5f);
+    }
+
+    MeshLodChain GenerateLodChain(const MeshLodSource& source, const MeshLodDesc& desc) {
+        MeshLodChain chain;
+        chain.lods.push_back({ std::vector<uint32_t>(source.indices.begin(), source.indices.end()), 0.0f });
+
+        SimplifyDesc simplify;
+        simplify.lockBorder = desc.lockBorder;
+        simplify.attributes = source.attributes;
+        simplify.attributeStride = source.attributeStride;
+        simplify.attributeWeights = desc.attributeWeights;
+
+        for (const float ratio : desc.ratios) {
+            const MeshLod& previous = chain.lods.back();
+            const uint32_t targetCount = static_cast<uint32_t>(source.indices.size() / 3 * ratio) * 3;
+            if (targetCount >= previous.indices.size()) {
+                continue;
+            }
+            if (previous.error >= desc.maxError) {
+                break;
+            }
+
+            // Errors of successive simplifications add up at worst
+            simplify.targetIndexCount = targetCount;
+            simplify.targetError = desc.maxError - previous.error;
+            MeshLod lod;
+            lod.indices.resize(previous.indices.size());
+            float error = 0.0f;
+            const uint32_t count = SimplifyMesh(lod.indices, previous.indices, source.positions, source.positionStride,
+                                                source.vertexCount, simplify, &error);
+            if (count > previous.indices.size() * (1.0f - MinReduction)) {
+                break;
+            }
+            lod.indices.resize(count);
+            lod.error = previous.error + error;
+            if (desc.optimizeVertexCache) {
+                OptimizeVertexCache(lod.indices, lod.indices, source.vertexCount);
+            }
+            chain.lods.push_back(std::move(lod));
+        }
+        return chain;
+    }
+
+    void GenerateLodChains(std::span<const MeshLodSource> sources, const MeshLodDesc& desc, std::span<MeshLodChain> chains) {
+        assert(chains.size() >= sources.size());
+        JobSystem::GetInstance().ParallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                chains[i] = GenerateLodChain(sources[i], desc);
+            }
+        });
+    }
+}
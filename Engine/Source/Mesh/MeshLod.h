@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "MeshSimplifier.h"
+#include <vector>
+
+namespace Reality {
+    // One indexed triangle list to build levels of detail for
+    struct MeshLodSource {
+        std::span<const uint32_t> indices;
+        const float* positions = nullptr;
+        uint32_t positionStride = 0;
+        uint32_t vertexCount = 0;
+
+        // Optional, laid out as in SimplifyDesc
+        const float* attributes = nullptr;
+        uint32_t attributeStride = 0;
+    };
+
+    struct MeshLodDesc {
+        // Fraction of the source triangles kept by each level after the full
+        // one, in decreasing order
+        std::vector<float> ratios = { 0.5f, 0.25f, 0.125f };
+
+        // Levels stop before their error passes this, in position units
+        float maxError = INFINITY;
+
+        bool lockBorder = true;
+        std::vector<float> attributeWeights;
+
+        // Reorder each level for the vertex cache, see OptimizeVertexCache
+        bool optimizeVertexCache = true;
+    };
+
+    struct MeshLod {
+        std::vector<uint32_t> indices;
+        float error = 0.0f;                 // Furthest the level may stray from the source, in position units
+    };
+
+    // Levels of one mesh, the source first. Every level indexes the source
+    // vertex buffer, so only the index buffer changes between them.
+    struct MeshLodChain {
+        std::vector<MeshLod> lods;
+
+        // Index of the coarsest level whose error, seen from distance, covers
+        // at most pixelError pixels. distance is in position units, so divide
+        // by the object's scale first.
+        uint32_t SelectLod(float distance, float projectionScale, float pixelError = 1.0f) const;
+    };
+
+    // Pixels per position unit at distance 1 for a perspective projection
+    float GetLodProjectionScale(float fovY, uint32_t viewportHeight);
+
+    // Simplifies each level from the one before it. Levels that barely
+    // reduce the previous one end the chain.
+    MeshLodChain GenerateLodChain(const MeshLodSource& source, const MeshLodDesc& desc);
+
+    // Builds one chain per source, spread across the job system
+    void GenerateLodChains(std::span<const MeshLodSource> sources, const MeshLodDesc& desc, std::span<MeshLodChain> chains);
+}
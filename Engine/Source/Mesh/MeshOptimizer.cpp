@@ -0,0 +1,381 @@
+﻿#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace Reality {
+    namespace {
+        // Forsyth's scoring cache, larger than any hardware one so the order
+        // suits every cache size
+        constexpr uint32_t ScoringCacheSize = 32;
+        constexpr uint32_t MaxValence = 32;
+        constexpr uint32_t NoTriangle = UINT32_MAX;
+
+        struct ScoreTables {
+            float cache[ScoringCacheSize];
+            float valence[MaxValence];
+
+            ScoreTables() {
+                for (uint32_t i = 0; i < ScoringCacheSize; i++) {
+                    // The last triangle's vertices score a little lower, so the
+                    // next triangle does not just reuse them
+                    cache[i] = i < 3 ? 0.75f : std::pow(1.0f - (i - 3) / static_cast<float>(ScoringCacheSize - 3), 1.5f);
+                }
+                valence[0] = 0.0f;
+                for (uint32_t i = 1; i < MaxValence; i++) {
+                    // Favors vertices with few triangles left, clearing them out of the way
+                    valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+                }
+            }
+        };
+
+        const ScoreTables& GetScoreTables() {
+            static const ScoreTables tables;
+            return tables;
+        }
+
+        float GetVertexScore(int32_t cachePosition, uint32_t remaining) {
+            if (remaining == 0) {
+                return -1.0f;
+            }
+            const ScoreTables& tables = GetScoreTables();
+            const float cacheScore = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+            return cacheScore + tables.valence[std::min(remaining, MaxValence - 1)];
+        }
+
+        // Per-vertex FIFO simulation, returns the misses of each triangle
+        class VertexCacheSimulator {
+        public:
+            VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize)
+                : m_timestamps(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1) {}
+
+            bool Access(uint32_t vertex) {
+                if (m_time - m_timestamps[vertex] <= m_cacheSize) {
+                    return false;
+                }
+                m_timestamps[vertex] = m_time++;
+                return true;
+            }
+
+            // Everything cached so far misses from here on
+            void Flush() { m_time += m_cacheSize + 1; }
+
+        private:
+            std::vector<uint32_t> m_timestamps;
+            uint32_t m_cacheSize;
+            uint32_t m_time;
+        };
+
+        constexpr uint32_t HardwareCacheSize = 16;
+        constexpr uint32_t MinClusterSize = 16;
+        constexpr uint32_t FetchLineSize = 64;
+        constexpr uint32_t FetchCacheLines = 64;
+    }
+
+    void OptimizeVertexCache(std::span<uint32_t> destination, std::span<const uint32_t> indices, uint32_t vertexCount) {
+        assert(indices.size() % 3 == 0 && destination.size() >= indices.size());
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        const std::vector<uint32_t> source(indices.begin(), indices.end());
+
+        // Remaining triangles of each vertex, as ranges of one array
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (const uint32_t index : source) {
+            assert(index < vertexCount);
+            remaining[index]++;
+        }
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        std::inclusive_scan(remaining.begin(), remaining.end(), offsets.begin() + 1);
+        std::vector<uint32_t> adjacency(source.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (uint32_t i = 0; i < source.size(); i++) {
+                adjacency[fill[source[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<int32_t> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            vertexScores[v] = GetVertexScore(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        uint32_t best = triangleCount > 0 ? 0 : NoTriangle;
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            triangleScores[t] = vertexScores[source[t * 3]] + vertexScores[source[t * 3 + 1]] + vertexScores[source[t * 3 + 2]];
+            if (triangleScores[t] > triangleScores[best]) {
+                best = t;
+            }
+        }
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        uint32_t cache[ScoringCacheSize + 3];
+        uint32_t cacheCount = 0;
+        uint32_t cursor = 0;
+        for (uint32_t output = 0; output < triangleCount; output++) {
+            // Nothing left around the cache, continue with the next triangle in input order
+            if (best == NoTriangle) {
+                while (emitted[cursor]) {
+                    cursor++;
+                }
+                best = cursor;
+            }
+
+            const uint32_t* triangle = &source[best * 3];
+            std::copy(triangle, triangle + 3, destination.begin() + output * 3);
+            emitted[best] = 1;
+
+            for (int i = 0; i < 3; i++) {
+                const uint32_t v = triangle[i];
+                uint32_t* begin = &adjacency[offsets[v]];
+                uint32_t* end = begin + remaining[v];
+                *std::find(begin, end, best) = *(end - 1);
+                remaining[v]--;
+            }
+
+            // The triangle's vertices move to the front of the cache
+            uint32_t newCache[ScoringCacheSize + 3] = { triangle[0], triangle[1], triangle[2] };
+            uint32_t newCount = 3;
+            for (uint32_t i = 0; i < cacheCount; i++) {
+                const uint32_t v = cache[i];
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                    newCache[newCount++] = v;
+                }
+            }
+
+            // Rescore the vertices that moved, including evicted ones, and their triangles
+            for (uint32_t i = 0; i < newCount; i++) {
+                const uint32_t v = newCache[i];
+                cachePositions[v] = i < ScoringCacheSize ? static_cast<int32_t>(i) : -1;
+                const float score = GetVertexScore(cachePositions[v], remaining[v]);
+                const float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+                for (uint32_t k = offsets[v]; k < offsets[v] + remaining[v]; k++) {
+                    triangleScores[adjacency[k]] += delta;
+                }
+            }
+
+            best = NoTriangle;
+            float bestScore = -1.0f;
+            cacheCount = std::min(newCount, ScoringCacheSize);
+            for (uint32_t i = 0; i < cacheCount; i++) {
+                const uint32_t v = newCache[i];
+                cache[i] = v;
+                for (uint32_t k = offsets[v]; k < offsets[v] + remaining[v]; k++) {
+                    const uint32_t t = adjacency[k];
+                    if (triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+    }
+
+    void OptimizeOverdraw(std::span<uint32_t> destination, std::span<const uint32_t> indices,
+                          const float* positions, uint32_t positionStride, uint32_t vertexCount, float threshold) {
+        assert(indices.size() % 3 == 0 && destination.size() >= indices.size());
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        const std::vector<uint32_t> source(indices.begin(), indices.end());
+        const auto getPosition = [positions, positionStride](uint32_t v) {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * static_cast<size_t>(positionStride));
+            return Vector3(p[0], p[1], p[2]);
+        };
+
+        // Hard boundaries where the cache order starts over, every vertex a miss
+        std::vector<uint32_t> misses(triangleCount);
+        std::vector<uint32_t> hardClusters;
+        {
+            VertexCacheSimulator cache(vertexCount, HardwareCacheSize);
+            for (uint32_t t = 0; t < triangleCount; t++) {
+                misses[t] = cache.Access(source[t * 3]) + cache.Access(source[t * 3 + 1]) + cache.Access(source[t * 3 + 2]);
+                if (t == 0 || misses[t] == 3) {
+                    hardClusters.push_back(t);
+                }
+            }
+            hardClusters.push_back(triangleCount);
+        }
+
+        // Soft boundaries inside each, where the part so far is no worse than
+        // the whole cluster by more than threshold, counting the cache as empty
+        std::vector<uint32_t> clusters;
+        {
+            VertexCacheSimulator cache(vertexCount, HardwareCacheSize);
+            for (size_t c = 0; c + 1 < hardClusters.size(); c++) {
+                const uint32_t begin = hardClusters[c];
+                const uint32_t end = hardClusters[c + 1];
+                uint32_t clusterMisses = 0;
+                for (uint32_t t = begin; t < end; t++) {
+                    clusterMisses += misses[t];
+                }
+                const float limit = clusterMisses / static_cast<float>(end - begin) * threshold;
+
+                uint32_t start = begin;
+                uint32_t partMisses = 0;
+                cache.Flush();
+                clusters.push_back(begin);
+                for (uint32_t t = begin; t < end; t++) {
+                    partMisses += cache.Access(source[t * 3]) + cache.Access(source[t * 3 + 1]) + cache.Access(source[t * 3 + 2]);
+                    const uint32_t partSize = t + 1 - start;
+                    if (partSize >= MinClusterSize && t + 1 < end && partMisses <= limit * partSize) {
+                        start = t + 1;
+                        partMisses = 0;
+                        cache.Flush();
+                        clusters.push_back(start);
+                    }
+                }
+            }
+            clusters.push_back(triangleCount);
+        }
+
+        // Area weighted centroid and normal of each cluster
+        const uint32_t clusterCount = static_cast<uint32_t>(clusters.size()) - 1;
+        std::vector<Vector3> centroids(clusterCount);
+        std::vector<Vector3> normals(clusterCount);
+        Vector3 meshCentroid = Vector3::Zero();
+        float meshArea = 0.0f;
+        for (uint32_t c = 0; c < clusterCount; c++) {
+            Vector3 centroid = Vector3::Zero();
+            Vector3 normal = Vector3::Zero();
+            float area = 0.0f;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+                const Vector3 p0 = getPosition(source[t * 3]);
+                const Vector3 p1 = getPosition(source[t * 3 + 1]);
+                const Vector3 p2 = getPosition(source[t * 3 + 2]);
+                const Vector3 cross = (p1 - p0).Cross(p2 - p0);
+                const float triangleArea = cross.Length();
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += cross;
+                area += triangleArea;
+            }
+            meshCentroid += centroid;
+            meshArea += area;
+            centroids[c] = area > 0.0f ? centroid / area : centroid;
+            normals[c] = normal.Normalized();
+        }
+        meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+        // Clusters far out along their normal occlude the rest, draw them first
+        std::vector<float> keys(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++) {
+            keys[c] = (centroids[c] - meshCentroid).Dot(normals[c]);
+        }
+        std::vector<uint32_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+        size_t output = 0;
+        for (const uint32_t c : order) {
+            const size_t begin = clusters[c] * 3;
+            const size_t end = clusters[c + 1] * 3;
+            std::copy(source.begin() + begin, source.begin() + end, destination.begin() + output);
+            output += end - begin;
+        }
+    }
+
+    uint32_t OptimizeVertexFetchRemap(std::span<uint32_t> remap, std::span<uint32_t> indices, uint32_t vertexCount) {
+        assert(remap.size() >= vertexCount);
+        std::fill(remap.begin(), remap.begin() + vertexCount, UINT32_MAX);
+        uint32_t next = 0;
+        for (uint32_t& index : indices) {
+            assert(index < vertexCount);
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = next++;
+            }
+            index = remap[index];
+        }
+        return next;
+    }
+
+    void RemapVertexBuffer(void* destination, const void* source, uint32_t vertexCount, uint32_t vertexSize,
+                           std::span<const uint32_t> remap) {
+        assert(destination != source);
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        const uint8_t* in = static_cast<const uint8_t*>(source);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            if (remap[v] != UINT32_MAX) {
+                memcpy(out + remap[v] * static_cast<size_t>(vertexSize), in + v * static_cast<size_t>(vertexSize), vertexSize);
+            }
+        }
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+        VertexCacheStatistics statistics;
+        if (indices.empty()) {
+            return statistics;
+        }
+
+        VertexCacheSimulator cache(vertexCount, cacheSize);
+        std::vector<uint8_t> used(vertexCount, 0);
+        uint32_t usedCount = 0;
+        for (const uint32_t index : indices) {
+            statistics.verticesTransformed += cache.Access(index);
+            usedCount += used[index] == 0;
+            used[index] = 1;
+        }
+        statistics.acmr = statistics.verticesTransformed / (indices.size() / 3.0f);
+        statistics.atvr = statistics.verticesTransformed / static_cast<float>(usedCount);
+        return statistics;
+    }
+
+    VertexFetchStatistics AnalyzeVertexFetch(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t vertexSize) {
+        VertexFetchStatistics statistics;
+        if (indices.empty()) {
+            return statistics;
+        }
+
+        // Vertices are fetched when they miss the post-transform cache
+        VertexCacheSimulator vertexCache(vertexCount, HardwareCacheSize);
+        const uint32_t lineCount = static_cast<uint32_t>((static_cast<uint64_t>(vertexCount) * vertexSize + FetchLineSize - 1) / FetchLineSize);
+        VertexCacheSimulator lineCache(lineCount, FetchCacheLines);
+        std::vector<uint8_t> used(vertexCount, 0);
+        uint32_t usedCount = 0;
+        for (const uint32_t index : indices) {
+            usedCount += used[index] == 0;
+            used[index] = 1;
+            if (!vertexCache.Access(index)) {
+                continue;
+            }
+            const uint64_t begin = static_cast<uint64_t>(index) * vertexSize;
+            for (uint64_t line = begin / FetchLineSize; line <= (begin + vertexSize - 1) / FetchLineSize; line++) {
+                statistics.bytesFetched += lineCache.Access(static_cast<uint32_t>(line)) ? FetchLineSize : 0;
+            }
+        }
+        statistics.overfetch = statistics.bytesFetched / static_cast<float>(static_cast<uint64_t>(usedCount) * vertexSize);
+        return statistics;
+    }
+
+    uint32_t OptimizeMesh(std::span<uint32_t> indices, void* vertices, uint32_t vertexCount, uint32_t vertexSize,
+                          const MeshOptimizeDesc& desc, MeshOptimizeStats* stats) {
+        if (stats) {
+            stats->cacheBefore = AnalyzeVertexCache(indices, vertexCount, desc.cacheSize);
+            stats->fetchBefore = AnalyzeVertexFetch(indices, vertexCount, vertexSize);
+            stats->vertexCountBefore = vertexCount;
+        }
+
+        if (desc.vertexCache) {
+            OptimizeVertexCache(indices, indices, vertexCount);
+        }
+        if (desc.overdraw) {
+            const float* positions = reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + desc.positionOffset);
+            OptimizeOverdraw(indices, indices, positions, vertexSize, vertexCount, desc.overdrawThreshold);
+        }
+
+        uint32_t newVertexCount = vertexCount;
+        if (desc.vertexFetch) {
+            std::vector<uint32_t> remap(vertexCount);
+            newVertexCount = OptimizeVertexFetchRemap(remap, indices, vertexCount);
+            const std::vector<uint8_t> source(static_cast<const uint8_t*>(vertices),
+                                              static_cast<const uint8_t*>(vertices) + static_cast<size_t>(vertexCount) * vertexSize);
+            RemapVertexBuffer(vertices, source.data(), vertexCount, vertexSize, remap);
+        }
+
+        if (stats) {
+            stats->cacheAfter = AnalyzeVertexCache(indices, newVertexCount, desc.cacheSize);
+            stats->fetchAfter = AnalyzeVertexFetch(indices, newVertexCount, vertexSize);
+            stats->vertexCountAfter = newVertexCount;
+        }
+        return newVertexCount;
+    }
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <span>
+
+namespace Reality {
+    // Post-transform vertex cache behaviour of an index buffer, simulated as
+    // a FIFO cache of cacheSize vertices
+    struct VertexCacheStatistics {
+        uint32_t verticesTransformed = 0;
+        float acmr = 0.0f;                  // Vertices transformed per triangle, 0.5 at best, 3 at worst
+        float atvr = 0.0f;                  // Vertices transformed per vertex used, 1 at best
+    };
+
+    // Vertex fetch behaviour, simulated as a cache of 64-byte lines
+    struct VertexFetchStatistics {
+        uint32_t bytesFetched = 0;
+        float overfetch = 0.0f;             // Bytes fetched per byte of vertex data used, 1 at best
+    };
+
+    struct MeshOptimizeDesc {
+        bool vertexCache = true;
+        bool overdraw = false;
+        bool vertexFetch = true;
+
+        // Overdraw ordering may raise the ACMR by up to this factor
+        float overdrawThreshold = 1.05f;
+
+        // Position of the three position floats in each vertex, read by the overdraw pass
+        uint32_t positionOffset = 0;
+
+        // For the statistics only, the optimization suits any cache size
+        uint32_t cacheSize = 16;
+    };
+
+    struct MeshOptimizeStats {
+        VertexCacheStatistics cacheBefore;
+        VertexCacheStatistics cacheAfter;
+        VertexFetchStatistics fetchBefore;
+        VertexFetchStatistics fetchAfter;
+        uint32_t vertexCountBefore = 0;
+        uint32_t vertexCountAfter = 0;
+    };
+
+    // Triangle list passes. destination and indices may be the same span.
+
+    // Reorders triangles for the post-transform vertex cache, using Forsyth's
+    // linear-speed algorithm
+    void OptimizeVertexCache(std::span<uint32_t> destination, std::span<const uint32_t> indices, uint32_t vertexCount);
+
+    // Reorders the clusters of a cache-optimized index buffer so triangles
+    // facing out of the mesh draw first, after Sander et al. Clusters are cut
+    // only where that raises the ACMR by less than threshold. Positions are
+    // three floats, positionStride bytes apart.
+    void OptimizeOverdraw(std::span<uint32_t> destination, std::span<const uint32_t> indices,
+                          const float* positions, uint32_t positionStride, uint32_t vertexCount, float threshold = 1.05f);
+
+    // Numbers vertices in the order the index buffer first uses them and
+    // rewrites the indices. remap receives the new index of each vertex,
+    // UINT32_MAX for unused ones. Returns the number of vertices in use.
+    uint32_t OptimizeVertexFetchRemap(std::span<uint32_t> remap, std::span<uint32_t> indices, uint32_t vertexCount);
+
+    // Moves vertex i of source to remap[i] in destination, which must not overlap source
+    void RemapVertexBuffer(void* destination, const void* source, uint32_t vertexCount, uint32_t vertexSize,
+                           std::span<const uint32_t> remap);
+
+    VertexCacheStatistics AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+    VertexFetchStatistics AnalyzeVertexFetch(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t vertexSize);
+
+    // Runs the passes enabled in desc on one mesh: vertex cache, overdraw,
+    // then vertex fetch, which rewrites vertices in place and drops unused
+    // ones. Returns the new vertex count.
+    uint32_t OptimizeMesh(std::span<uint32_t> indices, void* vertices, uint32_t vertexCount, uint32_t vertexSize,
+                          const MeshOptimizeDesc& desc = MeshOptimizeDesc(), MeshOptimizeStats* stats = nullptr);
+}
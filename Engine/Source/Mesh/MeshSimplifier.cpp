@@ -0,0 +1,557 @@
+﻿#include "MeshSimplifier.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace Reality {
+    namespace {
+        constexpr uint32_t MaxAttributes = 16;
+        constexpr uint32_t NoVertex = UINT32_MAX;
+
+        // Edge quadrics that hold borders and attribute seams in place,
+        // relative to the area weight of the surface quadrics
+        constexpr double BorderWeight = 10.0;
+        constexpr double SeamWeight = 1.0;
+
+        // Each pass takes collapses up to the cost of this fraction of its
+        // candidates, so the cheap ones that open up next pass go first
+        constexpr size_t PassFraction = 3;
+
+        // Symmetric 4x4 quadric in double, accumulated from weighted planes
+        struct Quadric {
+            double a00 = 0.0, a11 = 0.0, a22 = 0.0, a10 = 0.0, a20 = 0.0, a21 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            double c = 0.0;
+            double w = 0.0;
+
+            void AddPlane(const Vector3& normal, float distance, double weight) {
+                const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+                a00 += weight * x * x; a11 += weight * y * y; a22 += weight * z * z;
+                a10 += weight * x * y; a20 += weight * x * z; a21 += weight * y * z;
+                b0 += weight * x * d; b1 += weight * y * d; b2 += weight * z * d;
+                c += weight * d * d;
+                w += weight;
+            }
+
+            Quadric& operator+=(const Quadric& q) {
+                a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+                b0 += q.b0; b1 += q.b1; b2 += q.b2;
+                c += q.c;
+                w += q.w;
+                return *this;
+            }
+
+            // Weighted sum of squared distances, not yet divided by w
+            double Evaluate(const Vector3& p) const {
+                const double x = p.x, y = p.y, z = p.z;
+                const double rx = a00 * x + a10 * y + a20 * z;
+                const double ry = a10 * x + a11 * y + a21 * z;
+                const double rz = a20 * x + a21 * y + a22 * z;
+                return rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            }
+        };
+
+        enum class VertexKind : uint8_t {
+            Manifold,       // Interior, collapses along any edge
+            Border,         // On an open border, collapses along it only
+            Locked          // Never moves
+        };
+
+        struct Collapse {
+            uint32_t vertex;
+            uint32_t target;
+            float cost;
+        };
+
+        // Wedge of the collapsing vertex and the wedge of the target it merges into
+        struct WedgePair {
+            uint32_t wedge;
+            uint32_t target;
+        };
+
+        uint64_t EdgeKey(uint32_t a, uint32_t b) {
+            return (static_cast<uint64_t>(a) << 32) | b;
+        }
+
+        bool HasEdge(const std::vector<uint64_t>& edges, uint32_t a, uint32_t b) {
+            return std::binary_search(edges.begin(), edges.end(), EdgeKey(a, b));
+        }
+
+        // Vertices are wedges, the index buffer's vertices. Wedges that share a
+        // position are welded into one position vertex, named after its first
+        // wedge, which owns the position quadric and kind. Wedges own the
+        // attribute quadrics.
+        class Simplifier {
+        public:
+            Simplifier(std::span<const uint32_t> indices, const float* positions, uint32_t positionStride,
+                       uint32_t vertexCount, const SimplifyDesc& desc)
+                : m_positions(reinterpret_cast<const uint8_t*>(positions)), m_positionStride(positionStride),
+                  m_vertexCount(vertexCount), m_desc(desc),
+                  m_attributeCount(desc.attributes ? static_cast<uint32_t>(desc.attributeWeights.size()) : 0) {
+                assert(m_attributeCount <= MaxAttributes && "Too many simplification attributes");
+                WeldPositions();
+                m_indices.reserve(indices.size());
+                for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                    assert(indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount);
+                    if (!IsDegenerate(indices[i], indices[i + 1], indices[i + 2])) {
+                        m_indices.insert(m_indices.end(), { indices[i], indices[i + 1], indices[i + 2] });
+                    }
+                }
+                ClassifyVertices();
+                ComputeQuadrics();
+            }
+
+            void Run(uint32_t targetIndexCount, float targetError) {
+                const double errorLimit = static_cast<double>(targetError) * targetError;
+                m_remap.resize(m_vertexCount);
+                while (m_indices.size() > targetIndexCount) {
+                    BuildAdjacency();
+                    std::vector<Collapse> collapses = FindCollapses(errorLimit);
+                    if (collapses.empty()) {
+                        break;
+                    }
+                    std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+                    if (!ApplyCollapses(collapses, targetIndexCount)) {
+                        break;
+                    }
+                }
+            }
+
+            const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+            float GetError() const { return static_cast<float>(std::sqrt(m_error)); }
+
+        private:
+            Vector3 GetPosition(uint32_t v) const {
+                const float* p = reinterpret_cast<const float*>(m_positions + v * static_cast<size_t>(m_positionStride));
+                return Vector3(p[0], p[1], p[2]);
+            }
+
+            float GetAttribute(uint32_t v, uint32_t attribute) const {
+                const float* a = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(m_desc.attributes) +
+                                                                v * static_cast<size_t>(m_desc.attributeStride));
+                return a[attribute] * m_desc.attributeWeights[attribute];
+            }
+
+            bool IsDegenerate(uint32_t a, uint32_t b, uint32_t c) const {
+                a = m_weld[a]; b = m_weld[b]; c = m_weld[c];
+                return a == b || b == c || c == a;
+            }
+
+            void WeldPositions() {
+                std::vector<uint32_t> order(m_vertexCount);
+                std::iota(order.begin(), order.end(), 0u);
+                const auto less = [this](uint32_t a, uint32_t b) {
+                    const Vector3 pa = GetPosition(a);
+                    const Vector3 pb = GetPosition(b);
+                    return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z != pb.z ? pa.z < pb.z : a < b;
+                };
+                std::sort(order.begin(), order.end(), less);
+
+                // Equal positions link into a cycle through m_wedgeNext
+                m_weld.resize(m_vertexCount);
+                m_wedgeNext.resize(m_vertexCount);
+                for (size_t begin = 0; begin < order.size();) {
+                    size_t end = begin + 1;
+                    while (end < order.size() && GetPosition(order[end]) == GetPosition(order[begin])) {
+                        end++;
+                    }
+                    for (size_t i = begin; i < end; i++) {
+                        m_weld[order[i]] = order[begin];
+                        m_wedgeNext[order[i]] = order[i + 1 < end ? i + 1 : begin];
+                    }
+                    begin = end;
+                }
+            }
+
+            void ClassifyVertices() {
+                std::vector<uint64_t> edges;
+                edges.reserve(m_indices.size());
+                for (size_t i = 0; i < m_indices.size(); i++) {
+                    edges.push_back(EdgeKey(m_weld[m_indices[i]], m_weld[m_indices[i - i % 3 + (i + 1) % 3]]));
+                }
+                std::sort(edges.begin(), edges.end());
+
+                m_kinds.assign(m_vertexCount, VertexKind::Manifold);
+                std::vector<uint8_t> complex(m_vertexCount, 0);
+                for (size_t i = 0; i < edges.size(); i++) {
+                    const uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+                    const uint32_t b = static_cast<uint32_t>(edges[i]);
+                    // An edge used twice the same way joins more than two triangles or flipped ones
+                    if ((i > 0 && edges[i - 1] == edges[i]) || (i + 1 < edges.size() && edges[i + 1] == edges[i])) {
+                        complex[a] = complex[b] = 1;
+                    } else if (!HasEdge(edges, b, a)) {
+                        m_kinds[a] = m_kinds[b] = VertexKind::Border;
+                    }
+                }
+                for (uint32_t v = 0; v < m_vertexCount; v++) {
+                    if (complex[v] || (m_desc.lockBorder && m_kinds[v] == VertexKind::Border)) {
+                        m_kinds[v] = VertexKind::Locked;
+                    }
+                }
+                m_positionEdges = std::move(edges);
+            }
+
+            void ComputeQuadrics() {
+                m_quadrics.assign(m_vertexCount, Quadric());
+                if (m_attributeCount > 0) {
+                    m_attributeQuadrics.assign(m_vertexCount, Quadric());
+                    m_gradients.assign(static_cast<size_t>(m_vertexCount) * m_attributeCount * 4, 0.0);
+                }
+
+                // Wedge edges, an interior edge without its reverse is an attribute seam
+                std::vector<uint64_t> wedgeEdges;
+                wedgeEdges.reserve(m_indices.size());
+                for (size_t i = 0; i < m_indices.size(); i++) {
+                    wedgeEdges.push_back(EdgeKey(m_indices[i], m_indices[i - i % 3 + (i + 1) % 3]));
+                }
+                std::sort(wedgeEdges.begin(), wedgeEdges.end());
+
+                for (size_t i = 0; i < m_indices.size(); i += 3) {
+                    const uint32_t* triangle = &m_indices[i];
+                    const Vector3 p0 = GetPosition(triangle[0]);
+                    const Vector3 p1 = GetPosition(triangle[1]);
+                    const Vector3 p2 = GetPosition(triangle[2]);
+                    const Vector3 cross = (p1 - p0).Cross(p2 - p0);
+                    const float length = cross.Length();
+                    if (length == 0.0f) {
+                        continue;
+                    }
+                    const Vector3 normal = cross / length;
+                    const double area = length * 0.5;
+
+                    Quadric plane;
+                    plane.AddPlane(normal, -normal.Dot(p0), area);
+                    for (int k = 0; k < 3; k++) {
+                        m_quadrics[m_weld[triangle[k]]] += plane;
+                    }
+
+                    for (int k = 0; k < 3; k++) {
+                        const uint32_t a = triangle[k];
+                        const uint32_t b = triangle[(k + 1) % 3];
+                        const bool border = !HasEdge(m_positionEdges, m_weld[b], m_weld[a]);
+                        if (!border && HasEdge(wedgeEdges, b, a)) {
+                            continue;
+                        }
+                        // Plane through the edge, perpendicular to the triangle
+                        const Vector3 pa = GetPosition(a);
+                        const Vector3 edge = GetPosition(b) - pa;
+                        const Vector3 edgeNormal = edge.Cross(normal).Normalized();
+                        Quadric edgeQuadric;
+                        edgeQuadric.AddPlane(edgeNormal, -edgeNormal.Dot(pa), edge.LengthSquared() * (border ? BorderWeight : SeamWeight));
+                        m_quadrics[m_weld[a]] += edgeQuadric;
+                        m_quadrics[m_weld[b]] += edgeQuadric;
+                    }
+
+                    if (m_attributeCount > 0) {
+                        AddAttributeQuadrics(triangle, p0, p1, p2, area);
+                    }
+                }
+            }
+
+            // Each attribute varies linearly over the triangle as dot(g, p) + d.
+            // Its squared difference from the value kept at a collapse expands to
+            // a quadric in p plus terms linear in that value.
+            void AddAttributeQuadrics(const uint32_t* triangle, const Vector3& p0, const Vector3& p1, const Vector3& p2, double area) {
+                const Vector3 e1 = p1 - p0;
+                const Vector3 e2 = p2 - p0;
+                const double d11 = e1.Dot(e1), d12 = e1.Dot(e2), d22 = e2.Dot(e2);
+                const double determinant = d11 * d22 - d12 * d12;
+                if (determinant <= 0.0) {
+                    return;
+                }
+
+                Quadric quadric;
+                double gradients[MaxAttributes][4];
+                for (uint32_t j = 0; j < m_attributeCount; j++) {
+                    const double a0 = GetAttribute(triangle[0], j);
+                    const double da1 = GetAttribute(triangle[1], j) - a0;
+                    const double da2 = GetAttribute(triangle[2], j) - a0;
+                    const double alpha = (d22 * da1 - d12 * da2) / determinant;
+                    const double beta = (d11 * da2 - d12 * da1) / determinant;
+                    const double gx = alpha * e1.x + beta * e2.x;
+                    const double gy = alpha * e1.y + beta * e2.y;
+                    const double gz = alpha * e1.z + beta * e2.z;
+                    const double d = a0 - (gx * p0.x + gy * p0.y + gz * p0.z);
+
+                    quadric.a00 += area * gx * gx; quadric.a11 += area * gy * gy; quadric.a22 += area * gz * gz;
+                    quadric.a10 += area * gx * gy; quadric.a20 += area * gx * gz; quadric.a21 += area * gy * gz;
+                    quadric.b0 += area * gx * d; quadric.b1 += area * gy * d; quadric.b2 += area * gz * d;
+                    quadric.c += area * d * d;
+                    gradients[j][0] = area * gx;
+                    gradients[j][1] = area * gy;
+                    gradients[j][2] = area * gz;
+                    gradients[j][3] = area * d;
+                }
+                quadric.w = area;
+
+                for (int k = 0; k < 3; k++) {
+                    m_attributeQuadrics[triangle[k]] += quadric;
+                    double* target = &m_gradients[static_cast<size_t>(triangle[k]) * m_attributeCount * 4];
+                    for (uint32_t j = 0; j < m_attributeCount * 4; j++) {
+                        target[j] += gradients[j / 4][j % 4];
+                    }
+                }
+            }
+
+            // Attribute error of merging wedge into target, keeping target's attributes
+            double AttributeError(uint32_t wedge, uint32_t target, const Vector3& p) const {
+                Quadric quadric = m_attributeQuadrics[wedge];
+                quadric += m_attributeQuadrics[target];
+                if (quadric.w <= 0.0) {
+                    return 0.0;
+                }
+                double error = quadric.Evaluate(p);
+                const double* g0 = &m_gradients[static_cast<size_t>(wedge) * m_attributeCount * 4];
+                const double* g1 = &m_gradients[static_cast<size_t>(target) * m_attributeCount * 4];
+                for (uint32_t j = 0; j < m_attributeCount; j++) {
+                    const double* a = g0 + j * 4;
+                    const double* b = g1 + j * 4;
+                    const double s = GetAttribute(target, j);
+                    const double value = (a[0] + b[0]) * p.x + (a[1] + b[1]) * p.y + (a[2] + b[2]) * p.z + a[3] + b[3];
+                    error += s * s * quadric.w - 2.0 * s * value;
+                }
+                return std::max(error, 0.0) / quadric.w;
+            }
+
+            // Triangles around each position vertex
+            void BuildAdjacency() {
+                m_offsets.assign(m_vertexCount + 1, 0);
+                for (const uint32_t index : m_indices) {
+                    m_offsets[m_weld[index] + 1]++;
+                }
+                std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+                m_triangles.resize(m_indices.size());
+                std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+                for (size_t i = 0; i < m_indices.size(); i++) {
+                    m_triangles[fill[m_weld[m_indices[i]]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            // Checks that vertex can collapse onto target and pairs up their
+            // wedges. Each wedge in use must share an edge with exactly one
+            // wedge of target, a different one for each.
+            bool GetWedgePairs(uint32_t vertex, uint32_t target, std::vector<WedgePair>& pairs, uint32_t& sharedCount) const {
+                if (m_kinds[vertex] == VertexKind::Locked) {
+                    return false;
+                }
+
+                sharedCount = 0;
+                for (uint32_t k = m_offsets[vertex]; k < m_offsets[vertex + 1]; k++) {
+                    const uint32_t* triangle = &m_indices[m_triangles[k] * 3];
+                    sharedCount += m_weld[triangle[0]] == target || m_weld[triangle[1]] == target || m_weld[triangle[2]] == target;
+                }
+                // Borders only collapse along a border edge
+                if (sharedCount == 0 || sharedCount > 2 || (m_kinds[vertex] == VertexKind::Border && sharedCount != 1)) {
+                    return false;
+                }
+
+                pairs.clear();
+                uint32_t wedge = vertex;
+                do {
+                    bool used = false;
+                    uint32_t partner = NoVertex;
+                    for (uint32_t k = m_offsets[vertex]; k < m_offsets[vertex + 1]; k++) {
+                        const uint32_t* triangle = &m_indices[m_triangles[k] * 3];
+                        for (int i = 0; i < 3; i++) {
+                            if (triangle[i] != wedge) {
+                                continue;
+                            }
+                            used = true;
+                            for (int j = 1; j < 3; j++) {
+                                const uint32_t other = triangle[(i + j) % 3];
+                                if (m_weld[other] != target) {
+                                    continue;
+                                }
+                                if (partner != NoVertex && partner != other) {
+                                    return false;
+                                }
+                                partner = other;
+                            }
+                        }
+                    }
+                    if (used) {
+                        if (partner == NoVertex) {
+                            return false;
+                        }
+                        for (const WedgePair& pair : pairs) {
+                            if (pair.target == partner) {
+                                return false;
+                            }
+                        }
+                        pairs.push_back({ wedge, partner });
+                    }
+                    wedge = m_wedgeNext[wedge];
+                } while (wedge != vertex);
+                return true;
+            }
+
+            double GetCost(uint32_t vertex, uint32_t target, const std::vector<WedgePair>& pairs) const {
+                Quadric quadric = m_quadrics[vertex];
+                quadric += m_quadrics[target];
+                const Vector3 p = GetPosition(target);
+                double cost = quadric.w > 0.0 ? std::max(quadric.Evaluate(p), 0.0) / quadric.w : 0.0;
+                if (m_attributeCount > 0) {
+                    for (const WedgePair& pair : pairs) {
+                        cost += AttributeError(pair.wedge, pair.target, p);
+                    }
+                }
+                return cost;
+            }
+
+            std::vector<Collapse> FindCollapses(double errorLimit) const {
+                std::vector<uint64_t> edges;
+                edges.reserve(m_indices.size());
+                for (size_t i = 0; i < m_indices.size(); i++) {
+                    const uint32_t a = m_weld[m_indices[i]];
+                    const uint32_t b = m_weld[m_indices[i - i % 3 + (i + 1) % 3]];
+                    edges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+                }
+                std::sort(edges.begin(), edges.end());
+                edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+                // The cheaper direction of each edge
+                std::vector<Collapse> collapses;
+                std::vector<WedgePair> pairs;
+                for (const uint64_t edge : edges) {
+                    const uint32_t a = static_cast<uint32_t>(edge >> 32);
+                    const uint32_t b = static_cast<uint32_t>(edge);
+                    uint32_t sharedCount;
+                    double best = INFINITY;
+                    Collapse collapse = {};
+                    if (GetWedgePairs(a, b, pairs, sharedCount)) {
+                        best = GetCost(a, b, pairs);
+                        collapse = { a, b, static_cast<float>(best) };
+                    }
+                    if (GetWedgePairs(b, a, pairs, sharedCount)) {
+                        const double cost = GetCost(b, a, pairs);
+                        if (cost < best) {
+                            best = cost;
+                            collapse = { b, a, static_cast<float>(cost) };
+                        }
+                    }
+                    if (best <= errorLimit) {
+                        collapses.push_back(collapse);
+                    }
+                }
+                return collapses;
+            }
+
+            // Rejects collapses that would turn a triangle around vertex over
+            bool FlipsTriangle(uint32_t vertex, uint32_t target) const {
+                const Vector3 targetPosition = GetPosition(target);
+                for (uint32_t k = m_offsets[vertex]; k < m_offsets[vertex + 1]; k++) {
+                    const uint32_t* triangle = &m_indices[m_triangles[k] * 3];
+                    uint32_t corners[3];
+                    int moving = 0;
+                    for (int i = 0; i < 3; i++) {
+                        corners[i] = m_weld[m_remap[triangle[i]]];
+                        moving = corners[i] == vertex ? i : moving;
+                    }
+                    if (corners[0] == target || corners[1] == target || corners[2] == target ||
+                        corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+                        continue;
+                    }
+                    const Vector3 p1 = GetPosition(corners[(moving + 1) % 3]);
+                    const Vector3 p2 = GetPosition(corners[(moving + 2) % 3]);
+                    const Vector3 before = (p1 - GetPosition(vertex)).Cross(p2 - GetPosition(vertex));
+                    const Vector3 after = (p1 - targetPosition).Cross(p2 - targetPosition);
+                    if (before.Dot(after) <= 1e-2f * before.Length() * after.Length()) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Takes the cheapest collapses that touch no vertex another one did
+            // this pass, then rewrites the index buffer. Returns false if none applied.
+            bool ApplyCollapses(const std::vector<Collapse>& collapses, uint32_t targetIndexCount) {
+                std::iota(m_remap.begin(), m_remap.end(), 0u);
+                std::vector<uint8_t> touched(m_vertexCount, 0);
+                std::vector<WedgePair> pairs;
+                const float passLimit = collapses[collapses.size() / PassFraction].cost;
+                size_t triangleCount = m_indices.size() / 3;
+                uint32_t applied = 0;
+
+                for (const Collapse& collapse : collapses) {
+                    if (collapse.cost > passLimit || triangleCount * 3 <= targetIndexCount) {
+                        break;
+                    }
+                    if (touched[collapse.vertex] || touched[collapse.target]) {
+                        continue;
+                    }
+                    uint32_t sharedCount;
+                    if (!GetWedgePairs(collapse.vertex, collapse.target, pairs, sharedCount) ||
+                        FlipsTriangle(collapse.vertex, collapse.target)) {
+                        continue;
+                    }
+
+                    for (const WedgePair& pair : pairs) {
+                        m_remap[pair.wedge] = pair.target;
+                        if (m_attributeCount > 0) {
+                            m_attributeQuadrics[pair.target] += m_attributeQuadrics[pair.wedge];
+                            double* target = &m_gradients[static_cast<size_t>(pair.target) * m_attributeCount * 4];
+                            const double* source = &m_gradients[static_cast<size_t>(pair.wedge) * m_attributeCount * 4];
+                            for (uint32_t j = 0; j < m_attributeCount * 4; j++) {
+                                target[j] += source[j];
+                            }
+                        }
+                    }
+                    m_quadrics[collapse.target] += m_quadrics[collapse.vertex];
+                    m_error = std::max(m_error, static_cast<double>(collapse.cost));
+                    touched[collapse.vertex] = touched[collapse.target] = 1;
+                    triangleCount -= sharedCount;
+                    applied++;
+                }
+
+                size_t output = 0;
+                for (size_t i = 0; i < m_indices.size(); i += 3) {
+                    const uint32_t a = m_remap[m_indices[i]];
+                    const uint32_t b = m_remap[m_indices[i + 1]];
+                    const uint32_t c = m_remap[m_indices[i + 2]];
+                    if (!IsDegenerate(a, b, c)) {
+                        m_indices[output++] = a;
+                        m_indices[output++] = b;
+                        m_indices[output++] = c;
+                    }
+                }
+                m_indices.resize(output);
+                return applied > 0;
+            }
+
+            const uint8_t* m_positions;
+            uint32_t m_positionStride;
+            uint32_t m_vertexCount;
+            const SimplifyDesc& m_desc;
+            uint32_t m_attributeCount;
+
+            std::vector<uint32_t> m_indices;
+            std::vector<uint32_t> m_weld;
+            std::vector<uint32_t> m_wedgeNext;
+            std::vector<VertexKind> m_kinds;
+            std::vector<uint64_t> m_positionEdges;
+            std::vector<Quadric> m_quadrics;
+            std::vector<Quadric> m_attributeQuadrics;
+            std::vector<double> m_gradients;
+            std::vector<uint32_t> m_remap;
+            std::vector<uint32_t> m_offsets;
+            std::vector<uint32_t> m_triangles;
+            double m_error = 0.0;
+        };
+    }
+
+    uint32_t SimplifyMesh(std::span<uint32_t> destination, std::span<const uint32_t> indices, const float* positions,
+                          uint32_t positionStride, uint32_t vertexCount, const SimplifyDesc& desc, float* resultError) {
+        assert(indices.size() % 3 == 0 && destination.size() >= indices.size());
+        assert(positionStride >= sizeof(float) * 3);
+
+        Simplifier simplifier(indices, positions, positionStride, vertexCount, desc);
+        simplifier.Run(desc.targetIndexCount, desc.targetError);
+
+        const std::vector<uint32_t>& result = simplifier.GetIndices();
+        std::copy(result.begin(), result.end(), destination.begin());
+        if (resultError) {
+            *resultError = simplifier.GetError();
+        }
+        return static_cast<uint32_t>(result.size());
+    }
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <span>
+
+namespace Reality {
+    struct SimplifyDesc {
+        // Stop once the index count is at or below this
+        uint32_t targetIndexCount = 0;
+
+        // Stop before any collapse that would move the surface further than
+        // this, in position units
+        float targetError = INFINITY;
+
+        // Keep open borders exactly where they are. Otherwise border vertices
+        // may collapse along the border.
+        bool lockBorder = true;
+
+        // Optional per-vertex attributes, such as normals and texture coordinates,
+        // attributeWeights.size() floats each, attributeStride bytes apart. A
+        // weight scales how far an attribute may drift per unit of position
+        // error, so 1 for a unit normal keeps shading close to the source.
+        const float* attributes = nullptr;
+        uint32_t attributeStride = 0;
+        std::span<const float> attributeWeights;
+    };
+
+    // Simplifies a triangle list by edge collapse ordered by quadric error
+    // (Garland and Heckbert, with Hoppe's attribute terms). Vertices only
+    // move onto existing vertices, so the result indexes the same vertex
+    // buffer. Vertices that share a position but not attributes collapse
+    // together, keeping attribute seams intact. Non-manifold edges never
+    // collapse. Positions are three floats, positionStride bytes apart.
+    //
+    // destination may be the same span as indices. Returns the index count
+    // written, and the error reached in resultError if not null.
+    uint32_t SimplifyMesh(std::span<uint32_t> destination, std::span<const uint32_t> indices, const float* positions,
+                          uint32_t positionStride, uint32_t vertexCount, const SimplifyDesc& desc, float* resultError = nullptr);
+}
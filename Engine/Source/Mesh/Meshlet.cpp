@@ -0,0 +1,259 @@
+﻿#include "Meshlet.h"
+#include <algorithm>
+#include <numeric>
+
+namespace Reality {
+    namespace {
+        constexpr uint8_t NotInMeshlet = 0xFF;
+        constexpr uint32_t MaxVertexLimit = 255;
+        constexpr uint32_t MaxTriangleLimit = 512;
+
+        // New vertices weigh more than any difference in facing
+        constexpr float NewVertexCost = 4.0f;
+        constexpr float LiveTriangleCost = 0.1f;
+
+        Vector3 GetPosition(const float* positions, uint32_t stride, uint32_t v) {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * static_cast<size_t>(stride));
+            return Vector3(p[0], p[1], p[2]);
+        }
+
+        // Ritter's sphere, started from the most distant pair of axis extremes
+        BoundingSphere ComputeSphere(std::span<const Vector3> points) {
+            uint32_t minIndex[3] = {};
+            uint32_t maxIndex[3] = {};
+            for (uint32_t i = 1; i < points.size(); i++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    minIndex[axis] = points[i][axis] < points[minIndex[axis]][axis] ? i : minIndex[axis];
+                    maxIndex[axis] = points[i][axis] > points[maxIndex[axis]][axis] ? i : maxIndex[axis];
+                }
+            }
+            int widest = 0;
+            for (int axis = 1; axis < 3; axis++) {
+                if ((points[maxIndex[axis]] - points[minIndex[axis]]).LengthSquared() >
+                    (points[maxIndex[widest]] - points[minIndex[widest]]).LengthSquared()) {
+                    widest = axis;
+                }
+            }
+
+            Vector3 center = (points[minIndex[widest]] + points[maxIndex[widest]]) * 0.5f;
+            float radius = (points[maxIndex[widest]] - center).Length();
+            for (const Vector3& p : points) {
+                const float distance = (p - center).Length();
+                if (distance > radius) {
+                    const float grown = (radius + distance) * 0.5f;
+                    center += (p - center) * ((grown - radius) / distance);
+                    radius = grown;
+                }
+            }
+            return BoundingSphere(center, radius);
+        }
+
+        // Adds the meshlet's bounds and normal cone to the culling streams
+        void AddMeshletBounds(MeshletMesh& mesh, const Meshlet& meshlet, const float* positions, uint32_t positionStride) {
+            Vector3 points[MaxVertexLimit];
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                points[i] = GetPosition(positions, positionStride, mesh.vertices[meshlet.vertexOffset + i]);
+            }
+            const BoundingSphere sphere = ComputeSphere(std::span<const Vector3>(points, meshlet.vertexCount));
+
+            Vector3 normals[MaxTriangleLimit];
+            uint32_t normalCount = 0;
+            Vector3 axis = Vector3::Zero();
+            for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+                const uint8_t* triangle = &mesh.triangles[(meshlet.triangleOffset + t) * 3];
+                const Vector3 p0 = points[triangle[0]];
+                const Vector3 normal = (points[triangle[1]] - p0).Cross(points[triangle[2]] - p0);
+                const float length = normal.Length();
+                if (length > 0.0f) {
+                    normals[normalCount] = normal / length;
+                    axis += normals[normalCount++];
+                }
+            }
+
+            // The cone's half angle reaches the normal furthest from the axis
+            float cutoff = 1.0f;
+            const float axisLength = axis.Length();
+            if (axisLength > 0.0f) {
+                axis = axis / axisLength;
+                float minDot = 1.0f;
+                for (uint32_t i = 0; i < normalCount; i++) {
+                    minDot = Min(minDot, normals[i].Dot(axis));
+                }
+                cutoff = minDot > 0.0f ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+            }
+
+            mesh.centers.PushBack(sphere.center);
+            mesh.radii.push_back(sphere.radius);
+            mesh.coneAxes.PushBack(axis);
+            mesh.coneCutoffs.push_back(cutoff);
+        }
+    }
+
+    bool BuildMeshlets(MeshletMesh& result, std::span<const uint32_t> indices, const float* positions, uint32_t positionStride,
+                       uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles) {
+        assert(indices.size() % 3 == 0);
+        if (maxVertices < 3 || maxVertices > MaxVertexLimit || maxTriangles < 1 || maxTriangles > MaxTriangleLimit) {
+            return false;
+        }
+
+        result = MeshletMesh();
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        // Triangles around each vertex
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (const uint32_t index : indices) {
+            assert(index < vertexCount);
+            offsets[index + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (uint32_t i = 0; i < indices.size(); i++) {
+                adjacency[fill[indices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<Vector3> triangleNormals(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            const Vector3 p0 = GetPosition(positions, positionStride, indices[t * 3]);
+            const Vector3 p1 = GetPosition(positions, positionStride, indices[t * 3 + 1]);
+            const Vector3 p2 = GetPosition(positions, positionStride, indices[t * 3 + 2]);
+            triangleNormals[t] = (p1 - p0).Cross(p2 - p0).Normalized();
+        }
+
+        std::vector<uint8_t> localIndex(vertexCount, NotInMeshlet);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        Meshlet meshlet;
+        Vector3 normalSum = Vector3::Zero();
+        uint32_t cursor = 0;
+
+        const auto finishMeshlet = [&]() {
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                localIndex[result.vertices[meshlet.vertexOffset + i]] = NotInMeshlet;
+            }
+            result.meshlets.push_back(meshlet);
+            AddMeshletBounds(result, meshlet, positions, positionStride);
+            meshlet.vertexOffset += meshlet.vertexCount;
+            meshlet.triangleOffset += meshlet.triangleCount;
+            meshlet.vertexCount = 0;
+            meshlet.triangleCount = 0;
+            normalSum = Vector3::Zero();
+        };
+
+        const auto getNewVertexCount = [&](uint32_t t) {
+            return static_cast<uint32_t>(localIndex[indices[t * 3]] == NotInMeshlet) +
+                   static_cast<uint32_t>(localIndex[indices[t * 3 + 1]] == NotInMeshlet) +
+                   static_cast<uint32_t>(localIndex[indices[t * 3 + 2]] == NotInMeshlet);
+        };
+
+        // Triangles around the given vertices that fit the meshlet. Few new
+        // vertices come first, then vertices with few triangles left, which
+        // would otherwise end up stranded, then facing along direction.
+        std::vector<uint32_t> liveCounts(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            liveCounts[v] = offsets[v + 1] - offsets[v];
+        }
+        const auto findTriangle = [&](uint32_t vertexOffset, uint32_t count, const Vector3& direction) {
+            uint32_t best = UINT32_MAX;
+            float bestCost = INFINITY;
+            for (uint32_t i = 0; i < count; i++) {
+                const uint32_t v = result.vertices[vertexOffset + i];
+                for (uint32_t k = offsets[v]; k < offsets[v + 1]; k++) {
+                    const uint32_t t = adjacency[k];
+                    if (emitted[t]) {
+                        continue;
+                    }
+                    const uint32_t newVertices = getNewVertexCount(t);
+                    if (meshlet.vertexCount + newVertices > maxVertices) {
+                        continue;
+                    }
+                    const uint32_t live = liveCounts[indices[t * 3]] + liveCounts[indices[t * 3 + 1]] + liveCounts[indices[t * 3 + 2]];
+                    const float cost = newVertices * NewVertexCost + live * LiveTriangleCost + (1.0f - triangleNormals[t].Dot(direction));
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        best = t;
+                    }
+                }
+            }
+            return best;
+        };
+
+        for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+            // Best unemitted triangle sharing a vertex with the meshlet
+            uint32_t best = findTriangle(meshlet.vertexOffset, meshlet.vertexCount, normalSum.Normalized());
+
+            // Nothing fits, start a new meshlet next to the last one, or from
+            // the next triangle in order when it is surrounded
+            if (best == UINT32_MAX) {
+                uint32_t previousOffset = meshlet.vertexOffset;
+                uint32_t previousCount = meshlet.vertexCount;
+                if (meshlet.triangleCount > 0) {
+                    finishMeshlet();
+                } else if (!result.meshlets.empty()) {
+                    previousOffset = result.meshlets.back().vertexOffset;
+                    previousCount = result.meshlets.back().vertexCount;
+                }
+                best = findTriangle(previousOffset, previousCount, Vector3::Zero());
+                if (best == UINT32_MAX) {
+                    while (emitted[cursor]) {
+                        cursor++;
+                    }
+                    best = cursor;
+                }
+            }
+
+            for (int k = 0; k < 3; k++) {
+                const uint32_t v = indices[best * 3 + k];
+                if (localIndex[v] == NotInMeshlet) {
+                    localIndex[v] = static_cast<uint8_t>(meshlet.vertexCount++);
+                    result.vertices.push_back(v);
+                }
+                result.triangles.push_back(localIndex[v]);
+                liveCounts[v]--;
+            }
+            emitted[best] = 1;
+            normalSum += triangleNormals[best];
+            if (++meshlet.triangleCount == maxTriangles) {
+                finishMeshlet();
+            }
+        }
+        if (meshlet.triangleCount > 0) {
+            finishMeshlet();
+        }
+        return true;
+    }
+
+    uint32_t CullMeshlets(const MeshletMesh& mesh, const Frustum& frustum, const Vector3& cameraPosition,
+                          std::span<uint32_t> visibleMeshlets) {
+        assert(visibleMeshlets.size() >= mesh.meshlets.size() && "Output must have room for every meshlet");
+        const uint32_t inFrustum = CullSpheres(frustum, mesh.centers.AsSpan(), mesh.radii, visibleMeshlets);
+
+        // Compacts the survivors of the cone test in place
+        uint32_t visible = 0;
+        for (uint32_t i = 0; i < inFrustum; i++) {
+            const uint32_t index = visibleMeshlets[i];
+            const Vector3 toCenter = mesh.centers.Get(index) - cameraPosition;
+            const bool backFacing = toCenter.Dot(mesh.coneAxes.Get(index)) >=
+                                    mesh.coneCutoffs[index] * toCenter.Length() + mesh.radii[index];
+            if (!backFacing) {
+                visibleMeshlets[visible++] = index;
+            }
+        }
+        return visible;
+    }
+
+    uint32_t WriteMeshletIndices(const MeshletMesh& mesh, std::span<const uint32_t> meshlets, std::span<uint32_t> destination) {
+        uint32_t count = 0;
+        for (const uint32_t index : meshlets) {
+            const Meshlet& meshlet = mesh.meshlets[index];
+            assert(count + meshlet.triangleCount * 3 <= destination.size());
+            const uint32_t* vertices = &mesh.vertices[meshlet.vertexOffset];
+            const uint8_t* triangles = &mesh.triangles[meshlet.triangleOffset * 3];
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++) {
+                destination[count++] = vertices[triangles[i]];
+            }
+        }
+        return count;
+    }
+}
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <Core/MathBatch.h>
+#include <span>
+#include <vector>
+
+namespace Reality {
+    // Limits that fit every mesh shader implementation, with triangles
+    // rounded so a meshlet's local indices fill whole 4-byte words
+    constexpr uint32_t MeshletMaxVertices = 64;
+    constexpr uint32_t MeshletMaxTriangles = 124;
+
+    // Ranges of MeshletMesh::vertices and MeshletMesh::triangles
+    struct Meshlet {
+        uint32_t vertexOffset = 0;
+        uint32_t triangleOffset = 0;       // In triangles, three local indices each
+        uint32_t vertexCount = 0;
+        uint32_t triangleCount = 0;
+    };
+
+    // Small clusters of a triangle list, for mesh shaders or for culling on
+    // the CPU. Each meshlet lists the vertex buffer indices it uses and its
+    // triangles as 8-bit indices into that list.
+    struct MeshletMesh {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> vertices;
+        std::vector<uint8_t> triangles;
+
+        // Culling data of each meshlet, as streams for the batch kernels.
+        // The normal cone culls a meshlet seen from any point p where
+        // dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius.
+        // A cone of normals wider than a hemisphere has coneCutoff 1 and never culls.
+        Vector3Stream centers;
+        AlignedVector<float> radii;
+        Vector3Stream coneAxes;
+        AlignedVector<float> coneCutoffs;
+
+        uint32_t GetCount() const { return static_cast<uint32_t>(meshlets.size()); }
+    };
+
+    // Partitions a triangle list into meshlets of at most maxVertices vertices
+    // and maxTriangles triangles, growing each through shared vertices and
+    // favoring triangles that face the same way to keep the cones tight.
+    // Runs best on a cache-optimized index buffer. Positions are three floats,
+    // positionStride bytes apart. Fails on limits above 255 vertices or 512
+    // triangles.
+    bool BuildMeshlets(MeshletMesh& result, std::span<const uint32_t> indices, const float* positions, uint32_t positionStride,
+                       uint32_t vertexCount, uint32_t maxVertices = MeshletMaxVertices, uint32_t maxTriangles = MeshletMaxTriangles);
+
+    // Frustum and normal cone culling, with the frustum and camera in the
+    // mesh's space. Writes the index of every meshlet that may be visible to
+    // visibleMeshlets in increasing order and returns the count.
+    // visibleMeshlets must have room for every meshlet.
+    uint32_t CullMeshlets(const MeshletMesh& mesh, const Frustum& frustum, const Vector3& cameraPosition,
+                          std::span<uint32_t> visibleMeshlets);
+
+    // Expands meshlets into a triangle list on the source vertex buffer, for
+    // drawing without mesh shaders. Returns the index count written.
+    uint32_t WriteMeshletIndices(const MeshletMesh& mesh, std::span<const uint32_t> meshlets, std::span<uint32_t> destination);
+}
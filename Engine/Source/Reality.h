@@ -3,19 +3,48 @@
 #include <Core/Config.h>
 #include <Core/Log.h>
 #include <Core/Timer.h>
+#include <Core/JobSystem.h>
 #include <Core/MathF.h>
-
+#include <Core/MathBatch.h>
+#include <Core/Packing.h>
+#include <Core/PackedMatrix.h>
+
+#include <Animation/Skeleton.h>
+#include <Animation/Pose.h>
+#include <Animation/AnimationClip.h>
+#include <Animation/AnimationSampler.h>
+#include <Animation/Animator.h>
+
+#include <Scene/TransformHierarchy.h>
+#include <Scene/BVH.h>
+#include <Scene/LooseOctree.h>
+#include <Scene/SpatialHashGrid.h>
+
+#include <Mesh/MeshOptimizer.h>
+#include <Mesh/MeshSimplifier.h>
+#include <Mesh/MeshLod.h>
+#include <Mesh/Meshlet.h>
+
+#ifdef _WIN32
 #include <Platform/DisplayManager.h>
 #include <Platform/Window.h>
+#endif
 
 #include <Rendering/GraphicsTypes.h>
 #include <Rendering/CommandList.h>
 #include <Rendering/GraphicsDevice.h>
 #include <Rendering/GraphicsFactory.h>
 #include <Rendering/Resource.h>
+#include <Rendering/BackendMatrix.h>
 #include <Rendering/GraphicsFactory.h>
 #include <Rendering/HighLevelRenderer.h>
 
+#include "Rendering/Backends/Host/HostCommandList.h"
+#include "Rendering/Backends/Null/NullDevice.h"
+#include "Rendering/Backends/Software/SoftwareDevice.h"
+#include "Rendering/Backends/Software/SoftwareTexture.h"
+
+#ifdef _WIN32
 #include "Rendering/Backends/D3D12/D3D12Buffer.h"
 #include "Rendering/Backends/D3D12/D3D12CommandList.h"
 #include "Rendering/Backends/D3D12/D3D12Shader.h"
@@ -24,46 +53,65 @@
 #include "Rendering/Backends/D3D12/D3D12Texture.h"
 
 #include "RenderingBackend/RAW/DX12Renderer.h"
+#endif
 
 
-using Reality::DX12Renderer;
-
 using Reality::Log;
 
 using Reality::Config;
 
 using Reality::Timer;
 
-using Reality::DisplayInfo;
+using Reality::JobSystem;
 
-using Reality::Window;
+using Reality::Skeleton;
 
-using Reality::GraphicsFactory;
+using Reality::AnimationClip;
 
-using Reality::HighLevelRenderer;
+using Reality::AnimationSampler;
 
-using Reality::D3D12Buffer;
+using Reality::Animator;
 
-using Reality::D3D12Texture;
+using Reality::TransformHierarchy;
 
-using Reality::D3D12PipelineState;
+using Reality::BVH;
 
-using Reality::D3D12Shader;
+using Reality::LooseOctree;
 
-using Reality::D3D12SwapChain;
+using Reality::SpatialHashGrid;
 
-using Reality::D3D12CommandList;
+using Reality::GraphicsFactory;
 
-using Reality::D3D12PipelineState;
+using Reality::HighLevelRenderer;
 
-using Reality::D3D12Device;
+using Reality::HostCommandList;
+
+using Reality::NullDevice;
+
+using Reality::SoftwareDevice;
+
+using Reality::SoftwareTexture;
 
+#ifdef _WIN32
+using Reality::DX12Renderer;
+
+using Reality::DisplayInfo;
 
+using Reality::Window;
 
+using Reality::D3D12Buffer;
 
+using Reality::D3D12Texture;
 
+using Reality::D3D12PipelineState;
 
+using Reality::D3D12Shader;
 
+using Reality::D3D12SwapChain;
 
+using Reality::D3D12CommandList;
 
+using Reality::D3D12PipelineState;
 
+using Reality::D3D12Device;
+#endif
@@ -0,0 +1,24 @@
+﻿#pragma once
+#include "GraphicsTypes.h"
+#include <Core/PackedMatrix.h>
+
+namespace Reality {
+    // Matrix order each backend's shaders read from constant memory. Software
+    // and Null shaders are C++ and read Matrix4x4 as is.
+    constexpr MatrixStorage GetMatrixStorage(GraphicsAPI api) {
+        switch (api) {
+            case GraphicsAPI::DirectX12:
+            case GraphicsAPI::Vulkan:
+            case GraphicsAPI::Metal:
+                return MatrixStorage::ColumnMajor;
+            default:
+                return MatrixStorage::RowMajor;
+        }
+    }
+
+    // Matrix type a backend uploads, fixed at compile time, e.g.
+    //   BackendMatrix4x4<GraphicsAPI::DirectX12> viewProjection(camera.GetViewProjection());
+    //   WriteMatrixProduct(mapped + i * stride, viewProjection, worldMatrices[i]);
+    template<GraphicsAPI API>
+    using BackendMatrix4x4 = PackedMatrix4x4<GetMatrixStorage(API)>;
+}
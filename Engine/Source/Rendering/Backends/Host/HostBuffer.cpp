@@ -0,0 +1,52 @@
+﻿#include "HostBuffer.h"
+#include "HostDevice.h"
+#include <cassert>
+#include <cstring>
+
+namespace Reality {
+    HostBuffer::HostBuffer(HostDevice* device, const BufferDesc& desc)
+        : BufferBase(desc, device), m_device(device) {
+    }
+
+    HostBuffer::~HostBuffer() {
+        if (m_mappedData) {
+            Unmap();
+        }
+    }
+
+    bool HostBuffer::Initialize() {
+        if (m_desc.size == 0) {
+            return false;
+        }
+
+        m_data.resize(m_desc.size);
+        return true;
+    }
+
+    void* HostBuffer::Map() {
+        if (m_data.empty()) {
+            return nullptr;
+        }
+
+        m_mappedData = m_data.data();
+        return m_mappedData;
+    }
+
+    void HostBuffer::Unmap() {
+        m_mappedData = nullptr;
+    }
+
+    void HostBuffer::UpdateData(const void* data, size_t size, size_t offset) {
+        if (!data || size == 0) {
+            return;
+        }
+
+        assert(offset + size <= m_data.size() && "Buffer update out of range");
+        if (offset + size > m_data.size()) {
+            return;
+        }
+
+        memcpy(m_data.data() + offset, data, size);
+        m_device->OnUpload(size);
+    }
+}
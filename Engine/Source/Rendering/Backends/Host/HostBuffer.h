@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+#include <vector>
+
+namespace Reality {
+    class HostDevice;
+
+    class HostBuffer : public BufferBase {
+    public:
+        HostBuffer(HostDevice* device, const BufferDesc& desc);
+        ~HostBuffer();
+
+        bool Initialize();
+
+        // IBuffer interface
+        void* Map() override;
+        void Unmap() override;
+        void UpdateData(const void* data, size_t size, size_t offset = 0) override;
+        uint32_t GetSize() const override { return m_desc.size; }
+        uint32_t GetStride() const override { return m_desc.stride; }
+        ResourceUsage GetUsage() const override { return m_desc.usage; }
+        void* GetNativeResource() const override { return const_cast<uint8_t*>(m_data.data()); }
+
+        // Host memory accessors
+        const uint8_t* GetData() const { return m_data.data(); }
+        uint32_t GetBindFlags() const { return m_desc.bindFlags; }
+        bool IsMapped() const { return m_mappedData != nullptr; }
+
+    private:
+        HostDevice* m_device;
+        std::vector<uint8_t> m_data;
+    };
+}
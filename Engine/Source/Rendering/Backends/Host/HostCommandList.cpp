@@ -0,0 +1,139 @@
+﻿#include "HostCommandList.h"
+#include "HostDevice.h"
+#include <cassert>
+
+namespace Reality {
+    HostCommandList::HostCommandList(HostDevice* device)
+        : CommandListBase(device), m_device(device) {
+    }
+
+    HostCommandList::~HostCommandList() = default;
+
+    bool HostCommandList::Initialize() {
+        m_commands.reserve(256);
+        m_objectArgs.reserve(64);
+
+        // Match D3D12 semantics: lists are created closed and must be Reset before recording
+        m_isClosed = true;
+        return true;
+    }
+
+    HostCommand& HostCommandList::Record(HostCommandType type) {
+        assert(!m_isClosed && "Command list is closed");
+        HostCommand& command = m_commands.emplace_back();
+        command.type = type;
+        return command;
+    }
+
+    void HostCommandList::ResourceBarrier(ITexture* resource, ResourceState before, ResourceState after) {
+        HostCommand& command = Record(HostCommandType::ResourceBarrier);
+        command.objects[0] = resource;
+        command.args[0] = static_cast<uint32_t>(before);
+        command.args[1] = static_cast<uint32_t>(after);
+    }
+
+    void HostCommandList::SetPipelineState(IPipelineState* pipeline) {
+        HostCommand& command = Record(HostCommandType::SetPipelineState);
+        command.objects[0] = pipeline;
+        m_currentPipeline = pipeline;
+    }
+
+    void HostCommandList::SetVertexBuffers(IBuffer* const* buffers, uint32_t startSlot, uint32_t numBuffers) {
+        HostCommand& command = Record(HostCommandType::SetVertexBuffers);
+        command.args[0] = startSlot;
+        command.args[1] = static_cast<uint32_t>(m_objectArgs.size());
+        command.args[2] = numBuffers;
+        m_objectArgs.insert(m_objectArgs.end(), buffers, buffers + numBuffers);
+    }
+
+    void HostCommandList::SetIndexBuffer(IBuffer* buffer) {
+        HostCommand& command = Record(HostCommandType::SetIndexBuffer);
+        command.objects[0] = buffer;
+        m_indexBuffer = buffer;
+    }
+
+    void HostCommandList::SetGraphicsRootConstantBufferView(uint32_t rootIndex, IBuffer* buffer) {
+        HostCommand& command = Record(HostCommandType::SetConstantBufferView);
+        command.args[0] = rootIndex;
+        command.objects[0] = buffer;
+    }
+
+    void HostCommandList::SetGraphicsRootDescriptorTable(uint32_t rootIndex, IBuffer* buffer) {
+        HostCommand& command = Record(HostCommandType::SetDescriptorTable);
+        command.args[0] = rootIndex;
+        command.objects[0] = buffer;
+    }
+
+    void HostCommandList::Draw(uint32_t vertexCount, uint32_t instanceCount) {
+        assert(m_currentPipeline && "No pipeline state set");
+
+        HostCommand& command = Record(HostCommandType::Draw);
+        command.args[0] = vertexCount;
+        command.args[1] = instanceCount;
+    }
+
+    void HostCommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount) {
+        assert(m_currentPipeline && "No pipeline state set");
+        assert(m_indexBuffer && "No index buffer set");
+
+        HostCommand& command = Record(HostCommandType::DrawIndexed);
+        command.args[0] = indexCount;
+        command.args[1] = instanceCount;
+    }
+
+    void HostCommandList::CopyTextureRegion(ITexture* dst, ITexture* src) {
+        HostCommand& command = Record(HostCommandType::CopyTextureRegion);
+        command.objects[0] = dst;
+        command.objects[1] = src;
+    }
+
+    void HostCommandList::ClearRenderTargetView(ITexture* renderTarget, const float color[4]) {
+        HostCommand& command = Record(HostCommandType::ClearRenderTarget);
+        command.objects[0] = renderTarget;
+        for (int i = 0; i < 4; i++) {
+            command.values[i] = color[i];
+        }
+    }
+
+    void HostCommandList::ClearDepthStencilView(ITexture* depthStencil, float depth, uint8_t stencil) {
+        HostCommand& command = Record(HostCommandType::ClearDepthStencil);
+        command.objects[0] = depthStencil;
+        command.values[0] = depth;
+        command.args[0] = stencil;
+    }
+
+    void HostCommandList::OMSetRenderTargets(uint32_t numRenderTargets, ITexture* const* renderTargets, ITexture* depthStencil) {
+        HostCommand& command = Record(HostCommandType::SetRenderTargets);
+        command.objects[0] = depthStencil;
+        command.args[1] = static_cast<uint32_t>(m_objectArgs.size());
+        command.args[2] = numRenderTargets;
+        m_objectArgs.insert(m_objectArgs.end(), renderTargets, renderTargets + numRenderTargets);
+    }
+
+    void HostCommandList::RSSetViewports(uint32_t numViewports, const Viewport* viewports) {
+        HostCommand& command = Record(HostCommandType::SetViewports);
+        command.args[1] = static_cast<uint32_t>(m_viewportArgs.size());
+        command.args[2] = numViewports;
+        m_viewportArgs.insert(m_viewportArgs.end(), viewports, viewports + numViewports);
+    }
+
+    void HostCommandList::RSSetScissorRects(uint32_t numRects, const Rect* rects) {
+        HostCommand& command = Record(HostCommandType::SetScissorRects);
+        command.args[1] = static_cast<uint32_t>(m_rectArgs.size());
+        command.args[2] = numRects;
+        m_rectArgs.insert(m_rectArgs.end(), rects, rects + numRects);
+    }
+
+    void HostCommandList::ResetImpl() {
+        // Reset all state, keeping allocations for the next frame
+        m_commands.clear();
+        m_objectArgs.clear();
+        m_viewportArgs.clear();
+        m_rectArgs.clear();
+        m_currentPipeline = nullptr;
+        m_indexBuffer = nullptr;
+    }
+
+    void HostCommandList::CloseImpl() {
+    }
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+#include <vector>
+
+namespace Reality {
+    class HostDevice;
+
+    enum class HostCommandType : uint8_t {
+        ResourceBarrier,
+        SetPipelineState,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetConstantBufferView,
+        SetDescriptorTable,
+        Draw,
+        DrawIndexed,
+        CopyTextureRegion,
+        ClearRenderTarget,
+        ClearDepthStencil,
+        SetRenderTargets,
+        SetViewports,
+        SetScissorRects
+    };
+
+    // A single recorded command. Variable-length arguments (buffers, render
+    // targets, viewports, rects) live in side arrays of the command list and
+    // are referenced by offset/count in args.
+    struct HostCommand {
+        HostCommandType type;
+        uint32_t args[3] = {};
+        void* objects[2] = {};
+        float values[4] = {};
+    };
+
+    class HostCommandList : public CommandListBase {
+    public:
+        HostCommandList(HostDevice* device);
+        ~HostCommandList();
+
+        bool Initialize();
+
+        // ICommandList interface
+        void ResourceBarrier(ITexture* resource, ResourceState before, ResourceState after) override;
+        void SetPipelineState(IPipelineState* pipeline) override;
+        void SetVertexBuffers(IBuffer* const* buffers, uint32_t startSlot, uint32_t numBuffers) override;
+        void SetIndexBuffer(IBuffer* buffer) override;
+        void SetGraphicsRootConstantBufferView(uint32_t rootIndex, IBuffer* buffer) override;
+        void SetGraphicsRootDescriptorTable(uint32_t rootIndex, IBuffer* buffer) override;
+        void Draw(uint32_t vertexCount, uint32_t instanceCount = 1) override;
+        void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1) override;
+        void CopyTextureRegion(ITexture* dst, ITexture* src) override;
+        void ClearRenderTargetView(ITexture* renderTarget, const float color[4]) override;
+        void ClearDepthStencilView(ITexture* depthStencil, float depth, uint8_t stencil) override;
+        void OMSetRenderTargets(uint32_t numRenderTargets, ITexture* const* renderTargets, ITexture* depthStencil) override;
+        void RSSetViewports(uint32_t numViewports, const Viewport* viewports) override;
+        void RSSetScissorRects(uint32_t numRects, const Rect* rects) override;
+        void* GetNativeCommandList() const override { return nullptr; }
+
+        // Recorded stream, replayed or inspected by the device
+        bool IsClosed() const { return m_isClosed; }
+        const std::vector<HostCommand>& GetCommands() const { return m_commands; }
+        const std::vector<void*>& GetObjectArgs() const { return m_objectArgs; }
+        const std::vector<Viewport>& GetViewportArgs() const { return m_viewportArgs; }
+        const std::vector<Rect>& GetRectArgs() const { return m_rectArgs; }
+
+    protected:
+        void ResetImpl() override;
+        void CloseImpl() override;
+
+    private:
+        HostCommand& Record(HostCommandType type);
+
+        HostDevice* m_device;
+
+        // Recorded stream; cleared on Reset but keeps its capacity between frames
+        std::vector<HostCommand> m_commands;
+        std::vector<void*> m_objectArgs;
+        std::vector<Viewport> m_viewportArgs;
+        std::vector<Rect> m_rectArgs;
+
+        // Current state, used for validation only
+        IPipelineState* m_currentPipeline = nullptr;
+        IBuffer* m_indexBuffer = nullptr;
+    };
+}
@@ -0,0 +1,18 @@
+﻿#pragma once
+#include <Rendering/GraphicsDevice.h>
+
+namespace Reality {
+    // Base of the devices that keep every resource in host memory, the Null
+    // and Software backends. They share the Host resources: buffers, textures,
+    // shaders, fences, swap chains and a command list that records commands
+    // for the device to replay. Devices count uploads and presents through
+    // the callbacks below.
+    class HostDevice : public IGraphicsDevice {
+    public:
+        // Called by the host swap chain on Present
+        virtual void OnPresent() = 0;
+
+        // Called by host buffers and textures when host memory changes hands
+        virtual void OnUpload(size_t bytes) = 0;
+    };
+}
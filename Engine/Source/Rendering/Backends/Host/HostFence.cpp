@@ -0,0 +1,29 @@
+﻿#include "HostFence.h"
+#include "HostDevice.h"
+
+namespace Reality {
+    HostFence::HostFence(HostDevice* device)
+        : FenceBase(device), m_device(device) {
+    }
+
+    HostFence::~HostFence() = default;
+
+    bool HostFence::Initialize() {
+        m_completedValue = 0;
+        m_value = 0;
+        return true;
+    }
+
+    uint64_t HostFence::GetCompletedValueImpl() {
+        return m_completedValue;
+    }
+
+    void HostFence::SignalImpl(uint64_t value) {
+        m_completedValue = value;
+    }
+
+    void HostFence::WaitImpl(uint64_t value) {
+        // All submitted work is already complete, nothing to wait for
+        (void)value;
+    }
+}
@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+
+namespace Reality {
+    class HostDevice;
+
+    // Fence that completes as soon as it is signaled, since host devices
+    // execute command lists synchronously.
+    class HostFence : public FenceBase {
+    public:
+        HostFence(HostDevice* device);
+        ~HostFence();
+
+        bool Initialize();
+
+        // IFence interface
+        void* GetNativeFence() const override { return nullptr; }
+
+    protected:
+        uint64_t GetCompletedValueImpl() override;
+        void SignalImpl(uint64_t value) override;
+        void WaitImpl(uint64_t value) override;
+
+    private:
+        HostDevice* m_device;
+        uint64_t m_completedValue = 0;
+    };
+}
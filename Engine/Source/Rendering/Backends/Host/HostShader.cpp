@@ -0,0 +1,15 @@
+﻿#include "HostShader.h"
+#include "HostDevice.h"
+
+namespace Reality {
+    HostShader::HostShader(HostDevice* device, const ShaderDesc& desc)
+        : ShaderBase(desc, device), m_device(device) {
+    }
+
+    HostShader::~HostShader() = default;
+
+    bool HostShader::Compile() {
+        // Nothing to compile, the source is only kept for inspection
+        return true;
+    }
+}
@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+
+namespace Reality {
+    class HostDevice;
+
+    class HostShader : public ShaderBase {
+    public:
+        HostShader(HostDevice* device, const ShaderDesc& desc);
+        ~HostShader();
+
+        bool Compile();
+
+        // IShader interface
+        ShaderType GetType() const override { return m_desc.type; }
+        const std::string& GetSource() const override { return m_desc.source; }
+        const std::string& GetEntryPoint() const override { return m_desc.entryPoint; }
+        const std::string& GetTarget() const override { return m_desc.target; }
+        void* GetNativeShader() const override { return nullptr; }
+
+    private:
+        HostDevice* m_device;
+    };
+}
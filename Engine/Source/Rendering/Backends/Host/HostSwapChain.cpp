@@ -0,0 +1,89 @@
+﻿#include "HostSwapChain.h"
+#include "HostDevice.h"
+#include "HostTexture.h"
+#include <algorithm>
+
+namespace Reality {
+    HostSwapChain::HostSwapChain(HostDevice* device)
+        : m_device(device) {
+    }
+
+    HostSwapChain::~HostSwapChain() {
+        ReleaseBackBuffers();
+    }
+
+    bool HostSwapChain::Initialize(const SwapChainDesc& desc) {
+        if (!m_device || desc.width == 0 || desc.height == 0) {
+            return false;
+        }
+
+        m_width = desc.width;
+        m_height = desc.height;
+        m_bufferCount = std::clamp(desc.bufferCount, 1u, MaxBackBuffers);
+        m_format = desc.format;
+        m_vsync = desc.vsync;
+        m_fullscreen = desc.fullscreen;
+        m_currentBackBuffer = 0;
+
+        return CreateBackBuffers();
+    }
+
+    void HostSwapChain::Present(uint32_t SyncInterval) {
+        (void)SyncInterval;
+        m_currentBackBuffer = (m_currentBackBuffer + 1) % m_bufferCount;
+        m_device->OnPresent();
+    }
+
+    void HostSwapChain::Resize(uint32_t width, uint32_t height) {
+        if (width == 0 || height == 0 || (width == m_width && height == m_height)) {
+            return;
+        }
+
+        ReleaseBackBuffers();
+        m_width = width;
+        m_height = height;
+        m_currentBackBuffer = 0;
+        CreateBackBuffers();
+    }
+
+    void HostSwapChain::SetFullscreen(bool fullscreen) {
+        m_fullscreen = fullscreen;
+    }
+
+    void HostSwapChain::SetVSync(bool vsync) {
+        m_vsync = vsync;
+    }
+
+    ITexture* HostSwapChain::GetBackBuffer(uint32_t index) {
+        if (index >= m_bufferCount) {
+            return nullptr;
+        }
+        return m_backBuffers[index];
+    }
+
+    bool HostSwapChain::CreateBackBuffers() {
+        TextureDesc desc;
+        desc.type = ResourceType::Texture2D;
+        desc.width = m_width;
+        desc.height = m_height;
+        desc.format = m_format;
+        desc.bindFlags = TextureBindFlags::RenderTarget;
+
+        for (uint32_t i = 0; i < m_bufferCount; i++) {
+            m_backBuffers[i] = static_cast<HostTexture*>(m_device->CreateTexture(desc));
+            if (!m_backBuffers[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void HostSwapChain::ReleaseBackBuffers() {
+        for (auto& backBuffer : m_backBuffers) {
+            if (backBuffer) {
+                m_device->DestroyTexture(backBuffer);
+                backBuffer = nullptr;
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+#include <Rendering/GraphicsDevice.h>
+
+namespace Reality {
+    class HostDevice;
+    class HostTexture;
+
+    class HostSwapChain : public ISwapChain {
+    public:
+        HostSwapChain(HostDevice* device);
+        ~HostSwapChain();
+
+        bool Initialize(const SwapChainDesc& desc);
+
+        // ISwapChain interface
+        void Present(uint32_t SyncInterval = 1) override;
+        void Resize(uint32_t width, uint32_t height) override;
+        void SetFullscreen(bool fullscreen) override;
+        void SetVSync(bool vsync) override;
+
+        uint32_t GetWidth() const override { return m_width; }
+        uint32_t GetHeight() const override { return m_height; }
+        uint32_t GetBackBufferCount() const override { return m_bufferCount; }
+        ITexture* GetBackBuffer(uint32_t index) override;
+        uint32_t GetCurrentBackBufferIndex() const override { return m_currentBackBuffer; }
+
+    private:
+        bool CreateBackBuffers();
+        void ReleaseBackBuffers();
+
+        HostDevice* m_device;
+
+        // Back buffers
+        static constexpr uint32_t MaxBackBuffers = 8;
+        HostTexture* m_backBuffers[MaxBackBuffers] = {};
+
+        // Swap chain parameters
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        uint32_t m_bufferCount = 2;
+        Format m_format = Format::R8G8B8A8_UNORM;
+        bool m_vsync = true;
+        bool m_fullscreen = false;
+        uint32_t m_currentBackBuffer = 0;
+    };
+}
@@ -0,0 +1,90 @@
+﻿#include "HostTexture.h"
+#include "HostDevice.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Reality {
+    HostTexture::HostTexture(HostDevice* device, const TextureDesc& desc)
+        : TextureBase(desc, device), m_device(device) {
+    }
+
+    HostTexture::~HostTexture() = default;
+
+    bool HostTexture::Initialize() {
+        if (m_desc.width == 0 || m_desc.format == Format::Unknown) {
+            return false;
+        }
+
+        m_desc.height = std::max(m_desc.height, 1u);
+        m_desc.depth = std::max(m_desc.depth, 1u);
+        m_desc.mipLevels = std::max(m_desc.mipLevels, 1u);
+        m_desc.arraySize = std::max(m_desc.arraySize, 1u);
+
+        // Lay out each array slice as a contiguous mip chain
+        m_sliceSize = 0;
+        for (uint32_t mip = 0; mip < m_desc.mipLevels; mip++) {
+            m_sliceSize += GetSubresourceSize(mip);
+        }
+
+        const uint32_t faces = m_desc.type == ResourceType::TextureCube ? 6 : 1;
+        m_data.resize(m_sliceSize * m_desc.arraySize * faces);
+        return true;
+    }
+
+    size_t HostTexture::GetSubresourceSize(uint32_t mipLevel) const {
+        const size_t width = std::max(m_desc.width >> mipLevel, 1u);
+        const size_t height = std::max(m_desc.height >> mipLevel, 1u);
+        const size_t depth = m_desc.type == ResourceType::Texture3D ? std::max(m_desc.depth >> mipLevel, 1u) : 1;
+        return width * height * depth * GetFormatSize(m_desc.format);
+    }
+
+    size_t HostTexture::GetSubresourceOffset(uint32_t mipLevel, uint32_t arraySlice) const {
+        size_t offset = m_sliceSize * arraySlice;
+        for (uint32_t mip = 0; mip < mipLevel; mip++) {
+            offset += GetSubresourceSize(mip);
+        }
+        return offset;
+    }
+
+    void HostTexture::UpdateData(const void* data, uint32_t mipLevel, uint32_t arraySlice) {
+        if (!data || mipLevel >= m_desc.mipLevels) {
+            return;
+        }
+
+        const size_t offset = GetSubresourceOffset(mipLevel, arraySlice);
+        const size_t size = GetSubresourceSize(mipLevel);
+        assert(offset + size <= m_data.size() && "Texture update out of range");
+        if (offset + size > m_data.size()) {
+            return;
+        }
+
+        memcpy(m_data.data() + offset, data, size);
+        m_device->OnUpload(size);
+    }
+
+    uint32_t HostTexture::GetFormatSize(Format format) {
+        switch (format) {
+            case Format::R8_UNORM:            return 1;
+            case Format::R8G8_UNORM:          return 2;
+            case Format::R8G8B8A8_UNORM:
+            case Format::R8G8B8A8_UNORM_SRGB:
+            case Format::R8G8B8A8_SNORM:
+            case Format::B8G8R8A8_UNORM:
+            case Format::B8G8R8A8_UNORM_SRGB: return 4;
+            case Format::R16_FLOAT:           return 2;
+            case Format::R16G16_FLOAT:        return 4;
+            case Format::R16G16B16A16_FLOAT:  return 8;
+            case Format::R16G16_UNORM:
+            case Format::R16G16_SNORM:        return 4;
+            case Format::R32_FLOAT:           return 4;
+            case Format::R32G32_FLOAT:        return 8;
+            case Format::R32G32B32_FLOAT:     return 12;
+            case Format::R32G32B32A32_FLOAT:  return 16;
+            case Format::D32_FLOAT:           return 4;
+            case Format::D24_UNORM_S8_UINT:   return 4;
+            case Format::D16_UNORM:           return 2;
+            default:                          return 0;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+#include <vector>
+
+namespace Reality {
+    class HostDevice;
+
+    class HostTexture : public TextureBase {
+    public:
+        HostTexture(HostDevice* device, const TextureDesc& desc);
+        ~HostTexture();
+
+        bool Initialize();
+
+        // ITexture interface
+        void UpdateData(const void* data, uint32_t mipLevel, uint32_t arraySlice) override;
+        uint32_t GetWidth() const override { return m_desc.width; }
+        uint32_t GetHeight() const override { return m_desc.height; }
+        uint32_t GetDepth() const override { return m_desc.depth; }
+        uint32_t GetMipLevels() const override { return m_desc.mipLevels; }
+        uint32_t GetArraySize() const override { return m_desc.arraySize; }
+        Format GetFormat() const override { return m_desc.format; }
+        ResourceType GetType() const override { return m_desc.type; }
+        ResourceUsage GetUsage() const override { return m_desc.usage; }
+        void* GetNativeResource() const override { return const_cast<uint8_t*>(m_data.data()); }
+
+        // Host memory accessors
+        uint8_t* GetData() { return m_data.data(); }
+        const uint8_t* GetData() const { return m_data.data(); }
+        size_t GetDataSize() const { return m_data.size(); }
+        size_t GetSubresourceSize(uint32_t mipLevel) const;
+        size_t GetSubresourceOffset(uint32_t mipLevel, uint32_t arraySlice) const;
+
+        // Bytes per texel of the given format, 0 for Format::Unknown
+        static uint32_t GetFormatSize(Format format);
+
+    private:
+        HostDevice* m_device;
+        std::vector<uint8_t> m_data;
+        size_t m_sliceSize = 0; // Size of one array slice including its whole mip chain
+    };
+}
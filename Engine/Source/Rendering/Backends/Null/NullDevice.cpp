@@ -0,0 +1,253 @@
+﻿#include "NullDevice.h"
+#include "NullPipelineState.h"
+#include <Rendering/Backends/Host/HostSwapChain.h>
+#include <Rendering/Backends/Host/HostBuffer.h>
+#include <Rendering/Backends/Host/HostTexture.h>
+#include <Rendering/Backends/Host/HostShader.h>
+#include <Rendering/Backends/Host/HostCommandList.h>
+#include <Rendering/Backends/Host/HostFence.h>
+#include <cassert>
+
+namespace Reality {
+    NullDevice::NullDevice() {
+    }
+
+    NullDevice::~NullDevice() {
+        Shutdown();
+    }
+
+    bool NullDevice::Initialize(const DeviceCreationParams& params) {
+        if (m_initialized) {
+            return true;
+        }
+
+        m_width = params.width;
+        m_height = params.height;
+
+        // Advertise generous limits, nothing is backed by hardware
+        m_features = DeviceFeatures();
+        m_features.maxTextureSize = 16384;
+        m_features.maxConstantBufferSize = 65536;
+        m_features.maxVertexAttributes = 32;
+
+        m_stats = NullDeviceStats();
+        m_initialized = true;
+        return true;
+    }
+
+    void NullDevice::Shutdown() {
+        if (!m_initialized) {
+            return;
+        }
+
+        WaitForIdle();
+        m_initialized = false;
+    }
+
+    void NullDevice::ResetStats() {
+        // Keep the live object counters, they describe current state rather than history
+        NullDeviceStats stats;
+        stats.liveBuffers = m_stats.liveBuffers;
+        stats.liveTextures = m_stats.liveTextures;
+        stats.liveShaders = m_stats.liveShaders;
+        stats.livePipelineStates = m_stats.livePipelineStates;
+        stats.liveCommandLists = m_stats.liveCommandLists;
+        stats.liveFences = m_stats.liveFences;
+        stats.liveSwapChains = m_stats.liveSwapChains;
+        stats.liveBytes = m_stats.liveBytes;
+        m_stats = stats;
+    }
+
+    ISwapChain* NullDevice::CreateSwapChain(const SwapChainDesc& desc) {
+        auto swapChain = new HostSwapChain(this);
+        if (!swapChain->Initialize(desc)) {
+            delete swapChain;
+            return nullptr;
+        }
+        m_stats.liveSwapChains++;
+        return swapChain;
+    }
+
+    void NullDevice::DestroySwapChain(ISwapChain* swapChain) {
+        if (!swapChain) {
+            return;
+        }
+        auto nullSwapChain = static_cast<HostSwapChain*>(swapChain);
+        delete nullSwapChain;
+        m_stats.liveSwapChains--;
+    }
+
+    IBuffer* NullDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+        auto buffer = new HostBuffer(this, desc);
+        if (!buffer->Initialize()) {
+            delete buffer;
+            return nullptr;
+        }
+
+        m_stats.buffersCreated++;
+        m_stats.liveBuffers++;
+        m_stats.bytesAllocated += desc.size;
+        m_stats.liveBytes += desc.size;
+
+        if (initialData) {
+            buffer->UpdateData(initialData, desc.size, 0);
+        }
+        return buffer;
+    }
+
+    void NullDevice::DestroyBuffer(IBuffer* buffer) {
+        if (!buffer) {
+            return;
+        }
+        auto nullBuffer = static_cast<HostBuffer*>(buffer);
+        m_stats.buffersDestroyed++;
+        m_stats.liveBuffers--;
+        m_stats.liveBytes -= nullBuffer->GetSize();
+        delete nullBuffer;
+    }
+
+    ITexture* NullDevice::CreateTexture(const TextureDesc& desc, const void* initialData) {
+        auto texture = new HostTexture(this, desc);
+        if (!texture->Initialize()) {
+            delete texture;
+            return nullptr;
+        }
+
+        m_stats.texturesCreated++;
+        m_stats.liveTextures++;
+        m_stats.bytesAllocated += texture->GetDataSize();
+        m_stats.liveBytes += texture->GetDataSize();
+
+        if (initialData) {
+            // For simplicity, we'll just update the first mip and first array slice
+            texture->UpdateData(initialData, 0, 0);
+        }
+        return texture;
+    }
+
+    void NullDevice::DestroyTexture(ITexture* texture) {
+        if (!texture) {
+            return;
+        }
+        auto nullTexture = static_cast<HostTexture*>(texture);
+        m_stats.texturesDestroyed++;
+        m_stats.liveTextures--;
+        m_stats.liveBytes -= nullTexture->GetDataSize();
+        delete nullTexture;
+    }
+
+    IShader* NullDevice::CreateShader(const ShaderDesc& desc) {
+        auto shader = new HostShader(this, desc);
+        if (!shader->Compile()) {
+            delete shader;
+            return nullptr;
+        }
+        m_stats.liveShaders++;
+        return shader;
+    }
+
+    void NullDevice::DestroyShader(IShader* shader) {
+        if (!shader) {
+            return;
+        }
+        auto nullShader = static_cast<HostShader*>(shader);
+        delete nullShader;
+        m_stats.liveShaders--;
+    }
+
+    IPipelineState* NullDevice::CreatePipelineState(const PipelineStateDesc& desc) {
+        auto pipelineState = new NullPipelineState(this, desc);
+        if (!pipelineState->Initialize()) {
+            delete pipelineState;
+            return nullptr;
+        }
+        m_stats.livePipelineStates++;
+        return pipelineState;
+    }
+
+    void NullDevice::DestroyPipelineState(IPipelineState* pipelineState) {
+        if (!pipelineState) {
+            return;
+        }
+        auto nullPipelineState = static_cast<NullPipelineState*>(pipelineState);
+        delete nullPipelineState;
+        m_stats.livePipelineStates--;
+    }
+
+    ICommandList* NullDevice::CreateCommandList() {
+        auto commandList = new HostCommandList(this);
+        if (!commandList->Initialize()) {
+            delete commandList;
+            return nullptr;
+        }
+        m_stats.liveCommandLists++;
+        return commandList;
+    }
+
+    void NullDevice::DestroyCommandList(ICommandList* commandList) {
+        if (!commandList) {
+            return;
+        }
+        auto nullCommandList = static_cast<HostCommandList*>(commandList);
+        delete nullCommandList;
+        m_stats.liveCommandLists--;
+    }
+
+    void NullDevice::ExecuteCommandLists(ICommandList* const* commandLists, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            auto nullCommandList = static_cast<HostCommandList*>(commandLists[i]);
+            assert(nullCommandList->IsClosed() && "Command list must be closed before execution");
+
+            // "Execute" by accounting for the work a GPU would have done
+            for (const HostCommand& command : nullCommandList->GetCommands()) {
+                switch (command.type) {
+                    case HostCommandType::Draw:
+                        m_stats.drawCalls++;
+                        m_stats.verticesSubmitted += static_cast<uint64_t>(command.args[0]) * command.args[1];
+                        m_stats.instancesSubmitted += command.args[1];
+                        break;
+                    case HostCommandType::DrawIndexed:
+                        m_stats.drawCalls++;
+                        m_stats.indicesSubmitted += static_cast<uint64_t>(command.args[0]) * command.args[1];
+                        m_stats.instancesSubmitted += command.args[1];
+                        break;
+                    case HostCommandType::ClearRenderTarget:
+                    case HostCommandType::ClearDepthStencil:
+                        m_stats.clears++;
+                        break;
+                    case HostCommandType::SetPipelineState:
+                        m_stats.pipelineChanges++;
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            m_stats.commandsExecuted += nullCommandList->GetCommands().size();
+            m_stats.commandListsExecuted++;
+        }
+    }
+
+    IFence* NullDevice::CreateFence() {
+        auto fence = new HostFence(this);
+        if (!fence->Initialize()) {
+            delete fence;
+            return nullptr;
+        }
+        m_stats.liveFences++;
+        return fence;
+    }
+
+    void NullDevice::DestroyFence(IFence* fence) {
+        if (!fence) {
+            return;
+        }
+        auto nullFence = static_cast<HostFence*>(fence);
+        delete nullFence;
+        m_stats.liveFences--;
+    }
+
+    void NullDevice::WaitForIdle() {
+        // Command lists are executed synchronously, the device is always idle
+    }
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <Rendering/Backends/Host/HostDevice.h>
+#include <cstdint>
+
+namespace Reality {
+    class NullPipelineState;
+
+    // Counters gathered by the null device, useful for headless benchmarks
+    struct NullDeviceStats {
+        // Submission
+        uint64_t commandListsExecuted = 0;
+        uint64_t commandsExecuted = 0;
+        uint64_t drawCalls = 0;
+        uint64_t verticesSubmitted = 0;
+        uint64_t indicesSubmitted = 0;
+        uint64_t instancesSubmitted = 0;
+        uint64_t clears = 0;
+        uint64_t pipelineChanges = 0;
+        uint64_t framesPresented = 0;
+
+        // Resource churn
+        uint64_t buffersCreated = 0;
+        uint64_t buffersDestroyed = 0;
+        uint64_t texturesCreated = 0;
+        uint64_t texturesDestroyed = 0;
+        uint64_t bytesAllocated = 0;
+        uint64_t bytesUploaded = 0;
+
+        // Live objects
+        uint32_t liveBuffers = 0;
+        uint32_t liveTextures = 0;
+        uint32_t liveShaders = 0;
+        uint32_t livePipelineStates = 0;
+        uint32_t liveCommandLists = 0;
+        uint32_t liveFences = 0;
+        uint32_t liveSwapChains = 0;
+        uint64_t liveBytes = 0;
+    };
+
+    // Graphics device that keeps every resource in host memory and only records
+    // what it is asked to do. Lets the whole frame loop run without a GPU.
+    class NullDevice : public HostDevice {
+    public:
+        NullDevice();
+        ~NullDevice();
+
+        // IGraphicsDevice interface
+        bool Initialize(const DeviceCreationParams& params) override;
+        void Shutdown() override;
+
+        ISwapChain* CreateSwapChain(const SwapChainDesc& desc) override;
+        void DestroySwapChain(ISwapChain* swapChain) override;
+
+        IBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override;
+        void DestroyBuffer(IBuffer* buffer) override;
+
+        ITexture* CreateTexture(const TextureDesc& desc, const void* initialData = nullptr) override;
+        void DestroyTexture(ITexture* texture) override;
+
+        IShader* CreateShader(const ShaderDesc& desc) override;
+        void DestroyShader(IShader* shader) override;
+
+        IPipelineState* CreatePipelineState(const PipelineStateDesc& desc) override;
+        void DestroyPipelineState(IPipelineState* pipelineState) override;
+
+        ICommandList* CreateCommandList() override;
+        void DestroyCommandList(ICommandList* commandList) override;
+
+        void ExecuteCommandLists(ICommandList* const* commandLists, uint32_t count) override;
+
+        IFence* CreateFence() override;
+        void DestroyFence(IFence* fence) override;
+
+        void WaitForIdle() override;
+
+        GraphicsAPI GetAPI() const override { return GraphicsAPI::Null; }
+        const DeviceFeatures& GetFeatures() const override { return m_features; }
+        void* GetNativeDevice() const override { return nullptr; }
+
+        // Null-specific accessors
+        const NullDeviceStats& GetStats() const { return m_stats; }
+        void ResetStats();
+
+        // HostDevice interface
+        void OnPresent() override { m_stats.framesPresented++; }
+        void OnUpload(size_t bytes) override { m_stats.bytesUploaded += bytes; }
+
+    private:
+        DeviceFeatures m_features;
+        NullDeviceStats m_stats;
+
+        // Window parameters
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+
+        bool m_initialized = false;
+    };
+}
@@ -0,0 +1,21 @@
+﻿#include "NullPipelineState.h"
+#include "NullDevice.h"
+
+namespace Reality {
+    NullPipelineState::NullPipelineState(NullDevice* device, const PipelineStateDesc& desc)
+        : PipelineStateBase(desc, device), m_device(device) {
+    }
+
+    NullPipelineState::~NullPipelineState() = default;
+
+    bool NullPipelineState::Initialize() {
+        // Reject descriptions a real backend would refuse as well
+        if (m_desc.numRenderTargets > 8) {
+            return false;
+        }
+        if (m_desc.numInputElements > 0 && !m_desc.inputElements) {
+            return false;
+        }
+        return true;
+    }
+}
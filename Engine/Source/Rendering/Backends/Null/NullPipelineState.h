@@ -0,0 +1,21 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+
+namespace Reality {
+    class NullDevice;
+
+    class NullPipelineState : public PipelineStateBase {
+    public:
+        NullPipelineState(NullDevice* device, const PipelineStateDesc& desc);
+        ~NullPipelineState();
+
+        bool Initialize();
+
+        // IPipelineState interface
+        const PipelineStateDesc& GetDesc() const override { return m_desc; }
+        void* GetNativePipelineState() const override { return nullptr; }
+
+    private:
+        NullDevice* m_device;
+    };
+}
@@ -0,0 +1,320 @@
+﻿#include "SoftwareDevice.h"
+#include "SoftwareTexture.h"
+#include "SoftwarePipelineState.h"
+#include <Rendering/Backends/Host/HostSwapChain.h>
+#include <Rendering/Backends/Host/HostBuffer.h>
+#include <Rendering/Backends/Host/HostShader.h>
+#include <Rendering/Backends/Host/HostCommandList.h>
+#include <Rendering/Backends/Host/HostFence.h>
+#include <Core/JobSystem.h>
+#include <cassert>
+#include <cstring>
+
+namespace Reality {
+    SoftwareDevice::SoftwareDevice() {
+    }
+
+    SoftwareDevice::~SoftwareDevice() {
+        Shutdown();
+    }
+
+    bool SoftwareDevice::Initialize(const DeviceCreationParams& params) {
+        if (m_initialized) {
+            return true;
+        }
+
+        m_width = params.width;
+        m_height = params.height;
+
+        // Limits are only bounded by host memory
+        m_features = DeviceFeatures();
+        m_features.maxTextureSize = 16384;
+        m_features.maxConstantBufferSize = 65536;
+        m_features.maxVertexAttributes = 32;
+
+        m_stats = SoftwareDeviceStats();
+        m_rasterizer.ResetStats();
+
+        // Spin up the rasterizer workers now rather than on the first frame
+        JobSystem::GetInstance().Initialize();
+
+        m_initialized = true;
+        return true;
+    }
+
+    void SoftwareDevice::Shutdown() {
+        if (!m_initialized) {
+            return;
+        }
+
+        WaitForIdle();
+        m_initialized = false;
+    }
+
+    void SoftwareDevice::ResetStats() {
+        // Keep the live object counters, they describe current state rather than history
+        SoftwareDeviceStats stats;
+        stats.liveBuffers = m_stats.liveBuffers;
+        stats.liveTextures = m_stats.liveTextures;
+        stats.liveShaders = m_stats.liveShaders;
+        stats.livePipelineStates = m_stats.livePipelineStates;
+        stats.liveCommandLists = m_stats.liveCommandLists;
+        stats.liveFences = m_stats.liveFences;
+        stats.liveSwapChains = m_stats.liveSwapChains;
+        m_stats = stats;
+        m_rasterizer.ResetStats();
+    }
+
+    ISwapChain* SoftwareDevice::CreateSwapChain(const SwapChainDesc& desc) {
+        auto swapChain = new HostSwapChain(this);
+        if (!swapChain->Initialize(desc)) {
+            delete swapChain;
+            return nullptr;
+        }
+        m_stats.liveSwapChains++;
+        return swapChain;
+    }
+
+    void SoftwareDevice::DestroySwapChain(ISwapChain* swapChain) {
+        if (!swapChain) {
+            return;
+        }
+        auto softwareSwapChain = static_cast<HostSwapChain*>(swapChain);
+        delete softwareSwapChain;
+        m_stats.liveSwapChains--;
+    }
+
+    IBuffer* SoftwareDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+        auto buffer = new HostBuffer(this, desc);
+        if (!buffer->Initialize()) {
+            delete buffer;
+            return nullptr;
+        }
+
+        m_stats.liveBuffers++;
+
+        if (initialData) {
+            buffer->UpdateData(initialData, desc.size, 0);
+        }
+        return buffer;
+    }
+
+    void SoftwareDevice::DestroyBuffer(IBuffer* buffer) {
+        if (!buffer) {
+            return;
+        }
+        auto softwareBuffer = static_cast<HostBuffer*>(buffer);
+        m_stats.liveBuffers--;
+        delete softwareBuffer;
+    }
+
+    ITexture* SoftwareDevice::CreateTexture(const TextureDesc& desc, const void* initialData) {
+        auto texture = new SoftwareTexture(this, desc);
+        if (!texture->Initialize()) {
+            delete texture;
+            return nullptr;
+        }
+
+        m_stats.liveTextures++;
+
+        if (initialData) {
+            // For simplicity, we'll just update the first mip and first array slice
+            texture->UpdateData(initialData, 0, 0);
+        }
+        return texture;
+    }
+
+    void SoftwareDevice::DestroyTexture(ITexture* texture) {
+        if (!texture) {
+            return;
+        }
+        auto softwareTexture = static_cast<SoftwareTexture*>(texture);
+        m_stats.liveTextures--;
+        delete softwareTexture;
+    }
+
+    IShader* SoftwareDevice::CreateShader(const ShaderDesc& desc) {
+        auto shader = new HostShader(this, desc);
+        if (!shader->Compile()) {
+            delete shader;
+            return nullptr;
+        }
+        m_stats.liveShaders++;
+        return shader;
+    }
+
+    void SoftwareDevice::DestroyShader(IShader* shader) {
+        if (!shader) {
+            return;
+        }
+        auto softwareShader = static_cast<HostShader*>(shader);
+        delete softwareShader;
+        m_stats.liveShaders--;
+    }
+
+    IPipelineState* SoftwareDevice::CreatePipelineState(const PipelineStateDesc& desc) {
+        auto pipelineState = new SoftwarePipelineState(this, desc);
+        if (!pipelineState->Initialize()) {
+            delete pipelineState;
+            return nullptr;
+        }
+        m_stats.livePipelineStates++;
+        return pipelineState;
+    }
+
+    void SoftwareDevice::DestroyPipelineState(IPipelineState* pipelineState) {
+        if (!pipelineState) {
+            return;
+        }
+        auto softwarePipelineState = static_cast<SoftwarePipelineState*>(pipelineState);
+        delete softwarePipelineState;
+        m_stats.livePipelineStates--;
+    }
+
+    ICommandList* SoftwareDevice::CreateCommandList() {
+        auto commandList = new HostCommandList(this);
+        if (!commandList->Initialize()) {
+            delete commandList;
+            return nullptr;
+        }
+        m_stats.liveCommandLists++;
+        return commandList;
+    }
+
+    void SoftwareDevice::DestroyCommandList(ICommandList* commandList) {
+        if (!commandList) {
+            return;
+        }
+        auto softwareCommandList = static_cast<HostCommandList*>(commandList);
+        delete softwareCommandList;
+        m_stats.liveCommandLists--;
+    }
+
+    void SoftwareDevice::ExecuteCommandLists(ICommandList* const* commandLists, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            auto softwareCommandList = static_cast<const HostCommandList*>(commandLists[i]);
+            assert(softwareCommandList->IsClosed() && "Command list must be closed before execution");
+
+            ExecuteCommandList(softwareCommandList);
+
+            m_stats.commandsExecuted += softwareCommandList->GetCommands().size();
+            m_stats.commandListsExecuted++;
+        }
+
+        // Execution is synchronous, everything is in memory once we return
+        m_rasterizer.Flush();
+        m_rasterizer.SetRenderTargets(nullptr, nullptr);
+    }
+
+    void SoftwareDevice::ExecuteCommandList(const HostCommandList* commandList) {
+        // Like D3D12, every command list starts from default state
+        SoftwareRasterizer::DrawState state;
+        m_rasterizer.SetRenderTargets(nullptr, nullptr);
+
+        const std::vector<void*>& objectArgs = commandList->GetObjectArgs();
+
+        for (const HostCommand& command : commandList->GetCommands()) {
+            switch (command.type) {
+                case HostCommandType::SetPipelineState:
+                    state.pipeline = static_cast<const SoftwarePipelineState*>(
+                        static_cast<IPipelineState*>(command.objects[0]));
+                    break;
+                case HostCommandType::SetVertexBuffers:
+                    for (uint32_t slot = 0; slot < command.args[2]; slot++) {
+                        const uint32_t streamIndex = command.args[0] + slot;
+                        if (streamIndex < MaxSoftwareVertexStreams) {
+                            state.vertexBuffers[streamIndex] = static_cast<const HostBuffer*>(
+                                static_cast<IBuffer*>(objectArgs[command.args[1] + slot]));
+                        }
+                    }
+                    break;
+                case HostCommandType::SetIndexBuffer:
+                    state.indexBuffer = static_cast<const HostBuffer*>(static_cast<IBuffer*>(command.objects[0]));
+                    break;
+                case HostCommandType::SetConstantBufferView:
+                case HostCommandType::SetDescriptorTable:
+                    // Shaders see the buffer contents directly, indexed by root parameter
+                    if (command.args[0] < MaxSoftwareConstantBuffers) {
+                        auto buffer = static_cast<const HostBuffer*>(static_cast<IBuffer*>(command.objects[0]));
+                        state.constantBuffers[command.args[0]] = buffer ? buffer->GetData() : nullptr;
+                    }
+                    break;
+                case HostCommandType::Draw:
+                    m_rasterizer.Draw(state, command.args[0], command.args[1], false);
+                    break;
+                case HostCommandType::DrawIndexed:
+                    m_rasterizer.Draw(state, command.args[0], command.args[1], true);
+                    break;
+                case HostCommandType::CopyTextureRegion: {
+                    m_rasterizer.Flush();
+                    auto dst = static_cast<SoftwareTexture*>(static_cast<ITexture*>(command.objects[0]));
+                    auto src = static_cast<const SoftwareTexture*>(static_cast<ITexture*>(command.objects[1]));
+                    if (dst && src && dst->GetDataSize() == src->GetDataSize()) {
+                        std::memcpy(dst->GetData(), src->GetData(), src->GetDataSize());
+                    }
+                    break;
+                }
+                case HostCommandType::ClearRenderTarget:
+                    m_rasterizer.Flush();
+                    SoftwareRasterizer::ClearColor(static_cast<SoftwareTexture*>(static_cast<ITexture*>(command.objects[0])),
+                                                   command.values);
+                    m_stats.clears++;
+                    break;
+                case HostCommandType::ClearDepthStencil:
+                    m_rasterizer.Flush();
+                    SoftwareRasterizer::ClearDepth(static_cast<SoftwareTexture*>(static_cast<ITexture*>(command.objects[0])),
+                                                   command.values[0]);
+                    m_stats.clears++;
+                    break;
+                case HostCommandType::SetRenderTargets: {
+                    // Only the first render target is rasterized into
+                    SoftwareTexture* colorTarget = nullptr;
+                    if (command.args[2] > 0) {
+                        colorTarget = static_cast<SoftwareTexture*>(static_cast<ITexture*>(objectArgs[command.args[1]]));
+                    }
+                    m_rasterizer.SetRenderTargets(colorTarget,
+                                                  static_cast<SoftwareTexture*>(static_cast<ITexture*>(command.objects[0])));
+                    break;
+                }
+                case HostCommandType::SetViewports:
+                    if (command.args[2] > 0) {
+                        state.viewport = commandList->GetViewportArgs()[command.args[1]];
+                        state.hasViewport = true;
+                    }
+                    break;
+                case HostCommandType::SetScissorRects:
+                    if (command.args[2] > 0) {
+                        state.scissor = commandList->GetRectArgs()[command.args[1]];
+                        state.hasScissor = true;
+                    }
+                    break;
+                case HostCommandType::ResourceBarrier:
+                default:
+                    break;
+            }
+        }
+    }
+
+    IFence* SoftwareDevice::CreateFence() {
+        auto fence = new HostFence(this);
+        if (!fence->Initialize()) {
+            delete fence;
+            return nullptr;
+        }
+        m_stats.liveFences++;
+        return fence;
+    }
+
+    void SoftwareDevice::DestroyFence(IFence* fence) {
+        if (!fence) {
+            return;
+        }
+        auto softwareFence = static_cast<HostFence*>(fence);
+        delete softwareFence;
+        m_stats.liveFences--;
+    }
+
+    void SoftwareDevice::WaitForIdle() {
+        // Command lists are executed synchronously, the device is always idle
+    }
+}
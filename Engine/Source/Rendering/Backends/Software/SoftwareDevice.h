@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <Rendering/Backends/Host/HostDevice.h>
+#include "SoftwareRasterizer.h"
+#include <cstdint>
+
+namespace Reality {
+    class HostCommandList;
+    class SoftwareTexture;
+    class SoftwarePipelineState;
+
+    // Counters gathered by the software device
+    struct SoftwareDeviceStats {
+        uint64_t commandListsExecuted = 0;
+        uint64_t commandsExecuted = 0;
+        uint64_t clears = 0;
+        uint64_t framesPresented = 0;
+        uint64_t bytesUploaded = 0;
+
+        // Live objects
+        uint32_t liveBuffers = 0;
+        uint32_t liveTextures = 0;
+        uint32_t liveShaders = 0;
+        uint32_t livePipelineStates = 0;
+        uint32_t liveCommandLists = 0;
+        uint32_t liveFences = 0;
+        uint32_t liveSwapChains = 0;
+    };
+
+    // Graphics device that keeps every resource in host memory and executes
+    // command lists on the CPU. Pipelines run the C++ shaders attached to
+    // PipelineStateDesc, rasterization is spread over the job system workers.
+    class SoftwareDevice : public HostDevice {
+    public:
+        SoftwareDevice();
+        ~SoftwareDevice();
+
+        // IGraphicsDevice interface
+        bool Initialize(const DeviceCreationParams& params) override;
+        void Shutdown() override;
+
+        ISwapChain* CreateSwapChain(const SwapChainDesc& desc) override;
+        void DestroySwapChain(ISwapChain* swapChain) override;
+
+        IBuffer* CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override;
+        void DestroyBuffer(IBuffer* buffer) override;
+
+        ITexture* CreateTexture(const TextureDesc& desc, const void* initialData = nullptr) override;
+        void DestroyTexture(ITexture* texture) override;
+
+        IShader* CreateShader(const ShaderDesc& desc) override;
+        void DestroyShader(IShader* shader) override;
+
+        IPipelineState* CreatePipelineState(const PipelineStateDesc& desc) override;
+        void DestroyPipelineState(IPipelineState* pipelineState) override;
+
+        ICommandList* CreateCommandList() override;
+        void DestroyCommandList(ICommandList* commandList) override;
+
+        void ExecuteCommandLists(ICommandList* const* commandLists, uint32_t count) override;
+
+        IFence* CreateFence() override;
+        void DestroyFence(IFence* fence) override;
+
+        void WaitForIdle() override;
+
+        GraphicsAPI GetAPI() const override { return GraphicsAPI::Software; }
+        const DeviceFeatures& GetFeatures() const override { return m_features; }
+        void* GetNativeDevice() const override { return nullptr; }
+
+        // Software-specific accessors
+        const SoftwareDeviceStats& GetStats() const { return m_stats; }
+        const SoftwareRasterizerStats& GetRasterizerStats() const { return m_rasterizer.GetStats(); }
+        void ResetStats();
+
+        // HostDevice interface
+        void OnPresent() override { m_stats.framesPresented++; }
+        void OnUpload(size_t bytes) override { m_stats.bytesUploaded += bytes; }
+
+    private:
+        void ExecuteCommandList(const HostCommandList* commandList);
+
+        DeviceFeatures m_features;
+        SoftwareDeviceStats m_stats;
+        SoftwareRasterizer m_rasterizer;
+
+        // Window parameters
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+
+        bool m_initialized = false;
+    };
+}
@@ -0,0 +1,34 @@
+﻿#include "SoftwarePipelineState.h"
+#include "SoftwareDevice.h"
+
+namespace Reality {
+    SoftwarePipelineState::SoftwarePipelineState(SoftwareDevice* device, const PipelineStateDesc& desc)
+        : PipelineStateBase(desc, device), m_device(device) {
+    }
+
+    SoftwarePipelineState::~SoftwarePipelineState() = default;
+
+    bool SoftwarePipelineState::Initialize() {
+        // HLSL is not executed, a C++ vertex shader is mandatory
+        if (!m_desc.softwareVertexShader) {
+            return false;
+        }
+        if (m_desc.softwareVaryingCount > MaxSoftwareVaryings || m_desc.numRenderTargets > 8) {
+            return false;
+        }
+        if (m_desc.numInputElements > 0 && !m_desc.inputElements) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < m_desc.numInputElements; i++) {
+            const InputElementDesc& element = m_desc.inputElements[i];
+            if (element.inputSlot >= MaxSoftwareVertexStreams) {
+                return false;
+            }
+            if (element.inputSlotClass == InputClassification::PerInstance) {
+                m_perInstanceStreams[element.inputSlot] = true;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <Rendering/Resource.h>
+
+namespace Reality {
+    class SoftwareDevice;
+
+    class SoftwarePipelineState : public PipelineStateBase {
+    public:
+        SoftwarePipelineState(SoftwareDevice* device, const PipelineStateDesc& desc);
+        ~SoftwarePipelineState();
+
+        bool Initialize();
+
+        // IPipelineState interface
+        const PipelineStateDesc& GetDesc() const override { return m_desc; }
+        void* GetNativePipelineState() const override { return nullptr; }
+
+        // Software-specific accessors
+        bool IsPerInstanceStream(uint32_t slot) const { return m_perInstanceStreams[slot]; }
+
+    private:
+        SoftwareDevice* m_device;
+
+        // Vertex buffer slots that advance per instance, derived from the input layout
+        bool m_perInstanceStreams[MaxSoftwareVertexStreams] = {};
+    };
+}
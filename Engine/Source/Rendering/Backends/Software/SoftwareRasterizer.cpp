@@ -0,0 +1,958 @@
+﻿#include "SoftwareRasterizer.h"
+#include "SoftwarePipelineState.h"
+#include "SoftwareTexture.h"
+#include <Rendering/Backends/Host/HostBuffer.h>
+#include <Core/JobSystem.h>
+#include <Core/Packing.h>
+#include <Core/SIMD.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace Reality {
+    namespace {
+        // Clip-space guard band. Triangles are only clipped against x/y once they
+        // leave this multiple of the viewport, the rest is handled by the bounding
+        // box, which keeps clipping rare and screen coordinates in range.
+        constexpr float GuardBand = 8.0f;
+
+        // Screen positions are snapped to 1/16 pixel before edge setup
+        constexpr float SubpixelScale = 16.0f;
+
+        // Jobs smaller than this are not worth splitting
+        constexpr uint32_t VertexGrainSize = 256;
+        constexpr uint32_t PrimitiveGrainSize = 1024;
+        constexpr uint32_t ClearGrainRows = 16;
+
+        // Position plus varyings of a clipped vertex
+        constexpr uint32_t ClipVertexSize = 4 + MaxSoftwareVaryings;
+        // Each clip plane adds at most one vertex to a convex polygon
+        constexpr uint32_t MaxClipVertices = 3 + 6;
+
+        enum ClipPlane : uint32_t {
+            ClipNear,
+            ClipFar,
+            ClipLeft,
+            ClipRight,
+            ClipBottom,
+            ClipTop,
+            ClipPlaneCount
+        };
+
+        float PlaneDistance(const float* position, uint32_t plane) {
+            switch (plane) {
+                case ClipNear:   return position[2];
+                case ClipFar:    return position[3] - position[2];
+                case ClipLeft:   return position[0] + GuardBand * position[3];
+                case ClipRight:  return GuardBand * position[3] - position[0];
+                case ClipBottom: return position[1] + GuardBand * position[3];
+                default:         return GuardBand * position[3] - position[1];
+            }
+        }
+
+        uint32_t OutCode(const float* position, bool depthClip) {
+            uint32_t code = 0;
+            for (uint32_t plane = 0; plane < ClipPlaneCount; plane++) {
+                if (plane == ClipFar && !depthClip) {
+                    continue;
+                }
+                if (PlaneDistance(position, plane) < 0.0f) {
+                    code |= 1u << plane;
+                }
+            }
+            return code;
+        }
+
+        uint32_t FetchIndex(const uint8_t* indices, uint32_t stride, uint32_t i) {
+            if (stride == 2) {
+                uint16_t index;
+                std::memcpy(&index, indices + i * 2, sizeof(index));
+                return index;
+            }
+            uint32_t index;
+            std::memcpy(&index, indices + i * 4, sizeof(index));
+            return index;
+        }
+
+        bool DepthTest(ComparisonFunc func, float depth, float stored) {
+            switch (func) {
+                case ComparisonFunc::Never:        return false;
+                case ComparisonFunc::Less:         return depth < stored;
+                case ComparisonFunc::Equal:        return depth == stored;
+                case ComparisonFunc::LessEqual:    return depth <= stored;
+                case ComparisonFunc::Greater:      return depth > stored;
+                case ComparisonFunc::NotEqual:     return depth != stored;
+                case ComparisonFunc::GreaterEqual: return depth >= stored;
+                default:                           return true;
+            }
+        }
+
+        float Saturate(float value) {
+            return std::clamp(value, 0.0f, 1.0f);
+        }
+
+        uint8_t ToUnorm8(float value) {
+            return static_cast<uint8_t>(Saturate(value) * 255.0f + 0.5f);
+        }
+
+        // Color formats the rasterizer can render to. sRGB targets are stored
+        // without conversion. Returns false for anything else.
+        bool LoadPixel(Format format, const uint8_t* pixel, float color[4]) {
+            color[0] = color[1] = color[2] = 0.0f;
+            color[3] = 1.0f;
+            switch (format) {
+                case Format::R8_UNORM:
+                    color[0] = pixel[0] / 255.0f;
+                    return true;
+                case Format::R8G8_UNORM:
+                    color[0] = pixel[0] / 255.0f;
+                    color[1] = pixel[1] / 255.0f;
+                    return true;
+                case Format::R8G8B8A8_UNORM:
+                case Format::R8G8B8A8_UNORM_SRGB:
+                    for (int i = 0; i < 4; i++) {
+                        color[i] = pixel[i] / 255.0f;
+                    }
+                    return true;
+                case Format::B8G8R8A8_UNORM:
+                case Format::B8G8R8A8_UNORM_SRGB:
+                    color[0] = pixel[2] / 255.0f;
+                    color[1] = pixel[1] / 255.0f;
+                    color[2] = pixel[0] / 255.0f;
+                    color[3] = pixel[3] / 255.0f;
+                    return true;
+                case Format::R16_FLOAT:
+                case Format::R16G16_FLOAT:
+                case Format::R16G16B16A16_FLOAT: {
+                    const int channels = format == Format::R16_FLOAT ? 1 : format == Format::R16G16_FLOAT ? 2 : 4;
+                    for (int i = 0; i < channels; i++) {
+                        uint16_t half;
+                        std::memcpy(&half, pixel + i * sizeof(half), sizeof(half));
+                        color[i] = HalfToFloat(half);
+                    }
+                    return true;
+                }
+                case Format::R32_FLOAT:
+                    std::memcpy(color, pixel, sizeof(float));
+                    return true;
+                case Format::R32G32_FLOAT:
+                    std::memcpy(color, pixel, sizeof(float) * 2);
+                    return true;
+                case Format::R32G32B32A32_FLOAT:
+                    std::memcpy(color, pixel, sizeof(float) * 4);
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool StorePixel(Format format, uint8_t* pixel, const float color[4]) {
+            switch (format) {
+                case Format::R8_UNORM:
+                    pixel[0] = ToUnorm8(color[0]);
+                    return true;
+                case Format::R8G8_UNORM:
+                    pixel[0] = ToUnorm8(color[0]);
+                    pixel[1] = ToUnorm8(color[1]);
+                    return true;
+                case Format::R8G8B8A8_UNORM:
+                case Format::R8G8B8A8_UNORM_SRGB:
+                    for (int i = 0; i < 4; i++) {
+                        pixel[i] = ToUnorm8(color[i]);
+                    }
+                    return true;
+                case Format::B8G8R8A8_UNORM:
+                case Format::B8G8R8A8_UNORM_SRGB:
+                    pixel[0] = ToUnorm8(color[2]);
+                    pixel[1] = ToUnorm8(color[1]);
+                    pixel[2] = ToUnorm8(color[0]);
+                    pixel[3] = ToUnorm8(color[3]);
+                    return true;
+                case Format::R16_FLOAT:
+                case Format::R16G16_FLOAT:
+                case Format::R16G16B16A16_FLOAT: {
+                    const int channels = format == Format::R16_FLOAT ? 1 : format == Format::R16G16_FLOAT ? 2 : 4;
+                    for (int i = 0; i < channels; i++) {
+                        const uint16_t half = FloatToHalf(color[i]);
+                        std::memcpy(pixel + i * sizeof(half), &half, sizeof(half));
+                    }
+                    return true;
+                }
+                case Format::R32_FLOAT:
+                    std::memcpy(pixel, color, sizeof(float));
+                    return true;
+                case Format::R32G32_FLOAT:
+                    std::memcpy(pixel, color, sizeof(float) * 2);
+                    return true;
+                case Format::R32G32B32A32_FLOAT:
+                    std::memcpy(pixel, color, sizeof(float) * 4);
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool IsUnormFormat(Format format) {
+            return format != Format::R16_FLOAT && format != Format::R16G16_FLOAT &&
+                   format != Format::R16G16B16A16_FLOAT && format != Format::R32_FLOAT &&
+                   format != Format::R32G32_FLOAT && format != Format::R32G32B32A32_FLOAT;
+        }
+
+        // Dual-source factors have no second output here and map to the first one.
+        // The blend factor constant is the D3D default of one.
+        float BlendFactorValue(Blend factor, const float src[4], const float dst[4], int channel) {
+            switch (factor) {
+                case Blend::Zero:           return 0.0f;
+                case Blend::One:            return 1.0f;
+                case Blend::SrcColor:
+                case Blend::Src1Color:      return src[channel];
+                case Blend::InvSrcColor:
+                case Blend::InvSrc1Color:   return 1.0f - src[channel];
+                case Blend::SrcAlpha:
+                case Blend::Src1Alpha:      return src[3];
+                case Blend::InvSrcAlpha:
+                case Blend::InvSrc1Alpha:   return 1.0f - src[3];
+                case Blend::DestAlpha:      return dst[3];
+                case Blend::InvDestAlpha:   return 1.0f - dst[3];
+                case Blend::DestColor:      return dst[channel];
+                case Blend::InvDestColor:   return 1.0f - dst[channel];
+                case Blend::SrcAlphaSat:    return channel == 3 ? 1.0f : std::min(src[3], 1.0f - dst[3]);
+                case Blend::BlendFactor:    return 1.0f;
+                case Blend::InvBlendFactor: return 0.0f;
+                default:                    return 1.0f;
+            }
+        }
+
+        float ApplyBlendOp(BlendOp op, float src, float dst, float srcFactor, float dstFactor) {
+            switch (op) {
+                case BlendOp::Add:         return src * srcFactor + dst * dstFactor;
+                case BlendOp::Subtract:    return src * srcFactor - dst * dstFactor;
+                case BlendOp::RevSubtract: return dst * dstFactor - src * srcFactor;
+                case BlendOp::Min:         return std::min(src, dst);
+                case BlendOp::Max:         return std::max(src, dst);
+                default:                   return src;
+            }
+        }
+
+        void BlendColor(const BlendDesc::RenderTarget& blend, const float src[4], const float dst[4], float out[4]) {
+            for (int c = 0; c < 3; c++) {
+                out[c] = ApplyBlendOp(blend.blendOp, src[c], dst[c],
+                                      BlendFactorValue(blend.srcBlend, src, dst, c),
+                                      BlendFactorValue(blend.destBlend, src, dst, c));
+            }
+            out[3] = ApplyBlendOp(blend.blendOpAlpha, src[3], dst[3],
+                                  BlendFactorValue(blend.srcBlendAlpha, src, dst, 3),
+                                  BlendFactorValue(blend.destBlendAlpha, src, dst, 3));
+        }
+
+        // Depth buffers are only read and written in D32_FLOAT
+        bool IsRasterDepthFormat(const SoftwareTexture* texture) {
+            return texture && texture->GetFormat() == Format::D32_FLOAT;
+        }
+    }
+
+    SoftwareRasterizer::SoftwareRasterizer() = default;
+
+    SoftwareRasterizer::~SoftwareRasterizer() = default;
+
+    void SoftwareRasterizer::SetRenderTargets(SoftwareTexture* colorTarget, SoftwareTexture* depthTarget) {
+        if (colorTarget == m_colorTarget && depthTarget == m_depthTarget) {
+            return;
+        }
+
+        Flush();
+
+        m_colorTarget = colorTarget;
+        m_depthTarget = IsRasterDepthFormat(depthTarget) ? depthTarget : nullptr;
+
+        // Rasterize the area covered by every bound target
+        int32_t width = INT32_MAX;
+        int32_t height = INT32_MAX;
+        if (m_colorTarget) {
+            width = std::min(width, static_cast<int32_t>(m_colorTarget->GetWidth()));
+            height = std::min(height, static_cast<int32_t>(m_colorTarget->GetHeight()));
+        }
+        if (m_depthTarget) {
+            width = std::min(width, static_cast<int32_t>(m_depthTarget->GetWidth()));
+            height = std::min(height, static_cast<int32_t>(m_depthTarget->GetHeight()));
+        }
+        if (!m_colorTarget && !m_depthTarget) {
+            width = 0;
+            height = 0;
+        }
+
+        m_targetWidth = width;
+        m_targetHeight = height;
+        m_tilesX = (static_cast<uint32_t>(width) + TileSize - 1) / TileSize;
+        m_tilesY = (static_cast<uint32_t>(height) + TileSize - 1) / TileSize;
+    }
+
+    void SoftwareRasterizer::Draw(const DrawState& state, uint32_t vertexCount, uint32_t instanceCount, bool indexed) {
+        const SoftwarePipelineState* pipeline = state.pipeline;
+        if (!pipeline || vertexCount == 0 || instanceCount == 0 || m_targetWidth <= 0 || m_targetHeight <= 0) {
+            return;
+        }
+
+        const PipelineStateDesc& desc = pipeline->GetDesc();
+
+        // Points and lines are not rasterized
+        const bool strip = desc.primitiveTopology == PrimitiveTopology::TriangleStrip;
+        if (!strip && desc.primitiveTopology != PrimitiveTopology::TriangleList) {
+            return;
+        }
+
+        const uint8_t* indices = nullptr;
+        uint32_t indexStride = 0;
+        if (indexed) {
+            if (!state.indexBuffer) {
+                return;
+            }
+            indices = state.indexBuffer->GetData();
+            indexStride = state.indexBuffer->GetStride() == 2 ? 2 : 4;
+            vertexCount = std::min(vertexCount, state.indexBuffer->GetSize() / indexStride);
+        }
+
+        const uint32_t primitiveCount = strip ? (vertexCount >= 3 ? vertexCount - 2 : 0) : vertexCount / 3;
+        m_stats.drawCalls++;
+        if (primitiveCount == 0) {
+            return;
+        }
+
+        DrawRecord draw;
+        draw.pipeline = pipeline;
+        std::copy(std::begin(state.constantBuffers), std::end(state.constantBuffers), std::begin(draw.constantBuffers));
+        draw.varyingCount = desc.softwareVaryingCount;
+
+        // Clip rect: bound targets, then viewport and scissor
+        Viewport viewport = state.viewport;
+        if (!state.hasViewport) {
+            viewport = Viewport(0.0f, 0.0f, static_cast<float>(m_targetWidth), static_cast<float>(m_targetHeight));
+        }
+        draw.clipMinX = std::max(0, static_cast<int32_t>(std::floor(viewport.x)));
+        draw.clipMinY = std::max(0, static_cast<int32_t>(std::floor(viewport.y)));
+        draw.clipMaxX = std::min(m_targetWidth, static_cast<int32_t>(std::ceil(viewport.x + viewport.width))) - 1;
+        draw.clipMaxY = std::min(m_targetHeight, static_cast<int32_t>(std::ceil(viewport.y + viewport.height))) - 1;
+        if (state.hasScissor) {
+            draw.clipMinX = std::max(draw.clipMinX, state.scissor.left);
+            draw.clipMinY = std::max(draw.clipMinY, state.scissor.top);
+            draw.clipMaxX = std::min(draw.clipMaxX, state.scissor.right - 1);
+            draw.clipMaxY = std::min(draw.clipMaxY, state.scissor.bottom - 1);
+        }
+        if (draw.clipMinX > draw.clipMaxX || draw.clipMinY > draw.clipMaxY) {
+            return;
+        }
+
+        DrawState drawState = state;
+        drawState.viewport = viewport;
+
+        // Every vertex referenced by the draw is shaded exactly once per instance
+        uint32_t vertexRange = vertexCount;
+        if (indexed) {
+            vertexRange = 0;
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                vertexRange = std::max(vertexRange, FetchIndex(indices, indexStride, i) + 1);
+            }
+        }
+
+        const uint32_t shadedCount = vertexRange * instanceCount;
+        m_vertexOutputs.resize(shadedCount);
+
+        JobSystem& jobSystem = JobSystem::GetInstance();
+        jobSystem.ParallelFor(shadedCount, VertexGrainSize, [&](uint32_t begin, uint32_t end) {
+            SoftwareVertexInput input = {};
+            input.constantBuffers = draw.constantBuffers;
+
+            for (uint32_t i = begin; i < end; i++) {
+                input.vertexId = i % vertexRange;
+                input.instanceId = i / vertexRange;
+
+                for (uint32_t slot = 0; slot < MaxSoftwareVertexStreams; slot++) {
+                    const HostBuffer* buffer = drawState.vertexBuffers[slot];
+                    input.streams[slot] = nullptr;
+                    if (!buffer) {
+                        continue;
+                    }
+
+                    const uint64_t element = pipeline->IsPerInstanceStream(slot) ? input.instanceId : input.vertexId;
+                    const uint64_t offset = element * buffer->GetStride();
+                    if (offset + buffer->GetStride() <= buffer->GetSize()) {
+                        input.streams[slot] = buffer->GetData() + offset;
+                    }
+                }
+
+                SoftwareVertexOutput& output = m_vertexOutputs[i];
+                output = {};
+                desc.softwareVertexShader(input, output);
+            }
+        });
+        m_stats.verticesShaded += shadedCount;
+
+        // Primitive assembly, clipping and triangle setup
+        const uint32_t totalPrimitives = primitiveCount * instanceCount;
+        const uint32_t chunkCount = (totalPrimitives + PrimitiveGrainSize - 1) / PrimitiveGrainSize;
+        if (m_setupChunks.size() < chunkCount) {
+            m_setupChunks.resize(chunkCount);
+        }
+
+        jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                SetupChunk& chunk = m_setupChunks[c];
+                chunk.triangles.clear();
+                chunk.varyings.clear();
+                chunk.culled = 0;
+                chunk.clipped = 0;
+
+                const uint32_t first = c * PrimitiveGrainSize;
+                const uint32_t last = std::min(first + PrimitiveGrainSize, totalPrimitives);
+                for (uint32_t p = first; p < last; p++) {
+                    const uint32_t instance = p / primitiveCount;
+                    const uint32_t primitive = p % primitiveCount;
+
+                    uint32_t corners[3];
+                    if (strip) {
+                        // Odd strip triangles swap two vertices to keep a consistent winding
+                        const bool odd = (primitive & 1) != 0;
+                        corners[0] = primitive + (odd ? 1 : 0);
+                        corners[1] = primitive + (odd ? 0 : 1);
+                        corners[2] = primitive + 2;
+                    } else {
+                        corners[0] = primitive * 3;
+                        corners[1] = primitive * 3 + 1;
+                        corners[2] = primitive * 3 + 2;
+                    }
+
+                    const SoftwareVertexOutput* vertices[3];
+                    for (int k = 0; k < 3; k++) {
+                        const uint32_t vertex = indexed ? FetchIndex(indices, indexStride, corners[k]) : corners[k];
+                        vertices[k] = &m_vertexOutputs[instance * vertexRange + vertex];
+                    }
+                    SetupTriangle(drawState, draw, vertices, chunk);
+                }
+            }
+        });
+
+        // Merge in submission order
+        const uint32_t drawIndex = static_cast<uint32_t>(m_draws.size());
+        m_draws.push_back(draw);
+
+        for (uint32_t c = 0; c < chunkCount; c++) {
+            const SetupChunk& chunk = m_setupChunks[c];
+            const uint32_t varyingBase = static_cast<uint32_t>(m_varyings.size());
+            for (Triangle triangle : chunk.triangles) {
+                triangle.varyingOffset += varyingBase;
+                triangle.drawIndex = drawIndex;
+                m_triangles.push_back(triangle);
+            }
+            m_varyings.insert(m_varyings.end(), chunk.varyings.begin(), chunk.varyings.end());
+            m_stats.trianglesCulled += chunk.culled;
+            m_stats.trianglesClipped += chunk.clipped;
+        }
+        m_stats.trianglesSubmitted += totalPrimitives;
+    }
+
+    void SoftwareRasterizer::SetupTriangle(const DrawState& state, const DrawRecord& draw,
+                                           const SoftwareVertexOutput* const vertices[3], SetupChunk& chunk) const {
+        const bool depthClip = draw.pipeline->GetDesc().rasterizerState.depthClipEnable;
+
+        const uint32_t codes[3] = {
+            OutCode(vertices[0]->position, depthClip),
+            OutCode(vertices[1]->position, depthClip),
+            OutCode(vertices[2]->position, depthClip)
+        };
+
+        // Entirely outside one plane
+        if (codes[0] & codes[1] & codes[2]) {
+            chunk.culled++;
+            return;
+        }
+
+        // Common case, nothing to clip
+        if ((codes[0] | codes[1] | codes[2]) == 0) {
+            const float* clip[3] = { vertices[0]->position, vertices[1]->position, vertices[2]->position };
+            const float* varyings[3] = { vertices[0]->varyings, vertices[1]->varyings, vertices[2]->varyings };
+            EmitTriangle(state, draw, clip, varyings, chunk);
+            return;
+        }
+
+        // Sutherland-Hodgman against the planes the triangle crosses
+        const uint32_t vertexSize = 4 + draw.varyingCount;
+        float polygons[2][MaxClipVertices][ClipVertexSize];
+        uint32_t count = 3;
+        for (uint32_t k = 0; k < 3; k++) {
+            std::memcpy(polygons[0][k], vertices[k]->position, sizeof(float) * 4);
+            std::memcpy(polygons[0][k] + 4, vertices[k]->varyings, sizeof(float) * draw.varyingCount);
+        }
+
+        const uint32_t crossed = codes[0] | codes[1] | codes[2];
+        uint32_t current = 0;
+        for (uint32_t plane = 0; plane < ClipPlaneCount && count >= 3; plane++) {
+            if (!(crossed & (1u << plane))) {
+                continue;
+            }
+
+            const auto& input = polygons[current];
+            auto& output = polygons[current ^ 1];
+            uint32_t outputCount = 0;
+
+            for (uint32_t i = 0; i < count; i++) {
+                const float* a = input[i];
+                const float* b = input[(i + 1) % count];
+                const float da = PlaneDistance(a, plane);
+                const float db = PlaneDistance(b, plane);
+
+                if (da >= 0.0f) {
+                    std::memcpy(output[outputCount++], a, sizeof(float) * vertexSize);
+                }
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    const float t = da / (da - db);
+                    float* v = output[outputCount++];
+                    for (uint32_t j = 0; j < vertexSize; j++) {
+                        v[j] = a[j] + (b[j] - a[j]) * t;
+                    }
+                }
+            }
+
+            count = outputCount;
+            current ^= 1;
+        }
+
+        if (count < 3) {
+            chunk.culled++;
+            return;
+        }
+
+        chunk.clipped++;
+        const auto& polygon = polygons[current];
+        for (uint32_t i = 1; i + 1 < count; i++) {
+            const float* clip[3] = { polygon[0], polygon[i], polygon[i + 1] };
+            const float* varyings[3] = { polygon[0] + 4, polygon[i] + 4, polygon[i + 1] + 4 };
+            EmitTriangle(state, draw, clip, varyings, chunk);
+        }
+    }
+
+    void SoftwareRasterizer::EmitTriangle(const DrawState& state, const DrawRecord& draw, const float* const clip[3],
+                                          const float* const varyings[3], SetupChunk& chunk) const {
+        const PipelineStateDesc& desc = draw.pipeline->GetDesc();
+        const Viewport& viewport = state.viewport;
+
+        Triangle triangle;
+        float sx[3];
+        float sy[3];
+        for (int k = 0; k < 3; k++) {
+            const float w = clip[k][3];
+            if (!(w > 1e-20f)) {
+                chunk.culled++;
+                return;
+            }
+
+            const float invW = 1.0f / w;
+            const float ndcX = clip[k][0] * invW;
+            const float ndcY = clip[k][1] * invW;
+            const float ndcZ = std::clamp(clip[k][2] * invW, 0.0f, 1.0f);
+
+            sx[k] = std::round((viewport.x + (ndcX + 1.0f) * 0.5f * viewport.width) * SubpixelScale) / SubpixelScale;
+            sy[k] = std::round((viewport.y + (1.0f - ndcY) * 0.5f * viewport.height) * SubpixelScale) / SubpixelScale;
+            triangle.z[k] = viewport.minDepth + ndcZ * (viewport.maxDepth - viewport.minDepth);
+            triangle.invW[k] = invW;
+        }
+
+        // Twice the signed area, positive when the triangle is clockwise on screen
+        const double area = (static_cast<double>(sx[1]) - sx[0]) * (static_cast<double>(sy[2]) - sy[0]) -
+                            (static_cast<double>(sx[2]) - sx[0]) * (static_cast<double>(sy[1]) - sy[0]);
+        if (area == 0.0) {
+            chunk.culled++;
+            return;
+        }
+
+        const bool clockwise = area > 0.0;
+        triangle.frontFacing = desc.rasterizerState.frontCounterClockwise ? !clockwise : clockwise;
+        if ((desc.rasterizerState.cullMode == CullMode::Back && !triangle.frontFacing) ||
+            (desc.rasterizerState.cullMode == CullMode::Front && triangle.frontFacing)) {
+            chunk.culled++;
+            return;
+        }
+
+        // Pixel centers inside the bounding box and the clip rect
+        const float minX = std::min({ sx[0], sx[1], sx[2] });
+        const float maxX = std::max({ sx[0], sx[1], sx[2] });
+        const float minY = std::min({ sy[0], sy[1], sy[2] });
+        const float maxY = std::max({ sy[0], sy[1], sy[2] });
+        triangle.minX = std::max(draw.clipMinX, static_cast<int32_t>(std::ceil(minX - 0.5f)));
+        triangle.maxX = std::min(draw.clipMaxX, static_cast<int32_t>(std::floor(maxX - 0.5f)));
+        triangle.minY = std::max(draw.clipMinY, static_cast<int32_t>(std::ceil(minY - 0.5f)));
+        triangle.maxY = std::min(draw.clipMaxY, static_cast<int32_t>(std::floor(maxY - 0.5f)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+            chunk.culled++;
+            return;
+        }
+
+        // Edge i runs between the two other vertices and is zero on that edge.
+        // Orient every edge so the interior is positive, then the three edge
+        // values sum to the area and double as barycentrics.
+        const double orientation = clockwise ? 1.0 : -1.0;
+        triangle.topLeftMask = 0;
+        for (int i = 0; i < 3; i++) {
+            const int a = (i + 1) % 3;
+            const int b = (i + 2) % 3;
+            const double edgeA = (static_cast<double>(sy[a]) - sy[b]) * orientation;
+            const double edgeB = (static_cast<double>(sx[b]) - sx[a]) * orientation;
+            const double edgeC = (static_cast<double>(sx[a]) * sy[b] - static_cast<double>(sy[a]) * sx[b]) * orientation;
+            triangle.edgeA[i] = static_cast<float>(edgeA);
+            triangle.edgeB[i] = static_cast<float>(edgeB);
+            triangle.edgeC[i] = static_cast<float>(edgeC);
+
+            // Top-left fill rule: left edges and horizontal top edges own their pixels
+            if (edgeA > 0.0 || (edgeA == 0.0 && edgeB > 0.0)) {
+                triangle.topLeftMask |= 1u << i;
+            }
+        }
+        triangle.invArea = static_cast<float>(1.0 / (area * orientation));
+
+        // Interpolants are stored as vertex 0 plus deltas, varyings are divided
+        // by w so they interpolate linearly in screen space
+        triangle.drawIndex = 0;
+        triangle.varyingOffset = static_cast<uint32_t>(chunk.varyings.size());
+        for (uint32_t j = 0; j < draw.varyingCount; j++) {
+            chunk.varyings.push_back(varyings[0][j] * triangle.invW[0]);
+        }
+        for (int k = 1; k < 3; k++) {
+            for (uint32_t j = 0; j < draw.varyingCount; j++) {
+                chunk.varyings.push_back(varyings[k][j] * triangle.invW[k] - varyings[0][j] * triangle.invW[0]);
+            }
+        }
+        for (int k = 1; k < 3; k++) {
+            triangle.z[k] -= triangle.z[0];
+            triangle.invW[k] -= triangle.invW[0];
+        }
+
+        chunk.triangles.push_back(triangle);
+    }
+
+    void SoftwareRasterizer::Flush() {
+        if (m_triangles.empty()) {
+            m_draws.clear();
+            m_varyings.clear();
+            return;
+        }
+
+        m_stats.flushes++;
+        m_stats.trianglesBinned += m_triangles.size();
+
+        const uint32_t tileCount = m_tilesX * m_tilesY;
+        const uint32_t triangleCount = static_cast<uint32_t>(m_triangles.size());
+        const uint32_t binChunkCount = (triangleCount + TrianglesPerBinChunk - 1) / TrianglesPerBinChunk;
+        if (m_bins.size() < static_cast<size_t>(binChunkCount) * tileCount) {
+            m_bins.resize(static_cast<size_t>(binChunkCount) * tileCount);
+        }
+
+        JobSystem& jobSystem = JobSystem::GetInstance();
+
+        // Binning: each job owns one bin per tile, so no synchronization is needed
+        jobSystem.ParallelFor(binChunkCount, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                std::vector<uint32_t>* bins = &m_bins[static_cast<size_t>(c) * tileCount];
+                for (uint32_t tile = 0; tile < tileCount; tile++) {
+                    bins[tile].clear();
+                }
+
+                const uint32_t first = c * TrianglesPerBinChunk;
+                const uint32_t last = std::min(first + TrianglesPerBinChunk, triangleCount);
+                for (uint32_t t = first; t < last; t++) {
+                    const Triangle& triangle = m_triangles[t];
+                    const uint32_t tileMinX = static_cast<uint32_t>(triangle.minX) / TileSize;
+                    const uint32_t tileMaxX = static_cast<uint32_t>(triangle.maxX) / TileSize;
+                    const uint32_t tileMinY = static_cast<uint32_t>(triangle.minY) / TileSize;
+                    const uint32_t tileMaxY = static_cast<uint32_t>(triangle.maxY) / TileSize;
+                    for (uint32_t ty = tileMinY; ty <= tileMaxY; ty++) {
+                        for (uint32_t tx = tileMinX; tx <= tileMaxX; tx++) {
+                            bins[ty * m_tilesX + tx].push_back(t);
+                        }
+                    }
+                }
+            }
+        });
+
+        // Rasterization: one job per tile
+        std::atomic<uint64_t> pixelsShaded{0};
+        jobSystem.ParallelFor(tileCount, 1, [&](uint32_t begin, uint32_t end) {
+            uint64_t localPixels = 0;
+            for (uint32_t tile = begin; tile < end; tile++) {
+                RasterizeTile(tile, binChunkCount, localPixels);
+            }
+            pixelsShaded.fetch_add(localPixels, std::memory_order_relaxed);
+        });
+        m_stats.pixelsShaded += pixelsShaded.load();
+
+        m_triangles.clear();
+        m_varyings.clear();
+        m_draws.clear();
+    }
+
+    void SoftwareRasterizer::RasterizeTile(uint32_t tileIndex, uint32_t binChunkCount, uint64_t& pixelsShaded) const {
+        const uint32_t tileCount = m_tilesX * m_tilesY;
+        const int32_t tileMinX = static_cast<int32_t>((tileIndex % m_tilesX) * TileSize);
+        const int32_t tileMinY = static_cast<int32_t>((tileIndex / m_tilesX) * TileSize);
+        const int32_t tileMaxX = std::min(tileMinX + static_cast<int32_t>(TileSize), m_targetWidth) - 1;
+        const int32_t tileMaxY = std::min(tileMinY + static_cast<int32_t>(TileSize), m_targetHeight) - 1;
+
+        // Bins are walked in chunk order, which is submission order
+        for (uint32_t c = 0; c < binChunkCount; c++) {
+            for (uint32_t t : m_bins[static_cast<size_t>(c) * tileCount + tileIndex]) {
+                RasterizeTriangle(m_triangles[t], tileMinX, tileMinY, tileMaxX, tileMaxY, pixelsShaded);
+            }
+        }
+    }
+
+    void SoftwareRasterizer::RasterizeTriangle(const Triangle& triangle, int32_t tileMinX, int32_t tileMinY,
+                                               int32_t tileMaxX, int32_t tileMaxY, uint64_t& pixelsShaded) const {
+        const int32_t x0 = std::max(triangle.minX, tileMinX);
+        const int32_t x1 = std::min(triangle.maxX, tileMaxX);
+        const int32_t y0 = std::max(triangle.minY, tileMinY);
+        const int32_t y1 = std::min(triangle.maxY, tileMaxY);
+        if (x0 > x1 || y0 > y1) {
+            return;
+        }
+
+        const DrawRecord& draw = m_draws[triangle.drawIndex];
+        const PipelineStateDesc& desc = draw.pipeline->GetDesc();
+        const DepthStencilDesc& depthState = desc.depthStencilState;
+        const BlendDesc::RenderTarget& blend = desc.blendState.renderTarget[0];
+
+        float* depthPixels = nullptr;
+        if (m_depthTarget && depthState.depthEnable) {
+            depthPixels = reinterpret_cast<float*>(m_depthTarget->GetPixels());
+        }
+        const uint32_t depthPitch = m_depthTarget ? m_depthTarget->GetWidth() : 0;
+
+        uint8_t* colorPixels = nullptr;
+        uint32_t colorPitch = 0;
+        uint32_t bytesPerPixel = 0;
+        Format colorFormat = Format::Unknown;
+        const uint8_t writeMask = blend.renderTargetWriteMask & 0x0F;
+        if (m_colorTarget && writeMask != 0) {
+            colorPixels = m_colorTarget->GetPixels();
+            colorPitch = m_colorTarget->GetRowPitch();
+            bytesPerPixel = m_colorTarget->GetBytesPerPixel();
+            colorFormat = m_colorTarget->GetFormat();
+        }
+        const bool readDestination = blend.blendEnable || writeMask != 0x0F;
+        const bool clampSource = IsUnormFormat(colorFormat);
+
+        const uint32_t varyingCount = draw.varyingCount;
+        const float* v0 = m_varyings.data() + triangle.varyingOffset;
+        const float* v1 = v0 + varyingCount;
+        const float* v2 = v1 + varyingCount;
+
+        // b1 and b2 are the barycentrics of vertices 1 and 2, w the interpolated clip w
+        auto shadePixel = [&](int32_t x, int32_t y, float b1, float b2, float z, float w) {
+            float* depth = nullptr;
+            if (depthPixels) {
+                depth = depthPixels + static_cast<size_t>(y) * depthPitch + x;
+                if (!DepthTest(depthState.depthFunc, z, *depth)) {
+                    return;
+                }
+            }
+
+            // Perspective-correct varyings
+            float varyings[MaxSoftwareVaryings];
+            for (uint32_t j = 0; j < varyingCount; j++) {
+                varyings[j] = (v0[j] + b1 * v1[j] + b2 * v2[j]) * w;
+            }
+
+            float color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            if (desc.softwarePixelShader) {
+                SoftwarePixelInput input;
+                input.varyings = varyings;
+                input.constantBuffers = draw.constantBuffers;
+                input.x = static_cast<float>(x) + 0.5f;
+                input.y = static_cast<float>(y) + 0.5f;
+                input.depth = z;
+                input.frontFacing = triangle.frontFacing;
+                if (!desc.softwarePixelShader(input, color)) {
+                    return;
+                }
+            } else {
+                // Without a pixel shader the first varyings are the color
+                for (uint32_t j = 0; j < std::min(varyingCount, 4u); j++) {
+                    color[j] = varyings[j];
+                }
+            }
+            pixelsShaded++;
+
+            if (depth && depthState.depthWriteMask) {
+                *depth = z;
+            }
+
+            if (!colorPixels) {
+                return;
+            }
+
+            uint8_t* pixel = colorPixels + static_cast<size_t>(y) * colorPitch + static_cast<size_t>(x) * bytesPerPixel;
+            if (clampSource) {
+                for (float& channel : color) {
+                    channel = Saturate(channel);
+                }
+            }
+
+            if (readDestination) {
+                float destination[4];
+                LoadPixel(colorFormat, pixel, destination);
+
+                float result[4];
+                if (blend.blendEnable) {
+                    BlendColor(blend, color, destination, result);
+                } else {
+                    std::copy(color, color + 4, result);
+                }
+                for (int c = 0; c < 4; c++) {
+                    color[c] = (writeMask & (1u << c)) ? result[c] : destination[c];
+                }
+            }
+            StorePixel(colorFormat, pixel, color);
+        };
+
+#if defined(REALITY_SIMD_SSE)
+        // Four pixels of a row per step. Products and sums are kept apart,
+        // without MulAdd, so the lanes match the scalar path bit for bit.
+        using SIMD::Float4;
+        const Float4 laneOffsets = SIMD::Set(0.5f, 1.5f, 2.5f, 3.5f);
+        const Float4 zero = SIMD::Zero();
+        const Float4 invArea = SIMD::Splat(triangle.invArea);
+        const Float4 z0 = SIMD::Splat(triangle.z[0]);
+        const Float4 dz1 = SIMD::Splat(triangle.z[1]);
+        const Float4 dz2 = SIMD::Splat(triangle.z[2]);
+        const Float4 invW0 = SIMD::Splat(triangle.invW[0]);
+        const Float4 dInvW1 = SIMD::Splat(triangle.invW[1]);
+        const Float4 dInvW2 = SIMD::Splat(triangle.invW[2]);
+        const Float4 one = SIMD::Splat(1.0f);
+        Float4 edgeA[3];
+        Float4 topLeft[3];
+        for (int i = 0; i < 3; i++) {
+            edgeA[i] = SIMD::Splat(triangle.edgeA[i]);
+            topLeft[i] = SIMD::SplatMask((triangle.topLeftMask & (1u << i)) != 0);
+        }
+
+        for (int32_t y = y0; y <= y1; y++) {
+            const float py = static_cast<float>(y) + 0.5f;
+            Float4 rowE[3];
+            for (int i = 0; i < 3; i++) {
+                rowE[i] = SIMD::Splat(triangle.edgeB[i] * py + triangle.edgeC[i]);
+            }
+
+            for (int32_t x = x0; x <= x1; x += 4) {
+                const Float4 px = SIMD::Add(SIMD::Splat(static_cast<float>(x)), laneOffsets);
+
+                Float4 e[3];
+                Float4 inside = SIMD::SplatMask(true);
+                for (int i = 0; i < 3; i++) {
+                    e[i] = SIMD::Add(SIMD::Mul(edgeA[i], px), rowE[i]);
+                    const Float4 covered = SIMD::Or(SIMD::Greater(e[i], zero),
+                                                    SIMD::And(SIMD::Equal(e[i], zero), topLeft[i]));
+                    inside = SIMD::And(inside, covered);
+                }
+
+                const int remaining = x1 - x + 1;
+                int mask = SIMD::MoveMask(inside);
+                if (remaining < 4) {
+                    mask &= (1 << remaining) - 1;
+                }
+                if (mask == 0) {
+                    continue;
+                }
+
+                // Depth and w for all four lanes at once
+                const Float4 b1 = SIMD::Mul(e[1], invArea);
+                const Float4 b2 = SIMD::Mul(e[2], invArea);
+                const Float4 z = SIMD::Add(z0, SIMD::Add(SIMD::Mul(b1, dz1), SIMD::Mul(b2, dz2)));
+                const Float4 w = SIMD::Div(one, SIMD::Add(invW0, SIMD::Add(SIMD::Mul(b1, dInvW1), SIMD::Mul(b2, dInvW2))));
+
+                alignas(16) float b1Lanes[4];
+                alignas(16) float b2Lanes[4];
+                alignas(16) float zLanes[4];
+                alignas(16) float wLanes[4];
+                SIMD::Store(b1Lanes, b1);
+                SIMD::Store(b2Lanes, b2);
+                SIMD::Store(zLanes, z);
+                SIMD::Store(wLanes, w);
+                for (int lane = 0; lane < 4; lane++) {
+                    if (mask & (1 << lane)) {
+                        shadePixel(x + lane, y, b1Lanes[lane], b2Lanes[lane], zLanes[lane], wLanes[lane]);
+                    }
+                }
+            }
+        }
+#else
+        for (int32_t y = y0; y <= y1; y++) {
+            const float py = static_cast<float>(y) + 0.5f;
+            float rowE[3];
+            for (int i = 0; i < 3; i++) {
+                rowE[i] = triangle.edgeB[i] * py + triangle.edgeC[i];
+            }
+
+            for (int32_t x = x0; x <= x1; x++) {
+                const float px = static_cast<float>(x) + 0.5f;
+
+                float e[3];
+                bool inside = true;
+                for (int i = 0; i < 3; i++) {
+                    e[i] = triangle.edgeA[i] * px + rowE[i];
+                    inside = inside && (e[i] > 0.0f || (e[i] == 0.0f && (triangle.topLeftMask & (1u << i))));
+                }
+                if (inside) {
+                    const float b1 = e[1] * triangle.invArea;
+                    const float b2 = e[2] * triangle.invArea;
+                    const float z = triangle.z[0] + (b1 * triangle.z[1] + b2 * triangle.z[2]);
+                    const float w = 1.0f / (triangle.invW[0] + (b1 * triangle.invW[1] + b2 * triangle.invW[2]));
+                    shadePixel(x, y, b1, b2, z, w);
+                }
+            }
+        }
+#endif
+    }
+
+    void SoftwareRasterizer::ClearColor(SoftwareTexture* target, const float color[4]) {
+        if (!target) {
+            return;
+        }
+
+        // Pack once, then replicate
+        uint8_t packed[16] = {};
+        if (!StorePixel(target->GetFormat(), packed, color)) {
+            return;
+        }
+
+        uint8_t* pixels = target->GetPixels();
+        const uint32_t width = target->GetWidth();
+        const uint32_t rowPitch = target->GetRowPitch();
+        const uint32_t bytesPerPixel = target->GetBytesPerPixel();
+
+        JobSystem::GetInstance().ParallelFor(target->GetHeight(), ClearGrainRows, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; y++) {
+                uint8_t* row = pixels + static_cast<size_t>(y) * rowPitch;
+                if (bytesPerPixel == sizeof(uint32_t)) {
+                    uint32_t value;
+                    std::memcpy(&value, packed, sizeof(value));
+                    std::fill_n(reinterpret_cast<uint32_t*>(row), width, value);
+                    continue;
+                }
+                for (uint32_t x = 0; x < width; x++) {
+                    std::memcpy(row + static_cast<size_t>(x) * bytesPerPixel, packed, bytesPerPixel);
+                }
+            }
+        });
+    }
+
+    void SoftwareRasterizer::ClearDepth(SoftwareTexture* target, float depth) {
+        if (!IsRasterDepthFormat(target)) {
+            return;
+        }
+
+        float* pixels = reinterpret_cast<float*>(target->GetPixels());
+        const uint32_t width = target->GetWidth();
+
+        JobSystem::GetInstance().ParallelFor(target->GetHeight(), ClearGrainRows, [&](uint32_t begin, uint32_t end) {
+            std::fill(pixels + static_cast<size_t>(begin) * width, pixels + static_cast<size_t>(end) * width, depth);
+        });
+    }
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <Rendering/GraphicsTypes.h>
+#include <vector>
+
+namespace Reality {
+    class HostBuffer;
+    class SoftwareTexture;
+    class SoftwarePipelineState;
+
+    struct SoftwareRasterizerStats {
+        uint64_t drawCalls = 0;
+        uint64_t verticesShaded = 0;
+        uint64_t trianglesSubmitted = 0;
+        uint64_t trianglesCulled = 0;   // Back/front-face, degenerate or fully clipped
+        uint64_t trianglesClipped = 0;  // Triangles that needed polygon clipping
+        uint64_t trianglesBinned = 0;
+        uint64_t pixelsShaded = 0;
+        uint64_t flushes = 0;
+    };
+
+    // Binned, tile-based triangle rasterizer.
+    //
+    // Draws are vertex shaded and set up as soon as they are issued, then
+    // accumulated until Flush. Flush bins every pending triangle into
+    // TileSize x TileSize screen tiles and rasterizes the tiles in parallel on
+    // the job system. Each tile walks its triangles in submission order, so
+    // the output does not depend on the number of worker threads.
+    class SoftwareRasterizer {
+    public:
+        static constexpr uint32_t TileSize = 64;
+        static constexpr uint32_t TrianglesPerBinChunk = 2048;
+
+        // Pipeline and input bindings for one draw
+        struct DrawState {
+            const SoftwarePipelineState* pipeline = nullptr;
+            const HostBuffer* vertexBuffers[MaxSoftwareVertexStreams] = {};
+            const HostBuffer* indexBuffer = nullptr;
+            const void* constantBuffers[MaxSoftwareConstantBuffers] = {};
+            Viewport viewport;
+            Rect scissor;
+            bool hasViewport = false;
+            bool hasScissor = false;
+        };
+
+        SoftwareRasterizer();
+        ~SoftwareRasterizer();
+
+        // Flushes pending work first if the targets change
+        void SetRenderTargets(SoftwareTexture* colorTarget, SoftwareTexture* depthTarget);
+
+        void Draw(const DrawState& state, uint32_t vertexCount, uint32_t instanceCount, bool indexed);
+
+        // Rasterizes every pending triangle into the current targets
+        void Flush();
+
+        // Immediate operations, callers flush first to keep ordering
+        static void ClearColor(SoftwareTexture* target, const float color[4]);
+        static void ClearDepth(SoftwareTexture* target, float depth);
+
+        const SoftwareRasterizerStats& GetStats() const { return m_stats; }
+        void ResetStats() { m_stats = SoftwareRasterizerStats(); }
+
+    private:
+        // Per-draw data referenced by its triangles until the next flush
+        struct DrawRecord {
+            const SoftwarePipelineState* pipeline;
+            const void* constantBuffers[MaxSoftwareConstantBuffers];
+            uint32_t varyingCount;
+            int32_t clipMinX, clipMinY, clipMaxX, clipMaxY; // Inclusive, intersection of targets, viewport and scissor
+        };
+
+        // Screen-space triangle ready for rasterization
+        struct Triangle {
+            float edgeA[3];             // E_i(x, y) = A*x + B*y + C, positive inside,
+            float edgeB[3];             // E_i is the edge opposite vertex i
+            float edgeC[3];
+            float z[3];                 // Vertex 0 value, then deltas to vertices 1 and 2,
+            float invW[3];              // so interpolation only needs two barycentrics
+            float invArea;
+            int32_t minX, minY, maxX, maxY; // Inclusive pixel bounds, clipped to targets and scissor
+            uint32_t topLeftMask;       // Bit i set when edge i owns pixels exactly on it
+            uint32_t drawIndex;
+            uint32_t varyingOffset;     // 3 * varyingCount floats divided by w, same delta layout as z
+            bool frontFacing;
+        };
+
+        // Output of one setup job, merged in submission order
+        struct SetupChunk {
+            std::vector<Triangle> triangles;
+            std::vector<float> varyings;
+            uint64_t culled = 0;
+            uint64_t clipped = 0;
+        };
+
+        void SetupTriangle(const DrawState& state, const DrawRecord& draw,
+                           const SoftwareVertexOutput* const vertices[3], SetupChunk& chunk) const;
+        void EmitTriangle(const DrawState& state, const DrawRecord& draw, const float* const clip[3],
+                          const float* const varyings[3], SetupChunk& chunk) const;
+        void RasterizeTile(uint32_t tileIndex, uint32_t binChunkCount, uint64_t& pixelsShaded) const;
+        void RasterizeTriangle(const Triangle& triangle, int32_t tileMinX, int32_t tileMinY,
+                               int32_t tileMaxX, int32_t tileMaxY, uint64_t& pixelsShaded) const;
+
+        SoftwareTexture* m_colorTarget = nullptr;
+        SoftwareTexture* m_depthTarget = nullptr;
+        int32_t m_targetWidth = 0;
+        int32_t m_targetHeight = 0;
+        uint32_t m_tilesX = 0;
+        uint32_t m_tilesY = 0;
+
+        // Pending work, kept allocated between flushes
+        std::vector<DrawRecord> m_draws;
+        std::vector<Triangle> m_triangles;
+        std::vector<float> m_varyings;
+        std::vector<SoftwareVertexOutput> m_vertexOutputs;
+        std::vector<SetupChunk> m_setupChunks;
+        std::vector<std::vector<uint32_t>> m_bins; // [binChunk * tileCount + tile] -> triangle indices
+
+        SoftwareRasterizerStats m_stats;
+    };
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+#include <Rendering/Backends/Host/HostTexture.h>
+
+namespace Reality {
+    // Host texture the rasterizer renders into
+    class SoftwareTexture : public HostTexture {
+    public:
+        using HostTexture::HostTexture;
+
+        // Top mip of the first slice, the only subresource the rasterizer renders to
+        uint8_t* GetPixels() { return GetData(); }
+        const uint8_t* GetPixels() const { return GetData(); }
+        uint32_t GetRowPitch() const { return m_desc.width * GetFormatSize(m_desc.format); }
+        uint32_t GetBytesPerPixel() const { return GetFormatSize(m_desc.format); }
+    };
+}
@@ -2,16 +2,26 @@
 #include "GraphicsDevice.h"
 #include <cassert>
 #include <algorithm>
+#include "Backends/Null/NullDevice.h"
+#include "Backends/Software/SoftwareDevice.h"
+
+#ifdef _WIN32
 #include "Backends/D3D12/D3D12Device.h"
+#endif
 
 namespace Reality {
     DevicePtr GraphicsFactory::CreateDevice(const DeviceCreationParams& params) {
         switch (params.api) {
             case GraphicsAPI::DirectX12: {
+#ifdef _WIN32
                 auto device = std::make_unique<D3D12Device>();
                 if (device->Initialize(params)) {
-                    return DevicePtr(device.release(), ResourceDeleter<IGraphicsDevice>(device.get()));
+                    IGraphicsDevice* raw = device.release();
+                    return DevicePtr(raw, ResourceDeleter<IGraphicsDevice>(raw));
                 }
+#else
+                assert(false && "DirectX 12 backend is only available on Windows");
+#endif
                 break;
             }
             case GraphicsAPI::Vulkan:
@@ -22,6 +32,22 @@ namespace Reality {
                 // Not implemented yet
                 assert(false && "Metal backend not implemented yet");
                 break;
+            case GraphicsAPI::Null: {
+                auto device = std::make_unique<NullDevice>();
+                if (device->Initialize(params)) {
+                    IGraphicsDevice* raw = device.release();
+                    return DevicePtr(raw, ResourceDeleter<IGraphicsDevice>(raw));
+                }
+                break;
+            }
+            case GraphicsAPI::Software: {
+                auto device = std::make_unique<SoftwareDevice>();
+                if (device->Initialize(params)) {
+                    IGraphicsDevice* raw = device.release();
+                    return DevicePtr(raw, ResourceDeleter<IGraphicsDevice>(raw));
+                }
+                break;
+            }
             default:
                 assert(false && "Unknown graphics API");
                 break;
@@ -38,9 +64,24 @@ namespace Reality {
     }
 
     bool GraphicsFactory::IsAPISupported(GraphicsAPI api) {
-        // For now, we'll assume all APIs are supported
-        // In a real implementation, this would check the system capabilities
-        return true;
+        switch (api) {
+            case GraphicsAPI::DirectX12:
+#ifdef _WIN32
+                return true;
+#else
+                return false;
+#endif
+            case GraphicsAPI::Null:
+            case GraphicsAPI::Software:
+                // Host memory only, available everywhere
+                return true;
+            case GraphicsAPI::Vulkan:
+            case GraphicsAPI::Metal:
+                // Backends not implemented yet, CreateDevice would assert
+                return false;
+            default:
+                return false;
+        }
     }
 
     std::vector<GraphicsAPI> GraphicsFactory::GetSupportedAPIs() {
@@ -56,6 +97,12 @@ namespace Reality {
         if (IsAPISupported(GraphicsAPI::Metal)) {
             supported.push_back(GraphicsAPI::Metal);
         }
+        if (IsAPISupported(GraphicsAPI::Null)) {
+            supported.push_back(GraphicsAPI::Null);
+        }
+        if (IsAPISupported(GraphicsAPI::Software)) {
+            supported.push_back(GraphicsAPI::Software);
+        }
         
         return supported;
     }
@@ -80,6 +127,10 @@ namespace Reality {
                 return "Vulkan";
             case GraphicsAPI::Metal:
                 return "Metal";
+            case GraphicsAPI::Null:
+                return "Null";
+            case GraphicsAPI::Software:
+                return "Software";
             default:
                 return "Unknown";
         }
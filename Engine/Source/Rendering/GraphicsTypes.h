@@ -1,5 +1,7 @@
 ﻿#pragma once
 #include <cstdint>
+#include <cfloat>
+#include <functional>
 #include <string>
 
 namespace Reality {
@@ -8,6 +10,8 @@ namespace Reality {
         DirectX12,
         Vulkan,
         Metal,
+        Null,       // Headless host-memory backend, no GPU required
+        Software,   // Multithreaded CPU rasterizer
         Count
     };
 
@@ -61,11 +65,14 @@ namespace Reality {
         R8G8_UNORM,
         R8G8B8A8_UNORM,
         R8G8B8A8_UNORM_SRGB,
+        R8G8B8A8_SNORM,
         B8G8R8A8_UNORM,
         B8G8R8A8_UNORM_SRGB,
         R16_FLOAT,
         R16G16_FLOAT,
         R16G16B16A16_FLOAT,
+        R16G16_UNORM,
+        R16G16_SNORM,
         R32_FLOAT,
         R32G32_FLOAT,
         R32G32B32_FLOAT,
@@ -395,6 +402,38 @@ namespace Reality {
               instanceDataStepRate(0) {}
     };
 
+    // Software Shader Descriptors
+    // C++ callables executed by the software backend in place of compiled HLSL
+    constexpr uint32_t MaxSoftwareVertexStreams = 8;
+    constexpr uint32_t MaxSoftwareConstantBuffers = 8;
+    constexpr uint32_t MaxSoftwareVaryings = 16;
+
+    struct SoftwareVertexInput {
+        const uint8_t* streams[MaxSoftwareVertexStreams]; // Current element of each bound vertex buffer
+        const void* const* constantBuffers;                // Indexed by root parameter
+        uint32_t vertexId;
+        uint32_t instanceId;
+    };
+
+    struct SoftwareVertexOutput {
+        float position[4];                   // Clip space, D3D conventions (0 <= z <= w)
+        float varyings[MaxSoftwareVaryings]; // Perspective-correct interpolated for the pixel shader
+    };
+
+    struct SoftwarePixelInput {
+        const float* varyings;
+        const void* const* constantBuffers;
+        float x;     // Pixel center in render target space
+        float y;
+        float depth;
+        bool frontFacing;
+    };
+
+    // Writes the clip-space position and varyings of one vertex
+    using SoftwareVertexShader = std::function<void(const SoftwareVertexInput& input, SoftwareVertexOutput& output)>;
+    // Writes the color of one pixel, returns false to discard it
+    using SoftwarePixelShader = std::function<bool(const SoftwarePixelInput& input, float color[4])>;
+
     // Pipeline State Descriptors
     struct PipelineStateDesc {
         ShaderDesc vertexShader;
@@ -416,6 +455,11 @@ namespace Reality {
         uint32_t sampleQuality;
         uint32_t nodeMask;
 
+        // Used by GraphicsAPI::Software only
+        SoftwareVertexShader softwareVertexShader;
+        SoftwarePixelShader softwarePixelShader;
+        uint32_t softwareVaryingCount;
+
         PipelineStateDesc()
             : inputElements(nullptr),
               numInputElements(0),
@@ -424,7 +468,8 @@ namespace Reality {
               depthStencilFormat(Format::Unknown),
               sampleCount(1),
               sampleQuality(0),
-              nodeMask(0) {
+              nodeMask(0),
+              softwareVaryingCount(0) {
             for (int i = 0; i < 8; i++) {
                 renderTargetFormats[i] = Format::Unknown;
             }
@@ -1,5 +1,7 @@
 ﻿#include "HighLevelRenderer.h"
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 namespace Reality {
     HighLevelRenderer::HighLevelRenderer(IGraphicsDevice* device)
@@ -47,6 +49,12 @@ namespace Reality {
 
         // Reset command list
         m_currentCommandList->Reset();
+
+        // Render into the current back buffer
+        if (m_swapChain) {
+            ITexture* backBuffer = m_swapChain->GetBackBuffer(m_swapChain->GetCurrentBackBufferIndex());
+            m_currentCommandList->OMSetRenderTargets(1, &backBuffer, nullptr);
+        }
     }
 
     void HighLevelRenderer::EndFrame() {
@@ -113,6 +121,22 @@ namespace Reality {
         return BufferPtr(m_device->CreateBuffer(desc, data), ResourceDeleter<IBuffer>(m_device));
     }
 
+    MeshBuffers HighLevelRenderer::CreateMesh(const void* vertices, uint32_t vertexCount, uint32_t stride,
+                                              std::span<const uint32_t> indices, const MeshOptimizeDesc& desc,
+                                              MeshOptimizeStats* stats) {
+        std::vector<uint8_t> vertexData(static_cast<size_t>(vertexCount) * stride);
+        memcpy(vertexData.data(), vertices, vertexData.size());
+        std::vector<uint32_t> indexData(indices.begin(), indices.end());
+        const uint32_t usedCount = OptimizeMesh(indexData, vertexData.data(), vertexCount, stride, desc, stats);
+
+        MeshBuffers mesh;
+        mesh.vertexCount = usedCount;
+        mesh.indexCount = static_cast<uint32_t>(indexData.size());
+        mesh.vertexBuffer = CreateVertexBuffer(vertexData.data(), usedCount * stride, stride);
+        mesh.indexBuffer = CreateIndexBuffer(indexData.data(), mesh.indexCount * sizeof(uint32_t));
+        return mesh;
+    }
+
     TexturePtr HighLevelRenderer::CreateTextureFromFile(const std::string& filename) {
         // This would need to be implemented with a proper image loading library
         (void)filename;
@@ -150,6 +174,9 @@ namespace Reality {
         psoDesc.vertexShader = desc.vertexShader;
         psoDesc.pixelShader = desc.pixelShader;
         psoDesc.primitiveTopology = desc.topology;
+        psoDesc.softwareVertexShader = desc.softwareVertexShader;
+        psoDesc.softwarePixelShader = desc.softwarePixelShader;
+        psoDesc.softwareVaryingCount = desc.softwareVaryingCount;
 
         // Set default states based on the simplified description
         if (desc.depthTest) {
@@ -2,12 +2,21 @@
 #include "GraphicsDevice.h"
 #include "Resource.h"
 #include <Core/MathF.h>
+#include <Mesh/MeshOptimizer.h>
 #include <memory>
+#include <span>
 #include <string>
 
 namespace Reality {
     struct GraphicsPipelineDesc;
 
+    struct MeshBuffers {
+        BufferPtr vertexBuffer;
+        BufferPtr indexBuffer;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+    };
+
     // High-level renderer that uses the low-level backend
     class HighLevelRenderer {
     public:
@@ -30,6 +39,12 @@ namespace Reality {
         // Simplified resource creation
         BufferPtr CreateVertexBuffer(const void* data, uint32_t size, uint32_t stride);
         BufferPtr CreateIndexBuffer(const void* data, uint32_t size);
+
+        // Optimizes a copy of an indexed triangle list for the vertex cache,
+        // overdraw and vertex fetch as desc selects, then creates its buffers.
+        // Unused vertices are dropped, so draw with the returned counts.
+        MeshBuffers CreateMesh(const void* vertices, uint32_t vertexCount, uint32_t stride, std::span<const uint32_t> indices,
+                               const MeshOptimizeDesc& desc = MeshOptimizeDesc(), MeshOptimizeStats* stats = nullptr);
         TexturePtr CreateTextureFromFile(const std::string& filename);
         TexturePtr CreateTexture2D(uint32_t width, uint32_t height, Format format, const void* data = nullptr);
         ShaderPtr CreateShaderFromFile(const std::string& filename, ShaderType type, const std::string& entryPoint = "main");
@@ -77,5 +92,10 @@ namespace Reality {
         bool depthTest = true;
         bool depthWrite = true;
         bool cullBack = true;
+
+        // Used by GraphicsAPI::Software only
+        SoftwareVertexShader softwareVertexShader;
+        SoftwarePixelShader softwarePixelShader;
+        uint32_t softwareVaryingCount = 0;
     };
 }
\ No newline at end of file
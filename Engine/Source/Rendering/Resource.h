@@ -29,6 +29,8 @@ namespace Reality {
                     device->DestroyFence(resource);
                 } else if constexpr (std::is_same_v<T, ISwapChain>) {
                     device->DestroySwapChain(resource);
+                } else if constexpr (std::is_same_v<T, IGraphicsDevice>) {
+                    delete resource;
                 }
             }
         }
@@ -0,0 +1,804 @@
+﻿#include "BVH.h"
+#include <Core/JobSystem.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <numeric>
+#include <queue>
+
+namespace Reality {
+    namespace {
+        constexpr uint32_t NoParent = UINT32_MAX;
+        constexpr uint32_t BinCount = 16;
+
+        // Ranges up to this size always become leaves
+        constexpr uint32_t MinLeafSize = 4;
+
+        // Cost of visiting a node relative to testing one primitive box
+        constexpr float TraversalCost = 1.0f;
+
+        // Ranges at least this large are binned and built in parallel
+        constexpr uint32_t ParallelThreshold = 8192;
+        constexpr uint32_t BinGrainSize = 4096;
+
+        // Deeper ranges are split at the median, which bounds the depth of
+        // the tree and with it the traversal stack
+        constexpr uint32_t MaxSahDepth = 32;
+        constexpr uint32_t StackSize = 256;
+
+        float HalfArea(const AABB& box) {
+            const Vector3 size = box.Size();
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        struct Bin {
+            AABB bounds = AABB::Empty();
+            AABB centroids = AABB::Empty();
+            uint32_t count = 0;
+        };
+
+        using Bins = std::array<Bin, BinCount>;
+
+        // Ray with its reciprocal direction, and the rows holding the near and
+        // far plane of each slab
+        struct RayData {
+            Vector3 origin;
+            Vector3 inverse;
+            uint32_t nearRows[3];
+            uint32_t farRows[3];
+
+            RayData() = default;
+            explicit RayData(const Ray& ray) : origin(ray.origin), inverse(ray.GetInverseDirection()) {
+                for (int axis = 0; axis < 3; axis++) {
+                    const bool negative = inverse[axis] < 0.0f;
+                    nearRows[axis] = negative ? axis + 3 : axis;
+                    farRows[axis] = negative ? axis : axis + 3;
+                }
+            }
+        };
+
+        // Same arithmetic as the node test, so a primitive inside a hit child is not missed
+        bool IntersectBox(const AABB& box, const RayData& ray, float maxDistance, float& distance) {
+            float tNear = 0.0f;
+            float tFar = maxDistance;
+            for (int axis = 0; axis < 3; axis++) {
+                const float t0 = (box.min[axis] - ray.origin[axis]) * ray.inverse[axis];
+                const float t1 = (box.max[axis] - ray.origin[axis]) * ray.inverse[axis];
+                tNear = Max(tNear, ray.nearRows[axis] == static_cast<uint32_t>(axis) ? t0 : t1);
+                tFar = Min(tFar, ray.nearRows[axis] == static_cast<uint32_t>(axis) ? t1 : t0);
+            }
+            distance = tNear;
+            return tNear <= tFar;
+        }
+
+        // Bit i is set when the ray enters child i within maxDistance, at distances[i]
+        uint32_t IntersectChildren(const float (&bounds)[6][BVH::Width], const RayData& ray, float maxDistance,
+                                   float (&distances)[BVH::Width]) {
+#if defined(REALITY_SIMD_SSE)
+            SIMD::Float4 tNear = SIMD::Zero();
+            SIMD::Float4 tFar = SIMD::Splat(maxDistance);
+            for (int axis = 0; axis < 3; axis++) {
+                const SIMD::Float4 origin = SIMD::Splat(ray.origin[axis]);
+                const SIMD::Float4 inverse = SIMD::Splat(ray.inverse[axis]);
+                tNear = SIMD::Max(tNear, SIMD::Mul(SIMD::Sub(SIMD::Load(bounds[ray.nearRows[axis]]), origin), inverse));
+                tFar = SIMD::Min(tFar, SIMD::Mul(SIMD::Sub(SIMD::Load(bounds[ray.farRows[axis]]), origin), inverse));
+            }
+            SIMD::Store(distances, tNear);
+            return static_cast<uint32_t>(SIMD::MoveMask(SIMD::GreaterEqual(tFar, tNear)));
+#else
+            uint32_t mask = 0;
+            for (uint32_t child = 0; child < BVH::Width; child++) {
+                float tNear = 0.0f;
+                float tFar = maxDistance;
+                for (int axis = 0; axis < 3; axis++) {
+                    tNear = Max(tNear, (bounds[ray.nearRows[axis]][child] - ray.origin[axis]) * ray.inverse[axis]);
+                    tFar = Min(tFar, (bounds[ray.farRows[axis]][child] - ray.origin[axis]) * ray.inverse[axis]);
+                }
+                distances[child] = tNear;
+                mask |= tNear <= tFar ? 1u << child : 0u;
+            }
+            return mask;
+#endif
+        }
+
+        uint32_t OverlapChildren(const float (&bounds)[6][BVH::Width], const AABB& box) {
+#if defined(REALITY_SIMD_SSE)
+            SIMD::Float4 overlap = SIMD::Splat(-0.0f);
+            for (int axis = 0; axis < 3; axis++) {
+                overlap = SIMD::And(overlap, SIMD::GreaterEqual(SIMD::Splat(box.max[axis]), SIMD::Load(bounds[axis])));
+                overlap = SIMD::And(overlap, SIMD::GreaterEqual(SIMD::Load(bounds[axis + 3]), SIMD::Splat(box.min[axis])));
+            }
+            return static_cast<uint32_t>(SIMD::MoveMask(overlap));
+#else
+            uint32_t mask = 0;
+            for (uint32_t child = 0; child < BVH::Width; child++) {
+                bool overlap = true;
+                for (int axis = 0; axis < 3; axis++) {
+                    overlap = overlap && bounds[axis][child] <= box.max[axis] && bounds[axis + 3][child] >= box.min[axis];
+                }
+                mask |= overlap ? 1u << child : 0u;
+            }
+            return mask;
+#endif
+        }
+
+        uint32_t OverlapChildren(const float (&bounds)[6][BVH::Width], const BoundingSphere& sphere) {
+#if defined(REALITY_SIMD_SSE)
+            SIMD::Float4 distanceSquared = SIMD::Zero();
+            for (int axis = 0; axis < 3; axis++) {
+                const SIMD::Float4 center = SIMD::Splat(sphere.center[axis]);
+                const SIMD::Float4 closest = SIMD::Min(SIMD::Max(center, SIMD::Load(bounds[axis])), SIMD::Load(bounds[axis + 3]));
+                const SIMD::Float4 delta = SIMD::Sub(closest, center);
+                distanceSquared = SIMD::MulAdd(delta, delta, distanceSquared);
+            }
+            const SIMD::Float4 radiusSquared = SIMD::Splat(sphere.radius * sphere.radius);
+            return static_cast<uint32_t>(SIMD::MoveMask(SIMD::GreaterEqual(radiusSquared, distanceSquared)));
+#else
+            uint32_t mask = 0;
+            for (uint32_t child = 0; child < BVH::Width; child++) {
+                const AABB box(Vector3(bounds[0][child], bounds[1][child], bounds[2][child]),
+                               Vector3(bounds[3][child], bounds[4][child], bounds[5][child]));
+                mask |= box.IsValid() && sphere.Intersects(box) ? 1u << child : 0u;
+            }
+            return mask;
+#endif
+        }
+
+        // Child slots of a hit mask, farthest first so the nearest is popped first
+        uint32_t SortFarToNear(uint32_t mask, const float (&distances)[BVH::Width], uint32_t (&order)[BVH::Width]) {
+            uint32_t count = 0;
+            for (; mask != 0; mask &= mask - 1) {
+                const uint32_t child = static_cast<uint32_t>(std::countr_zero(mask));
+                uint32_t k = count++;
+                for (; k > 0 && distances[order[k - 1]] < distances[child]; k--) {
+                    order[k] = order[k - 1];
+                }
+                order[k] = child;
+            }
+            return count;
+        }
+    }
+
+    struct BVH::BuildRange {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        AABB bounds = AABB::Empty();
+        AABB centroids = AABB::Empty();
+
+        uint32_t GetCount() const { return end - begin; }
+    };
+
+    // Top down build. Nodes are claimed from a shared counter before their
+    // children, so parents always precede them, and large subtrees are built
+    // concurrently on disjoint ranges of the slot array.
+    class BVH::Builder {
+    public:
+        Builder(BVH& bvh, std::span<const AABB> bounds) : m_bvh(bvh), m_bounds(bounds) {}
+
+        void Run() {
+            const uint32_t count = static_cast<uint32_t>(m_bounds.size());
+            m_centroids.resize(count);
+            m_bvh.m_primitiveIds.resize(count);
+            std::iota(m_bvh.m_primitiveIds.begin(), m_bvh.m_primitiveIds.end(), 0u);
+            m_bvh.m_primitiveNodes.resize(count);
+
+            // Centroids and root bounds, reduced per chunk
+            const uint32_t chunkCount = (count + BinGrainSize - 1) / BinGrainSize;
+            std::vector<BuildRange> chunks(chunkCount);
+            JobSystem::GetInstance().ParallelFor(count, BinGrainSize, [this, &chunks](uint32_t begin, uint32_t end) {
+                BuildRange& chunk = chunks[begin / BinGrainSize];
+                for (uint32_t i = begin; i < end; i++) {
+                    m_centroids[i] = m_bounds[i].Center();
+                    chunk.bounds.Expand(m_bounds[i]);
+                    chunk.centroids.Expand(m_centroids[i]);
+                }
+            });
+
+            BuildRange root;
+            root.end = count;
+            for (const BuildRange& chunk : chunks) {
+                root.bounds.Expand(chunk.bounds);
+                root.centroids.Expand(chunk.centroids);
+            }
+
+            // Every node but the root holds more than MinLeafSize primitives
+            // and has at least two children, so this is an upper bound
+            m_bvh.m_nodes.resize(count);
+            BuildNode(root, NoParent, 0, 1);
+            m_bvh.m_nodes.resize(m_nodeCount.load());
+            m_bvh.m_depth = m_depth.load();
+        }
+
+    private:
+        uint32_t GetBin(uint32_t id, const BuildRange& range, int axis, float scale) const {
+            const float offset = (m_centroids[id][axis] - range.centroids.min[axis]) * scale;
+            return std::min(static_cast<uint32_t>(offset), BinCount - 1);
+        }
+
+        void AddToBins(Bins& bins, uint32_t begin, uint32_t end, const BuildRange& range, int axis, float scale) const {
+            const std::vector<uint32_t>& ids = m_bvh.m_primitiveIds;
+            for (uint32_t slot = begin; slot < end; slot++) {
+                const uint32_t id = ids[slot];
+                Bin& bin = bins[GetBin(id, range, axis, scale)];
+                bin.bounds.Expand(m_bounds[id]);
+                bin.centroids.Expand(m_centroids[id]);
+                bin.count++;
+            }
+        }
+
+        void SplitMedian(const BuildRange& range, int axis, BuildRange& left, BuildRange& right) {
+            std::vector<uint32_t>& ids = m_bvh.m_primitiveIds;
+            const uint32_t middle = range.begin + range.GetCount() / 2;
+            std::nth_element(ids.begin() + range.begin, ids.begin() + middle, ids.begin() + range.end,
+                             [this, axis](uint32_t a, uint32_t b) { return m_centroids[a][axis] < m_centroids[b][axis]; });
+
+            left = BuildRange{ range.begin, middle };
+            right = BuildRange{ middle, range.end };
+            for (BuildRange* half : { &left, &right }) {
+                for (uint32_t slot = half->begin; slot < half->end; slot++) {
+                    half->bounds.Expand(m_bounds[ids[slot]]);
+                    half->centroids.Expand(m_centroids[ids[slot]]);
+                }
+            }
+        }
+
+        // Partitions the range at its cheapest bin boundary. Returns false when
+        // the range is cheaper as a leaf.
+        bool Split(const BuildRange& range, uint32_t depth, BuildRange& left, BuildRange& right) {
+            const Vector3 extent = range.centroids.Size();
+            int axis = extent.x > extent.y ? 0 : 1;
+            axis = extent.z > extent[axis] ? 2 : axis;
+
+            // Coincident centroids cannot be binned
+            if (extent[axis] <= 0.0f || depth >= MaxSahDepth) {
+                SplitMedian(range, axis, left, right);
+                return true;
+            }
+
+            const float scale = BinCount * (1.0f - 1e-6f) / extent[axis];
+            Bins bins;
+            const uint32_t count = range.GetCount();
+            if (count >= ParallelThreshold) {
+                std::vector<Bins> partialBins((count + BinGrainSize - 1) / BinGrainSize);
+                JobSystem::GetInstance().ParallelFor(count, BinGrainSize, [&](uint32_t begin, uint32_t end) {
+                    AddToBins(partialBins[begin / BinGrainSize], range.begin + begin, range.begin + end, range, axis, scale);
+                });
+                for (const Bins& partial : partialBins) {
+                    for (uint32_t i = 0; i < BinCount; i++) {
+                        bins[i].bounds.Expand(partial[i].bounds);
+                        bins[i].centroids.Expand(partial[i].centroids);
+                        bins[i].count += partial[i].count;
+                    }
+                }
+            } else {
+                AddToBins(bins, range.begin, range.end, range, axis, scale);
+            }
+
+            // Sweep from the right, then from the left evaluating each boundary
+            float rightCosts[BinCount];
+            AABB rightBounds = AABB::Empty();
+            uint32_t rightCount = 0;
+            for (uint32_t i = BinCount - 1; i > 0; i--) {
+                rightBounds.Expand(bins[i].bounds);
+                rightCount += bins[i].count;
+                rightCosts[i] = rightCount > 0 ? HalfArea(rightBounds) * rightCount : 0.0f;
+            }
+
+            float bestCost = INFINITY;
+            uint32_t bestSplit = 0;
+            AABB leftBounds = AABB::Empty();
+            uint32_t leftCount = 0;
+            for (uint32_t i = 1; i < BinCount; i++) {
+                leftBounds.Expand(bins[i - 1].bounds);
+                leftCount += bins[i - 1].count;
+                if (leftCount == 0 || leftCount == count) {
+                    continue;
+                }
+                const float cost = HalfArea(leftBounds) * leftCount + rightCosts[i];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = i;
+                }
+            }
+
+            const float rangeArea = HalfArea(range.bounds);
+            if (bestSplit == 0 || (count <= MaxLeafSize && TraversalCost * rangeArea + bestCost >= count * rangeArea)) {
+                return false;
+            }
+
+            std::vector<uint32_t>& ids = m_bvh.m_primitiveIds;
+            const auto middle = std::partition(ids.begin() + range.begin, ids.begin() + range.end,
+                [&](uint32_t id) { return GetBin(id, range, axis, scale) < bestSplit; });
+
+            left = BuildRange{ range.begin, static_cast<uint32_t>(middle - ids.begin()) };
+            right = BuildRange{ left.end, range.end };
+            for (uint32_t i = 0; i < BinCount; i++) {
+                BuildRange& half = i < bestSplit ? left : right;
+                half.bounds.Expand(bins[i].bounds);
+                half.centroids.Expand(bins[i].centroids);
+            }
+            return true;
+        }
+
+        uint32_t BuildNode(const BuildRange& range, uint32_t parent, uint32_t parentSlot, uint32_t depth) {
+            const uint32_t index = m_nodeCount.fetch_add(1);
+            uint32_t maxDepth = m_depth.load();
+            while (depth > maxDepth && !m_depth.compare_exchange_weak(maxDepth, depth)) {
+            }
+
+            // Split the largest child until the node is full
+            BuildRange children[Width] = { range };
+            bool leaves[Width] = {};
+            uint32_t childCount = 1;
+            while (childCount < Width) {
+                int largest = -1;
+                float largestArea = -1.0f;
+                for (uint32_t i = 0; i < childCount; i++) {
+                    if (!leaves[i] && children[i].GetCount() > MinLeafSize && HalfArea(children[i].bounds) > largestArea) {
+                        largest = static_cast<int>(i);
+                        largestArea = HalfArea(children[i].bounds);
+                    }
+                }
+                if (largest < 0) {
+                    break;
+                }
+
+                BuildRange left, right;
+                if (!Split(children[largest], depth, left, right)) {
+                    leaves[largest] = true;
+                    continue;
+                }
+                children[largest] = left;
+                children[childCount++] = right;
+            }
+
+            Node& node = m_bvh.m_nodes[index];
+            node.parent = parent;
+            node.parentSlot = parentSlot;
+
+            uint32_t innerChildren[Width];
+            uint32_t innerCount = 0;
+            for (uint32_t i = 0; i < Width; i++) {
+                if (i >= childCount) {
+                    node.children[i] = EmptyChild;
+                    SetChildBounds(node, i, AABB::Empty());
+                    continue;
+                }
+
+                const BuildRange& child = children[i];
+                SetChildBounds(node, i, child.bounds);
+                bool leaf = leaves[i] || child.GetCount() <= MinLeafSize;
+                if (!leaf && child.GetCount() <= MaxLeafSize) {
+                    // Not split yet. A node holding a single leaf would only add a level.
+                    BuildRange left, right;
+                    leaf = !Split(child, depth + 1, left, right);
+                }
+
+                if (leaf) {
+                    node.children[i] = MakeLeaf(child.begin, child.GetCount());
+                    std::fill(m_bvh.m_primitiveNodes.begin() + child.begin, m_bvh.m_primitiveNodes.begin() + child.end, index);
+                } else {
+                    innerChildren[innerCount++] = i;
+                }
+            }
+
+            const auto buildChild = [&](uint32_t i) {
+                const uint32_t slot = innerChildren[i];
+                node.children[slot] = BuildNode(children[slot], index, slot, depth + 1);
+            };
+            if (range.GetCount() >= ParallelThreshold && innerCount > 1) {
+                JobSystem::GetInstance().ParallelFor(innerCount, 1, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; i++) {
+                        buildChild(i);
+                    }
+                });
+            } else {
+                for (uint32_t i = 0; i < innerCount; i++) {
+                    buildChild(i);
+                }
+            }
+            return index;
+        }
+
+        BVH& m_bvh;
+        std::span<const AABB> m_bounds;
+        std::vector<Vector3> m_centroids;
+        std::atomic<uint32_t> m_nodeCount{0};
+        std::atomic<uint32_t> m_depth{0};
+    };
+
+    void BVH::Build(std::span<const AABB> bounds) {
+        assert(bounds.size() < (LeafFlag >> LeafCountBits) && "Too many primitives");
+        Clear();
+        if (bounds.empty()) {
+            return;
+        }
+
+        Builder builder(*this, bounds);
+        builder.Run();
+
+        const uint32_t count = static_cast<uint32_t>(bounds.size());
+        m_primitiveBounds.resize(count);
+        m_primitiveSlots.resize(count);
+        for (uint32_t slot = 0; slot < count; slot++) {
+            m_primitiveBounds[slot] = bounds[m_primitiveIds[slot]];
+            m_primitiveSlots[m_primitiveIds[slot]] = slot;
+        }
+        m_dirtyFlags.assign(m_nodes.size(), 0);
+    }
+
+    void BVH::Clear() {
+        m_nodes.clear();
+        m_primitiveBounds.clear();
+        m_primitiveIds.clear();
+        m_primitiveSlots.clear();
+        m_primitiveNodes.clear();
+        m_dirtyNodes.clear();
+        m_dirtyFlags.clear();
+        m_depth = 0;
+    }
+
+    void BVH::SetChildBounds(Node& node, uint32_t slot, const AABB& bounds) {
+        for (int axis = 0; axis < 3; axis++) {
+            node.bounds[axis][slot] = bounds.min[axis];
+            node.bounds[axis + 3][slot] = bounds.max[axis];
+        }
+    }
+
+    AABB BVH::GetChildBounds(const Node& node, uint32_t slot) {
+        return AABB(Vector3(node.bounds[0][slot], node.bounds[1][slot], node.bounds[2][slot]),
+                    Vector3(node.bounds[3][slot], node.bounds[4][slot], node.bounds[5][slot]));
+    }
+
+    AABB BVH::ComputeChildBounds(uint32_t child) const {
+        AABB bounds = AABB::Empty();
+        if (IsLeaf(child)) {
+            const uint32_t begin = GetLeafBegin(child);
+            const uint32_t end = begin + GetLeafCount(child);
+            for (uint32_t slot = begin; slot < end; slot++) {
+                bounds.Expand(m_primitiveBounds[slot]);
+            }
+        } else {
+            const Node& node = m_nodes[child];
+            for (uint32_t slot = 0; slot < Width; slot++) {
+                if (node.children[slot] != EmptyChild) {
+                    bounds.Expand(GetChildBounds(node, slot));
+                }
+            }
+        }
+        return bounds;
+    }
+
+    AABB BVH::RefitNode(uint32_t index) {
+        Node& node = m_nodes[index];
+        AABB total = AABB::Empty();
+        for (uint32_t slot = 0; slot < Width; slot++) {
+            if (node.children[slot] != EmptyChild) {
+                const AABB bounds = ComputeChildBounds(node.children[slot]);
+                SetChildBounds(node, slot, bounds);
+                total.Expand(bounds);
+            }
+        }
+        return total;
+    }
+
+    void BVH::SetBounds(uint32_t id, const AABB& bounds) {
+        const uint32_t slot = m_primitiveSlots[id];
+        m_primitiveBounds[slot] = bounds;
+        const uint32_t node = m_primitiveNodes[slot];
+        if (!m_dirtyFlags[node]) {
+            m_dirtyFlags[node] = 1;
+            m_dirtyNodes.push_back(node);
+        }
+    }
+
+    void BVH::Refit() {
+        // Deepest first: children have higher indices than their parents
+        std::priority_queue<uint32_t> queue(m_dirtyNodes.begin(), m_dirtyNodes.end());
+        m_dirtyNodes.clear();
+        while (!queue.empty()) {
+            const uint32_t index = queue.top();
+            queue.pop();
+            m_dirtyFlags[index] = 0;
+
+            const Node& node = m_nodes[index];
+            const AABB bounds = RefitNode(index);
+            if (node.parent == NoParent) {
+                continue;
+            }
+            const AABB previous = GetChildBounds(m_nodes[node.parent], node.parentSlot);
+            if ((bounds.min != previous.min || bounds.max != previous.max) && !m_dirtyFlags[node.parent]) {
+                m_dirtyFlags[node.parent] = 1;
+                queue.push(node.parent);
+            }
+        }
+    }
+
+    void BVH::Refit(std::span<const AABB> bounds) {
+        assert(bounds.size() == m_primitiveIds.size());
+        JobSystem::GetInstance().ParallelFor(GetPrimitiveCount(), BinGrainSize, [this, bounds](uint32_t begin, uint32_t end) {
+            for (uint32_t slot = begin; slot < end; slot++) {
+                m_primitiveBounds[slot] = bounds[m_primitiveIds[slot]];
+            }
+        });
+        for (uint32_t index = GetNodeCount(); index-- > 0;) {
+            RefitNode(index);
+        }
+        m_dirtyNodes.clear();
+        std::fill(m_dirtyFlags.begin(), m_dirtyFlags.end(), uint8_t(0));
+    }
+
+    bool BVH::Raycast(const Ray& ray, float maxDistance, RayHit& hit, const RayTestFunction& test) const {
+        hit = RayHit();
+        if (IsEmpty()) {
+            return false;
+        }
+
+        struct StackEntry {
+            uint32_t child;
+            float distance;
+        };
+        StackEntry stack[StackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = { 0, 0.0f };
+
+        const RayData data(ray);
+        float closest = maxDistance;
+        while (stackSize > 0) {
+            const StackEntry entry = stack[--stackSize];
+            if (entry.distance > closest) {
+                continue;
+            }
+
+            if (IsLeaf(entry.child)) {
+                const uint32_t begin = GetLeafBegin(entry.child);
+                const uint32_t end = begin + GetLeafCount(entry.child);
+                for (uint32_t slot = begin; slot < end; slot++) {
+                    float distance;
+                    if (!IntersectBox(m_primitiveBounds[slot], data, closest, distance)) {
+                        continue;
+                    }
+                    if (test) {
+                        distance = test(m_primitiveIds[slot], ray, closest);
+                        if (distance < 0.0f || distance > closest) {
+                            continue;
+                        }
+                    }
+                    closest = distance;
+                    hit.id = m_primitiveIds[slot];
+                    hit.distance = distance;
+                }
+                continue;
+            }
+
+            const Node& node = m_nodes[entry.child];
+            float distances[Width];
+            uint32_t order[Width];
+            const uint32_t hitCount = SortFarToNear(IntersectChildren(node.bounds, data, closest, distances), distances, order);
+            assert(stackSize + hitCount <= StackSize);
+            for (uint32_t i = 0; i < hitCount; i++) {
+                stack[stackSize++] = { node.children[order[i]], distances[order[i]] };
+            }
+        }
+        return hit.id != UINT32_MAX;
+    }
+
+    bool BVH::RaycastAny(const Ray& ray, float maxDistance, const RayTestFunction& test) const {
+        if (IsEmpty()) {
+            return false;
+        }
+
+        uint32_t stack[StackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        const RayData data(ray);
+        while (stackSize > 0) {
+            const uint32_t child = stack[--stackSize];
+            if (IsLeaf(child)) {
+                const uint32_t begin = GetLeafBegin(child);
+                const uint32_t end = begin + GetLeafCount(child);
+                for (uint32_t slot = begin; slot < end; slot++) {
+                    float distance;
+                    if (IntersectBox(m_primitiveBounds[slot], data, maxDistance, distance)) {
+                        if (!test) {
+                            return true;
+                        }
+                        distance = test(m_primitiveIds[slot], ray, maxDistance);
+                        if (distance >= 0.0f && distance <= maxDistance) {
+                            return true;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            const Node& node = m_nodes[child];
+            float distances[Width];
+            uint32_t mask = IntersectChildren(node.bounds, data, maxDistance, distances);
+            assert(stackSize + std::popcount(mask) <= StackSize);
+            for (; mask != 0; mask &= mask - 1) {
+                stack[stackSize++] = node.children[std::countr_zero(mask)];
+            }
+        }
+        return false;
+    }
+
+    void BVH::RaycastPacket(std::span<const Ray> rays, float maxDistance, std::span<RayHit> hits,
+                            const RayTestFunction& test) const {
+        assert(hits.size() >= rays.size());
+#if defined(REALITY_SIMD_SSE)
+        if (IsEmpty()) {
+            std::fill(hits.begin(), hits.begin() + rays.size(), RayHit());
+            return;
+        }
+
+        // Rays are the lanes, each child box is tested against all four
+        struct StackEntry {
+            uint32_t child;
+            uint32_t lanes;
+        };
+        StackEntry stack[StackSize];
+
+        for (size_t first = 0; first < rays.size(); first += 4) {
+            const uint32_t laneCount = static_cast<uint32_t>(std::min<size_t>(4, rays.size() - first));
+            RayData data[4];
+            alignas(16) float origins[3][4];
+            alignas(16) float inverses[3][4];
+            alignas(16) float closest[4];
+            for (uint32_t lane = 0; lane < 4; lane++) {
+                data[lane] = RayData(rays[first + std::min(lane, laneCount - 1)]);
+                closest[lane] = maxDistance;
+                for (int axis = 0; axis < 3; axis++) {
+                    origins[axis][lane] = data[lane].origin[axis];
+                    inverses[axis][lane] = data[lane].inverse[axis];
+                }
+            }
+            for (uint32_t lane = 0; lane < laneCount; lane++) {
+                hits[first + lane] = RayHit();
+            }
+
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { 0, (1u << laneCount) - 1 };
+            while (stackSize > 0) {
+                const StackEntry entry = stack[--stackSize];
+                if (IsLeaf(entry.child)) {
+                    const uint32_t begin = GetLeafBegin(entry.child);
+                    const uint32_t end = begin + GetLeafCount(entry.child);
+                    for (uint32_t lanes = entry.lanes; lanes != 0; lanes &= lanes - 1) {
+                        const uint32_t lane = static_cast<uint32_t>(std::countr_zero(lanes));
+                        RayHit& hit = hits[first + lane];
+                        for (uint32_t slot = begin; slot < end; slot++) {
+                            float distance;
+                            if (!IntersectBox(m_primitiveBounds[slot], data[lane], closest[lane], distance)) {
+                                continue;
+                            }
+                            if (test) {
+                                distance = test(m_primitiveIds[slot], rays[first + lane], closest[lane]);
+                                if (distance < 0.0f || distance > closest[lane]) {
+                                    continue;
+                                }
+                            }
+                            closest[lane] = distance;
+                            hit.id = m_primitiveIds[slot];
+                            hit.distance = distance;
+                        }
+                    }
+                    continue;
+                }
+
+                const Node& node = m_nodes[entry.child];
+                const SIMD::Float4 tLimit = SIMD::Load(closest);
+                float distances[Width];
+                uint32_t childLanes[Width];
+                uint32_t childMask = 0;
+                for (uint32_t slot = 0; slot < Width; slot++) {
+                    if (node.children[slot] == EmptyChild) {
+                        continue;
+                    }
+                    SIMD::Float4 tNear = SIMD::Zero();
+                    SIMD::Float4 tFar = tLimit;
+                    for (int axis = 0; axis < 3; axis++) {
+                        const SIMD::Float4 origin = SIMD::Load(origins[axis]);
+                        const SIMD::Float4 inverse = SIMD::Load(inverses[axis]);
+                        const SIMD::Float4 t0 = SIMD::Mul(SIMD::Sub(SIMD::Splat(node.bounds[axis][slot]), origin), inverse);
+                        const SIMD::Float4 t1 = SIMD::Mul(SIMD::Sub(SIMD::Splat(node.bounds[axis + 3][slot]), origin), inverse);
+                        tNear = SIMD::Max(tNear, SIMD::Min(t0, t1));
+                        tFar = SIMD::Min(tFar, SIMD::Max(t0, t1));
+                    }
+                    const SIMD::Float4 hitLanes = SIMD::GreaterEqual(tFar, tNear);
+                    childLanes[slot] = static_cast<uint32_t>(SIMD::MoveMask(hitLanes)) & entry.lanes;
+                    if (childLanes[slot] != 0) {
+                        // Nearest entry among the lanes that hit
+                        alignas(16) float entries[4];
+                        SIMD::Store(entries, SIMD::Select(SIMD::Splat(INFINITY), tNear, hitLanes));
+                        distances[slot] = Min(Min(entries[0], entries[1]), Min(entries[2], entries[3]));
+                        childMask |= 1u << slot;
+                    }
+                }
+
+                uint32_t order[Width];
+                const uint32_t hitCount = SortFarToNear(childMask, distances, order);
+                assert(stackSize + hitCount <= StackSize);
+                for (uint32_t i = 0; i < hitCount; i++) {
+                    stack[stackSize++] = { node.children[order[i]], childLanes[order[i]] };
+                }
+            }
+        }
+#else
+        for (size_t i = 0; i < rays.size(); i++) {
+            Raycast(rays[i], maxDistance, hits[i], test);
+        }
+#endif
+    }
+
+    template<typename ChildTest, typename PrimitiveTest>
+    void BVH::Query(const ChildTest& childTest, const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const {
+        if (IsEmpty()) {
+            return;
+        }
+
+        uint32_t stack[StackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const uint32_t child = stack[--stackSize];
+            if (IsLeaf(child)) {
+                const uint32_t begin = GetLeafBegin(child);
+                const uint32_t end = begin + GetLeafCount(child);
+                for (uint32_t slot = begin; slot < end; slot++) {
+                    if (primitiveTest(m_primitiveBounds[slot])) {
+                        results.push_back(m_primitiveIds[slot]);
+                    }
+                }
+                continue;
+            }
+
+            const Node& node = m_nodes[child];
+            uint32_t mask = childTest(node.bounds);
+            assert(stackSize + std::popcount(mask) <= StackSize);
+            for (; mask != 0; mask &= mask - 1) {
+                stack[stackSize++] = node.children[std::countr_zero(mask)];
+            }
+        }
+    }
+
+    void BVH::QueryOverlap(const AABB& box, std::vector<uint32_t>& results) const {
+        Query([&box](const float (&bounds)[6][Width]) { return OverlapChildren(bounds, box); },
+              [&box](const AABB& bounds) { return box.Intersects(bounds); }, results);
+    }
+
+    void BVH::QueryOverlap(const BoundingSphere& sphere, std::vector<uint32_t>& results) const {
+        Query([&sphere](const float (&bounds)[6][Width]) { return OverlapChildren(bounds, sphere); },
+              [&sphere](const AABB& bounds) { return sphere.Intersects(bounds); }, results);
+    }
+
+    float BVH::GetCost() const {
+        const float rootArea = HalfArea(GetRootBounds());
+        if (IsEmpty() || rootArea <= 0.0f) {
+            return 0.0f;
+        }
+
+        float cost = 0.0f;
+        for (const Node& node : m_nodes) {
+            AABB nodeBounds = AABB::Empty();
+            for (uint32_t slot = 0; slot < Width; slot++) {
+                if (node.children[slot] == EmptyChild) {
+                    continue;
+                }
+                const AABB bounds = GetChildBounds(node, slot);
+                nodeBounds.Expand(bounds);
+                if (IsLeaf(node.children[slot])) {
+                    cost += GetLeafCount(node.children[slot]) * HalfArea(bounds);
+                }
+            }
+            cost += TraversalCost * HalfArea(nodeBounds);
+        }
+        return cost / (rootArea * GetPrimitiveCount());
+    }
+
+    AABB BVH::GetRootBounds() const {
+        return IsEmpty() ? AABB::Empty() : ComputeChildBounds(0);
+    }
+}
@@ -0,0 +1,115 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace Reality {
+    struct RayHit {
+        uint32_t id = UINT32_MAX;       // Primitive index, UINT32_MAX on a miss
+        float distance = INFINITY;
+    };
+
+    // BVH - bounding volume hierarchy over primitive AABBs, for picking,
+    // visibility and occlusion queries. Built top down with binned SAH splits,
+    // large ranges binned and split across the JobSystem workers. Nodes are
+    // 4 wide with their children's boxes stored as structure of arrays, so one
+    // SSE test covers all four.
+    //
+    // Moving primitives are handled by refitting the boxes above them, which
+    // keeps the tree valid but not optimal. Rebuild when GetCost has grown
+    // well past its value after Build.
+    class BVH {
+    public:
+        // Exact test for a primitive whose box the ray hits. Returns the hit
+        // distance, or a negative value on a miss.
+        using RayTestFunction = std::function<float(uint32_t id, const Ray& ray, float maxDistance)>;
+
+        static constexpr uint32_t Width = 4;
+        static constexpr uint32_t MaxLeafSize = 8;
+
+        BVH() = default;
+
+        // Primitive i is bounds[i]
+        void Build(std::span<const AABB> bounds);
+        void Clear();
+
+        // Moves a primitive. The boxes above it are updated by the next Refit.
+        void SetBounds(uint32_t id, const AABB& bounds);
+        const AABB& GetBounds(uint32_t id) const { return m_primitiveBounds[m_primitiveSlots[id]]; }
+
+        // Updates the nodes above primitives moved since the last Refit,
+        // stopping where a box no longer changes
+        void Refit();
+
+        // Replaces every primitive's bounds and refits the whole tree
+        void Refit(std::span<const AABB> bounds);
+
+        // Closest hit within maxDistance. Without a test function the hit is
+        // where the ray enters the primitive's box.
+        bool Raycast(const Ray& ray, float maxDistance, RayHit& hit, const RayTestFunction& test = nullptr) const;
+
+        // Stops at the first hit within maxDistance, for occlusion
+        bool RaycastAny(const Ray& ray, float maxDistance, const RayTestFunction& test = nullptr) const;
+
+        // Closest hits for coherent rays, traversed four at a time
+        void RaycastPacket(std::span<const Ray> rays, float maxDistance, std::span<RayHit> hits,
+                           const RayTestFunction& test = nullptr) const;
+
+        // Append the ids of primitives whose boxes overlap the volume
+        void QueryOverlap(const AABB& box, std::vector<uint32_t>& results) const;
+        void QueryOverlap(const BoundingSphere& sphere, std::vector<uint32_t>& results) const;
+
+        // Surface area heuristic cost of the current tree, relative to a
+        // single leaf holding every primitive
+        float GetCost() const;
+
+        AABB GetRootBounds() const;
+        uint32_t GetPrimitiveCount() const { return static_cast<uint32_t>(m_primitiveIds.size()); }
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+        uint32_t GetDepth() const { return m_depth; }
+        bool IsEmpty() const { return m_nodes.empty(); }
+
+    private:
+        // Children are node indices, leaf ranges of primitive slots, or empty.
+        // Empty children have inverted boxes that no test can hit.
+        static constexpr uint32_t LeafFlag = 0x80000000u;
+        static constexpr uint32_t EmptyChild = 0xFFFFFFFFu;
+        static constexpr uint32_t LeafCountBits = 3;
+
+        // Two cache lines: the children's boxes, then links
+        struct alignas(64) Node {
+            float bounds[6][Width];                     // Rows min x, y, z, then max x, y, z
+            uint32_t children[Width];
+            uint32_t parent;
+            uint32_t parentSlot;
+        };
+
+        static bool IsLeaf(uint32_t child) { return child != EmptyChild && (child & LeafFlag) != 0; }
+        static uint32_t GetLeafBegin(uint32_t child) { return (child & ~LeafFlag) >> LeafCountBits; }
+        static uint32_t GetLeafCount(uint32_t child) { return (child & ((1u << LeafCountBits) - 1)) + 1; }
+        static uint32_t MakeLeaf(uint32_t begin, uint32_t count) {
+            return LeafFlag | (begin << LeafCountBits) | (count - 1);
+        }
+
+        struct BuildRange;
+        class Builder;
+
+        template<typename ChildTest, typename PrimitiveTest>
+        void Query(const ChildTest& childTest, const PrimitiveTest& primitiveTest, std::vector<uint32_t>& results) const;
+
+        static void SetChildBounds(Node& node, uint32_t slot, const AABB& bounds);
+        static AABB GetChildBounds(const Node& node, uint32_t slot);
+        AABB ComputeChildBounds(uint32_t child) const;
+        AABB RefitNode(uint32_t index);
+
+        std::vector<Node> m_nodes;                      // Parents precede their children
+        std::vector<AABB> m_primitiveBounds;            // In leaf order
+        std::vector<uint32_t> m_primitiveIds;           // Slot to primitive
+        std::vector<uint32_t> m_primitiveSlots;         // Primitive to slot
+        std::vector<uint32_t> m_primitiveNodes;         // Slot to the node holding its leaf
+        std::vector<uint32_t> m_dirtyNodes;
+        std::vector<uint8_t> m_dirtyFlags;
+        uint32_t m_depth = 0;
+    };
+}
@@ -0,0 +1,222 @@
+﻿#include "LooseOctree.h"
+#include <functional>
+
+namespace Reality {
+    namespace {
+        uint32_t GetOctant(const Vector3& nodeCenter, const Vector3& point) {
+            return (point.x >= nodeCenter.x ? 1u : 0u) | (point.y >= nodeCenter.y ? 2u : 0u) |
+                   (point.z >= nodeCenter.z ? 4u : 0u);
+        }
+
+        bool Encloses(const AABB& outer, const AABB& inner) {
+            return inner.min.x >= outer.min.x && inner.min.y >= outer.min.y && inner.min.z >= outer.min.z &&
+                   inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+        }
+    }
+
+    bool LooseOctree::Initialize(const AABB& worldBounds, uint32_t maxDepth) {
+        if (!worldBounds.IsValid() || maxDepth > MaxDepth) {
+            return false;
+        }
+
+        const Vector3 extents = worldBounds.Extents();
+        m_rootCenter = worldBounds.Center();
+        m_rootHalfSize = Max(Max(extents.x, extents.y), Max(extents.z, EPSILON));
+        m_maxDepth = maxDepth;
+        Clear();
+        return true;
+    }
+
+    void LooseOctree::Clear() {
+        ClearItems();
+        m_nodes.clear();
+        m_freeNodes.clear();
+        m_nodes.emplace_back();
+        m_nodes[0].center = m_rootCenter;
+        m_nodes[0].halfSize = m_rootHalfSize;
+    }
+
+    bool LooseOctree::Fits(const Node& node, const AABB& bounds) const {
+        if (node.depth >= m_maxDepth) {
+            return true;
+        }
+
+        const float childHalfSize = node.halfSize * 0.5f;
+        const Vector3 extents = bounds.Extents();
+        if (Max(Max(extents.x, extents.y), extents.z) > childHalfSize) {
+            return true;
+        }
+
+        // The child holding the center has to enclose the object in its loose bounds
+        const Vector3 center = bounds.Center();
+        const Vector3 childCenter = node.center + Vector3(center.x >= node.center.x ? childHalfSize : -childHalfSize,
+                                                          center.y >= node.center.y ? childHalfSize : -childHalfSize,
+                                                          center.z >= node.center.z ? childHalfSize : -childHalfSize);
+        return Abs(center.x - childCenter.x) + extents.x > node.halfSize ||
+               Abs(center.y - childCenter.y) + extents.y > node.halfSize ||
+               Abs(center.z - childCenter.z) + extents.z > node.halfSize;
+    }
+
+    uint32_t LooseOctree::CreateNode(uint32_t parent, uint32_t octant) {
+        uint32_t index;
+        if (!m_freeNodes.empty()) {
+            index = m_freeNodes.back();
+            m_freeNodes.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        Node& parentNode = m_nodes[parent];
+        Node& node = m_nodes[index];
+        const float halfSize = parentNode.halfSize * 0.5f;
+        node.center = parentNode.center + Vector3((octant & 1) ? halfSize : -halfSize,
+                                                  (octant & 2) ? halfSize : -halfSize,
+                                                  (octant & 4) ? halfSize : -halfSize);
+        node.halfSize = halfSize;
+        node.depth = parentNode.depth + 1;
+        node.parent = parent;
+        node.octant = octant;
+        std::fill(std::begin(node.children), std::end(node.children), NoNode);
+        node.childCount = 0;
+
+        parentNode.children[octant] = index;
+        parentNode.childCount++;
+        return index;
+    }
+
+    uint32_t LooseOctree::FindOrCreateNode(const AABB& bounds) {
+        const Vector3 center = bounds.Center();
+        uint32_t index = 0;
+        while (!Fits(m_nodes[index], bounds)) {
+            const uint32_t octant = GetOctant(m_nodes[index].center, center);
+            const uint32_t child = m_nodes[index].children[octant];
+            index = child != NoNode ? child : CreateNode(index, octant);
+        }
+        return index;
+    }
+
+    void LooseOctree::ReleaseEmptyNodes(uint32_t index) {
+        while (index != 0 && m_nodes[index].entries.empty() && m_nodes[index].childCount == 0) {
+            Node& node = m_nodes[index];
+            Node& parent = m_nodes[node.parent];
+            parent.children[node.octant] = NoNode;
+            parent.childCount--;
+            m_freeNodes.push_back(index);
+            index = node.parent;
+        }
+    }
+
+    SpatialHandle LooseOctree::Insert(const AABB& bounds) {
+        assert(!m_nodes.empty() && "LooseOctree is not initialized");
+        const SpatialHandle handle = AllocateHandle(bounds);
+        const uint32_t index = FindOrCreateNode(bounds);
+        AddEntry(m_nodes[index].entries, index, handle);
+        return handle;
+    }
+
+    void LooseOctree::Move(SpatialHandle handle, const AABB& bounds) {
+        assert(IsValid(handle));
+        Item& item = m_items[handle];
+        item.bounds = bounds;
+
+        // Stays put while it is still enclosed and not small enough for a child
+        const uint32_t previous = item.container;
+        Node& node = m_nodes[previous];
+        if ((previous == 0 || Encloses(node.GetLooseBounds(), bounds)) && Fits(node, bounds)) {
+            node.entries[item.slot].bounds = bounds;
+            return;
+        }
+
+        RemoveEntry(node.entries, handle);
+        const uint32_t index = FindOrCreateNode(bounds);
+        AddEntry(m_nodes[index].entries, index, handle);
+        ReleaseEmptyNodes(previous);
+    }
+
+    void LooseOctree::Remove(SpatialHandle handle) {
+        assert(IsValid(handle));
+        const uint32_t index = m_items[handle].container;
+        RemoveEntry(m_nodes[index].entries, handle);
+        FreeHandle(handle);
+        ReleaseEmptyNodes(index);
+    }
+
+    template<typename Test>
+    void LooseOctree::Query(const AABB& region, const Test& test, std::vector<SpatialHandle>& results) const {
+        if (m_nodes.empty()) {
+            return;
+        }
+
+        // The root is always visited, it also holds objects outside the world bounds
+        uint32_t stack[MaxDepth * 7 + 1];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const Node& node = m_nodes[stack[--stackSize]];
+            for (const Entry& entry : node.entries) {
+                if (test(entry.bounds)) {
+                    results.push_back(entry.handle);
+                }
+            }
+            if (node.childCount == 0) {
+                continue;
+            }
+            for (const uint32_t child : node.children) {
+                if (child != NoNode && m_nodes[child].GetLooseBounds().Intersects(region)) {
+                    stack[stackSize++] = child;
+                }
+            }
+        }
+    }
+
+    void LooseOctree::QuerySphere(const BoundingSphere& sphere, std::vector<SpatialHandle>& results) const {
+        const Vector3 extents(sphere.radius, sphere.radius, sphere.radius);
+        Query(AABB::FromCenterExtents(sphere.center, extents),
+              [&sphere](const AABB& bounds) { return sphere.Intersects(bounds); }, results);
+    }
+
+    void LooseOctree::QueryAABB(const AABB& box, std::vector<SpatialHandle>& results) const {
+        Query(box, [&box](const AABB& bounds) { return box.Intersects(bounds); }, results);
+    }
+
+    void LooseOctree::QueryNearest(const Vector3& point, uint32_t k, std::vector<SpatialHandle>& results,
+                                   float maxDistance) const {
+        NearestSet nearest(k, maxDistance);
+        if (m_nodes.empty()) {
+            nearest.Extract(results);
+            return;
+        }
+
+        // Best first: nodes in order of their distance, until none can beat the kth object
+        using Candidate = std::pair<float, uint32_t>;
+        std::vector<Candidate> queue = { { 0.0f, 0 } };
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<Candidate>());
+            const Candidate candidate = queue.back();
+            queue.pop_back();
+            if (candidate.first > nearest.GetLimit()) {
+                break;
+            }
+
+            const Node& node = m_nodes[candidate.second];
+            for (const Entry& entry : node.entries) {
+                nearest.Add(DistanceSquared(entry.bounds, point), entry.handle);
+            }
+            if (node.childCount == 0) {
+                continue;
+            }
+            for (const uint32_t child : node.children) {
+                if (child == NoNode) {
+                    continue;
+                }
+                const float distanceSquared = DistanceSquared(m_nodes[child].GetLooseBounds(), point);
+                if (distanceSquared <= nearest.GetLimit()) {
+                    queue.emplace_back(distanceSquared, child);
+                    std::push_heap(queue.begin(), queue.end(), std::greater<Candidate>());
+                }
+            }
+        }
+        nearest.Extract(results);
+    }
+}
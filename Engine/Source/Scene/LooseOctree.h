@@ -0,0 +1,66 @@
+﻿#pragma once
+#include "SpatialIndex.h"
+
+namespace Reality {
+    // LooseOctree - every node's bounds are twice its cell, so an object is
+    // stored in the deepest node whose cell is at least as large as the
+    // object and contains its center. Nodes are created on demand and freed
+    // when empty, so insertion and removal cost at most MaxDepth steps.
+    // Suits objects of widely varying sizes.
+    class LooseOctree final : public SpatialIndex {
+    public:
+        static constexpr uint32_t MaxDepth = 16;
+
+        LooseOctree() = default;
+
+        // Objects outside worldBounds still work but all end up in the root.
+        // Fails on an invalid box or a depth over MaxDepth.
+        bool Initialize(const AABB& worldBounds, uint32_t maxDepth = 8);
+
+        SpatialHandle Insert(const AABB& bounds) override;
+        void Move(SpatialHandle handle, const AABB& bounds) override;
+        void Remove(SpatialHandle handle) override;
+        void Clear() override;
+
+        void QuerySphere(const BoundingSphere& sphere, std::vector<SpatialHandle>& results) const override;
+        void QueryAABB(const AABB& box, std::vector<SpatialHandle>& results) const override;
+        void QueryNearest(const Vector3& point, uint32_t k, std::vector<SpatialHandle>& results,
+                          float maxDistance = INFINITY) const override;
+
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size() - m_freeNodes.size()); }
+
+    private:
+        static constexpr uint32_t NoNode = UINT32_MAX;
+
+        struct Node {
+            Vector3 center = Vector3::Zero();
+            float halfSize = 0.0f;                      // Of the cell, the loose bounds extend twice as far
+            uint32_t depth = 0;
+            uint32_t parent = NoNode;
+            uint32_t octant = 0;                        // Index in the parent's children
+            uint32_t children[8] = { NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, NoNode };
+            uint32_t childCount = 0;
+            std::vector<Entry> entries;
+
+            AABB GetLooseBounds() const {
+                const Vector3 extents(halfSize * 2.0f, halfSize * 2.0f, halfSize * 2.0f);
+                return AABB::FromCenterExtents(center, extents);
+            }
+        };
+
+        // Whether the object belongs in this node rather than one of its children
+        bool Fits(const Node& node, const AABB& bounds) const;
+        uint32_t FindOrCreateNode(const AABB& bounds);
+        uint32_t CreateNode(uint32_t parent, uint32_t octant);
+        void ReleaseEmptyNodes(uint32_t index);
+
+        template<typename Test>
+        void Query(const AABB& region, const Test& test, std::vector<SpatialHandle>& results) const;
+
+        std::vector<Node> m_nodes;                      // Root at 0
+        std::vector<uint32_t> m_freeNodes;
+        uint32_t m_maxDepth = 0;
+        Vector3 m_rootCenter = Vector3::Zero();
+        float m_rootHalfSize = 0.0f;
+    };
+}
@@ -0,0 +1,251 @@
+﻿#include "SpatialHashGrid.h"
+#include <cstdlib>
+
+namespace Reality {
+    namespace {
+        // Cell coordinates are packed into 21 bits per axis
+        constexpr int32_t CoordLimit = (1 << 20) - 1;
+
+        int32_t ToCoord(float value) {
+            return static_cast<int32_t>(Clamp(std::floor(value), static_cast<float>(-CoordLimit), static_cast<float>(CoordLimit)));
+        }
+    }
+
+    bool SpatialHashGrid::Initialize(float cellSize) {
+        if (!(cellSize > 0.0f)) {
+            return false;
+        }
+
+        m_cellSize = cellSize;
+        m_inverseCellSize = 1.0f / cellSize;
+        Clear();
+        return true;
+    }
+
+    void SpatialHashGrid::Clear() {
+        ClearItems();
+        m_cellMap.clear();
+        m_cells.clear();
+        m_freeCells.clear();
+        m_largeEntries.clear();
+    }
+
+    SpatialHashGrid::CellCoord SpatialHashGrid::GetCellCoord(const Vector3& point) const {
+        return { ToCoord(point.x * m_inverseCellSize), ToCoord(point.y * m_inverseCellSize), ToCoord(point.z * m_inverseCellSize) };
+    }
+
+    uint64_t SpatialHashGrid::GetCellKey(const CellCoord& coord) {
+        const auto pack = [](int32_t value) { return static_cast<uint64_t>(value + CoordLimit + 1) & 0x1FFFFF; };
+        return pack(coord.x) | (pack(coord.y) << 21) | (pack(coord.z) << 42);
+    }
+
+    bool SpatialHashGrid::IsLarge(const AABB& bounds) const {
+        const Vector3 extents = bounds.Extents();
+        return Max(Max(extents.x, extents.y), extents.z) > m_cellSize * 0.5f;
+    }
+
+    const SpatialHashGrid::Cell* SpatialHashGrid::FindCell(const CellCoord& coord) const {
+        if (std::abs(coord.x) > CoordLimit || std::abs(coord.y) > CoordLimit || std::abs(coord.z) > CoordLimit) {
+            return nullptr;
+        }
+        const auto it = m_cellMap.find(GetCellKey(coord));
+        return it != m_cellMap.end() ? &m_cells[it->second] : nullptr;
+    }
+
+    uint32_t SpatialHashGrid::FindOrCreateCell(const CellCoord& coord) {
+        const auto [it, inserted] = m_cellMap.try_emplace(GetCellKey(coord), 0);
+        if (!inserted) {
+            return it->second;
+        }
+
+        if (!m_freeCells.empty()) {
+            it->second = m_freeCells.back();
+            m_freeCells.pop_back();
+        } else {
+            it->second = static_cast<uint32_t>(m_cells.size());
+            m_cells.emplace_back();
+        }
+        m_cells[it->second].coord = coord;
+        return it->second;
+    }
+
+    void SpatialHashGrid::AddToContainer(SpatialHandle handle) {
+        const AABB& bounds = m_items[handle].bounds;
+        if (IsLarge(bounds)) {
+            AddEntry(m_largeEntries, LargeObjects, handle);
+            return;
+        }
+        const uint32_t index = FindOrCreateCell(GetCellCoord(bounds.Center()));
+        AddEntry(m_cells[index].entries, index, handle);
+    }
+
+    void SpatialHashGrid::RemoveFromContainer(SpatialHandle handle) {
+        const uint32_t container = m_items[handle].container;
+        if (container == LargeObjects) {
+            RemoveEntry(m_largeEntries, handle);
+            return;
+        }
+
+        // Empty cells go back to the free list
+        Cell& cell = m_cells[container];
+        RemoveEntry(cell.entries, handle);
+        if (cell.entries.empty()) {
+            m_cellMap.erase(GetCellKey(cell.coord));
+            m_freeCells.push_back(container);
+        }
+    }
+
+    SpatialHandle SpatialHashGrid::Insert(const AABB& bounds) {
+        assert(m_cellSize > 0.0f && "SpatialHashGrid is not initialized");
+        const SpatialHandle handle = AllocateHandle(bounds);
+        AddToContainer(handle);
+        return handle;
+    }
+
+    void SpatialHashGrid::Move(SpatialHandle handle, const AABB& bounds) {
+        assert(IsValid(handle));
+        Item& item = m_items[handle];
+        item.bounds = bounds;
+
+        // Updated in place while it stays in the same cell
+        const bool large = IsLarge(bounds);
+        if (large && item.container == LargeObjects) {
+            m_largeEntries[item.slot].bounds = bounds;
+            return;
+        }
+        if (!large && item.container != LargeObjects) {
+            const CellCoord coord = GetCellCoord(bounds.Center());
+            Cell& cell = m_cells[item.container];
+            if (coord.x == cell.coord.x && coord.y == cell.coord.y && coord.z == cell.coord.z) {
+                cell.entries[item.slot].bounds = bounds;
+                return;
+            }
+        }
+
+        RemoveFromContainer(handle);
+        AddToContainer(handle);
+    }
+
+    void SpatialHashGrid::Remove(SpatialHandle handle) {
+        assert(IsValid(handle));
+        RemoveFromContainer(handle);
+        FreeHandle(handle);
+    }
+
+    template<typename Test>
+    void SpatialHashGrid::Query(const AABB& region, const Test& test, std::vector<SpatialHandle>& results) const {
+        for (const Entry& entry : m_largeEntries) {
+            if (test(entry.bounds)) {
+                results.push_back(entry.handle);
+            }
+        }
+        if (m_cellMap.empty()) {
+            return;
+        }
+
+        const Vector3 reach(m_cellSize * 0.5f, m_cellSize * 0.5f, m_cellSize * 0.5f);
+        const CellCoord first = GetCellCoord(region.min - reach);
+        const CellCoord last = GetCellCoord(region.max + reach);
+        const auto testCell = [&](const Cell& cell) {
+            for (const Entry& entry : cell.entries) {
+                if (test(entry.bounds)) {
+                    results.push_back(entry.handle);
+                }
+            }
+        };
+
+        // Large regions scan the allocated cells instead of looking up every one in range
+        const double rangeSize = (static_cast<double>(last.x) - first.x + 1) * (static_cast<double>(last.y) - first.y + 1) *
+                                 (static_cast<double>(last.z) - first.z + 1);
+        if (rangeSize > static_cast<double>(m_cellMap.size())) {
+            for (const Cell& cell : m_cells) {
+                if (!cell.entries.empty() && cell.coord.x >= first.x && cell.coord.x <= last.x &&
+                    cell.coord.y >= first.y && cell.coord.y <= last.y && cell.coord.z >= first.z && cell.coord.z <= last.z) {
+                    testCell(cell);
+                }
+            }
+            return;
+        }
+
+        for (int32_t z = first.z; z <= last.z; z++) {
+            for (int32_t y = first.y; y <= last.y; y++) {
+                for (int32_t x = first.x; x <= last.x; x++) {
+                    if (const Cell* cell = FindCell({ x, y, z })) {
+                        testCell(*cell);
+                    }
+                }
+            }
+        }
+    }
+
+    void SpatialHashGrid::QuerySphere(const BoundingSphere& sphere, std::vector<SpatialHandle>& results) const {
+        const Vector3 extents(sphere.radius, sphere.radius, sphere.radius);
+        Query(AABB::FromCenterExtents(sphere.center, extents),
+              [&sphere](const AABB& bounds) { return sphere.Intersects(bounds); }, results);
+    }
+
+    void SpatialHashGrid::QueryAABB(const AABB& box, std::vector<SpatialHandle>& results) const {
+        Query(box, [&box](const AABB& bounds) { return box.Intersects(bounds); }, results);
+    }
+
+    void SpatialHashGrid::QueryNearest(const Vector3& point, uint32_t k, std::vector<SpatialHandle>& results,
+                                       float maxDistance) const {
+        NearestSet nearest(k, maxDistance);
+        for (const Entry& entry : m_largeEntries) {
+            nearest.Add(DistanceSquared(entry.bounds, point), entry.handle);
+        }
+
+        const auto addCell = [&](const Cell& cell) {
+            for (const Entry& entry : cell.entries) {
+                nearest.Add(DistanceSquared(entry.bounds, point), entry.handle);
+            }
+        };
+
+        // Rings of cells around the point's own, until no unvisited cell can
+        // hold an object closer than the kth found so far
+        const CellCoord origin = GetCellCoord(point);
+        const Vector3 cellMin(origin.x * m_cellSize, origin.y * m_cellSize, origin.z * m_cellSize);
+        const Vector3 toMin = point - cellMin;
+        const float faceDistance = Max(Min(Min(Min(toMin.x, toMin.y), toMin.z),
+                                           m_cellSize - Max(Max(toMin.x, toMin.y), toMin.z)), 0.0f);
+        const size_t cellCount = m_cellMap.size();
+        size_t visitedCount = 0;
+        for (int32_t ring = 0; k > 0 && visitedCount < cellCount; ring++) {
+            if (ring > 0) {
+                // Objects reach up to half a cell out of the cell holding their center
+                const float bound = (ring - 1) * m_cellSize + faceDistance - m_cellSize * 0.5f;
+                if (bound > 0.0f && bound * bound > nearest.GetLimit()) {
+                    break;
+                }
+            }
+
+            // Once a ring has more cells than are allocated, scan the rest directly
+            const double side = 2.0 * ring + 1.0;
+            if (ring > 0 && side * side * side - (side - 2.0) * (side - 2.0) * (side - 2.0) > static_cast<double>(cellCount)) {
+                for (const Cell& cell : m_cells) {
+                    const int32_t distance = std::max({ std::abs(cell.coord.x - origin.x), std::abs(cell.coord.y - origin.y),
+                                                        std::abs(cell.coord.z - origin.z) });
+                    if (!cell.entries.empty() && distance >= ring) {
+                        addCell(cell);
+                    }
+                }
+                break;
+            }
+
+            for (int32_t dz = -ring; dz <= ring; dz++) {
+                for (int32_t dy = -ring; dy <= ring; dy++) {
+                    // Inside the shell only the two x faces are new
+                    const bool onFace = std::abs(dz) == ring || std::abs(dy) == ring;
+                    const int32_t step = onFace ? 1 : 2 * ring;
+                    for (int32_t dx = -ring; dx <= ring; dx += step) {
+                        if (const Cell* cell = FindCell({ origin.x + dx, origin.y + dy, origin.z + dz })) {
+                            addCell(*cell);
+                            visitedCount++;
+                        }
+                    }
+                }
+            }
+        }
+        nearest.Extract(results);
+    }
+}
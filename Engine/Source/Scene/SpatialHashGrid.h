@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "SpatialIndex.h"
+#include <unordered_map>
+
+namespace Reality {
+    // SpatialHashGrid - unbounded uniform grid, objects stored in the cell
+    // holding their center and cells allocated only where objects are.
+    // Queries widen their range by half a cell to catch objects that reach
+    // into it. Objects larger than a cell go to a list every query scans, so
+    // pick a cell size around twice the typical object size. Suits many
+    // similar sized objects, such as agents.
+    class SpatialHashGrid final : public SpatialIndex {
+    public:
+        SpatialHashGrid() = default;
+
+        // Fails on a cell size that is not positive
+        bool Initialize(float cellSize);
+
+        SpatialHandle Insert(const AABB& bounds) override;
+        void Move(SpatialHandle handle, const AABB& bounds) override;
+        void Remove(SpatialHandle handle) override;
+        void Clear() override;
+
+        void QuerySphere(const BoundingSphere& sphere, std::vector<SpatialHandle>& results) const override;
+        void QueryAABB(const AABB& box, std::vector<SpatialHandle>& results) const override;
+        void QueryNearest(const Vector3& point, uint32_t k, std::vector<SpatialHandle>& results,
+                          float maxDistance = INFINITY) const override;
+
+        float GetCellSize() const { return m_cellSize; }
+        uint32_t GetCellCount() const { return static_cast<uint32_t>(m_cellMap.size()); }
+
+    private:
+        // Container index of the large object list
+        static constexpr uint32_t LargeObjects = UINT32_MAX;
+
+        struct CellCoord {
+            int32_t x = 0;
+            int32_t y = 0;
+            int32_t z = 0;
+        };
+
+        struct Cell {
+            CellCoord coord;
+            std::vector<Entry> entries;
+        };
+
+        CellCoord GetCellCoord(const Vector3& point) const;
+        static uint64_t GetCellKey(const CellCoord& coord);
+        bool IsLarge(const AABB& bounds) const;
+        const Cell* FindCell(const CellCoord& coord) const;
+        uint32_t FindOrCreateCell(const CellCoord& coord);
+        void AddToContainer(SpatialHandle handle);
+        void RemoveFromContainer(SpatialHandle handle);
+
+        template<typename Test>
+        void Query(const AABB& region, const Test& test, std::vector<SpatialHandle>& results) const;
+
+        float m_cellSize = 0.0f;
+        float m_inverseCellSize = 0.0f;
+        std::unordered_map<uint64_t, uint32_t> m_cellMap;
+        std::vector<Cell> m_cells;
+        std::vector<uint32_t> m_freeCells;
+        std::vector<Entry> m_largeEntries;
+    };
+}
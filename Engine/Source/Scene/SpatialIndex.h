@@ -0,0 +1,139 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <algorithm>
+#include <vector>
+
+namespace Reality {
+    using SpatialHandle = uint32_t;
+    constexpr SpatialHandle InvalidSpatialHandle = UINT32_MAX;
+
+    // SpatialIndex - dynamic broad phase over object bounds, implemented by
+    // LooseOctree and SpatialHashGrid. Insert, Move and Remove are O(1)
+    // amortized. Queries only read, so any number of them may run on worker
+    // threads at once, as long as nothing is inserted, moved or removed
+    // meanwhile.
+    class SpatialIndex {
+    public:
+        virtual ~SpatialIndex() = default;
+
+        virtual SpatialHandle Insert(const AABB& bounds) = 0;
+        virtual void Move(SpatialHandle handle, const AABB& bounds) = 0;
+        virtual void Remove(SpatialHandle handle) = 0;
+        virtual void Clear() = 0;
+
+        // Append the handles of objects whose bounds overlap the volume
+        virtual void QuerySphere(const BoundingSphere& sphere, std::vector<SpatialHandle>& results) const = 0;
+        virtual void QueryAABB(const AABB& box, std::vector<SpatialHandle>& results) const = 0;
+
+        // Replaces results with the k objects nearest to the point, nearest
+        // first. Distances are to the object bounds, zero inside them.
+        virtual void QueryNearest(const Vector3& point, uint32_t k, std::vector<SpatialHandle>& results,
+                                  float maxDistance = INFINITY) const = 0;
+
+        const AABB& GetBounds(SpatialHandle handle) const { return m_items[handle].bounds; }
+        uint32_t GetCount() const { return static_cast<uint32_t>(m_items.size() - m_freeHandles.size()); }
+        bool IsValid(SpatialHandle handle) const { return handle < m_items.size() && m_items[handle].alive; }
+
+    protected:
+        // Objects are stored by value in their container so queries scan memory
+        // in order. Items map handles back to them.
+        struct Entry {
+            AABB bounds;
+            SpatialHandle handle;
+        };
+
+        struct Item {
+            AABB bounds;
+            uint32_t container = 0;
+            uint32_t slot = 0;
+            bool alive = false;
+        };
+
+        // The k nearest candidates seen so far, as a max-heap on distance
+        class NearestSet {
+        public:
+            NearestSet(uint32_t k, float maxDistance) : m_k(k), m_limit(maxDistance * maxDistance) {
+                m_heap.reserve(k);
+            }
+
+            // Squared distance a candidate has to beat
+            float GetLimit() const { return m_limit; }
+
+            void Add(float distanceSquared, SpatialHandle handle) {
+                if (distanceSquared > m_limit || m_k == 0) {
+                    return;
+                }
+                if (m_heap.size() == m_k) {
+                    std::pop_heap(m_heap.begin(), m_heap.end());
+                    m_heap.pop_back();
+                }
+                m_heap.emplace_back(distanceSquared, handle);
+                std::push_heap(m_heap.begin(), m_heap.end());
+                if (m_heap.size() == m_k) {
+                    m_limit = m_heap.front().first;
+                }
+            }
+
+            void Extract(std::vector<SpatialHandle>& results) {
+                std::sort_heap(m_heap.begin(), m_heap.end());
+                results.clear();
+                for (const auto& candidate : m_heap) {
+                    results.push_back(candidate.second);
+                }
+            }
+
+        private:
+            std::vector<std::pair<float, SpatialHandle>> m_heap;
+            uint32_t m_k;
+            float m_limit;
+        };
+
+        static float DistanceSquared(const AABB& box, const Vector3& point) {
+            const Vector3 closest = Vector3::Min(Vector3::Max(point, box.min), box.max);
+            return (closest - point).LengthSquared();
+        }
+
+        SpatialHandle AllocateHandle(const AABB& bounds) {
+            SpatialHandle handle;
+            if (!m_freeHandles.empty()) {
+                handle = m_freeHandles.back();
+                m_freeHandles.pop_back();
+            } else {
+                handle = static_cast<SpatialHandle>(m_items.size());
+                m_items.emplace_back();
+            }
+            m_items[handle].bounds = bounds;
+            m_items[handle].alive = true;
+            return handle;
+        }
+
+        void FreeHandle(SpatialHandle handle) {
+            m_items[handle].alive = false;
+            m_freeHandles.push_back(handle);
+        }
+
+        // Adds the object to a container and records where it went
+        void AddEntry(std::vector<Entry>& entries, uint32_t container, SpatialHandle handle) {
+            Item& item = m_items[handle];
+            item.container = container;
+            item.slot = static_cast<uint32_t>(entries.size());
+            entries.push_back({ item.bounds, handle });
+        }
+
+        // Swaps the last entry into the removed one's slot
+        void RemoveEntry(std::vector<Entry>& entries, SpatialHandle handle) {
+            const uint32_t slot = m_items[handle].slot;
+            entries[slot] = entries.back();
+            m_items[entries[slot].handle].slot = slot;
+            entries.pop_back();
+        }
+
+        void ClearItems() {
+            m_items.clear();
+            m_freeHandles.clear();
+        }
+
+        std::vector<Item> m_items;
+        std::vector<SpatialHandle> m_freeHandles;
+    };
+}
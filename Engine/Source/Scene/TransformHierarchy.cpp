@@ -0,0 +1,285 @@
+﻿#include "TransformHierarchy.h"
+#include <Core/JobSystem.h>
+#include <algorithm>
+
+namespace Reality {
+    namespace {
+        constexpr uint32_t NoParent = UINT32_MAX;
+
+        template<typename T>
+        void Permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+            // Appended rather than sized up front, which would clear it first
+            std::vector<T> sorted;
+            sorted.reserve(order.size());
+            for (const uint32_t index : order) {
+                sorted.push_back(values[index]);
+            }
+            values.swap(sorted);
+        }
+    }
+
+    TransformHandle TransformHierarchy::Create(const Transform& local, TransformHandle parent) {
+        assert((parent == InvalidTransformHandle || IsValid(parent)) && "Invalid parent transform");
+
+        TransformHandle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        } else {
+            handle = static_cast<TransformHandle>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        // Appended unsorted, Update sorts it into its level
+        Node& node = m_nodes[handle];
+        node = Node();
+        node.alive = true;
+        node.index = static_cast<uint32_t>(m_handles.size());
+        m_translations.push_back(local.translation);
+        m_rotations.push_back(local.rotation);
+        m_scales.push_back(local.scale);
+        m_worlds.push_back(Matrix4x4::Identity());
+        m_parents.push_back(NoParent);
+        m_firstChildren.push_back(0);
+        m_childCounts.push_back(0);
+        m_levels.push_back(0);
+        m_handles.push_back(handle);
+
+        if (parent != InvalidTransformHandle) {
+            Link(handle, parent);
+        }
+        MarkDirty(handle);
+        m_structureChanged = true;
+        return handle;
+    }
+
+    void TransformHierarchy::Destroy(TransformHandle handle) {
+        assert(IsValid(handle));
+        Unlink(handle);
+
+        // Sorted slots are released by the next Update
+        std::vector<TransformHandle> stack = { handle };
+        while (!stack.empty()) {
+            const TransformHandle current = stack.back();
+            stack.pop_back();
+            for (TransformHandle child = m_nodes[current].firstChild; child != InvalidTransformHandle;
+                 child = m_nodes[child].nextSibling) {
+                stack.push_back(child);
+            }
+            m_nodes[current].alive = false;
+            m_freeHandles.push_back(current);
+        }
+        m_structureChanged = true;
+    }
+
+    void TransformHierarchy::SetParent(TransformHandle handle, TransformHandle parent) {
+        assert(IsValid(handle) && (parent == InvalidTransformHandle || IsValid(parent)));
+        for (TransformHandle ancestor = parent; ancestor != InvalidTransformHandle; ancestor = m_nodes[ancestor].parent) {
+            assert(ancestor != handle && "A transform cannot be parented to its own descendant");
+        }
+
+        Unlink(handle);
+        if (parent != InvalidTransformHandle) {
+            Link(handle, parent);
+        }
+        MarkDirty(handle);
+        m_structureChanged = true;
+    }
+
+    void TransformHierarchy::SetLocal(TransformHandle handle, const Transform& local) {
+        assert(IsValid(handle));
+        const uint32_t index = m_nodes[handle].index;
+        m_translations[index] = local.translation;
+        m_rotations[index] = local.rotation;
+        m_scales[index] = local.scale;
+        MarkDirty(handle);
+    }
+
+    void TransformHierarchy::SetTranslation(TransformHandle handle, const Vector3& translation) {
+        assert(IsValid(handle));
+        m_translations[m_nodes[handle].index] = translation;
+        MarkDirty(handle);
+    }
+
+    void TransformHierarchy::SetRotation(TransformHandle handle, const Quaternion& rotation) {
+        assert(IsValid(handle));
+        m_rotations[m_nodes[handle].index] = rotation;
+        MarkDirty(handle);
+    }
+
+    void TransformHierarchy::SetScale(TransformHandle handle, const Vector3& scale) {
+        assert(IsValid(handle));
+        m_scales[m_nodes[handle].index] = scale;
+        MarkDirty(handle);
+    }
+
+    Transform TransformHierarchy::GetLocal(TransformHandle handle) const {
+        assert(IsValid(handle));
+        const uint32_t index = m_nodes[handle].index;
+        return Transform(m_translations[index], m_rotations[index], m_scales[index]);
+    }
+
+    void TransformHierarchy::MarkDirty(TransformHandle handle) {
+        Node& node = m_nodes[handle];
+        if (!node.dirty) {
+            node.dirty = true;
+            m_dirtyHandles.push_back(handle);
+        }
+    }
+
+    void TransformHierarchy::Link(TransformHandle handle, TransformHandle parent) {
+        Node& node = m_nodes[handle];
+        node.parent = parent;
+        node.nextSibling = m_nodes[parent].firstChild;
+        m_nodes[parent].firstChild = handle;
+    }
+
+    void TransformHierarchy::Unlink(TransformHandle handle) {
+        Node& node = m_nodes[handle];
+        if (node.parent == InvalidTransformHandle) {
+            return;
+        }
+
+        TransformHandle* link = &m_nodes[node.parent].firstChild;
+        while (*link != handle) {
+            link = &m_nodes[*link].nextSibling;
+        }
+        *link = node.nextSibling;
+        node.parent = InvalidTransformHandle;
+        node.nextSibling = InvalidTransformHandle;
+    }
+
+    void TransformHierarchy::Sort() {
+        // Breadth first walk, roots in their previous order. order[k] is the
+        // current slot of the node that moves to slot k.
+        const uint32_t slotCount = static_cast<uint32_t>(m_handles.size());
+        std::vector<uint32_t> order;
+        order.reserve(GetCount());
+        for (uint32_t slot = 0; slot < slotCount; slot++) {
+            const Node& node = m_nodes[m_handles[slot]];
+            // Slots of destroyed nodes, including handles reused since, are dropped
+            if (node.alive && node.index == slot && node.parent == InvalidTransformHandle) {
+                order.push_back(slot);
+            }
+        }
+
+        std::vector<uint32_t> levels(order.size(), 0);
+        std::vector<uint32_t> parents(order.size(), NoParent);
+        m_firstChildren.assign(GetCount(), 0);
+        m_childCounts.assign(GetCount(), 0);
+        for (uint32_t k = 0; k < order.size(); k++) {
+            const TransformHandle handle = m_handles[order[k]];
+            m_firstChildren[k] = static_cast<uint32_t>(order.size());
+            for (TransformHandle child = m_nodes[handle].firstChild; child != InvalidTransformHandle;
+                 child = m_nodes[child].nextSibling) {
+                order.push_back(m_nodes[child].index);
+                levels.push_back(levels[k] + 1);
+                parents.push_back(k);
+            }
+            m_childCounts[k] = static_cast<uint32_t>(order.size()) - m_firstChildren[k];
+        }
+
+        Permute(m_translations, order);
+        Permute(m_rotations, order);
+        Permute(m_scales, order);
+        Permute(m_worlds, order);
+        Permute(m_handles, order);
+        m_parents.swap(parents);
+        m_levels.swap(levels);
+        for (uint32_t k = 0; k < order.size(); k++) {
+            m_nodes[m_handles[k]].index = k;
+        }
+
+        m_levelStarts.clear();
+        for (uint32_t k = 0; k < order.size(); k++) {
+            if (k == 0 || m_levels[k] != m_levels[k - 1]) {
+                m_levelStarts.push_back(k);
+            }
+        }
+        m_levelStarts.push_back(static_cast<uint32_t>(order.size()));
+
+        m_queued.assign(order.size(), 0);
+        m_structureChanged = false;
+    }
+
+    void TransformHierarchy::Update(uint32_t grainSize) {
+        if (m_structureChanged) {
+            Sort();
+        }
+
+        // Changed nodes, bucketed by level
+        const uint32_t levelCount = GetLevelCount();
+        m_dirtyLevels.resize(levelCount);
+        for (const TransformHandle handle : m_dirtyHandles) {
+            Node& node = m_nodes[handle];
+            if (!node.alive || !node.dirty) {
+                continue;
+            }
+            node.dirty = false;
+            if (!m_queued[node.index]) {
+                m_queued[node.index] = 1;
+                m_dirtyLevels[m_levels[node.index]].push_back(node.index);
+            }
+        }
+        m_dirtyHandles.clear();
+
+        // Parents are final before their level is read, so each level is one parallel pass
+        m_updatedCount = 0;
+        for (uint32_t level = 0; level < levelCount; level++) {
+            std::vector<uint32_t>& dirty = m_dirtyLevels[level];
+            if (dirty.empty()) {
+                continue;
+            }
+
+            // Process the level in memory order. Mostly changed levels are
+            // rebuilt from the queued flags, the rest are sorted.
+            const uint32_t levelBegin = m_levelStarts[level];
+            const uint32_t levelEnd = m_levelStarts[level + 1];
+            if (dirty.size() * 8 >= levelEnd - levelBegin) {
+                dirty.clear();
+                for (uint32_t index = levelBegin; index < levelEnd; index++) {
+                    if (m_queued[index]) {
+                        dirty.push_back(index);
+                    }
+                }
+            } else {
+                std::sort(dirty.begin(), dirty.end());
+            }
+
+            const auto updateRange = [this, &dirty](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    const uint32_t index = dirty[i];
+                    const Matrix4x4 local = Transform(m_translations[index], m_rotations[index], m_scales[index]).ToMatrix4x4();
+                    const uint32_t parent = m_parents[index];
+                    m_worlds[index] = parent == NoParent ? local : m_worlds[parent] * local;
+                }
+            };
+            const uint32_t dirtyCount = static_cast<uint32_t>(dirty.size());
+            if (dirtyCount >= grainSize) {
+                JobSystem::GetInstance().ParallelFor(dirtyCount, grainSize, updateRange);
+            } else {
+                updateRange(0, dirtyCount);
+            }
+
+            // Children of changed nodes change with them
+            if (level + 1 < levelCount) {
+                std::vector<uint32_t>& next = m_dirtyLevels[level + 1];
+                for (const uint32_t index : dirty) {
+                    const uint32_t end = m_firstChildren[index] + m_childCounts[index];
+                    for (uint32_t child = m_firstChildren[index]; child < end; child++) {
+                        if (!m_queued[child]) {
+                            m_queued[child] = 1;
+                            next.push_back(child);
+                        }
+                    }
+                }
+            }
+
+            for (const uint32_t index : dirty) {
+                m_queued[index] = 0;
+            }
+            m_updatedCount += dirtyCount;
+            dirty.clear();
+        }
+    }
+}
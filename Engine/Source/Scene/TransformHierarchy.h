@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <Core/MathF.h>
+#include <vector>
+
+namespace Reality {
+    using TransformHandle = uint32_t;
+    constexpr TransformHandle InvalidTransformHandle = UINT32_MAX;
+
+    // TransformHierarchy - local transforms and world matrices of scene nodes
+    // in flat arrays, sorted breadth first. Every depth level is a contiguous
+    // range and the children of a node are contiguous within the next one.
+    // Update recomputes only the nodes that changed and their descendants,
+    // level by level, each level split across the JobSystem workers.
+    //
+    // Handles stay valid until destroyed. Creating, destroying or reparenting
+    // nodes re-sorts the arrays on the next Update, moving nodes does not.
+    class TransformHierarchy {
+    public:
+        TransformHierarchy() = default;
+
+        TransformHandle Create(const Transform& local = Transform::Identity(), TransformHandle parent = InvalidTransformHandle);
+
+        // Destroys the node and all of its descendants
+        void Destroy(TransformHandle handle);
+
+        // Keeps the local transform, so the world transform changes with the new parent
+        void SetParent(TransformHandle handle, TransformHandle parent);
+        TransformHandle GetParent(TransformHandle handle) const { return m_nodes[handle].parent; }
+
+        void SetLocal(TransformHandle handle, const Transform& local);
+        void SetTranslation(TransformHandle handle, const Vector3& translation);
+        void SetRotation(TransformHandle handle, const Quaternion& rotation);
+        void SetScale(TransformHandle handle, const Vector3& scale);
+
+        Transform GetLocal(TransformHandle handle) const;
+
+        // Current as of the last Update
+        const Matrix4x4& GetWorld(TransformHandle handle) const { return m_worlds[m_nodes[handle].index]; }
+
+        // Propagates changes to world matrices. Levels with fewer than
+        // grainSize changed nodes are processed on the calling thread.
+        void Update(uint32_t grainSize = 1024);
+
+        uint32_t GetCount() const { return static_cast<uint32_t>(m_nodes.size() - m_freeHandles.size()); }
+
+        // Depth of the deepest node plus one, as of the last Update
+        uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levelStarts.size()) - 1; }
+
+        // Number of world matrices recomputed by the last Update
+        uint32_t GetUpdatedCount() const { return m_updatedCount; }
+
+        bool IsValid(TransformHandle handle) const { return handle < m_nodes.size() && m_nodes[handle].alive; }
+
+    private:
+        // Per handle. The tree structure lives here so that it survives re-sorting.
+        struct Node {
+            uint32_t index = 0;                             // Position in the sorted arrays
+            TransformHandle parent = InvalidTransformHandle;
+            TransformHandle firstChild = InvalidTransformHandle;
+            TransformHandle nextSibling = InvalidTransformHandle;
+            bool alive = false;
+            bool dirty = false;
+        };
+
+        void MarkDirty(TransformHandle handle);
+        void Link(TransformHandle handle, TransformHandle parent);
+        void Unlink(TransformHandle handle);
+        void Sort();
+
+        std::vector<Node> m_nodes;
+        std::vector<TransformHandle> m_freeHandles;
+        std::vector<TransformHandle> m_dirtyHandles;
+        bool m_structureChanged = false;
+
+        // Sorted breadth first
+        std::vector<Vector3> m_translations;
+        std::vector<Quaternion> m_rotations;
+        std::vector<Vector3> m_scales;
+        std::vector<Matrix4x4> m_worlds;
+        std::vector<uint32_t> m_parents;                    // Sorted index, UINT32_MAX for roots
+        std::vector<uint32_t> m_firstChildren;
+        std::vector<uint32_t> m_childCounts;
+        std::vector<uint32_t> m_levels;
+        std::vector<TransformHandle> m_handles;
+        std::vector<uint32_t> m_levelStarts = { 0 };
+
+        // Update scratch: changed nodes per level, and whether a node is queued
+        std::vector<std::vector<uint32_t>> m_dirtyLevels;
+        std::vector<uint8_t> m_queued;
+        uint32_t m_updatedCount = 0;
+    };
+}
@@ -511,6 +511,9 @@ STBSP__PUBLICDEF int STB_SPRINTF_DECORATE(vsprintfcb)(STBSP_SPRINTFCB *callback,
          ++f;
          if (f[0] == '*') {
             pr = va_arg(va, stbsp__uint32);
+            // a negative precision is taken as if it were omitted (Reality)
+            if (pr < 0)
+               pr = -1;
             ++f;
          } else {
             pr = 0;
@@ -0,0 +1,165 @@
+﻿#include <Reality.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+using namespace Reality;
+
+// Headless frame loop on the Null or Software backend. Runs the same
+// HighLevelRenderer path as the Sandbox without a window or GPU, so
+// render-side CPU cost can be profiled on any machine.
+
+// Define vertex structure
+struct Vertex {
+    float position[3];
+    float color[4];
+};
+
+// Triangle vertex data
+Vertex triangleVertices[] = {
+    {{ 0.0f,  0.5f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},  // Top - Red
+    {{-0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f, 1.0f}},  // Bottom Left - Green
+    {{ 0.5f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f, 1.0f}}   // Bottom Right - Blue
+};
+
+uint32_t triangleIndices[] = {
+    0, 1, 2  // Triangle indices
+};
+
+int main(int argc, char** argv) {
+    // Usage: Headless [frames] [draws per frame] [transient buffers per frame] [null|software] [output.png]
+    const uint32_t frameCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    const uint32_t drawsPerFrame = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100;
+    const uint32_t transientBuffersPerFrame = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 16;
+    const bool software = argc > 4 && std::strcmp(argv[4], "software") == 0;
+    const char* outputPath = argc > 5 ? argv[5] : nullptr;
+
+    constexpr uint32_t width = 1920;
+    constexpr uint32_t height = 1080;
+
+    Timer::Init();
+
+    DeviceCreationParams deviceParams;
+    deviceParams.api = software ? GraphicsAPI::Software : GraphicsAPI::Null;
+    deviceParams.width = width;
+    deviceParams.height = height;
+
+    DevicePtr device = GraphicsFactory::CreateDevice(deviceParams);
+    if (!device) {
+        RLOG_ERROR("Failed to create graphics device!");
+        return -1;
+    }
+
+    HighLevelRenderer renderer(device.get());
+    if (!renderer.Initialize(nullptr, width, height)) {
+        RLOG_ERROR("Failed to initialize renderer!");
+        return -1;
+    }
+
+    BufferPtr vertexBuffer = renderer.CreateVertexBuffer(triangleVertices, sizeof(triangleVertices), sizeof(Vertex));
+    BufferPtr indexBuffer = renderer.CreateIndexBuffer(triangleIndices, sizeof(triangleIndices));
+
+    GraphicsPipelineDesc pipelineDesc;
+    pipelineDesc.vertexShader.type = ShaderType::Vertex;
+    pipelineDesc.vertexShader.entryPoint = "main";
+    pipelineDesc.pixelShader.type = ShaderType::Pixel;
+    pipelineDesc.pixelShader.entryPoint = "main";
+    pipelineDesc.cullBack = false;
+
+    // Software equivalent of the pass-through HLSL, color is written straight from the varyings
+    pipelineDesc.softwareVaryingCount = 4;
+    pipelineDesc.softwareVertexShader = [](const SoftwareVertexInput& input, SoftwareVertexOutput& output) {
+        const auto* vertex = reinterpret_cast<const Vertex*>(input.streams[0]);
+        output.position[0] = vertex->position[0];
+        output.position[1] = vertex->position[1];
+        output.position[2] = vertex->position[2];
+        output.position[3] = 1.0f;
+        std::memcpy(output.varyings, vertex->color, sizeof(vertex->color));
+    };
+    PipelineStatePtr pipelineState = renderer.CreateGraphicsPipeline(pipelineDesc);
+
+    if (!vertexBuffer || !indexBuffer || !pipelineState) {
+        RLOG_ERROR("Failed to create resources!");
+        return -1;
+    }
+
+    RLOG_INFO("Running %u frames, %u draws and %u transient buffers per frame on the %s backend",
+              frameCount, drawsPerFrame, transientBuffersPerFrame, GraphicsFactory::GetAPIName(deviceParams.api).c_str());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        Timer::Update();
+
+        renderer.BeginFrame();
+        renderer.SetViewport(0, 0, width, height);
+        renderer.SetScissor(0, 0, width, height);
+        renderer.Clear(Vector4(0.1f, 0.1f, 0.3f, 1.0f));
+
+        renderer.SetPipelineState(pipelineState.get());
+        renderer.SetVertexBuffer(0, vertexBuffer.get());
+        renderer.SetIndexBuffer(indexBuffer.get());
+
+        for (uint32_t draw = 0; draw < drawsPerFrame; draw++) {
+            renderer.DrawIndexed(3);
+        }
+
+        // Simulate per-frame upload churn
+        for (uint32_t i = 0; i < transientBuffersPerFrame; i++) {
+            BufferPtr transient = renderer.CreateVertexBuffer(triangleVertices, sizeof(triangleVertices), sizeof(Vertex));
+        }
+
+        renderer.EndFrame();
+        renderer.Present();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    RLOG_INFO("%u frames in %.3f s (%.1f frames/s, %.3f us/frame)",
+              frameCount, seconds, frameCount / seconds, seconds * 1e6 / frameCount);
+
+    if (software) {
+        const auto* softwareDevice = static_cast<SoftwareDevice*>(device.get());
+        const SoftwareRasterizerStats& stats = softwareDevice->GetRasterizerStats();
+
+        RLOG_INFO("Rasterized on %u threads: %llu draws, %llu triangles, %llu culled, %llu pixels shaded",
+                  JobSystem::GetInstance().GetThreadCount(),
+                  static_cast<unsigned long long>(stats.drawCalls),
+                  static_cast<unsigned long long>(stats.trianglesSubmitted),
+                  static_cast<unsigned long long>(stats.trianglesCulled),
+                  static_cast<unsigned long long>(stats.pixelsShaded));
+
+        // The last presented frame is the one before the current back buffer
+        if (outputPath) {
+            ISwapChain* swapChain = renderer.GetSwapChain();
+            const uint32_t count = swapChain->GetBackBufferCount();
+            const uint32_t index = (swapChain->GetCurrentBackBufferIndex() + count - 1) % count;
+            auto* backBuffer = static_cast<SoftwareTexture*>(swapChain->GetBackBuffer(index));
+            if (!stbi_write_png(outputPath, static_cast<int>(width), static_cast<int>(height), 4,
+                                backBuffer->GetPixels(), static_cast<int>(backBuffer->GetRowPitch()))) {
+                RLOG_ERROR("Failed to write %s", outputPath);
+                return -1;
+            }
+            RLOG_INFO("Wrote last frame to %s", outputPath);
+        }
+        return 0;
+    }
+
+    const auto* nullDevice = static_cast<NullDevice*>(device.get());
+    const NullDeviceStats& stats = nullDevice->GetStats();
+
+    RLOG_INFO("Executed %llu command lists, %llu commands, %llu draws, %llu indices",
+              static_cast<unsigned long long>(stats.commandListsExecuted),
+              static_cast<unsigned long long>(stats.commandsExecuted),
+              static_cast<unsigned long long>(stats.drawCalls),
+              static_cast<unsigned long long>(stats.indicesSubmitted));
+    RLOG_INFO("Created %llu buffers, uploaded %llu bytes, %u buffers still alive",
+              static_cast<unsigned long long>(stats.buffersCreated),
+              static_cast<unsigned long long>(stats.bytesUploaded),
+              stats.liveBuffers);
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+﻿#include <Reality.h>
+#include <cmath>
+#include <cstdio>
+using namespace Reality;
+
+// Compresses synthetic clips, smooth, noisy, constant and one with a track
+// spanning 200 units, samples them at every frame with AnimationSampler and
+// fails if a bone is further from its source sample than the tolerances.
+// Also checks that a sampler follows a clip that is initialized again, and
+// that Initialize rejects what it cannot compress.
+
+namespace {
+    constexpr uint32_t BoneCount = 23;
+    constexpr uint32_t FrameCount = 241;
+    // A power of two, so frame / rate * rate gives back the exact frame
+    constexpr float SampleRate = 32.0f;
+    // Room for the sampler blending in SIMD registers where the compressor
+    // measured with scalar code
+    constexpr float Slack = 1.02f;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    uint32_t g_failures = 0;
+
+    void Fail(const char* clip, const char* what, uint32_t bone, uint32_t frame, float error, float tolerance) {
+        if (g_failures < 20) {
+            RLOG_ERROR("%s: %s of bone %u at frame %u off by %g, tolerance %g", clip, what, bone, frame, error, tolerance);
+        }
+        g_failures++;
+    }
+
+    // Same measure as the compressor, the angle from the chord between the quaternions
+    float RotationError(const Quaternion& a, const Quaternion& b) {
+        const Quaternion n = b.Normalized();
+        const float s = a.Dot(n) < 0.0f ? -1.0f : 1.0f;
+        const Vector4 d(a.x - n.x * s, a.y - n.y * s, a.z - n.z * s, a.w - n.w * s);
+        return 4.0f * std::asin(Min(0.5f * d.Length(), 1.0f));
+    }
+
+    // Bone 0 is constant, bone 1 moves over 200 units, bone 2 is noise, the
+    // rest are smooth curves with their own phases and amplitudes
+    AnimationClipDesc MakeClip(const char* name, uint32_t seed) {
+        Random random;
+        for (uint32_t i = 0; i < seed; i++) {
+            random.Next();
+        }
+
+        AnimationClipDesc desc;
+        desc.name = name;
+        desc.boneCount = BoneCount;
+        desc.frameCount = FrameCount;
+        desc.sampleRate = SampleRate;
+        desc.samples.resize(BoneCount * FrameCount);
+
+        float phases[BoneCount][9];
+        for (auto& bone : phases) {
+            for (float& phase : bone) {
+                phase = random.Next() * PI;
+            }
+        }
+        for (uint32_t frame = 0; frame < FrameCount; frame++) {
+            const float t = static_cast<float>(frame) / SampleRate;
+            for (uint32_t bone = 0; bone < BoneCount; bone++) {
+                const float* p = phases[bone];
+                Transform sample;
+                if (bone == 0) {
+                    sample = Transform(Vector3(0.0f, 1.0f, 0.0f), Quaternion::FromEulerAngles(0.3f, 0.2f, 0.1f), Vector3::One());
+                } else if (bone == 1) {
+                    sample = Transform(Vector3(-100.0f + 200.0f * t / 7.5f, 3.0f * std::sin(t * 2.0f + p[0]), 50.0f * std::cos(t + p[1])),
+                                       Quaternion::FromEulerAngles(t, 0.5f * t, 0.0f), Vector3::One());
+                } else if (bone == 2) {
+                    sample = Transform(Vector3(random.Next(), random.Next(), random.Next()) * 0.1f,
+                                       Quaternion::FromEulerAngles(random.Next(), random.Next(), random.Next()),
+                                       Vector3(1.0f + random.Next() * 0.05f));
+                } else {
+                    const float amplitude = 0.2f + 0.1f * static_cast<float>(bone % 5);
+                    sample = Transform(Vector3(std::sin(t * 1.3f + p[0]), std::sin(t * 0.7f + p[1]), std::sin(t * 2.1f + p[2])) * amplitude,
+                                       Quaternion::FromEulerAngles(std::sin(t + p[3]) * 1.5f, std::sin(t * 1.7f + p[4]) * 2.5f,
+                                                                   std::sin(t * 0.9f + p[5]) * 0.8f),
+                                       Vector3(1.0f + 0.2f * std::sin(t + p[6]), 1.0f + 0.2f * std::sin(t * 1.1f + p[7]),
+                                               1.0f + 0.2f * std::sin(t * 0.6f + p[8])));
+                }
+                desc.samples[frame * BoneCount + bone] = sample;
+            }
+        }
+        return desc;
+    }
+
+    // Samples every frame and compares with the source samples, returning
+    // the worst error as a fraction of the tolerance
+    float CheckClip(const AnimationClipDesc& desc, const AnimationClip& clip, AnimationSampler& sampler) {
+        Pose pose;
+        float worst = 0.0f;
+        for (uint32_t frame = 0; frame < desc.frameCount; frame++) {
+            sampler.Sample(clip, static_cast<float>(frame) / desc.sampleRate, pose);
+            for (uint32_t bone = 0; bone < desc.boneCount; bone++) {
+                const Transform& expected = desc.samples[frame * desc.boneCount + bone];
+                const Transform actual = pose.GetTransform(bone);
+                const float rotation = RotationError(actual.rotation, expected.rotation);
+                const float translation = (actual.translation - expected.translation).Length();
+                const float scale = (actual.scale - expected.scale).Length();
+                if (rotation > desc.rotationTolerance * Slack) {
+                    Fail(desc.name.c_str(), "Rotation", bone, frame, rotation, desc.rotationTolerance);
+                }
+                if (translation > desc.translationTolerance * Slack) {
+                    Fail(desc.name.c_str(), "Translation", bone, frame, translation, desc.translationTolerance);
+                }
+                if (scale > desc.scaleTolerance * Slack) {
+                    Fail(desc.name.c_str(), "Scale", bone, frame, scale, desc.scaleTolerance);
+                }
+                worst = Max(worst, Max(rotation / desc.rotationTolerance,
+                                       Max(translation / desc.translationTolerance, scale / desc.scaleTolerance)));
+            }
+        }
+        return worst;
+    }
+
+    void TestClip(AnimationClipDesc desc, float rotationTolerance, float vectorTolerance) {
+        desc.rotationTolerance = rotationTolerance;
+        desc.translationTolerance = vectorTolerance;
+        desc.scaleTolerance = vectorTolerance;
+
+        AnimationClip clip;
+        if (!clip.Initialize(desc)) {
+            Fail(desc.name.c_str(), "Initialize", 0, 0, 0.0f, rotationTolerance);
+            return;
+        }
+        AnimationSampler sampler;
+        const float worst = CheckClip(desc, clip, sampler);
+        const size_t rawSize = desc.samples.size() * sizeof(Transform);
+        RLOG_INFO("%s at %g rad, %g units: %zu of %zu bytes, %zu keys, worst error %.4f of tolerance", desc.name.c_str(),
+                  rotationTolerance, vectorTolerance, clip.GetCompressedSize(), rawSize, clip.GetKeys().size(), worst);
+        if (clip.GetCompressedSize() >= rawSize) {
+            Fail(desc.name.c_str(), "Compressed size", 0, 0, static_cast<float>(clip.GetCompressedSize()), 0.0f);
+        }
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    const AnimationClipDesc walk = MakeClip("Walk", 0);
+    TestClip(walk, 0.001f, 0.0005f);
+    TestClip(walk, 0.01f, 0.005f);
+    TestClip(walk, 0.0002f, 0.0001f);
+
+    // The 200 unit track needs 32-bit keys at this tolerance
+    AnimationClip wide;
+    AnimationClipDesc wideDesc = walk;
+    wideDesc.translationTolerance = 0.0001f;
+    if (!wide.Initialize(wideDesc) || wide.GetTrack(1, AnimationClip::Translation).firstLowBits == AnimationClip::NoLowBits) {
+        Fail("Walk", "32-bit keys for the wide track", 1, 0, 0.0f, wideDesc.translationTolerance);
+    }
+
+    // A sampler bound to a clip follows it when it is initialized again
+    AnimationClip clip;
+    AnimationSampler sampler;
+    clip.Initialize(walk);
+    CheckClip(walk, clip, sampler);
+    // Back at the first frame, where the new clip's sampling starts, so only
+    // the rebind can replace the decoded keys
+    Pose pose;
+    sampler.Sample(clip, 0.0f, pose);
+    const uint64_t generation = clip.GetGeneration();
+    const AnimationClipDesc run = MakeClip("Run", 1000);
+    if (!clip.Initialize(run) || clip.GetGeneration() == generation) {
+        Fail("Run", "Initialize again", 0, 0, 0.0f, 0.0f);
+    }
+    CheckClip(run, clip, sampler);
+
+    // Clips Initialize cannot compress
+    AnimationClipDesc invalid = walk;
+    invalid.rotationTolerance = 1e-9f;
+    if (AnimationClip().Initialize(invalid)) {
+        Fail("Walk", "Initialize with a tolerance below the quantization", 0, 0, 0.0f, invalid.rotationTolerance);
+    }
+    invalid = walk;
+    invalid.samples.pop_back();
+    if (AnimationClip().Initialize(invalid)) {
+        Fail("Walk", "Initialize with missing samples", 0, 0, 0.0f, 0.0f);
+    }
+    invalid.frameCount = 65537;
+    invalid.boneCount = 1;
+    invalid.samples.assign(invalid.frameCount, Transform::Identity());
+    if (AnimationClip().Initialize(invalid)) {
+        Fail("Walk", "Initialize with more than 65536 frames", 0, 0, 0.0f, 0.0f);
+    }
+
+    RLOG_INFO("%u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+﻿#include <Reality.h>
+#include <cmath>
+#include <cstdio>
+using namespace Reality;
+
+// Measures the maximum error of every Approx function and precision over its
+// valid range against double precision, and fails if one exceeds the table
+// in MathF.h or if the SIMD versions differ from the float ones.
+
+namespace {
+    constexpr uint32_t Samples = 1 << 20;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    struct Function {
+        const char* name;
+        float minimum;
+        float maximum;
+        bool relative;
+        double (*reference)(double);
+        float (*approx[3])(float);
+        float documented[3];
+#if defined(REALITY_SIMD_SSE)
+        SIMD::Float4 (*approx4[3])(SIMD::Float4);
+#endif
+#if defined(REALITY_SIMD_AVX2)
+        SIMD::Float8 (*approx8[3])(SIMD::Float8);
+#endif
+    };
+
+    // Initializers for the Float4 and Float8 overloads this build has
+#if defined(REALITY_SIMD_AVX2)
+#define APPROX_SIMD(function) \
+    , { Approx::function<Precision::Fast>, Approx::function<Precision::Medium>, Approx::function<Precision::Precise> } \
+    , { Approx::function<Precision::Fast>, Approx::function<Precision::Medium>, Approx::function<Precision::Precise> }
+#elif defined(REALITY_SIMD_SSE)
+#define APPROX_SIMD(function) \
+    , { Approx::function<Precision::Fast>, Approx::function<Precision::Medium>, Approx::function<Precision::Precise> }
+#else
+#define APPROX_SIMD(function)
+#endif
+
+    double ReferenceRSqrt(double x) { return 1.0 / std::sqrt(x); }
+    double ReferenceSqrt(double x) { return std::sqrt(x); }
+    double ReferenceSin(double x) { return std::sin(x); }
+    double ReferenceCos(double x) { return std::cos(x); }
+    double ReferenceACos(double x) { return std::acos(x); }
+
+#if defined(REALITY_SIMD_SSE)
+    // Scalar builds without SSE start RSqrt from a bit-level estimate
+    constexpr float RSqrtFast = 3.3e-4f;
+    constexpr float RSqrtMedium = 2.8e-7f;
+    constexpr float SqrtFast = 3.3e-4f;
+    constexpr float SqrtMedium = 3.1e-7f;
+#else
+    constexpr float RSqrtFast = 1.8e-3f;
+    constexpr float RSqrtMedium = 4.8e-6f;
+    constexpr float SqrtFast = 1.8e-3f;
+    constexpr float SqrtMedium = 4.8e-6f;
+#endif
+
+    const Function Functions[] = {
+        { "Sin", -8192.0f, 8192.0f, false, ReferenceSin,
+          { Approx::Sin<Precision::Fast>, Approx::Sin<Precision::Medium>, Approx::Sin<Precision::Precise> },
+          { 1.3e-6f, 2.4e-7f, 2.3e-7f } APPROX_SIMD(Sin) },
+        { "Cos", -8192.0f, 8192.0f, false, ReferenceCos,
+          { Approx::Cos<Precision::Fast>, Approx::Cos<Precision::Medium>, Approx::Cos<Precision::Precise> },
+          { 7.0e-6f, 3.0e-7f, 2.6e-7f } APPROX_SIMD(Cos) },
+        { "ACos", -1.0f, 1.0f, false, ReferenceACos,
+          { Approx::ACos<Precision::Fast>, Approx::ACos<Precision::Medium>, Approx::ACos<Precision::Precise> },
+          { 8.6e-5f, 1.6e-6f, 4.2e-7f } APPROX_SIMD(ACos) },
+        { "RSqrt", 1e-6f, 1e6f, true, ReferenceRSqrt,
+          { Approx::RSqrt<Precision::Fast>, Approx::RSqrt<Precision::Medium>, Approx::RSqrt<Precision::Precise> },
+          { RSqrtFast, RSqrtMedium, 9.0e-8f } APPROX_SIMD(RSqrt) },
+        { "Sqrt", 0.0f, 1e6f, true, ReferenceSqrt,
+          { Approx::Sqrt<Precision::Fast>, Approx::Sqrt<Precision::Medium>, Approx::Sqrt<Precision::Precise> },
+          { SqrtFast, SqrtMedium, 6.0e-8f } APPROX_SIMD(Sqrt) },
+    };
+
+#undef APPROX_SIMD
+
+    const char* const PrecisionNames[] = { "Fast", "Medium", "Precise" };
+
+    // Evenly spaced inputs over the range, then random ones; RSqrt and Sqrt
+    // spread them over the exponents instead
+    float Input(const Function& function, uint32_t index, Random& random) {
+        float t = index < Samples / 2 ? static_cast<float>(index) / static_cast<float>(Samples / 2 - 1)
+                                      : random.Next() * 0.5f + 0.5f;
+        if (function.relative) {
+            const float logMinimum = std::log2(function.minimum > 0.0f ? function.minimum : 1e-6f);
+            const float logMaximum = std::log2(function.maximum);
+            return std::fmin(std::exp2(logMinimum + (logMaximum - logMinimum) * t), function.maximum);
+        }
+        return std::fmin(function.minimum + (function.maximum - function.minimum) * t, function.maximum);
+    }
+
+    // Whether the SIMD versions give the float result in every lane
+    bool LanesMatch(const Function& function, uint32_t precision, const float* inputs) {
+        const auto scalar = function.approx[precision];
+        bool matches = true;
+#if defined(REALITY_SIMD_SSE)
+        alignas(16) float lanes4[4];
+        SIMD::Store(lanes4, function.approx4[precision](SIMD::Load(inputs)));
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            matches &= lanes4[lane] == scalar(inputs[lane]);
+        }
+#endif
+#if defined(REALITY_SIMD_AVX2)
+        alignas(32) float lanes8[8];
+        SIMD::Store(lanes8, function.approx8[precision](SIMD::Load8(inputs)));
+        for (uint32_t lane = 0; lane < 8; lane++) {
+            matches &= lanes8[lane] == scalar(inputs[lane]);
+        }
+#endif
+        (void)inputs;
+        (void)scalar;
+        return matches;
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+    RLOG_INFO("%s", SIMD::GetInstructionSetName());
+
+    uint32_t failures = 0;
+    for (const Function& function : Functions) {
+        for (uint32_t precision = 0; precision < 3; precision++) {
+            Random random;
+            double worst = 0.0;
+            float worstInput = 0.0f;
+            uint32_t mismatches = 0;
+            alignas(32) float group[8];
+            for (uint32_t i = 0; i < Samples; i++) {
+                const float x = Input(function, i, random);
+                group[i % 8] = x;
+                if (i % 8 == 7 && !LanesMatch(function, precision, group)) {
+                    mismatches++;
+                }
+                const double expected = function.reference(x);
+                double error = std::fabs(function.approx[precision](x) - expected);
+                if (function.relative && expected != 0.0) {
+                    error /= std::fabs(expected);
+                }
+                if (error > worst) {
+                    worst = error;
+                    worstInput = x;
+                }
+            }
+
+            const bool passed = worst <= function.documented[precision] && mismatches == 0;
+            RLOG_INFO("%-6s %-8s %.2e (documented %.1e) at %g, %u SIMD mismatches%s", function.name,
+                      PrecisionNames[precision], worst, function.documented[precision], worstInput, mismatches,
+                      passed ? "" : " FAILED");
+            if (!passed) {
+                failures++;
+            }
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+using namespace Reality;
+
+// Builds a BVH over random boxes, large enough for the parallel build, and
+// fails if a raycast, packet raycast, occlusion ray or overlap query differs
+// from testing every primitive, before and after moving primitives with
+// SetBounds and Refit.
+
+namespace {
+    constexpr uint32_t PrimitiveCount = 10007;
+    constexpr uint32_t RayCount = 1003;         // Not a multiple of the packet size
+    constexpr uint32_t QueryCount = 200;
+    constexpr uint32_t MovedCount = 1000;
+    constexpr float MaxDistance = 150.0f;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+        uint32_t NextIndex(uint32_t count) {
+            return static_cast<uint32_t>(Abs(Next()) * static_cast<float>(count)) % count;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    uint32_t g_failures = 0;
+
+    void Fail(const char* what, uint32_t index) {
+        if (g_failures < 20) {
+            RLOG_ERROR("%s, query %u", what, index);
+        }
+        g_failures++;
+    }
+
+    AABB RandomBox(Random& random) {
+        // A few large boxes among many small ones, as in a scene
+        const float size = Abs(random.Next()) < 0.01f ? 30.0f : 3.0f;
+        const Vector3 center(random.Next() * 100.0f, random.Next() * 100.0f, random.Next() * 100.0f);
+        const Vector3 extents(Abs(random.Next()) * size, Abs(random.Next()) * size, Abs(random.Next()) * size);
+        return AABB::FromCenterExtents(center, extents);
+    }
+
+    Ray RandomRay(Random& random) {
+        Vector3 direction(random.Next(), random.Next(), random.Next());
+        // Some rays run parallel to the slab planes
+        const uint32_t flat = random.NextIndex(8);
+        if (flat < 3) {
+            direction[static_cast<int>(flat)] = 0.0f;
+        }
+        if (direction.LengthSquared() < 1e-6f) {
+            direction = Vector3(1.0f, 0.0f, 0.0f);
+        }
+        return Ray(Vector3(random.Next() * 120.0f, random.Next() * 120.0f, random.Next() * 120.0f), direction.Normalized());
+    }
+
+    // Exact primitives: the sphere inside each box, a little smaller so a ray
+    // that hits it clearly hits the box
+    struct Spheres {
+        const std::vector<AABB>* bounds;
+
+        float operator()(uint32_t id, const Ray& ray, float maxDistance) const {
+            const AABB& box = (*bounds)[id];
+            const Vector3 extents = box.Extents();
+            const float radius = Min(Min(extents.x, extents.y), extents.z) * 0.9f;
+            const Vector3 offset = ray.origin - box.Center();
+            const float b = offset.Dot(ray.direction);
+            const float c = offset.LengthSquared() - radius * radius;
+            if (c <= 0.0f) {
+                return 0.0f;
+            }
+            const float discriminant = b * b - c;
+            if (b > 0.0f || discriminant < 0.0f) {
+                return -1.0f;
+            }
+            const float distance = -b - std::sqrt(discriminant);
+            return distance <= maxDistance ? distance : -1.0f;
+        }
+    };
+
+    // Closest hit by testing every primitive, with the arithmetic of Ray::Intersects
+    RayHit BruteForceRaycast(const std::vector<AABB>& bounds, const Ray& ray, float maxDistance, const Spheres* spheres) {
+        RayHit hit;
+        for (uint32_t id = 0; id < bounds.size(); id++) {
+            float distance;
+            if (!ray.Intersects(bounds[id], maxDistance, distance)) {
+                continue;
+            }
+            if (spheres) {
+                distance = (*spheres)(id, ray, maxDistance);
+                if (distance < 0.0f) {
+                    continue;
+                }
+            }
+            if (distance < hit.distance) {
+                hit.id = id;
+                hit.distance = distance;
+            }
+        }
+        return hit;
+    }
+
+    // Ties between primitives may pick either, so the distances are compared
+    // and the returned primitive checked to be at that distance
+    bool SameHit(const RayHit& hit, const RayHit& expected, const std::vector<AABB>& bounds, const Ray& ray,
+                 float maxDistance, const Spheres* spheres) {
+        if (hit.id == UINT32_MAX || expected.id == UINT32_MAX) {
+            return hit.id == expected.id;
+        }
+        if (hit.distance != expected.distance || hit.id >= bounds.size()) {
+            return false;
+        }
+        float distance;
+        if (!ray.Intersects(bounds[hit.id], maxDistance, distance)) {
+            return false;
+        }
+        return (spheres ? (*spheres)(hit.id, ray, maxDistance) : distance) == hit.distance;
+    }
+
+    void TestRays(const BVH& bvh, const std::vector<AABB>& bounds, const std::vector<Ray>& rays) {
+        const Spheres spheres{ &bounds };
+        std::vector<RayHit> packetHits(rays.size());
+        for (uint32_t pass = 0; pass < 2; pass++) {
+            const Spheres* exact = pass == 1 ? &spheres : nullptr;
+            const BVH::RayTestFunction test = exact ? BVH::RayTestFunction(spheres) : nullptr;
+            bvh.RaycastPacket(rays, MaxDistance, packetHits, test);
+
+            for (uint32_t i = 0; i < rays.size(); i++) {
+                const RayHit expected = BruteForceRaycast(bounds, rays[i], MaxDistance, exact);
+                RayHit hit;
+                const bool hitAny = bvh.Raycast(rays[i], MaxDistance, hit, test);
+                if (hitAny != (expected.id != UINT32_MAX) || !SameHit(hit, expected, bounds, rays[i], MaxDistance, exact)) {
+                    Fail(exact ? "Raycast with a test function" : "Raycast", i);
+                }
+                if (!SameHit(packetHits[i], expected, bounds, rays[i], MaxDistance, exact)) {
+                    Fail(exact ? "RaycastPacket with a test function" : "RaycastPacket", i);
+                }
+                if (bvh.RaycastAny(rays[i], MaxDistance, test) != (expected.id != UINT32_MAX)) {
+                    Fail(exact ? "RaycastAny with a test function" : "RaycastAny", i);
+                }
+            }
+        }
+    }
+
+    void TestOverlaps(const BVH& bvh, const std::vector<AABB>& bounds, Random& random) {
+        std::vector<uint32_t> results;
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < QueryCount; i++) {
+            const AABB box = RandomBox(random);
+            results.clear();
+            expected.clear();
+            bvh.QueryOverlap(box, results);
+            for (uint32_t id = 0; id < bounds.size(); id++) {
+                if (box.Intersects(bounds[id])) {
+                    expected.push_back(id);
+                }
+            }
+            std::sort(results.begin(), results.end());
+            if (results != expected) {
+                Fail("QueryOverlap box", i);
+            }
+
+            const BoundingSphere sphere(box.Center(), Abs(random.Next()) * 20.0f);
+            results.clear();
+            expected.clear();
+            bvh.QueryOverlap(sphere, results);
+            for (uint32_t id = 0; id < bounds.size(); id++) {
+                if (sphere.Intersects(bounds[id])) {
+                    expected.push_back(id);
+                }
+            }
+            std::sort(results.begin(), results.end());
+            if (results != expected) {
+                Fail("QueryOverlap sphere", i);
+            }
+        }
+    }
+
+    void TestAll(const char* stage, const BVH& bvh, const std::vector<AABB>& bounds, const std::vector<Ray>& rays,
+                 Random& random) {
+        const uint32_t failures = g_failures;
+        TestRays(bvh, bounds, rays);
+        TestOverlaps(bvh, bounds, random);
+        RLOG_INFO("%s: %u primitives, %u nodes, depth %u, cost %.2f, %u mismatches", stage, bvh.GetPrimitiveCount(),
+                  bvh.GetNodeCount(), bvh.GetDepth(), bvh.GetCost(), g_failures - failures);
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    Random random;
+    std::vector<AABB> bounds(PrimitiveCount);
+    for (AABB& box : bounds) {
+        box = RandomBox(random);
+    }
+    std::vector<Ray> rays(RayCount);
+    for (Ray& ray : rays) {
+        ray = RandomRay(random);
+    }
+
+    BVH bvh;
+    bvh.Build(bounds);
+    TestAll("Build", bvh, bounds, rays, random);
+
+    // Incremental refit of a tenth of the primitives
+    for (uint32_t i = 0; i < MovedCount; i++) {
+        const uint32_t id = random.NextIndex(PrimitiveCount);
+        bounds[id] = RandomBox(random);
+        bvh.SetBounds(id, bounds[id]);
+    }
+    bvh.Refit();
+    TestAll("Refit", bvh, bounds, rays, random);
+
+    // Full refit with every primitive moved
+    for (AABB& box : bounds) {
+        box = AABB::FromCenterExtents(box.Center() + Vector3(random.Next(), random.Next(), random.Next()) * 5.0f,
+                                      box.Extents());
+    }
+    bvh.Refit(bounds);
+    TestAll("Refit all", bvh, bounds, rays, random);
+
+    // Trees small enough for a single leaf, and an empty one
+    for (const uint32_t count : { 1u, 5u, 37u, 0u }) {
+        std::vector<AABB> small(bounds.begin(), bounds.begin() + count);
+        BVH smallBvh;
+        smallBvh.Build(small);
+        TestAll("Small", smallBvh, small, rays, random);
+    }
+
+    RLOG_INFO("%s: %u mismatches", SIMD::GetInstructionSetName(), g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
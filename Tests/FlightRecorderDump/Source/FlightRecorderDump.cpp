@@ -0,0 +1,288 @@
+﻿#include <Reality.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+using namespace Reality;
+
+// The flight recorder keeps the last records at its own level while the
+// console and file filter them out: a dump lists exactly the newest
+// records, oldest first, with local times, events and fields. Fatal
+// messages dump in both logging modes, dumps taken while threads record
+// only hold whole records, and crash signals dump before the process dies.
+
+namespace {
+    namespace fs = std::filesystem;
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    // "[time] [LEVEL] [thread N] message" split up
+    struct DumpLine {
+        std::string time;
+        std::string level;
+        std::string message;
+    };
+
+    struct Dump {
+        std::string title;
+        std::vector<DumpLine> lines;
+        bool valid = true;
+    };
+
+    Dump ReadDump(const fs::path& path) {
+        Dump dump;
+        std::ifstream file(path, std::ios::binary);
+        std::getline(file, dump.title);
+        for (std::string line; std::getline(file, line);) {
+            const size_t levelStart = line.find("] [");
+            const size_t threadStart = line.find("] [thread ");
+            const size_t messageStart = threadStart == std::string::npos ? std::string::npos : line.find("] ", threadStart + 1);
+            if (line.empty() || line[0] != '[' || levelStart == std::string::npos || messageStart == std::string::npos ||
+                threadStart <= levelStart) {
+                RLOG_ERROR("Malformed dump line \"%s\"", line.c_str());
+                dump.valid = false;
+                continue;
+            }
+            dump.lines.push_back({ line.substr(1, levelStart - 1), line.substr(levelStart + 3, threadStart - levelStart - 3),
+                                   line.substr(messageStart + 2) });
+        }
+        return dump;
+    }
+
+    std::string Numbered(const char* text, uint32_t number) {
+        return text + std::to_string(number);
+    }
+
+    FlightRecorderDesc MakeDesc(const fs::path& path, uint32_t recordCount) {
+        FlightRecorderDesc desc;
+        desc.recordCount = recordCount;
+        desc.level = LogLevel::Debug;
+        desc.dumpPath = path.string();
+        desc.installSignalHandlers = false;
+        return desc;
+    }
+
+    // Filtered records are kept, the oldest are overwritten
+    void TestLastRecords(const fs::path& directory) {
+        const fs::path dumpPath = directory / "last.log";
+        const fs::path logPath = directory / "last_file.log";
+
+        Log& log = Log::GetInstance();
+        log.SetLogFile(logPath.string());
+        log.EnableFileOutput(true);
+        log.SetLevel(LogLevel::Warning);
+        log.StartFlightRecorder(MakeDesc(dumpPath, 100));
+
+        const std::string before = Log::GetTimestamp();
+        for (uint32_t index = 0; index < 300; index++) {
+            RLOG_TRACE("Trace %u", index);
+            RLOG_DEBUG("Debug %u", index);
+        }
+        RLOG_WARNING("Warning %d", 300);
+        log.LogMessage(LogLevel::Info, "Plain text");
+        RLOG_FIELDS(LogLevel::Info, "Fields", LogField("subsystem", "Render"), LogField("frame", 42));
+        FlightRecorder::RecordEvent("Event", std::chrono::microseconds(1500));
+        { FlightRecorderScope scope("Scope"); }
+        log.DumpFlightRecorder();
+        const std::string after = Log::GetTimestamp();
+
+        log.StopFlightRecorder();
+        log.EnableFileOutput(false);
+        log.SetLevel(LogLevel::Trace);
+
+        // 100 rounds up to 128, the last 5 are the other records
+        const Dump dump = ReadDump(dumpPath);
+        Check(dump.valid, "Dump has malformed lines");
+        Check(dump.title == "Flight recorder, last 128 records", "Dump title does not count 128 records");
+        if (dump.lines.size() != 128) {
+            RLOG_ERROR("Dump has %zu records, expected 128", dump.lines.size());
+            g_failures++;
+            return;
+        }
+        for (uint32_t index = 0; index < 123; index++) {
+            const DumpLine& line = dump.lines[index];
+            if (line.level != "DEBUG" || line.message != Numbered("Debug ", 177 + index)) {
+                RLOG_ERROR("Dump record %u is [%s] %s, expected Debug %u", index, line.level.c_str(), line.message.c_str(), 177 + index);
+                g_failures++;
+            }
+        }
+        Check(dump.lines[123].level == "WARNING" && dump.lines[123].message == "Warning 300", "Dump lost the warning");
+        Check(dump.lines[124].level == "INFO" && dump.lines[124].message == "Plain text", "Dump lost the plain text message");
+        Check(dump.lines[125].message == "Fields subsystem=Render frame=42", "Dump lost the fields");
+        Check(dump.lines[126].level == "EVENT" && dump.lines[126].message == "Event 1.500 ms", "Dump lost the event");
+        Check(dump.lines[127].level == "EVENT" && dump.lines[127].message.rfind("Scope ", 0) == 0, "Dump lost the scope");
+
+        // Same local time as the log lines
+        for (const DumpLine& line : dump.lines) {
+            if (line.time < before || line.time > after) {
+                RLOG_ERROR("Dump time %s is outside %s to %s", line.time.c_str(), before.c_str(), after.c_str());
+                g_failures++;
+                break;
+            }
+        }
+
+        // The file only got the warning
+        std::vector<std::string> fileLines;
+        std::ifstream file(logPath);
+        for (std::string line; std::getline(file, line);) {
+            fileLines.push_back(line);
+        }
+        Check(fileLines.size() == 1 && fileLines[0].find("Warning 300") != std::string::npos, "Log file got filtered messages");
+    }
+
+    // Fatal messages dump without DumpFlightRecorder
+    void TestFatal(const fs::path& directory, bool async, bool deferFormatting) {
+        const fs::path dumpPath = directory / "fatal.log";
+        fs::remove(dumpPath);
+
+        Log& log = Log::GetInstance();
+        if (async) {
+            LogAsyncDesc desc;
+            desc.deferFormatting = deferFormatting;
+            log.StartAsync(desc);
+        }
+        log.StartFlightRecorder(MakeDesc(dumpPath, 16));
+        RLOG_DEBUG("Before fatal %d", 1);
+        RLOG_FATAL("Fatal %d", 2);
+        log.StopFlightRecorder();
+        if (async) {
+            log.StopAsync();
+        }
+
+        const Dump dump = ReadDump(dumpPath);
+        const bool dumped = dump.valid && dump.lines.size() == 2 && dump.lines[0].message == "Before fatal 1" &&
+                            dump.lines[1].level == "FATAL" && dump.lines[1].message == "Fatal 2";
+        if (!dumped) {
+            RLOG_ERROR("Fatal message was not dumped, async %d, deferred %d", async, deferFormatting);
+            g_failures++;
+        }
+    }
+
+    // Dumps taken while threads record hold whole records, in order per thread
+    void TestConcurrentDumps(const fs::path& directory) {
+        constexpr uint32_t ThreadCount = 4;
+        const fs::path dumpPath = directory / "concurrent.log";
+
+        Log& log = Log::GetInstance();
+        log.StartFlightRecorder(MakeDesc(dumpPath, 256));
+
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < ThreadCount; thread++) {
+            threads.emplace_back([&stop, thread] {
+                for (uint32_t index = 0; !stop.load(std::memory_order_relaxed); index++) {
+                    RLOG_DEBUG("Thread %u record %u with a longer text %s", thread, index, "to copy");
+                }
+            });
+        }
+
+        uint32_t records = 0;
+        for (uint32_t round = 0; round < 50; round++) {
+            log.DumpFlightRecorder();
+            const Dump dump = ReadDump(dumpPath);
+            Check(dump.valid, "Concurrent dump has malformed lines");
+
+            int64_t last[ThreadCount] = { -1, -1, -1, -1 };
+            for (const DumpLine& line : dump.lines) {
+                unsigned thread = 0;
+                unsigned index = 0;
+                char tail[32] = {};
+                if (sscanf(line.message.c_str(), "Thread %u record %u with a longer text %31s", &thread, &index, tail) != 3 ||
+                    thread >= ThreadCount || std::string(tail) != "to" ||
+                    line.message.size() < 7 || line.message.substr(line.message.size() - 7) != "to copy") {
+                    RLOG_ERROR("Torn dump record \"%s\"", line.message.c_str());
+                    g_failures++;
+                    continue;
+                }
+                if (static_cast<int64_t>(index) <= last[thread]) {
+                    RLOG_ERROR("Thread %u record %u dumped after record %lld", thread, index, static_cast<long long>(last[thread]));
+                    g_failures++;
+                }
+                last[thread] = index;
+            }
+            records += static_cast<uint32_t>(dump.lines.size());
+        }
+
+        stop = true;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        log.StopFlightRecorder();
+        Check(records != 0, "Concurrent dumps held no records");
+    }
+
+#ifndef _WIN32
+    // The crash handlers dump and then let the signal end the process
+    void TestCrash(const fs::path& directory, int signal) {
+        const fs::path dumpPath = directory / "crash.log";
+        fs::remove(dumpPath);
+        std::cout.flush();
+
+        const pid_t child = fork();
+        if (child == 0) {
+            FlightRecorderDesc desc = MakeDesc(dumpPath, 16);
+            desc.installSignalHandlers = true;
+            Log::GetInstance().StartFlightRecorder(desc);
+            RLOG_DEBUG("Before crash %d", signal);
+            raise(signal);
+            _exit(0);
+        }
+
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFSIGNALED(status) || WTERMSIG(status) != signal) {
+            RLOG_ERROR("Signal %d did not end the process, status %d", signal, status);
+            g_failures++;
+        }
+        const Dump dump = ReadDump(dumpPath);
+        if (!dump.valid || dump.lines.size() != 1 || dump.lines[0].message != Numbered("Before crash ", signal)) {
+            RLOG_ERROR("Signal %d did not dump the recorder", signal);
+            g_failures++;
+        }
+    }
+#endif
+}
+
+int main() {
+    Log::GetInstance().EnableColors(false);
+    Log::GetInstance().SetRateLimit(0, 0);
+
+    const fs::path directory = fs::temp_directory_path() / "RealityFlightRecorderDump";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    Log::GetInstance().EnableConsoleOutput(false);
+    TestLastRecords(directory);
+    TestFatal(directory, false, false);
+    TestFatal(directory, true, false);
+    TestFatal(directory, true, true);
+    TestConcurrentDumps(directory);
+#ifndef _WIN32
+    TestCrash(directory, SIGSEGV);
+    TestCrash(directory, SIGABRT);
+#endif
+    Log::GetInstance().EnableConsoleOutput(true);
+
+    fs::remove_all(directory);
+    RLOG_INFO("Flight recorder checked, %u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+﻿#include <Reality.h>
+#include <cstdio>
+#include <vector>
+using namespace Reality;
+
+// Culls random boxes and spheres against random cameras with CullBoxes,
+// CullSpheres and their parallel versions, and fails if any index list
+// differs from testing each volume with Frustum::Intersects.
+
+namespace {
+    constexpr uint32_t CameraCount = 32;
+    constexpr uint32_t VolumeCount = 10007;     // Not a multiple of the group size, the scalar tail runs too
+    constexpr uint32_t BaseIndex = 1000;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+        // Multiple of 1/64, so box corners and centers convert exactly
+        float NextGrid(float scale) {
+            return std::round(Next() * scale * 64.0f) / 64.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    uint32_t g_failures = 0;
+
+    void Check(const char* name, uint32_t camera, const std::vector<uint32_t>& expected, std::span<const uint32_t> indices,
+               uint32_t visible, uint32_t baseIndex) {
+        bool matches = visible == expected.size();
+        for (uint32_t i = 0; matches && i < visible; i++) {
+            matches = indices[i] == expected[i] + baseIndex;
+        }
+        if (!matches) {
+            RLOG_ERROR("%s, camera %u: %u visible, expected %u", name, camera, visible, static_cast<uint32_t>(expected.size()));
+            g_failures++;
+        }
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    Random random;
+    Vector3Stream centers(VolumeCount);
+    Vector3Stream extents(VolumeCount);
+    std::vector<float> radii(VolumeCount);
+    for (uint32_t i = 0; i < VolumeCount; i++) {
+        centers.Set(i, Vector3(random.NextGrid(60.0f), random.NextGrid(60.0f), random.NextGrid(60.0f)));
+        extents.Set(i, Vector3(Abs(random.NextGrid(4.0f)), Abs(random.NextGrid(4.0f)), Abs(random.NextGrid(4.0f))));
+        radii[i] = Abs(random.NextGrid(4.0f));
+    }
+
+    std::vector<uint32_t> indices(VolumeCount);
+    uint32_t visibleBoxes = 0;
+    uint32_t visibleSpheres = 0;
+    for (uint32_t camera = 0; camera < CameraCount; camera++) {
+        const Vector3 eye(random.Next() * 40.0f, random.Next() * 40.0f, random.Next() * 40.0f);
+        const Vector3 target(random.Next() * 20.0f, random.Next() * 20.0f, random.Next() * 20.0f);
+        const Matrix4x4 projection = Matrix4x4::Perspective(0.6f + Abs(random.Next()) * 1.2f, 16.0f / 9.0f, 0.1f, 80.0f);
+        const Frustum frustum = Frustum::FromViewProjection(projection * Matrix4x4::LookAt(eye, target, Vector3(0.0f, 1.0f, 0.0f)));
+
+        std::vector<uint32_t> expectedBoxes;
+        std::vector<uint32_t> expectedSpheres;
+        for (uint32_t i = 0; i < VolumeCount; i++) {
+            if (frustum.Intersects(AABB::FromCenterExtents(centers.Get(i), extents.Get(i)))) {
+                expectedBoxes.push_back(i);
+            }
+            if (frustum.Intersects(BoundingSphere(centers.Get(i), radii[i]))) {
+                expectedSpheres.push_back(i);
+            }
+        }
+        visibleBoxes += static_cast<uint32_t>(expectedBoxes.size());
+        visibleSpheres += static_cast<uint32_t>(expectedSpheres.size());
+
+        Check("CullBoxes", camera, expectedBoxes, indices,
+              CullBoxes(frustum, centers.AsSpan(), extents.AsSpan(), indices, BaseIndex), BaseIndex);
+        Check("ParallelCullBoxes", camera, expectedBoxes, indices,
+              ParallelCullBoxes(frustum, centers.AsSpan(), extents.AsSpan(), indices, 1000), 0);
+        Check("CullSpheres", camera, expectedSpheres, indices,
+              CullSpheres(frustum, centers.AsSpan(), radii, indices, BaseIndex), BaseIndex);
+        Check("ParallelCullSpheres", camera, expectedSpheres, indices,
+              ParallelCullSpheres(frustum, centers.AsSpan(), radii, indices, 1000), 0);
+    }
+
+    RLOG_INFO("%s: %u boxes and %u spheres visible over %u cameras, %u mismatches", SIMD::GetInstructionSetName(),
+              visibleBoxes, visibleSpheres, CameraCount, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
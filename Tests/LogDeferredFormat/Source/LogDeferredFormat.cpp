@@ -0,0 +1,138 @@
+﻿#include <Reality.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace Reality;
+
+// Deferred records must print exactly what immediate formatting prints.
+// Each case is formatted both ways directly, then the whole set is logged
+// through the asynchronous Log with and without deferFormatting and the
+// two JSON files compared.
+
+namespace {
+    enum class Channel : uint8_t {
+        Audio = 3,
+        Network = 200
+    };
+
+    uint32_t g_failures = 0;
+
+    // Formats a case both ways and compares
+    struct CheckSink {
+        uint32_t caseCount = 0;
+
+        template<typename... Args>
+        void operator()(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+            char immediate[Log::MessageCapacity];
+            stbsp_snprintf(immediate, sizeof(immediate), format.Get(), Detail::ToPrintfArgument(args)...);
+
+            uint8_t arguments[512];
+            const uint32_t size = EncodeLogArguments(arguments, sizeof(arguments), args...);
+            char deferred[Log::MessageCapacity];
+            FormatLogArguments(deferred, sizeof(deferred), format.Get(), arguments, size);
+
+            if (strcmp(immediate, deferred) != 0) {
+                RLOG_ERROR("\"%s\": immediate \"%s\", deferred \"%s\"", format.Get(), immediate, deferred);
+                g_failures++;
+            }
+            caseCount++;
+        }
+    };
+
+    struct LogSink {
+        template<typename... Args>
+        void operator()(LogFormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+            Log::GetInstance().Info(format, args...);
+        }
+    };
+
+    template<typename Sink>
+    void RunCases(Sink& sink) {
+        const int minusOne = -1;
+        sink("%d %i %u %x %X %o", minusOne, minusOne, minusOne, minusOne, minusOne, minusOne);
+        sink("%d %u %x", 123456789, 4000000000u, 0xDEADBEEFu);
+        sink("%hd %hu %hx %hhd %hhu %hhx", 40000, minusOne, minusOne, 200, minusOne, minusOne);
+        sink("%d %u %d %u", static_cast<int8_t>(-5), static_cast<uint8_t>(250), static_cast<int16_t>(-300), static_cast<uint16_t>(65000));
+        sink("%ld %lu %lx", -7L, static_cast<unsigned long>(-7L), -7L);
+        sink("%lld %llu %llx %llX", -9LL, static_cast<unsigned long long>(-9LL), -9LL, 0xABCDEF0123456789ULL);
+        sink("%zu %zx %td", static_cast<size_t>(-1), static_cast<size_t>(48879), static_cast<ptrdiff_t>(-12));
+        sink("%jd %ju", static_cast<intmax_t>(INT64_MIN), static_cast<uintmax_t>(UINT64_MAX));
+        sink("[%5d] [%-5d] [%05d] [%+d] [% d] [%#x] [%#o]", 42, 42, 42, 42, 42, 255, 8);
+        sink("[%*d] [%-*d] [%.*d] [%*.*x]", 6, -17, 6, -17, 4, 7, 8, 3, 0xFFu);
+        sink("[%.0d] [%.3u] [%8.4x]", 0, 5u, 0xBEEFu);
+        sink("[%.*f] [%.*d] [%.*s] [%8.*e]", -1, 2.5, -1, 42, -1, "text", -1, 0.125);
+        sink("[%.*f] [%.*d] [%.*s]", -3, 2.5, -7, 42, -2, "text");
+        sink("%c%c%c", 'a', static_cast<char>(66), 67);
+        sink("%d %u", true, Channel::Network);
+        sink("%d", Channel::Audio);
+        sink("%f %.2f %10.3f %-10.1f|", 3.14159265, -2.5, 1e6, 0.25f);
+        sink("%e %.3E %g %G %.10g", 12345.678, -0.000123, 1e-5, 1e20, 1.0 / 3.0);
+        sink("%a %A", 1.0, -0.5);
+        sink("%f %f %f", 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0);
+        sink("%s|%10s|%-10s|%.3s|%8.2s|", "text", "right", "left", "truncated", "ab");
+        const char* empty = "";
+        // Read through a volatile so the compiler does not warn about the null %s
+        const char* volatile nullSource = nullptr;
+        const char* null = nullSource;
+        sink("[%s] [%s]", empty, null);
+        sink("%p %p", static_cast<const void*>(&g_failures), static_cast<const void*>(nullptr));
+        sink("100%% done, %d%% left", 0);
+        sink("no arguments at all");
+    }
+
+    std::vector<std::string> LogCases(const bool deferFormatting) {
+        const std::string path = (std::filesystem::temp_directory_path() / "RealityLogDeferredFormat.jsonl").string();
+
+        Log& log = Log::GetInstance();
+        log.EnableConsoleOutput(false);
+        LogAsyncDesc desc;
+        desc.deferFormatting = deferFormatting;
+        desc.jsonFile = path;
+        log.StartAsync(desc);
+        LogSink sink;
+        RunCases(sink);
+        log.StopAsync();
+        log.EnableConsoleOutput(true);
+
+        // Times and threads differ between the runs, the messages may not
+        std::vector<std::string> messages;
+        std::ifstream input(path);
+        for (std::string line; std::getline(input, line);) {
+            const size_t message = line.find("\"message\":");
+            messages.push_back(message == std::string::npos ? line : line.substr(message));
+        }
+        input.close();
+        std::filesystem::remove(path);
+        return messages;
+    }
+}
+
+int main() {
+    Log::GetInstance().EnableColors(false);
+    Log::GetInstance().SetRateLimit(0, 0);
+
+    CheckSink check;
+    RunCases(check);
+    const uint32_t caseCount = check.caseCount;
+
+    const std::vector<std::string> immediate = LogCases(false);
+    const std::vector<std::string> deferred = LogCases(true);
+    if (immediate.size() != caseCount || deferred.size() != caseCount) {
+        RLOG_ERROR("Logged %u cases, %zu lines immediate and %zu deferred", caseCount, immediate.size(), deferred.size());
+        g_failures++;
+    } else {
+        for (uint32_t index = 0; index < caseCount; index++) {
+            if (immediate[index] != deferred[index]) {
+                RLOG_ERROR("Logged immediate %s, deferred %s", immediate[index].c_str(), deferred[index].c_str());
+                g_failures++;
+            }
+        }
+    }
+
+    RLOG_INFO("%u format cases, %u failures", caseCount, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+﻿#include <Reality.h>
+#include <Core/LogFileSink.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Reality;
+
+// Drives LogFileSink directly and reads back what reached the disk: size
+// rotation keeps whole, consecutive lines within the limit and the number
+// of files asked for, full chunks end on page boundaries, urgent lines and
+// due lines are written at once, a file that cannot be opened is retried,
+// and daily rotation starts a new file at local midnight.
+
+namespace {
+    namespace fs = std::filesystem;
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    std::string ReadFile(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::vector<std::string> ReadLines(const fs::path& path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path, std::ios::binary);
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    std::string NumberedLine(uint32_t number) {
+        char line[96];
+        snprintf(line, sizeof(line), "line %06u of the rotation test, padded to vary %.*s", number,
+                 static_cast<int>(number % 17), "xxxxxxxxxxxxxxxxx");
+        return line;
+    }
+
+    void TestSizeRotation(const fs::path& directory) {
+        LogFileDesc desc;
+        desc.path = (directory / "size.log").string();
+        desc.bufferSize = 4096;
+        desc.flushLevel = LogLevel::Fatal;
+        desc.maxFileSize = 10000;
+        desc.maxFiles = 3;
+
+        constexpr uint32_t LineCount = 3000;
+        LogFileSink sink;
+        Check(sink.Open(desc), "Size rotation: Open");
+        for (uint32_t i = 0; i < LineCount; i++) {
+            sink.Write(LogLevel::Info, NumberedLine(i));
+        }
+        sink.Close();
+
+        // Oldest first, each file whole lines that continue the previous one
+        const fs::path files[] = { directory / "size.3.log", directory / "size.2.log", directory / "size.1.log",
+                                   directory / "size.log" };
+        Check(!fs::exists(directory / "size.4.log"), "Size rotation: more files kept than maxFiles");
+        int64_t expected = -1;
+        for (const fs::path& path : files) {
+            const std::string contents = ReadFile(path);
+            Check(!contents.empty() && contents.size() <= desc.maxFileSize && contents.back() == '\n',
+                  "Size rotation: file empty, too large or ending mid-line");
+            for (const std::string& line : ReadLines(path)) {
+                const uint32_t number = static_cast<uint32_t>(std::strtoul(line.c_str() + 5, nullptr, 10));
+                if (expected < 0) {
+                    expected = number;
+                }
+                Check(line == NumberedLine(static_cast<uint32_t>(expected)), "Size rotation: line lost or out of order");
+                expected = number + 1;
+            }
+        }
+        Check(expected == LineCount, "Size rotation: last line missing");
+    }
+
+    // A full buffer is written up to a page boundary of the file, also when
+    // appending to a file that does not end on one
+    void TestAlignedChunks(const fs::path& directory) {
+        LogFileDesc desc;
+        desc.path = (directory / "aligned.log").string();
+        desc.bufferSize = 4096 * 3;
+        desc.flushLevel = LogLevel::Fatal;
+        desc.flushIntervalMs = 60000;
+
+        std::ofstream(desc.path, std::ios::binary) << std::string(1000, '#') << '\n';
+        std::string expected = ReadFile(desc.path);
+
+        LogFileSink sink;
+        Check(sink.Open(desc), "Aligned chunks: Open");
+        bool aligned = true;
+        uintmax_t written = fs::file_size(desc.path);
+        for (uint32_t i = 0; i < 2000; i++) {
+            const std::string line = NumberedLine(i);
+            sink.Write(LogLevel::Info, line);
+            expected += line + '\n';
+            const uintmax_t size = fs::file_size(desc.path);
+            if (size != written) {
+                aligned &= size % 4096 == 0;
+                written = size;
+            }
+        }
+        Check(aligned && written > 4096, "Aligned chunks: a full chunk ended off a page boundary");
+        sink.Close();
+        Check(ReadFile(desc.path) == expected, "Aligned chunks: contents differ");
+
+        // Starting over instead of appending
+        desc.append = false;
+        Check(sink.Open(desc), "Aligned chunks: Open without append");
+        sink.Write(LogLevel::Info, "fresh");
+        sink.Close();
+        Check(ReadFile(desc.path) == "fresh\n", "Aligned chunks: append off kept the old contents");
+    }
+
+    void TestFlushing(const fs::path& directory) {
+        LogFileDesc desc;
+        desc.path = (directory / "flush.log").string();
+        desc.append = false;
+        desc.flushLevel = LogLevel::Error;
+        desc.flushIntervalMs = 50;
+
+        LogFileSink sink;
+        Check(sink.Open(desc), "Flushing: Open");
+        sink.Write(LogLevel::Info, "buffered");
+        sink.FlushIfDue();
+        Check(ReadFile(desc.path).empty(), "Flushing: line written before it was due");
+        sink.Write(LogLevel::Error, "urgent");
+        Check(ReadFile(desc.path) == "buffered\nurgent\n", "Flushing: urgent line not written at once");
+
+        sink.Write(LogLevel::Info, "due");
+        std::this_thread::sleep_for(std::chrono::milliseconds(desc.flushIntervalMs + 20));
+        sink.FlushIfDue();
+        Check(ReadFile(desc.path) == "buffered\nurgent\ndue\n", "Flushing: due line not written");
+        sink.Close();
+    }
+
+    void TestReopen(const fs::path& directory) {
+        LogFileDesc desc;
+        desc.path = (directory / "missing" / "reopen.log").string();
+        desc.flushIntervalMs = 20;
+
+        LogFileSink sink;
+        Check(!sink.Open(desc) && !sink.IsOpen(), "Reopen: Open succeeded without the directory");
+        Check(!sink.Reopen(), "Reopen: retried before the interval");
+        fs::create_directories(directory / "missing");
+        std::this_thread::sleep_for(std::chrono::milliseconds(desc.flushIntervalMs + 10));
+        Check(sink.Reopen() && sink.IsOpen(), "Reopen: not reopened once possible");
+        sink.Write(LogLevel::Info, "recovered");
+        sink.Close();
+        Check(ReadFile(desc.path) == "recovered\n", "Reopen: line lost");
+        Check(!sink.Reopen(), "Reopen: reopened after Close");
+    }
+
+    // Moves local midnight a second or two ahead through TZ, so the test
+    // does not wait for the real one
+    void TestDailyRotation(const fs::path& directory) {
+#ifdef _WIN32
+        (void)directory;
+        RLOG_INFO("Daily rotation: skipped, needs a POSIX TZ");
+#else
+        const auto now = std::chrono::system_clock::now();
+        const int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+        const int64_t east = 86400 - seconds % 86400 - 2;
+        char zone[32];
+        snprintf(zone, sizeof(zone), "TEST-%02d:%02d:%02d", static_cast<int>(east / 3600), static_cast<int>(east / 60 % 60),
+                 static_cast<int>(east % 60));
+        setenv("TZ", zone, 1);
+        tzset();
+
+        LogFileDesc desc;
+        desc.path = (directory / "daily.log").string();
+        desc.rotateDaily = true;
+        desc.flushLevel = LogLevel::Trace;
+
+        LogFileSink sink;
+        Check(sink.Open(desc), "Daily rotation: Open");
+        sink.Write(LogLevel::Info, "before midnight");
+        std::this_thread::sleep_until(std::chrono::system_clock::time_point(std::chrono::seconds(seconds + 2)) +
+                                      std::chrono::milliseconds(100));
+        sink.Write(LogLevel::Info, "after midnight");
+        sink.Close();
+        unsetenv("TZ");
+        tzset();
+
+        Check(ReadFile(directory / "daily.1.log") == "before midnight\n" && ReadFile(directory / "daily.log") == "after midnight\n",
+              "Daily rotation: no new file at midnight");
+#endif
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    const fs::path directory = fs::temp_directory_path() / "RealityLogFileRotation";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    TestSizeRotation(directory);
+    TestAlignedChunks(directory);
+    TestFlushing(directory);
+    TestReopen(directory);
+    TestDailyRotation(directory);
+
+    fs::remove_all(directory);
+    RLOG_INFO("%u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+﻿#include <Reality.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Reality;
+
+// A rate limited site lets its messages through per window and counts the
+// rest: every call is either allowed or counted exactly once, also across
+// threads, the count is handed to the next message of a new window, and a
+// site that stays quiet is reported by Log once its window has ended.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t Interval = 200;
+    constexpr auto PastInterval = std::chrono::milliseconds(Interval + 50);
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    // Checks that rely on the window still being open are skipped if the
+    // machine stalled for longer than the interval
+    bool WindowOpen(Clock::time_point start) {
+        return Clock::now() - start < std::chrono::milliseconds(Interval);
+    }
+
+    void TestWindows() {
+        LogRateLimiter limiter;
+        uint64_t suppressed = ~0ull;
+        Check(limiter.Allow(0, Interval, suppressed) && suppressed == ~0ull, "0 messages is not unlimited");
+
+        const Clock::time_point start = Clock::now();
+        uint32_t allowed = 0;
+        for (uint32_t call = 0; call < 10; call++) {
+            suppressed = 0;
+            if (limiter.Allow(3, Interval, suppressed)) {
+                allowed++;
+                Check(suppressed == 0, "First window handed back a suppressed count");
+            }
+        }
+        if (WindowOpen(start)) {
+            Check(allowed == 3, "First window did not allow exactly 3 messages");
+            Check(limiter.MarkPending(), "First suppressed call was not marked pending");
+            Check(!limiter.MarkPending(), "Site was marked pending twice");
+            uint64_t pending = 0;
+            Check(!limiter.TakePending(Interval, false, pending), "Pending count taken before the window ended");
+        }
+
+        // A new window hands back what the last one dropped
+        std::this_thread::sleep_for(PastInterval);
+        suppressed = 0;
+        Check(limiter.Allow(3, Interval, suppressed), "New window did not allow a message");
+        Check(suppressed == 7, "New window did not hand back 7 suppressed calls");
+
+        // Taken by Log instead once the window ends
+        const Clock::time_point second = Clock::now();
+        allowed = 1;
+        for (uint32_t call = 0; call < 5; call++) {
+            suppressed = 0;
+            allowed += limiter.Allow(3, Interval, suppressed) ? 1 : 0;
+        }
+        uint64_t pending = 0;
+        if (WindowOpen(second)) {
+            Check(allowed == 3, "Second window did not allow exactly 3 messages");
+            // Still registered with Log from the first window
+            Check(!limiter.MarkPending(), "Site was marked pending while still registered");
+            Check(!limiter.TakePending(Interval, false, pending), "Pending count taken before the second window ended");
+        }
+        std::this_thread::sleep_for(PastInterval);
+        Check(limiter.TakePending(Interval, false, pending) && pending == 3, "Ended window did not give up 3 suppressed calls");
+        Check(limiter.MarkPending(), "Taking the count did not clear the pending mark");
+
+        // Nothing is left for the next message
+        suppressed = ~0ull;
+        Check(limiter.Allow(3, Interval, suppressed) && suppressed == 0, "Taken count was handed back again");
+
+        // Force takes the count at once
+        for (uint32_t call = 0; call < 4; call++) {
+            limiter.Allow(1, Interval, suppressed);
+        }
+        Check(limiter.TakePending(Interval, true, pending) && pending == 4, "Forced take did not give up 4 suppressed calls");
+    }
+
+    // Every call is allowed or counted once, however the threads interleave
+    void TestThreads(uint32_t messages, uint32_t intervalMs) {
+        constexpr uint32_t ThreadCount = 8;
+        constexpr uint32_t CallCount = 50000;
+
+        LogRateLimiter limiter;
+        std::atomic<uint64_t> allowed{0};
+        std::atomic<uint64_t> handed{0};
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < ThreadCount; thread++) {
+            threads.emplace_back([&] {
+                uint64_t threadAllowed = 0;
+                uint64_t threadHanded = 0;
+                for (uint32_t call = 0; call < CallCount; call++) {
+                    uint64_t suppressed = 0;
+                    if (limiter.Allow(messages, intervalMs, suppressed)) {
+                        threadAllowed++;
+                        threadHanded += suppressed;
+                    }
+                }
+                allowed += threadAllowed;
+                handed += threadHanded;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        uint64_t pending = 0;
+        limiter.TakePending(intervalMs, true, pending);
+        const uint64_t total = static_cast<uint64_t>(ThreadCount) * CallCount;
+        if (allowed + handed + pending != total) {
+            RLOG_ERROR("%u messages per %u ms: %llu allowed, %llu handed back and %llu pending of %llu calls", messages, intervalMs,
+                       static_cast<unsigned long long>(allowed.load()), static_cast<unsigned long long>(handed.load()),
+                       static_cast<unsigned long long>(pending), static_cast<unsigned long long>(total));
+            g_failures++;
+        }
+        if (intervalMs >= 10000 && allowed != messages) {
+            RLOG_ERROR("%llu messages allowed in one window of %u", static_cast<unsigned long long>(allowed.load()), messages);
+            g_failures++;
+        }
+    }
+
+    uint32_t CountLines(const std::vector<std::string>& lines, const char* text) {
+        uint32_t count = 0;
+        for (const std::string& line : lines) {
+            count += line.find(text) != std::string::npos ? 1 : 0;
+        }
+        return count;
+    }
+
+    void LogBurst(uint32_t count) {
+        for (uint32_t index = 0; index < count; index++) {
+            RLOG_AT_RATE(LogLevel::Info, 3, Interval, "Burst message %u", index);
+        }
+    }
+
+    // The macros through Log into a file
+    void TestLog() {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "RealityLogRateLimit.log";
+        std::filesystem::remove(path);
+
+        Log& log = Log::GetInstance();
+        log.EnableConsoleOutput(false);
+        log.SetLogFile(path.string());
+        log.EnableFileOutput(true);
+
+        // Reported with the next message of the site
+        LogBurst(10);
+        std::this_thread::sleep_for(PastInterval);
+        LogBurst(1);
+        log.Flush();
+        // Reported by Log once the window ends, with another site's message
+        LogBurst(9);
+        std::this_thread::sleep_for(PastInterval);
+        RLOG_AT_RATE(LogLevel::Info, 0, 0, "Unlimited message");
+        // Reported by Flush at once
+        std::this_thread::sleep_for(PastInterval);
+        LogBurst(5);
+        log.Flush();
+
+        log.EnableFileOutput(false);
+        log.EnableConsoleOutput(true);
+
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        file.close();
+        std::filesystem::remove(path);
+
+        Check(CountLines(lines, "Burst message") == 3 + 1 + 2 + 3, "Log did not keep 9 burst messages");
+        Check(CountLines(lines, "Unlimited message") == 1, "Log dropped the unlimited message");
+        Check(CountLines(lines, "Suppressed 7 repeats") == 2, "Log did not report 7 suppressed repeats twice");
+        Check(CountLines(lines, "Suppressed 2 repeats") == 1, "Log did not report 2 suppressed repeats");
+        Check(CountLines(lines, "Suppressed") == 3, "Log reported suppressed messages more than 3 times");
+        if (lines.size() != 13) {
+            RLOG_ERROR("Log file has %zu lines, expected 13", lines.size());
+            g_failures++;
+        }
+    }
+}
+
+int main() {
+    Log::GetInstance().EnableColors(false);
+    Log::GetInstance().SetRateLimit(0, 0);
+
+    TestWindows();
+    TestThreads(5, 100000);
+    TestThreads(5, 1);
+    TestThreads(1, 0);
+    TestLog();
+
+    RLOG_INFO("Rate limiter checked, %u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+﻿#include <Reality.h>
+#include <Core/LogRingBuffer.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Reality;
+
+// Several producers against one consumer: every record must arrive once,
+// whole, and in the order its producer pushed it. First on a small ring
+// directly, then through the asynchronous Log with the Block policy.
+
+namespace {
+    constexpr uint32_t ProducerCount = 8;
+
+    struct RecordHeader {
+        uint32_t producer;
+        uint32_t index;
+    };
+
+    // Sizes from nothing to several cells, so records wrap around the ring
+    uint32_t GetPayloadSize(const uint32_t producer, const uint32_t index) {
+        return (producer * 131 + index * 37) % 300;
+    }
+
+    uint8_t GetPayloadByte(const uint32_t producer, const uint32_t index, const uint32_t offset) {
+        return static_cast<uint8_t>(producer * 31 + index * 7 + offset);
+    }
+
+    bool TestRing() {
+        constexpr uint32_t RecordCount = 50000;
+        LogRingBuffer ring(4096);
+
+        std::vector<std::thread> producers;
+        for (uint32_t producer = 0; producer < ProducerCount; producer++) {
+            producers.emplace_back([&ring, producer] {
+                uint8_t payload[300];
+                for (uint32_t index = 0; index < RecordCount; index++) {
+                    const RecordHeader header = { producer, index };
+                    const uint32_t size = GetPayloadSize(producer, index);
+                    for (uint32_t offset = 0; offset < size; offset++) {
+                        payload[offset] = GetPayloadByte(producer, index, offset);
+                    }
+                    while (!ring.TryPush(&header, sizeof(header), payload, size)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::vector<uint32_t> next(ProducerCount, 0);
+        std::vector<uint8_t> record;
+        uint64_t received = 0;
+        uint64_t errors = 0;
+        while (received < static_cast<uint64_t>(ProducerCount) * RecordCount) {
+            if (!ring.TryPop(record)) {
+                std::this_thread::yield();
+                continue;
+            }
+            received++;
+
+            RecordHeader header;
+            memcpy(&header, record.data(), sizeof(header));
+            const uint32_t size = GetPayloadSize(header.producer, header.index);
+            bool valid = header.producer < ProducerCount && header.index == next[header.producer] &&
+                         record.size() == sizeof(header) + size;
+            for (uint32_t offset = 0; valid && offset < size; offset++) {
+                valid = record[sizeof(header) + offset] == GetPayloadByte(header.producer, header.index, offset);
+            }
+            if (!valid) {
+                if (errors++ == 0) {
+                    RLOG_ERROR("Ring record %u of producer %u is out of order or damaged", header.index, header.producer);
+                }
+                continue;
+            }
+            next[header.producer]++;
+        }
+
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        if (!ring.IsEmpty()) {
+            RLOG_ERROR("Ring holds records nobody pushed");
+            errors++;
+        }
+        RLOG_INFO("Ring: %llu records from %u producers, %llu errors", static_cast<unsigned long long>(received), ProducerCount,
+                  static_cast<unsigned long long>(errors));
+        return errors == 0;
+    }
+
+    bool TestAsyncLog() {
+        constexpr uint32_t MessageCount = 20000;
+        const std::string path = (std::filesystem::temp_directory_path() / "RealityLogRingBuffer.jsonl").string();
+
+        Log& log = Log::GetInstance();
+        log.EnableConsoleOutput(false);
+        LogAsyncDesc desc;
+        desc.bufferSize = 16 << 10;             // Small, so producers wait on the sink
+        desc.overflowPolicy = LogOverflowPolicy::Block;
+        desc.jsonFile = path;
+        log.StartAsync(desc);
+
+        std::vector<std::thread> producers;
+        for (uint32_t producer = 0; producer < ProducerCount; producer++) {
+            producers.emplace_back([&log, producer] {
+                for (uint32_t index = 0; index < MessageCount; index++) {
+                    log.Info("producer %u message %u", producer, index);
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        log.StopAsync();
+        log.EnableConsoleOutput(true);
+
+        // Each producer's messages must all be there, in order
+        std::vector<uint32_t> next(ProducerCount, 0);
+        uint64_t errors = 0;
+        std::ifstream input(path);
+        for (std::string line; std::getline(input, line);) {
+            const size_t message = line.find("\"message\":\"");
+            unsigned producer = 0;
+            unsigned index = 0;
+            if (message == std::string::npos ||
+                sscanf(line.c_str() + message, "\"message\":\"producer %u message %u\"", &producer, &index) != 2 ||
+                producer >= ProducerCount || index != next[producer]) {
+                errors++;
+                continue;
+            }
+            next[producer]++;
+        }
+        input.close();
+        std::filesystem::remove(path);
+
+        for (uint32_t producer = 0; producer < ProducerCount; producer++) {
+            if (next[producer] != MessageCount) {
+                RLOG_ERROR("Producer %u: %u of %u messages written", producer, next[producer], MessageCount);
+                errors++;
+            }
+        }
+        if (log.GetDroppedCount() != 0) {
+            RLOG_ERROR("%llu messages dropped under the Block policy", static_cast<unsigned long long>(log.GetDroppedCount()));
+            errors++;
+        }
+        RLOG_INFO("Asynchronous log: %u messages from %u producers, %llu errors", ProducerCount * MessageCount, ProducerCount,
+                  static_cast<unsigned long long>(errors));
+        return errors == 0;
+    }
+}
+
+int main() {
+    Log::GetInstance().EnableColors(false);
+    const bool ring = TestRing();
+    const bool log = TestAsyncLog();
+    return ring && log ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+﻿#include <Reality.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace Reality;
+
+// Structured records reach every sink of the asynchronous pipeline: each
+// JSON line parses, with the time, level, frame, thread, message and the
+// fields as typed values, escaped strings and cut records included, and
+// Tools/LogDecoder turns the binary file into exactly the JSON lines and
+// the text lines the other sinks wrote. Runs with and without deferred
+// formatting.
+
+namespace {
+    namespace fs = std::filesystem;
+
+    constexpr uint32_t WorkerCount = 4;
+    constexpr uint32_t WorkerRecords = 500;
+    constexpr uint64_t Frame = 7;
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    std::vector<std::string> ReadLines(const fs::path& path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path, std::ios::binary);
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Flat JSON object, which is all the sink writes. Numbers keep their text.
+    struct JsonValue {
+        enum class Kind {
+            String,
+            Number,
+            Null
+        };
+
+        Kind kind = Kind::Null;
+        std::string text;
+    };
+
+    using JsonObject = std::vector<std::pair<std::string, JsonValue>>;
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& text) : m_text(text) {}
+
+        bool ParseObject(JsonObject& object) {
+            if (!Consume('{')) {
+                return false;
+            }
+            while (m_offset < m_text.size() && m_text[m_offset] != '}') {
+                if (!object.empty() && !Consume(',')) {
+                    return false;
+                }
+                std::string key;
+                JsonValue value;
+                if (!ParseString(key) || !Consume(':') || !ParseValue(value)) {
+                    return false;
+                }
+                object.emplace_back(std::move(key), std::move(value));
+            }
+            return Consume('}') && m_offset == m_text.size();
+        }
+
+    private:
+        bool Consume(char character) {
+            if (m_offset < m_text.size() && m_text[m_offset] == character) {
+                m_offset++;
+                return true;
+            }
+            return false;
+        }
+
+        bool ParseValue(JsonValue& value) {
+            if (m_offset < m_text.size() && m_text[m_offset] == '"') {
+                value.kind = JsonValue::Kind::String;
+                return ParseString(value.text);
+            }
+            if (m_text.compare(m_offset, 4, "null") == 0) {
+                value.kind = JsonValue::Kind::Null;
+                m_offset += 4;
+                return true;
+            }
+            const size_t start = m_offset;
+            while (m_offset < m_text.size() && std::string_view("-+.eE0123456789").find(m_text[m_offset]) != std::string_view::npos) {
+                m_offset++;
+            }
+            value.kind = JsonValue::Kind::Number;
+            value.text = m_text.substr(start, m_offset - start);
+            return m_offset != start;
+        }
+
+        bool ParseString(std::string& value) {
+            if (!Consume('"')) {
+                return false;
+            }
+            while (m_offset < m_text.size()) {
+                const char character = m_text[m_offset++];
+                if (character == '"') {
+                    return true;
+                }
+                if (static_cast<unsigned char>(character) < 0x20) {
+                    return false;
+                }
+                if (character != '\\') {
+                    value += character;
+                    continue;
+                }
+                if (m_offset >= m_text.size()) {
+                    return false;
+                }
+                switch (m_text[m_offset++]) {
+                    case '"': value += '"'; break;
+                    case '\\': value += '\\'; break;
+                    case '/': value += '/'; break;
+                    case 'b': value += '\b'; break;
+                    case 'f': value += '\f'; break;
+                    case 'n': value += '\n'; break;
+                    case 'r': value += '\r'; break;
+                    case 't': value += '\t'; break;
+                    case 'u': {
+                        // The sink only escapes control characters this way
+                        if (m_offset + 4 > m_text.size()) {
+                            return false;
+                        }
+                        const unsigned long code = strtoul(m_text.substr(m_offset, 4).c_str(), nullptr, 16);
+                        if (code >= 0x80) {
+                            return false;
+                        }
+                        value += static_cast<char>(code);
+                        m_offset += 4;
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+            return false;
+        }
+
+        const std::string& m_text;
+        size_t m_offset = 0;
+    };
+
+    const JsonValue* Find(const JsonObject& object, const char* key) {
+        for (const auto& [name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    bool HasString(const JsonObject& object, const char* key, const std::string& text) {
+        const JsonValue* value = Find(object, key);
+        return value && value->kind == JsonValue::Kind::String && value->text == text;
+    }
+
+    bool HasNumber(const JsonObject& object, const char* key, const std::string& text) {
+        const JsonValue* value = Find(object, key);
+        return value && value->kind == JsonValue::Kind::Number && value->text == text;
+    }
+
+    const std::string EscapedMessage = "Quote \" backslash \\ tab \t newline \n bell \x07 utf8 \xC3\xA9 end";
+    const std::string PlainMessage = "Plain\ttext";
+
+    void LogRecords(uint32_t workerThreads[WorkerCount]) {
+        const void* pointer = reinterpret_cast<const void*>(static_cast<uintptr_t>(0x1234));
+        RLOG_FIELDS(LogLevel::Info, "Frame submitted", LogField("subsystem", "Render"), LogField("duration", 1.25),
+                    LogField("count", -3), LogField("big", std::numeric_limits<uint64_t>::max()),
+                    LogField("ratio", std::numeric_limits<double>::quiet_NaN()), LogField("pointer", pointer),
+                    LogField("flag", true));
+        RLOG_FIELDS(LogLevel::Warning, EscapedMessage, LogField("path", "C:\\dir\\\"x\""));
+        RLOG_INFO("Formatted %d %s %.2f", 42, "with \"quotes\"", 0.5);
+        Log::GetInstance().LogMessage(LogLevel::Error, PlainMessage);
+
+        // Cut to the record, and the JSON line cut to its capacity
+        const std::string longText(3000, 'x');
+        RLOG_FIELDS(LogLevel::Info, "Long field", LogField("before", 1), LogField("long", longText.c_str()), LogField("after", 2));
+        const std::string controls(Log::MessageCapacity - 1, '\x01');
+        Log::GetInstance().LogMessage(LogLevel::Info, controls);
+
+        std::vector<std::thread> threads;
+        for (uint32_t worker = 0; worker < WorkerCount; worker++) {
+            threads.emplace_back([worker, workerThreads] {
+                workerThreads[worker] = GetLogThreadId();
+                for (uint32_t index = 0; index < WorkerRecords; index++) {
+                    RLOG_FIELDS(LogLevel::Info, "Worker", LogField("worker", worker), LogField("index", index));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void CheckJson(const std::vector<std::string>& lines, const uint32_t workerThreads[WorkerCount],
+                   long long startTime, long long endTime) {
+        constexpr size_t FixedCount = 6;
+        if (lines.size() != FixedCount + WorkerCount * WorkerRecords) {
+            RLOG_ERROR("JSON file has %zu lines, expected %zu", lines.size(), FixedCount + WorkerCount * WorkerRecords);
+            g_failures++;
+            return;
+        }
+
+        std::vector<JsonObject> objects(lines.size());
+        for (size_t index = 0; index < lines.size(); index++) {
+            JsonObject& object = objects[index];
+            if (!JsonParser(lines[index]).ParseObject(object)) {
+                RLOG_ERROR("JSON line %zu does not parse: %.200s", index, lines[index].c_str());
+                g_failures++;
+                continue;
+            }
+            const char* keys[] = { "time", "level", "frame", "thread", "message" };
+            bool header = object.size() >= std::size(keys);
+            for (size_t key = 0; header && key < std::size(keys); key++) {
+                header = object[key].first == keys[key];
+            }
+            const JsonValue* time = Find(object, "time");
+            const long long nanoseconds = time ? strtoll(time->text.c_str(), nullptr, 10) : 0;
+            if (!header || !HasNumber(object, "frame", std::to_string(Frame)) || nanoseconds < startTime || nanoseconds > endTime) {
+                RLOG_ERROR("JSON line %zu has a wrong header: %.200s", index, lines[index].c_str());
+                g_failures++;
+            }
+        }
+
+        const JsonObject& fields = objects[0];
+        Check(HasString(fields, "level", "INFO") && HasString(fields, "message", "Frame submitted") &&
+              HasString(fields, "subsystem", "Render") && HasNumber(fields, "duration", "1.25") &&
+              HasNumber(fields, "count", "-3") && HasNumber(fields, "big", "18446744073709551615") &&
+              HasString(fields, "pointer", "0x1234") && HasNumber(fields, "flag", "1") && fields.size() == 12,
+              "JSON fields do not hold their values");
+        const JsonValue* ratio = Find(fields, "ratio");
+        Check(ratio && ratio->kind == JsonValue::Kind::Null, "JSON NaN field is not null");
+
+        Check(HasString(objects[1], "level", "WARNING") && HasString(objects[1], "message", EscapedMessage) &&
+              HasString(objects[1], "path", "C:\\dir\\\"x\""), "JSON strings are not escaped");
+        Check(HasString(objects[2], "message", "Formatted 42 with \"quotes\" 0.50"), "JSON lost the formatted message");
+        Check(HasString(objects[3], "level", "ERROR") && HasString(objects[3], "message", PlainMessage), "JSON lost the plain message");
+
+        const JsonValue* longField = Find(objects[4], "long");
+        Check(HasNumber(objects[4], "before", "1") && longField && longField->text.size() > 500 &&
+              longField->text.size() < 1024 && longField->text.find_first_not_of('x') == std::string::npos &&
+              !Find(objects[4], "after"), "JSON long field is not cut to the record");
+        const JsonValue* controls = Find(objects[5], "message");
+        Check(controls && !controls->text.empty() && controls->text.size() < Log::MessageCapacity - 1 &&
+              controls->text.find_first_not_of('\x01') == std::string::npos, "JSON long message is not cut to the line");
+
+        // Each worker's records in order, from its own thread
+        uint32_t next[WorkerCount] = {};
+        for (size_t index = FixedCount; index < objects.size(); index++) {
+            const JsonObject& object = objects[index];
+            const JsonValue* worker = Find(object, "worker");
+            const uint32_t workerIndex = worker ? static_cast<uint32_t>(strtoul(worker->text.c_str(), nullptr, 10)) : WorkerCount;
+            if (workerIndex >= WorkerCount || !HasString(object, "message", "Worker") ||
+                !HasNumber(object, "index", std::to_string(next[workerIndex])) ||
+                !HasNumber(object, "thread", std::to_string(workerThreads[workerIndex]))) {
+                RLOG_ERROR("JSON worker record out of order: %s", lines[index].c_str());
+                g_failures++;
+                break;
+            }
+            next[workerIndex]++;
+        }
+    }
+
+    // Decodes the binary file and compares with what the other sinks wrote
+    void CheckDecoder(const std::string& decoder, const fs::path& binaryPath, const fs::path& expectedPath, bool json) {
+        const fs::path decodedPath = binaryPath.parent_path() / (json ? "decoded.jsonl" : "decoded.log");
+        const std::string command = "\"" + decoder + "\"" + (json ? " --json " : " ") + "\"" + binaryPath.string() + "\" \"" +
+                                    decodedPath.string() + "\"";
+        if (std::system(command.c_str()) != 0) {
+            RLOG_ERROR("%s failed", command.c_str());
+            g_failures++;
+            return;
+        }
+
+        const std::vector<std::string> decoded = ReadLines(decodedPath);
+        const std::vector<std::string> expected = ReadLines(expectedPath);
+        if (decoded.size() != expected.size()) {
+            RLOG_ERROR("Decoded %zu %s lines, the sink wrote %zu", decoded.size(), json ? "JSON" : "text", expected.size());
+            g_failures++;
+            return;
+        }
+        for (size_t index = 0; index < decoded.size(); index++) {
+            if (decoded[index] != expected[index]) {
+                RLOG_ERROR("Decoded %s line %zu differs: %.200s", json ? "JSON" : "text", index, decoded[index].c_str());
+                g_failures++;
+                return;
+            }
+        }
+    }
+
+    void TestSinks(const fs::path& directory, const char* decoder, bool deferFormatting) {
+        const fs::path jsonPath = directory / "log.jsonl";
+        const fs::path binaryPath = directory / "log.bin";
+        const fs::path textPath = directory / "log.log";
+
+        Log& log = Log::GetInstance();
+        LogFileDesc fileDesc;
+        fileDesc.path = textPath.string();
+        fileDesc.append = false;
+        log.EnableConsoleOutput(false);
+        log.SetLogFile(fileDesc);
+        log.EnableFileOutput(true);
+        log.SetFrame(Frame);
+
+        LogAsyncDesc desc;
+        desc.deferFormatting = deferFormatting;
+        desc.jsonFile = jsonPath.string();
+        desc.binaryFile = binaryPath.string();
+        const long long startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        log.StartAsync(desc);
+        uint32_t workerThreads[WorkerCount] = {};
+        LogRecords(workerThreads);
+        log.StopAsync();
+        const long long endTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        log.SetFrame(0);
+        log.EnableFileOutput(false);
+        log.EnableConsoleOutput(true);
+
+        CheckJson(ReadLines(jsonPath), workerThreads, startTime, endTime);
+        if (decoder) {
+            CheckDecoder(decoder, binaryPath, jsonPath, true);
+            CheckDecoder(decoder, binaryPath, textPath, false);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Log::GetInstance().EnableColors(false);
+    Log::GetInstance().SetRateLimit(0, 0);
+
+    // Usage: LogStructuredSinks [LogDecoder path]
+    const char* decoder = argc > 1 ? argv[1] : nullptr;
+    if (!decoder) {
+        RLOG_WARNING("No LogDecoder given, the binary file is not checked");
+    }
+
+    const fs::path directory = fs::temp_directory_path() / "RealityLogStructuredSinks";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    TestSinks(directory, decoder, false);
+    TestSinks(directory, decoder, true);
+
+    fs::remove_all(directory);
+    RLOG_INFO("Structured sinks checked, %u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+﻿#include <Reality.h>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include "MathCases.h"
+
+// Runs every operation of MathCases.inl on random inputs with the SIMD
+// paths of this build and with the scalar ones, and fails if any result
+// differs by more than the case's tolerance.
+
+namespace SimdCases {
+#include "MathCases.inl"
+}
+
+namespace {
+    constexpr uint32_t Iterations = 10000;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+}
+
+int main() {
+    using namespace Reality;
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    if (SimdCases::CaseCount != ScalarCases::CaseCount) {
+        RLOG_ERROR("The SIMD and scalar builds have different cases");
+        return 1;
+    }
+
+    Random random;
+    uint32_t failures = 0;
+    for (uint32_t index = 0; index < SimdCases::CaseCount; index++) {
+        const MathCase& simd = SimdCases::Cases[index];
+        const MathCase& scalar = ScalarCases::Cases[index];
+
+        float worst = 0.0f;
+        for (uint32_t iteration = 0; iteration < Iterations; iteration++) {
+            float inputs[32];
+            float simdOutputs[16];
+            float scalarOutputs[16];
+            for (uint32_t i = 0; i < simd.inputCount; i++) {
+                inputs[i] = random.Next();
+            }
+            simd.run(inputs, simdOutputs);
+            scalar.run(inputs, scalarOutputs);
+
+            for (uint32_t i = 0; i < simd.outputCount; i++) {
+                const float error = std::fabs(simdOutputs[i] - scalarOutputs[i]) / std::fmax(std::fabs(scalarOutputs[i]), 1.0f);
+                if (!(error <= worst)) {
+                    worst = error;
+                }
+            }
+        }
+
+        const bool passed = worst <= simd.tolerance;
+        if (passed) {
+            RLOG_INFO("%-28s max error %.3g", simd.name, static_cast<double>(worst));
+        } else {
+            RLOG_ERROR("%-28s max error %.3g, over %.3g", simd.name, static_cast<double>(worst), static_cast<double>(simd.tolerance));
+            failures++;
+        }
+    }
+
+    RLOG_INFO("%s against scalar: %u of %u cases passed", SIMD::GetInstructionSetName(), SimdCases::CaseCount - failures,
+              SimdCases::CaseCount);
+    return failures == 0 ? 0 : 1;
+}
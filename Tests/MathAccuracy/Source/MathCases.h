@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <cstdint>
+
+// One operation of the math types, run on floats so the SIMD and scalar
+// builds of MathF.h can be compared without sharing a type
+struct MathCase {
+    const char* name;
+    uint32_t inputCount;
+    uint32_t outputCount;
+    float tolerance;                            // Relative, absolute below 1
+    void (*run)(const float* inputs, float* outputs);
+};
+
+// Inputs are in [-1, 1], each case maps them to the range it needs.
+// MathCases.inl defines both tables, in the same order.
+namespace SimdCases {
+    extern const MathCase Cases[];
+    extern const uint32_t CaseCount;
+}
+
+namespace ScalarCases {
+    extern const MathCase Cases[];
+    extern const uint32_t CaseCount;
+}
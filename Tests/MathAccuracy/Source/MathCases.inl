@@ -0,0 +1,102 @@
+﻿// Case table, included by MathAccuracy.cpp with the SIMD paths and by
+// ScalarCases.cpp with REALITY_MATH_SCALAR. Uses only Reality:: names, so
+// each build resolves them to its own copy of the math types.
+namespace {
+    using Reality::Matrix4x4;
+    using Reality::Quaternion;
+    using Reality::Vector3;
+    using Reality::Vector4;
+
+    Vector4 LoadVector4(const float* in) {
+        return Vector4(in[0], in[1], in[2], in[3]);
+    }
+
+    Quaternion LoadQuaternion(const float* in) {
+        return Quaternion(in[0], in[1], in[2], in[3]);
+    }
+
+    Quaternion LoadRotation(const float* in) {
+        return LoadQuaternion(in).Normalized();
+    }
+
+    // Diagonally dominant, so the inverse is well conditioned
+    Matrix4x4 LoadMatrix(const float* in) {
+        Matrix4x4 matrix;
+        for (int i = 0; i < 16; i++) {
+            matrix.m[i / 4][i % 4] = in[i] * 0.5f + (i % 5 == 0 ? 3.0f : 0.0f);
+        }
+        return matrix;
+    }
+
+    // Translation, rotation and optionally scale
+    Matrix4x4 LoadAffine(const float* in, bool scaled) {
+        const float scale = scaled ? 1.5f + in[7] : 1.0f;
+        return Matrix4x4::Translation(Vector3(in[4], in[5], in[6]) * 10.0f) * LoadRotation(in).ToMatrix4x4() *
+               Matrix4x4::Scale(scale);
+    }
+
+    void StoreVector4(const Vector4& v, float* out) {
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+        out[3] = v.w;
+    }
+
+    void StoreQuaternion(const Quaternion& q, float* out) {
+        out[0] = q.x;
+        out[1] = q.y;
+        out[2] = q.z;
+        out[3] = q.w;
+    }
+
+    void StoreMatrix(const Matrix4x4& matrix, float* out) {
+        for (int i = 0; i < 16; i++) {
+            out[i] = matrix.m[i / 4][i % 4];
+        }
+    }
+}
+
+const MathCase Cases[] = {
+    { "Vector4 negate", 4, 4, 0.0f, [](const float* in, float* out) { StoreVector4(-LoadVector4(in), out); } },
+    { "Vector4 add", 8, 4, 0.0f, [](const float* in, float* out) { StoreVector4(LoadVector4(in) + LoadVector4(in + 4), out); } },
+    { "Vector4 subtract", 8, 4, 0.0f, [](const float* in, float* out) { StoreVector4(LoadVector4(in) - LoadVector4(in + 4), out); } },
+    { "Vector4 scale", 5, 4, 0.0f, [](const float* in, float* out) { StoreVector4(LoadVector4(in) * in[4], out); } },
+    { "Vector4 multiply", 8, 4, 0.0f, [](const float* in, float* out) { StoreVector4(LoadVector4(in) * LoadVector4(in + 4), out); } },
+    { "Vector4 divide", 8, 4, 1e-6f, [](const float* in, float* out) {
+        StoreVector4(LoadVector4(in) / (LoadVector4(in + 4) * 0.5f + Vector4(1.5f)), out);
+    } },
+    { "Vector4 dot", 8, 1, 1e-6f, [](const float* in, float* out) { out[0] = LoadVector4(in).Dot(LoadVector4(in + 4)); } },
+    { "Vector4 length", 4, 1, 1e-6f, [](const float* in, float* out) { out[0] = LoadVector4(in).Length(); } },
+    { "Vector4 normalized", 4, 4, 1e-5f, [](const float* in, float* out) { StoreVector4(LoadVector4(in).Normalized(), out); } },
+    { "Vector4 equal", 8, 2, 0.0f, [](const float* in, float* out) {
+        out[0] = LoadVector4(in) == LoadVector4(in) ? 1.0f : 0.0f;
+        out[1] = LoadVector4(in) == LoadVector4(in + 4) ? 1.0f : 0.0f;
+    } },
+
+    { "Matrix4x4 multiply", 32, 16, 1e-6f, [](const float* in, float* out) { StoreMatrix(LoadMatrix(in) * LoadMatrix(in + 16), out); } },
+    { "Matrix4x4 transform", 20, 4, 1e-6f, [](const float* in, float* out) { StoreVector4(LoadMatrix(in) * LoadVector4(in + 16), out); } },
+    { "Matrix4x4 transposed", 16, 16, 0.0f, [](const float* in, float* out) { StoreMatrix(LoadMatrix(in).Transposed(), out); } },
+    { "Matrix4x4 inverse", 16, 16, 1e-5f, [](const float* in, float* out) { StoreMatrix(LoadMatrix(in).Inverse(), out); } },
+    { "Matrix4x4 inverse affine", 8, 16, 1e-5f, [](const float* in, float* out) { StoreMatrix(LoadAffine(in, true).InverseAffine(), out); } },
+    { "Matrix4x4 inverse rigid", 8, 16, 1e-5f, [](const float* in, float* out) { StoreMatrix(LoadAffine(in, false).InverseRigid(), out); } },
+
+    { "Quaternion negate", 4, 4, 0.0f, [](const float* in, float* out) { StoreQuaternion(-LoadQuaternion(in), out); } },
+    { "Quaternion add", 8, 4, 0.0f, [](const float* in, float* out) { StoreQuaternion(LoadQuaternion(in) + LoadQuaternion(in + 4), out); } },
+    { "Quaternion subtract", 8, 4, 0.0f, [](const float* in, float* out) { StoreQuaternion(LoadQuaternion(in) - LoadQuaternion(in + 4), out); } },
+    { "Quaternion multiply", 8, 4, 1e-6f, [](const float* in, float* out) { StoreQuaternion(LoadRotation(in) * LoadRotation(in + 4), out); } },
+    { "Quaternion scale", 5, 4, 0.0f, [](const float* in, float* out) { StoreQuaternion(LoadQuaternion(in) * in[4], out); } },
+    { "Quaternion conjugate", 4, 4, 0.0f, [](const float* in, float* out) { StoreQuaternion(LoadQuaternion(in).Conjugate(), out); } },
+    { "Quaternion dot", 8, 1, 1e-6f, [](const float* in, float* out) { out[0] = LoadQuaternion(in).Dot(LoadQuaternion(in + 4)); } },
+    { "Quaternion rotate", 7, 3, 1e-5f, [](const float* in, float* out) {
+        const Vector3 v = LoadRotation(in) * Vector3(in[4], in[5], in[6]);
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+    } },
+    { "Quaternion slerp", 9, 4, 1e-5f, [](const float* in, float* out) {
+        StoreQuaternion(Quaternion::Slerp(LoadRotation(in), LoadRotation(in + 4), in[8] * 0.5f + 0.5f), out);
+    } },
+    { "Quaternion to matrix", 4, 16, 1e-6f, [](const float* in, float* out) { StoreMatrix(LoadRotation(in).ToMatrix4x4(), out); } },
+};
+
+const uint32_t CaseCount = static_cast<uint32_t>(std::size(Cases));
@@ -0,0 +1,13 @@
+﻿// The scalar build of the math types, renamed so its inline functions do
+// not merge with the SIMD ones of MathAccuracy.cpp at link time
+#ifndef REALITY_MATH_SCALAR
+#define REALITY_MATH_SCALAR
+#endif
+#define Reality RealityScalar
+#include <Core/MathF.h>
+#include <iterator>
+#include "MathCases.h"
+
+namespace ScalarCases {
+#include "MathCases.inl"
+}
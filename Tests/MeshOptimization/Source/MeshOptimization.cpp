@@ -0,0 +1,192 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+using namespace Reality;
+
+// Runs the index buffer passes on a torus with shuffled triangles and
+// vertices, and fails if a pass loses, adds or flips a triangle, if the
+// vertex cache or fetch statistics get worse, or if the remap does not
+// number vertices in first use order.
+
+namespace {
+    constexpr uint32_t Rings = 96;
+    constexpr uint32_t Sides = 48;
+    constexpr uint32_t UnusedVertices = 100;    // Appended, for the remap to drop
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+        uint32_t NextIndex(uint32_t count) {
+            return static_cast<uint32_t>(Abs(Next()) * static_cast<float>(count)) % count;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    struct Vertex {
+        float position[3];
+        float normal[3];
+        uint32_t id;                            // Source vertex, so triangles can be compared after a remap
+        uint32_t padding;
+    };
+
+    using Triangle = std::array<uint32_t, 3>;
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    // Rotated to start at the smallest index, which keeps the winding
+    std::vector<Triangle> SortedTriangles(std::span<const uint32_t> indices, const Vertex* vertices = nullptr) {
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            Triangle triangle = { indices[i], indices[i + 1], indices[i + 2] };
+            if (vertices) {
+                for (uint32_t& index : triangle) {
+                    index = vertices[index].id;
+                }
+            }
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Torus with shuffled vertices and triangles, as an exporter might leave it
+    void MakeTorus(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        Random random;
+        const uint32_t usedCount = Rings * Sides;
+        std::vector<uint32_t> order(usedCount + UnusedVertices);
+        for (uint32_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        for (uint32_t i = static_cast<uint32_t>(order.size()) - 1; i > 0; i--) {
+            std::swap(order[i], order[random.NextIndex(i + 1)]);
+        }
+
+        vertices.assign(order.size(), Vertex());
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const float u = TWO_PI * static_cast<float>(ring) / Rings;
+                const float v = TWO_PI * static_cast<float>(side) / Sides;
+                const Vector3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+                const Vector3 position = Vector3(std::cos(u), std::sin(u), 0.0f) * 3.0f + normal;
+                Vertex& vertex = vertices[order[ring * Sides + side]];
+                vertex = { { position.x, position.y, position.z }, { normal.x, normal.y, normal.z }, 0, 0 };
+            }
+        }
+        for (uint32_t i = 0; i < vertices.size(); i++) {
+            vertices[i].id = i;
+        }
+
+        std::vector<Triangle> triangles;
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const uint32_t a = order[ring * Sides + side];
+                const uint32_t b = order[(ring + 1) % Rings * Sides + side];
+                const uint32_t c = order[(ring + 1) % Rings * Sides + (side + 1) % Sides];
+                const uint32_t d = order[ring * Sides + (side + 1) % Sides];
+                triangles.push_back({ a, b, c });
+                triangles.push_back({ a, c, d });
+            }
+        }
+        for (uint32_t i = static_cast<uint32_t>(triangles.size()) - 1; i > 0; i--) {
+            std::swap(triangles[i], triangles[random.NextIndex(i + 1)]);
+        }
+        indices.clear();
+        for (const Triangle& triangle : triangles) {
+            indices.insert(indices.end(), triangle.begin(), triangle.end());
+        }
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    MakeTorus(vertices, indices);
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    const std::vector<Triangle> source = SortedTriangles(indices);
+
+    // Vertex cache, out of place and in place
+    std::vector<uint32_t> cached(indices.size());
+    OptimizeVertexCache(cached, indices, vertexCount);
+    std::vector<uint32_t> inPlace = indices;
+    OptimizeVertexCache(inPlace, inPlace, vertexCount);
+    const VertexCacheStatistics before = AnalyzeVertexCache(indices, vertexCount);
+    const VertexCacheStatistics after = AnalyzeVertexCache(cached, vertexCount);
+    RLOG_INFO("Vertex cache: ACMR %.3f to %.3f, ATVR %.3f to %.3f", before.acmr, after.acmr, before.atvr, after.atvr);
+    Check(SortedTriangles(cached) == source, "OptimizeVertexCache changed the triangles");
+    Check(inPlace == cached, "OptimizeVertexCache in place differs");
+    Check(after.acmr < 0.8f && after.acmr < before.acmr, "OptimizeVertexCache ACMR");
+
+    // Overdraw, within its ACMR threshold
+    std::vector<uint32_t> overdraw(indices.size());
+    OptimizeOverdraw(overdraw, cached, vertices[0].position, sizeof(Vertex), vertexCount, 1.05f);
+    const VertexCacheStatistics afterOverdraw = AnalyzeVertexCache(overdraw, vertexCount);
+    RLOG_INFO("Overdraw: ACMR %.3f", afterOverdraw.acmr);
+    Check(SortedTriangles(overdraw) == source, "OptimizeOverdraw changed the triangles");
+    Check(afterOverdraw.acmr <= after.acmr * 1.05f, "OptimizeOverdraw ACMR threshold");
+
+    // Vertex fetch remap: first use order, unused vertices dropped
+    std::vector<uint32_t> remapped = cached;
+    std::vector<uint32_t> remap(vertexCount);
+    const uint32_t usedCount = OptimizeVertexFetchRemap(remap, remapped, vertexCount);
+    Check(usedCount == Rings * Sides, "OptimizeVertexFetchRemap used count");
+    uint32_t next = 0;
+    bool firstUseOrder = true;
+    for (size_t i = 0; i < cached.size(); i++) {
+        firstUseOrder &= remapped[i] == remap[cached[i]];
+        if (remapped[i] == next) {
+            next++;
+        } else {
+            firstUseOrder &= remapped[i] < next;
+        }
+    }
+    uint32_t unused = 0;
+    for (const uint32_t index : remap) {
+        unused += index == UINT32_MAX ? 1 : 0;
+    }
+    Check(firstUseOrder && next == usedCount, "OptimizeVertexFetchRemap order");
+    Check(unused == UnusedVertices, "OptimizeVertexFetchRemap unused vertices");
+
+    std::vector<Vertex> fetched(usedCount);
+    RemapVertexBuffer(fetched.data(), vertices.data(), vertexCount, sizeof(Vertex), remap);
+    Check(SortedTriangles(remapped, fetched.data()) == source, "RemapVertexBuffer moved the wrong vertices");
+
+    // Every pass at once, rewriting the vertices in place
+    MeshOptimizeDesc desc;
+    desc.overdraw = true;
+    MeshOptimizeStats stats;
+    std::vector<uint32_t> optimized = indices;
+    std::vector<Vertex> optimizedVertices = vertices;
+    const uint32_t optimizedCount = OptimizeMesh(optimized, optimizedVertices.data(), vertexCount, sizeof(Vertex), desc, &stats);
+    RLOG_INFO("OptimizeMesh: ACMR %.3f to %.3f, overfetch %.3f to %.3f, %u to %u vertices", stats.cacheBefore.acmr,
+              stats.cacheAfter.acmr, stats.fetchBefore.overfetch, stats.fetchAfter.overfetch, stats.vertexCountBefore,
+              stats.vertexCountAfter);
+    Check(optimizedCount == usedCount && stats.vertexCountAfter == usedCount, "OptimizeMesh vertex count");
+    Check(SortedTriangles(optimized, optimizedVertices.data()) == source, "OptimizeMesh changed the triangles");
+    Check(stats.cacheAfter.acmr < stats.cacheBefore.acmr, "OptimizeMesh ACMR");
+    Check(stats.fetchAfter.overfetch < stats.fetchBefore.overfetch, "OptimizeMesh overfetch");
+
+    RLOG_INFO("%u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
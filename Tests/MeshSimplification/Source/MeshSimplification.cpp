@@ -0,0 +1,252 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+using namespace Reality;
+
+// Simplifies a closed torus and an open flat grid, and fails if the result
+// is not a valid triangle list over the source vertices, if the torus stops
+// being closed or has triangles facing inward, if the grid changes its area
+// or loses a locked border vertex, or if the error and count limits are not
+// kept. Also checks that a LOD chain coarsens level by level.
+
+namespace {
+    constexpr uint32_t Rings = 64;
+    constexpr uint32_t Sides = 32;
+    constexpr uint32_t GridSize = 40;           // Quads per side
+
+    struct Vertex {
+        Vector3 position;
+        Vector3 normal;
+    };
+
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        const float* GetPositions() const { return &vertices[0].position.x; }
+        uint32_t GetVertexCount() const { return static_cast<uint32_t>(vertices.size()); }
+    };
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what) {
+        if (!passed) {
+            RLOG_ERROR("%s", what);
+            g_failures++;
+        }
+    }
+
+    Mesh MakeTorus() {
+        Mesh mesh;
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const float u = TWO_PI * static_cast<float>(ring) / Rings;
+                const float v = TWO_PI * static_cast<float>(side) / Sides;
+                const Vector3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+                mesh.vertices.push_back({ Vector3(std::cos(u), std::sin(u), 0.0f) * 3.0f + normal, normal });
+            }
+        }
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const uint32_t a = ring * Sides + side;
+                const uint32_t b = (ring + 1) % Rings * Sides + side;
+                const uint32_t c = (ring + 1) % Rings * Sides + (side + 1) % Sides;
+                const uint32_t d = ring * Sides + (side + 1) % Sides;
+                mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+            }
+        }
+        return mesh;
+    }
+
+    // Unit squares in the z = 0 plane, facing +z
+    Mesh MakeGrid() {
+        Mesh mesh;
+        for (uint32_t y = 0; y <= GridSize; y++) {
+            for (uint32_t x = 0; x <= GridSize; x++) {
+                mesh.vertices.push_back({ Vector3(static_cast<float>(x), static_cast<float>(y), 0.0f), Vector3(0.0f, 0.0f, 1.0f) });
+            }
+        }
+        for (uint32_t y = 0; y < GridSize; y++) {
+            for (uint32_t x = 0; x < GridSize; x++) {
+                const uint32_t a = y * (GridSize + 1) + x;
+                const uint32_t b = a + 1;
+                const uint32_t c = a + GridSize + 2;
+                const uint32_t d = a + GridSize + 1;
+                mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+            }
+        }
+        return mesh;
+    }
+
+    Vector3 TriangleNormal(const Mesh& mesh, std::span<const uint32_t> indices, size_t i) {
+        const Vector3& a = mesh.vertices[indices[i]].position;
+        const Vector3& b = mesh.vertices[indices[i + 1]].position;
+        const Vector3& c = mesh.vertices[indices[i + 2]].position;
+        return (b - a).Cross(c - a);
+    }
+
+    // Indices in range, no triangle using a vertex twice
+    bool IsValidList(const Mesh& mesh, std::span<const uint32_t> indices) {
+        if (indices.size() % 3 != 0) {
+            return false;
+        }
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const uint32_t a = indices[i];
+            const uint32_t b = indices[i + 1];
+            const uint32_t c = indices[i + 2];
+            if (a >= mesh.vertices.size() || b >= mesh.vertices.size() || c >= mesh.vertices.size() ||
+                a == b || b == c || a == c) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every directed edge used once and matched by its reverse
+    bool IsClosed(std::span<const uint32_t> indices) {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (uint32_t e = 0; e < 3; e++) {
+                const uint64_t from = indices[i + e];
+                const uint64_t to = indices[i + (e + 1) % 3];
+                edges[from << 32 | to]++;
+            }
+        }
+        for (const auto& [edge, count] : edges) {
+            const auto reverse = edges.find(edge << 32 | edge >> 32);
+            if (count != 1 || reverse == edges.end() || reverse->second != 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestTorus() {
+        const Mesh torus = MakeTorus();
+        std::vector<uint32_t> result(torus.indices.size());
+
+        SimplifyDesc desc;
+        desc.targetIndexCount = static_cast<uint32_t>(torus.indices.size()) / 4;
+        float error = 0.0f;
+        const uint32_t count = SimplifyMesh(result, torus.indices, torus.GetPositions(), sizeof(Vertex),
+                                            torus.GetVertexCount(), desc, &error);
+        const std::span<const uint32_t> simplified(result.data(), count);
+        RLOG_INFO("Torus to a quarter: %u of %u indices, error %g", count, static_cast<uint32_t>(torus.indices.size()), error);
+        Check(count <= desc.targetIndexCount, "Torus: target index count not reached");
+        Check(IsValidList(torus, simplified), "Torus: invalid triangle list");
+        Check(IsClosed(simplified), "Torus: no longer closed");
+        bool outward = true;
+        for (size_t i = 0; i < count; i += 3) {
+            const Vector3 normal = torus.vertices[simplified[i]].normal + torus.vertices[simplified[i + 1]].normal +
+                                   torus.vertices[simplified[i + 2]].normal;
+            outward &= TriangleNormal(torus, simplified, i).Dot(normal) > 0.0f;
+        }
+        Check(outward, "Torus: flipped triangle");
+
+        // An error budget stops earlier, within the budget
+        desc.targetIndexCount = 0;
+        desc.targetError = error * 0.25f;
+        float budgetError = 0.0f;
+        const uint32_t budgetCount = SimplifyMesh(result, torus.indices, torus.GetPositions(), sizeof(Vertex),
+                                                  torus.GetVertexCount(), desc, &budgetError);
+        RLOG_INFO("Torus within %g: %u indices, error %g", desc.targetError, budgetCount, budgetError);
+        Check(budgetError <= desc.targetError, "Torus: error budget exceeded");
+        Check(budgetCount > count && budgetCount < torus.indices.size(), "Torus: error budget count");
+        Check(IsClosed(std::span<const uint32_t>(result.data(), budgetCount)), "Torus: no longer closed within the budget");
+
+        // In place
+        std::vector<uint32_t> inPlace = torus.indices;
+        desc.targetIndexCount = static_cast<uint32_t>(torus.indices.size()) / 4;
+        desc.targetError = INFINITY;
+        const uint32_t inPlaceCount = SimplifyMesh(inPlace, inPlace, torus.GetPositions(), sizeof(Vertex),
+                                                   torus.GetVertexCount(), desc);
+        SimplifyMesh(result, torus.indices, torus.GetPositions(), sizeof(Vertex), torus.GetVertexCount(), desc);
+        Check(inPlaceCount == count && std::equal(inPlace.begin(), inPlace.begin() + count, result.begin()),
+              "Torus: in place result differs");
+    }
+
+    // A flat grid simplifies at no error. Its area and facing stay, and a
+    // locked border keeps every border vertex.
+    void TestGrid(bool lockBorder) {
+        const Mesh grid = MakeGrid();
+        std::vector<uint32_t> result(grid.indices.size());
+        SimplifyDesc desc;
+        desc.targetError = 1e-4f;
+        desc.lockBorder = lockBorder;
+        const uint32_t count = SimplifyMesh(result, grid.indices, grid.GetPositions(), sizeof(Vertex),
+                                            grid.GetVertexCount(), desc);
+        const std::span<const uint32_t> simplified(result.data(), count);
+
+        double area = 0.0;
+        bool facing = true;
+        std::vector<bool> used(grid.vertices.size(), false);
+        for (size_t i = 0; i < count; i += 3) {
+            const Vector3 normal = TriangleNormal(grid, simplified, i);
+            area += 0.5 * normal.z;
+            facing &= normal.z > 0.0f && normal.x == 0.0f && normal.y == 0.0f;
+            used[simplified[i]] = used[simplified[i + 1]] = used[simplified[i + 2]] = true;
+        }
+        bool bordersKept = true;
+        for (uint32_t y = 0; y <= GridSize; y++) {
+            for (uint32_t x = 0; x <= GridSize; x++) {
+                if (x == 0 || y == 0 || x == GridSize || y == GridSize) {
+                    bordersKept &= used[y * (GridSize + 1) + x];
+                }
+            }
+        }
+
+        RLOG_INFO("Grid, border %s: %u of %u indices, area %g", lockBorder ? "locked" : "free", count,
+                  static_cast<uint32_t>(grid.indices.size()), area);
+        Check(IsValidList(grid, simplified), "Grid: invalid triangle list");
+        Check(count < grid.indices.size() / 4, "Grid: barely simplified");
+        Check(std::fabs(area - GridSize * GridSize) < 1e-3, "Grid: area changed");
+        Check(facing, "Grid: triangle left the plane or flipped");
+        Check(!lockBorder || bordersKept, "Grid: locked border vertex removed");
+    }
+
+    void TestLodChain() {
+        const Mesh torus = MakeTorus();
+        MeshLodSource source;
+        source.indices = torus.indices;
+        source.positions = torus.GetPositions();
+        source.positionStride = sizeof(Vertex);
+        source.vertexCount = torus.GetVertexCount();
+
+        const MeshLodChain chain = GenerateLodChain(source, MeshLodDesc());
+        Check(chain.lods.size() == 4 && chain.lods[0].indices == torus.indices && chain.lods[0].error == 0.0f,
+              "LOD chain: levels");
+        for (size_t i = 1; i < chain.lods.size(); i++) {
+            RLOG_INFO("LOD %zu: %zu indices, error %g", i, chain.lods[i].indices.size(), chain.lods[i].error);
+            Check(chain.lods[i].indices.size() < chain.lods[i - 1].indices.size(), "LOD chain: level does not reduce");
+            Check(chain.lods[i].error >= chain.lods[i - 1].error, "LOD chain: error decreases");
+            Check(IsValidList(torus, chain.lods[i].indices) && IsClosed(chain.lods[i].indices), "LOD chain: invalid level");
+        }
+
+        const float scale = GetLodProjectionScale(1.0f, 1080);
+        uint32_t previous = 0;
+        bool monotonic = true;
+        for (float distance = 0.5f; distance < 10000.0f; distance *= 1.5f) {
+            const uint32_t lod = chain.SelectLod(distance, scale);
+            monotonic &= lod >= previous && lod < chain.lods.size();
+            previous = lod;
+        }
+        Check(monotonic && previous == chain.lods.size() - 1, "LOD chain: SelectLod over distance");
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    TestTorus();
+    TestGrid(true);
+    TestGrid(false);
+    TestLodChain();
+
+    RLOG_INFO("%u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+using namespace Reality;
+
+// Builds meshlets for a torus under several limits, and fails if a meshlet
+// breaks its limits, the meshlets do not cover every triangle exactly once,
+// a bounding sphere misses a vertex, or CullMeshlets culls a meshlet with a
+// triangle that faces a camera inside its frustum.
+
+namespace {
+    constexpr uint32_t Rings = 96;
+    constexpr uint32_t Sides = 48;
+    constexpr uint32_t CameraCount = 64;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    using Triangle = std::array<uint32_t, 3>;
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what, uint32_t value = 0) {
+        if (!passed) {
+            if (g_failures < 20) {
+                RLOG_ERROR("%s (%u)", what, value);
+            }
+            g_failures++;
+        }
+    }
+
+    // Rotated to start at the smallest index, which keeps the winding
+    std::vector<Triangle> SortedTriangles(std::span<const uint32_t> indices) {
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            Triangle triangle = { indices[i], indices[i + 1], indices[i + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void MakeTorus(std::vector<Vector3>& positions, std::vector<uint32_t>& indices) {
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const float u = TWO_PI * static_cast<float>(ring) / Rings;
+                const float v = TWO_PI * static_cast<float>(side) / Sides;
+                const Vector3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+                positions.push_back(Vector3(std::cos(u), std::sin(u), 0.0f) * 3.0f + normal);
+            }
+        }
+        for (uint32_t ring = 0; ring < Rings; ring++) {
+            for (uint32_t side = 0; side < Sides; side++) {
+                const uint32_t a = ring * Sides + side;
+                const uint32_t b = (ring + 1) % Rings * Sides + side;
+                const uint32_t c = (ring + 1) % Rings * Sides + (side + 1) % Sides;
+                const uint32_t d = ring * Sides + (side + 1) % Sides;
+                indices.insert(indices.end(), { a, b, c, a, c, d });
+            }
+        }
+        OptimizeVertexCache(indices, indices, static_cast<uint32_t>(positions.size()));
+    }
+
+    void TestLimits(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices, uint32_t maxVertices,
+                    uint32_t maxTriangles) {
+        MeshletMesh mesh;
+        if (!BuildMeshlets(mesh, indices, &positions[0].x, sizeof(Vector3), static_cast<uint32_t>(positions.size()),
+                           maxVertices, maxTriangles)) {
+            Check(false, "BuildMeshlets failed with limits", maxVertices);
+            return;
+        }
+
+        const uint32_t count = mesh.GetCount();
+        Check(mesh.centers.Size() == count && mesh.radii.size() == count && mesh.coneAxes.Size() == count &&
+              mesh.coneCutoffs.size() == count, "Culling streams do not match the meshlets");
+
+        uint32_t fullCount = 0;
+        for (uint32_t m = 0; m < count; m++) {
+            const Meshlet& meshlet = mesh.meshlets[m];
+            Check(meshlet.vertexCount <= maxVertices && meshlet.triangleCount <= maxTriangles &&
+                  meshlet.triangleCount > 0, "Meshlet limits", m);
+            Check(meshlet.vertexOffset + meshlet.vertexCount <= mesh.vertices.size() &&
+                  (meshlet.triangleOffset + meshlet.triangleCount) * 3 <= mesh.triangles.size(), "Meshlet ranges", m);
+            fullCount += meshlet.vertexCount == maxVertices || meshlet.triangleCount == maxTriangles ? 1 : 0;
+
+            // Local indices stay in the meshlet, every listed vertex is used
+            // and lies in the bounding sphere
+            std::vector<bool> used(meshlet.vertexCount, false);
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++) {
+                const uint8_t local = mesh.triangles[meshlet.triangleOffset * 3 + i];
+                Check(local < meshlet.vertexCount, "Local index out of range", m);
+                if (local < meshlet.vertexCount) {
+                    used[local] = true;
+                }
+            }
+            Check(std::count(used.begin(), used.end(), false) == 0, "Unused meshlet vertex", m);
+            const BoundingSphere sphere(mesh.centers.Get(m), mesh.radii[m]);
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                const Vector3& p = positions[mesh.vertices[meshlet.vertexOffset + i]];
+                Check((p - sphere.center).Length() <= sphere.radius * 1.0001f, "Vertex outside the bounding sphere", m);
+            }
+        }
+
+        std::vector<uint32_t> all(count);
+        for (uint32_t m = 0; m < count; m++) {
+            all[m] = m;
+        }
+        std::vector<uint32_t> written(indices.size());
+        const uint32_t writtenCount = WriteMeshletIndices(mesh, all, written);
+        Check(writtenCount == indices.size() && SortedTriangles(written) == SortedTriangles(indices),
+              "Meshlets do not cover every triangle once", maxVertices);
+
+        // Cameras around and inside the ring, looking at random points of it
+        Random random;
+        std::vector<uint32_t> visible(count);
+        uint32_t culledCount = 0;
+        for (uint32_t camera = 0; camera < CameraCount; camera++) {
+            const Vector3 eye = camera % 4 == 0 ? Vector3(random.Next(), random.Next(), random.Next())
+                                                : Vector3(random.Next(), random.Next(), random.Next() * 0.5f) * 10.0f;
+            const Vector3 target = Vector3(random.Next(), random.Next(), 0.0f) * 3.0f;
+            const Matrix4x4 viewProjection = Matrix4x4::Perspective(1.2f, 16.0f / 9.0f, 0.1f, 50.0f) *
+                                             Matrix4x4::LookAt(eye, target, Vector3(0.0f, 0.0f, 1.0f));
+            const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+
+            const uint32_t visibleCount = CullMeshlets(mesh, frustum, eye, visible);
+            Check(std::is_sorted(visible.begin(), visible.begin() + visibleCount), "CullMeshlets order", camera);
+            std::vector<bool> isVisible(count, false);
+            for (uint32_t i = 0; i < visibleCount; i++) {
+                isVisible[visible[i]] = true;
+            }
+            culledCount += count - visibleCount;
+
+            for (uint32_t m = 0; m < count; m++) {
+                if (isVisible[m]) {
+                    continue;
+                }
+                // Every triangle of a culled meshlet faces away or is out of view
+                const Meshlet& meshlet = mesh.meshlets[m];
+                for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+                    const uint8_t* local = &mesh.triangles[(meshlet.triangleOffset + t) * 3];
+                    const Vector3& p0 = positions[mesh.vertices[meshlet.vertexOffset + local[0]]];
+                    const Vector3& p1 = positions[mesh.vertices[meshlet.vertexOffset + local[1]]];
+                    const Vector3& p2 = positions[mesh.vertices[meshlet.vertexOffset + local[2]]];
+                    const Vector3 normal = (p1 - p0).Cross(p2 - p0).Normalized();
+                    const Vector3 toEye = eye - p0;
+                    const bool facing = normal.Dot(toEye) > 1e-4f * toEye.Length();
+                    const bool inView = frustum.Contains(p0) || frustum.Contains(p1) || frustum.Contains(p2);
+                    Check(!(facing && inView), "Culled a meshlet with a visible triangle", m);
+                }
+            }
+        }
+
+        RLOG_INFO("Limits %u/%u: %u meshlets, %u full, %.1f%% culled on average", maxVertices, maxTriangles, count, fullCount,
+                  100.0f * static_cast<float>(culledCount) / static_cast<float>(count * CameraCount));
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    std::vector<Vector3> positions;
+    std::vector<uint32_t> indices;
+    MakeTorus(positions, indices);
+
+    TestLimits(positions, indices, MeshletMaxVertices, MeshletMaxTriangles);
+    TestLimits(positions, indices, 32, 40);
+    TestLimits(positions, indices, 128, 256);
+    TestLimits(positions, indices, 3, 1);
+
+    MeshletMesh mesh;
+    Check(!BuildMeshlets(mesh, indices, &positions[0].x, sizeof(Vector3), static_cast<uint32_t>(positions.size()), 256, 124),
+          "BuildMeshlets accepted 256 vertices");
+    Check(!BuildMeshlets(mesh, indices, &positions[0].x, sizeof(Vector3), static_cast<uint32_t>(positions.size()), 64, 513),
+          "BuildMeshlets accepted 513 triangles");
+
+    RLOG_INFO("%u failures", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
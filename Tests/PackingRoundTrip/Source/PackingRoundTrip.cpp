@@ -0,0 +1,240 @@
+﻿#include <Reality.h>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+using namespace Reality;
+
+// Round trips every half and normalized code through the scalar and batch
+// conversions of Packing.h, checks that the batch kernels give the scalar
+// bits on random and special inputs, NaN included, and measures the angular
+// error of the octahedral normal encoding.
+
+namespace {
+    constexpr uint32_t Count = 4099;            // Not a multiple of the SIMD width, the tails run too
+    constexpr uint32_t NormalCount = 1 << 18;
+    constexpr double OctahedralTolerance = 7e-5;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    // Inputs every conversion has to handle: signed zeros, half denormals and
+    // the ties between them, the half overflow threshold, out of range
+    // normalized values, infinities and NaN
+    const float Specials[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 2.0f, -2.0f, 1.5f, -1.5f,
+        65504.0f, 65519.0f, 65520.0f, -65520.0f, 1e6f, -1e6f,
+        5.9604645e-8f, 2.9802322e-8f, 8.940697e-8f, 6.1035156e-5f, 6.1032176e-5f, 1e-10f, -1e-10f,
+        0.5f / 255.0f, 1.5f / 255.0f, 0.5f / 127.0f, -0.5f / 127.0f, 0.5f / 65535.0f, 0.5f / 32767.0f,
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max(),
+    };
+
+    // Interleaved like a vertex, so the kernels write with a stride
+    struct Vertex {
+        uint8_t unorm8[4];
+        int8_t snorm8[4];
+        uint16_t half4[4];
+        uint16_t half2[2];
+        uint16_t unorm16[2];
+        int16_t snorm16[2];
+        int16_t octahedral[2];
+        uint32_t padding;
+    };
+
+    uint32_t g_failures = 0;
+
+    void Check(bool passed, const char* what, uint32_t index) {
+        if (!passed) {
+            if (g_failures < 20) {
+                RLOG_ERROR("%s, element %u", what, index);
+            }
+            g_failures++;
+        }
+    }
+
+    bool SameBits(float a, float b) {
+        return std::isnan(a) ? std::isnan(b) : memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    // Every code unpacks and packs back to itself, apart from the SNORM
+    // minimum that decodes to -1
+    void TestCodes() {
+        for (uint32_t bits = 0; bits < 0x10000u; bits++) {
+            const uint16_t half = static_cast<uint16_t>(bits);
+            const float value = HalfToFloat(half);
+            const bool nan = (half & 0x7C00u) == 0x7C00u && (half & 0x03FFu) != 0;
+            Check(nan ? std::isnan(value) && std::isnan(HalfToFloat(FloatToHalf(value)))
+                      : FloatToHalf(value) == half, "Half round trip", bits);
+
+            const int16_t snorm16 = static_cast<int16_t>(half);
+            Check(PackUnorm16(UnpackUnorm16(half)) == half, "Unorm16 round trip", bits);
+            Check(PackSnorm16(UnpackSnorm16(snorm16)) == (snorm16 == -32768 ? -32767 : snorm16), "Snorm16 round trip", bits);
+        }
+        for (uint32_t bits = 0; bits < 0x100u; bits++) {
+            const uint8_t unorm8 = static_cast<uint8_t>(bits);
+            const int8_t snorm8 = static_cast<int8_t>(bits);
+            Check(PackUnorm8(UnpackUnorm8(unorm8)) == unorm8, "Unorm8 round trip", bits);
+            Check(PackSnorm8(UnpackSnorm8(snorm8)) == (snorm8 == -128 ? -127 : snorm8), "Snorm8 round trip", bits);
+        }
+
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        Check(PackUnorm8(nan) == 0 && PackSnorm8(nan) == 0 && PackUnorm16(nan) == 0 && PackSnorm16(nan) == 0,
+              "NaN packs to 0", 0);
+    }
+
+    // The batch kernels against the scalar conversions, element by element
+    void TestKernels() {
+        Random random;
+        std::vector<Vector2> values2(Count);
+        std::vector<Vector4> values4(Count);
+        for (uint32_t i = 0; i < Count; i++) {
+            float v[6];
+            for (float& component : v) {
+                // Mostly in range, some far outside, some specials
+                const uint32_t kind = static_cast<uint32_t>(Abs(random.Next()) * 8.0f);
+                component = kind == 0 ? Specials[static_cast<uint32_t>(Abs(random.Next()) * std::size(Specials)) % std::size(Specials)]
+                          : kind == 1 ? random.Next() * 70000.0f
+                          : random.Next() * 1.25f;
+            }
+            values2[i] = Vector2(v[0], v[1]);
+            values4[i] = Vector4(v[2], v[3], v[4], v[5]);
+        }
+
+        std::vector<Vertex> vertices(Count);
+        const size_t stride = sizeof(Vertex);
+        PackUnorm8(values4, vertices[0].unorm8, stride);
+        PackSnorm8(values4, vertices[0].snorm8, stride);
+        PackHalf(values4, vertices[0].half4, stride);
+        PackHalf(values2, vertices[0].half2, stride);
+        PackUnorm16(values2, vertices[0].unorm16, stride);
+        PackSnorm16(values2, vertices[0].snorm16, stride);
+
+        for (uint32_t i = 0; i < Count; i++) {
+            const Vertex& vertex = vertices[i];
+            const float* v4 = &values4[i].x;
+            const float* v2 = &values2[i].x;
+            for (uint32_t c = 0; c < 4; c++) {
+                Check(vertex.unorm8[c] == PackUnorm8(v4[c]), "PackUnorm8", i);
+                Check(vertex.snorm8[c] == PackSnorm8(v4[c]), "PackSnorm8", i);
+                Check(vertex.half4[c] == FloatToHalf(v4[c]), "PackHalf Vector4", i);
+            }
+            for (uint32_t c = 0; c < 2; c++) {
+                Check(vertex.half2[c] == FloatToHalf(v2[c]), "PackHalf Vector2", i);
+                Check(vertex.unorm16[c] == PackUnorm16(v2[c]), "PackUnorm16", i);
+                Check(vertex.snorm16[c] == PackSnorm16(v2[c]), "PackSnorm16", i);
+            }
+        }
+
+        std::vector<Vector2> decoded2(Count);
+        std::vector<Vector4> decoded4(Count);
+        const auto checkDecoded4 = [&](const char* what, auto unpack, const auto* field) {
+            const uint8_t* base = reinterpret_cast<const uint8_t*>(field);
+            for (uint32_t i = 0; i < Count; i++) {
+                const auto* codes = reinterpret_cast<decltype(field)>(base + i * stride);
+                const float* d = &decoded4[i].x;
+                for (uint32_t c = 0; c < 4; c++) {
+                    Check(SameBits(d[c], unpack(codes[c])), what, i);
+                }
+            }
+        };
+        const auto checkDecoded2 = [&](const char* what, auto unpack, const auto* field) {
+            const uint8_t* base = reinterpret_cast<const uint8_t*>(field);
+            for (uint32_t i = 0; i < Count; i++) {
+                const auto* codes = reinterpret_cast<decltype(field)>(base + i * stride);
+                const float* d = &decoded2[i].x;
+                for (uint32_t c = 0; c < 2; c++) {
+                    Check(SameBits(d[c], unpack(codes[c])), what, i);
+                }
+            }
+        };
+
+        UnpackUnorm8(vertices[0].unorm8, stride, decoded4);
+        checkDecoded4("UnpackUnorm8", [](uint8_t code) { return UnpackUnorm8(code); }, vertices[0].unorm8);
+        UnpackSnorm8(vertices[0].snorm8, stride, decoded4);
+        checkDecoded4("UnpackSnorm8", [](int8_t code) { return UnpackSnorm8(code); }, vertices[0].snorm8);
+        UnpackHalf(vertices[0].half4, stride, decoded4);
+        checkDecoded4("UnpackHalf Vector4", [](uint16_t code) { return HalfToFloat(code); }, vertices[0].half4);
+        UnpackHalf(vertices[0].half2, stride, decoded2);
+        checkDecoded2("UnpackHalf Vector2", [](uint16_t code) { return HalfToFloat(code); }, vertices[0].half2);
+        UnpackUnorm16(vertices[0].unorm16, stride, decoded2);
+        checkDecoded2("UnpackUnorm16", [](uint16_t code) { return UnpackUnorm16(code); }, vertices[0].unorm16);
+        UnpackSnorm16(vertices[0].snorm16, stride, decoded2);
+        checkDecoded2("UnpackSnorm16", [](int16_t code) { return UnpackSnorm16(code); }, vertices[0].snorm16);
+    }
+
+    // Angle between two directions, accurate for small angles
+    double Angle(const Vector3& a, const Vector3& b) {
+        const double cx = static_cast<double>(a.y) * b.z - static_cast<double>(a.z) * b.y;
+        const double cy = static_cast<double>(a.z) * b.x - static_cast<double>(a.x) * b.z;
+        const double cz = static_cast<double>(a.x) * b.y - static_cast<double>(a.y) * b.x;
+        const double dot = static_cast<double>(a.x) * b.x + static_cast<double>(a.y) * b.y + static_cast<double>(a.z) * b.z;
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+    }
+
+    // Unit normals, the axes and the octahedron edges first, through the
+    // scalar encoding and through the batch kernels
+    void TestOctahedral() {
+        Random random;
+        Vector3Stream normals(NormalCount);
+        const Vector3 fixed[] = {
+            Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0), Vector3(0, 0, 1), Vector3(0, 0, -1),
+            Vector3(1, 1, 0).Normalized(), Vector3(-1, 1, 0).Normalized(), Vector3(1, -1, 0).Normalized(),
+            Vector3(-1, -1, 0).Normalized(), Vector3(1, 1, -1).Normalized(), Vector3(-1, -1, -1).Normalized(),
+        };
+        for (uint32_t i = 0; i < NormalCount; i++) {
+            Vector3 normal;
+            if (i < std::size(fixed)) {
+                normal = fixed[i];
+            } else {
+                do {
+                    normal = Vector3(random.Next(), random.Next(), random.Next());
+                } while (normal.LengthSquared() < 1e-4f || normal.LengthSquared() > 1.0f);
+                normal = normal.Normalized();
+            }
+            normals.Set(i, normal);
+        }
+
+        std::vector<Vertex> vertices(NormalCount);
+        PackOctahedral(normals.AsSpan(), vertices[0].octahedral, sizeof(Vertex));
+        Vector3Stream decoded(NormalCount);
+        UnpackOctahedral(vertices[0].octahedral, sizeof(Vertex), decoded.AsSpan());
+
+        double worstScalar = 0.0;
+        double worstBatch = 0.0;
+        for (uint32_t i = 0; i < NormalCount; i++) {
+            const Vector3 normal = normals.Get(i);
+            const Vector2 encoded = EncodeOctahedral(normal);
+            const Vector2 quantized(UnpackSnorm16(PackSnorm16(encoded.x)), UnpackSnorm16(PackSnorm16(encoded.y)));
+            worstScalar = std::fmax(worstScalar, Angle(normal, DecodeOctahedral(quantized)));
+            worstBatch = std::fmax(worstBatch, Angle(normal, decoded.Get(i)));
+        }
+        RLOG_INFO("Octahedral: worst angle %.2e scalar, %.2e batch, tolerance %.0e", worstScalar, worstBatch,
+                  OctahedralTolerance);
+        Check(worstScalar <= OctahedralTolerance, "Octahedral scalar tolerance", 0);
+        Check(worstBatch <= OctahedralTolerance, "Octahedral batch tolerance", 0);
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    TestCodes();
+    TestKernels();
+    TestOctahedral();
+
+    RLOG_INFO("%s: %u failures", SIMD::GetInstructionSetName(), g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+using namespace Reality;
+
+// Inserts, moves and removes random objects in a LooseOctree and a
+// SpatialHashGrid, and fails if a sphere, box or nearest query differs from
+// testing every live object, or if the containers are not released once
+// every object is removed.
+
+namespace {
+    constexpr uint32_t ObjectCount = 5000;
+    constexpr uint32_t RoundCount = 4;
+    constexpr uint32_t QueryCount = 300;
+    constexpr float WorldSize = 100.0f;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+        uint32_t NextIndex(uint32_t count) {
+            return static_cast<uint32_t>(Abs(Next()) * static_cast<float>(count)) % count;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    uint32_t g_failures = 0;
+
+    void Fail(const char* index, const char* what, uint32_t query) {
+        if (g_failures < 20) {
+            RLOG_ERROR("%s: %s, query %u", index, what, query);
+        }
+        g_failures++;
+    }
+
+    // Mostly small objects, some larger than a grid cell or an octree cell,
+    // and a few outside the octree's world bounds
+    AABB RandomBox(Random& random) {
+        const float roll = Abs(random.Next());
+        const float size = roll < 0.02f ? 25.0f : 2.0f;
+        const float spread = roll > 0.98f ? WorldSize * 1.5f : WorldSize;
+        const Vector3 center(random.Next() * spread, random.Next() * spread, random.Next() * spread);
+        const Vector3 extents(Abs(random.Next()) * size, Abs(random.Next()) * size, Abs(random.Next()) * size);
+        return AABB::FromCenterExtents(center, extents);
+    }
+
+    float DistanceSquared(const AABB& box, const Vector3& point) {
+        const Vector3 closest = Vector3::Min(Vector3::Max(point, box.min), box.max);
+        return (closest - point).LengthSquared();
+    }
+
+    // The objects the index should hold
+    struct Reference {
+        std::vector<AABB> bounds;
+        std::vector<bool> alive;
+
+        void Set(SpatialHandle handle, const AABB& box) {
+            if (handle >= bounds.size()) {
+                bounds.resize(handle + 1);
+                alive.resize(handle + 1, false);
+            }
+            bounds[handle] = box;
+            alive[handle] = true;
+        }
+
+        template<typename Test>
+        std::vector<SpatialHandle> Query(const Test& test) const {
+            std::vector<SpatialHandle> results;
+            for (SpatialHandle handle = 0; handle < bounds.size(); handle++) {
+                if (alive[handle] && test(bounds[handle])) {
+                    results.push_back(handle);
+                }
+            }
+            return results;
+        }
+
+        uint32_t GetCount() const { return static_cast<uint32_t>(std::count(alive.begin(), alive.end(), true)); }
+    };
+
+    // Ties in distance may be ordered either way, so the distances are compared
+    bool SameNearest(const std::vector<SpatialHandle>& results, const Reference& reference, const Vector3& point,
+                     uint32_t k, float maxDistance) {
+        std::vector<float> expected;
+        for (SpatialHandle handle = 0; handle < reference.bounds.size(); handle++) {
+            const float distanceSquared = DistanceSquared(reference.bounds[handle], point);
+            if (reference.alive[handle] && distanceSquared <= maxDistance * maxDistance) {
+                expected.push_back(distanceSquared);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.resize(std::min<size_t>(expected.size(), k));
+
+        if (results.size() != expected.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            if (results[i] >= reference.bounds.size() || !reference.alive[results[i]] ||
+                DistanceSquared(reference.bounds[results[i]], point) != expected[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestQueries(const char* name, const SpatialIndex& index, const Reference& reference, Random& random) {
+        if (index.GetCount() != reference.GetCount()) {
+            Fail(name, "GetCount", 0);
+        }
+        for (SpatialHandle handle = 0; handle < reference.bounds.size(); handle++) {
+            if (index.IsValid(handle) != reference.alive[handle] ||
+                (reference.alive[handle] && !(index.GetBounds(handle).min == reference.bounds[handle].min &&
+                                              index.GetBounds(handle).max == reference.bounds[handle].max))) {
+                Fail(name, "IsValid and GetBounds", handle);
+            }
+        }
+
+        std::vector<SpatialHandle> results;
+        for (uint32_t i = 0; i < QueryCount; i++) {
+            const AABB box = RandomBox(random);
+            results.clear();
+            index.QueryAABB(box, results);
+            std::sort(results.begin(), results.end());
+            if (results != reference.Query([&box](const AABB& bounds) { return box.Intersects(bounds); })) {
+                Fail(name, "QueryAABB", i);
+            }
+
+            const BoundingSphere sphere(box.Center(), Abs(random.Next()) * 15.0f);
+            results.clear();
+            index.QuerySphere(sphere, results);
+            std::sort(results.begin(), results.end());
+            if (results != reference.Query([&sphere](const AABB& bounds) { return sphere.Intersects(bounds); })) {
+                Fail(name, "QuerySphere", i);
+            }
+
+            const uint32_t k = 1 + random.NextIndex(16);
+            const float maxDistance = i % 2 == 0 ? INFINITY : Abs(random.Next()) * 20.0f;
+            index.QueryNearest(sphere.center, k, results, maxDistance);
+            if (!SameNearest(results, reference, sphere.center, k, maxDistance)) {
+                Fail(name, "QueryNearest", i);
+            }
+        }
+    }
+
+    void Run(const char* name, SpatialIndex& index) {
+        const uint32_t failures = g_failures;
+        Random random;
+        Reference reference;
+        std::vector<SpatialHandle> handles;
+        for (uint32_t i = 0; i < ObjectCount; i++) {
+            const AABB box = RandomBox(random);
+            handles.push_back(index.Insert(box));
+            reference.Set(handles.back(), box);
+        }
+        TestQueries(name, index, reference, random);
+
+        // Moves of all sizes, removals, and inserts that reuse the freed handles
+        for (uint32_t round = 0; round < RoundCount; round++) {
+            for (uint32_t i = 0; i < ObjectCount / 4; i++) {
+                const uint32_t slot = random.NextIndex(static_cast<uint32_t>(handles.size()));
+                const SpatialHandle handle = handles[slot];
+                const float roll = Abs(random.Next());
+                if (roll < 0.6f) {
+                    const AABB& current = reference.bounds[handle];
+                    const AABB box = roll < 0.5f ? AABB::FromCenterExtents(current.Center() + Vector3(random.Next(), random.Next(), random.Next()),
+                                                                           current.Extents())
+                                                 : RandomBox(random);
+                    index.Move(handle, box);
+                    reference.Set(handle, box);
+                } else if (roll < 0.8f) {
+                    index.Remove(handle);
+                    reference.alive[handle] = false;
+                    handles[slot] = handles.back();
+                    handles.pop_back();
+                } else {
+                    const AABB box = RandomBox(random);
+                    handles.push_back(index.Insert(box));
+                    reference.Set(handles.back(), box);
+                }
+            }
+            TestQueries(name, index, reference, random);
+        }
+
+        for (const SpatialHandle handle : handles) {
+            index.Remove(handle);
+            reference.alive[handle] = false;
+        }
+        TestQueries(name, index, reference, random);
+        RLOG_INFO("%s: %u queries, %u mismatches", name, QueryCount * (RoundCount + 2) * 3, g_failures - failures);
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    LooseOctree octree;
+    if (!octree.Initialize(AABB(Vector3(-WorldSize), Vector3(WorldSize)), 6)) {
+        RLOG_ERROR("LooseOctree::Initialize failed");
+        return 1;
+    }
+    Run("LooseOctree", octree);
+    if (octree.GetNodeCount() != 1) {
+        Fail("LooseOctree", "Nodes left after removing every object", octree.GetNodeCount());
+    }
+
+    SpatialHashGrid grid;
+    if (!grid.Initialize(8.0f)) {
+        RLOG_ERROR("SpatialHashGrid::Initialize failed");
+        return 1;
+    }
+    Run("SpatialHashGrid", grid);
+    if (grid.GetCellCount() != 0) {
+        Fail("SpatialHashGrid", "Cells left after removing every object", grid.GetCellCount());
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+﻿#include <Reality.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+using namespace Reality;
+
+// Moves, creates, destroys and reparents random nodes of a TransformHierarchy
+// and fails if a world matrix after Update differs from evaluating the
+// parent chain recursively, or if Update recomputed other nodes than the
+// changed ones and their descendants.
+
+namespace {
+    constexpr uint32_t NodeCount = 20000;
+    constexpr uint32_t ChainLength = 40;
+    constexpr uint32_t RoundCount = 12;
+    constexpr uint32_t GrainSize = 64;          // Small, so the wide levels run on the workers
+    constexpr TransformHandle None = InvalidTransformHandle;
+
+    // Same inputs on every run
+    class Random {
+    public:
+        float Next() {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return static_cast<float>(static_cast<int32_t>(m_state >> 32)) / 2147483648.0f;
+        }
+
+        uint32_t NextIndex(uint32_t count) {
+            return static_cast<uint32_t>(Abs(Next()) * static_cast<float>(count)) % count;
+        }
+
+    private:
+        uint64_t m_state = 0x9E3779B97F4A7C15ull;
+    };
+
+    Transform RandomTransform(Random& random) {
+        return Transform(Vector3(random.Next(), random.Next(), random.Next()) * 10.0f,
+                         Quaternion::FromEulerAngles(random.Next() * PI, random.Next() * PI, random.Next() * PI),
+                         Vector3(1.0f + random.Next() * 0.5f, 1.0f + random.Next() * 0.5f, 1.0f + random.Next() * 0.5f));
+    }
+
+    // What the hierarchy should hold, per handle
+    struct Reference {
+        std::vector<Transform> locals;
+        std::vector<TransformHandle> parents;
+        std::vector<bool> alive;
+        std::vector<bool> changed;
+
+        void Set(TransformHandle handle, const Transform& local, TransformHandle parent) {
+            if (handle >= locals.size()) {
+                locals.resize(handle + 1);
+                parents.resize(handle + 1, None);
+                alive.resize(handle + 1, false);
+                changed.resize(handle + 1, false);
+            }
+            locals[handle] = local;
+            parents[handle] = parent;
+            alive[handle] = true;
+            changed[handle] = true;
+        }
+
+        bool IsAncestor(TransformHandle ancestor, TransformHandle handle) const {
+            for (TransformHandle current = handle; current != None; current = parents[current]) {
+                if (current == ancestor) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Same arithmetic as Update, parent world times local matrix
+        const Matrix4x4& World(TransformHandle handle, std::vector<Matrix4x4>& worlds, std::vector<bool>& done) const {
+            if (!done[handle]) {
+                const Matrix4x4 local = locals[handle].ToMatrix4x4();
+                worlds[handle] = parents[handle] == None ? local : World(parents[handle], worlds, done) * local;
+                done[handle] = true;
+            }
+            return worlds[handle];
+        }
+
+        uint32_t Depth(TransformHandle handle) const {
+            uint32_t depth = 0;
+            for (TransformHandle current = parents[handle]; current != None; current = parents[current]) {
+                depth++;
+            }
+            return depth;
+        }
+    };
+
+    uint32_t g_failures = 0;
+
+    void Fail(const char* what, uint32_t round, uint32_t value) {
+        if (g_failures < 20) {
+            RLOG_ERROR("Round %u: %s (%u)", round, what, value);
+        }
+        g_failures++;
+    }
+
+    void Check(const TransformHierarchy& hierarchy, Reference& reference, uint32_t round) {
+        const size_t size = reference.locals.size();
+        std::vector<Matrix4x4> worlds(size);
+        std::vector<bool> done(size, false);
+        uint32_t count = 0;
+        uint32_t expectedUpdated = 0;
+        uint32_t levelCount = 0;
+        for (TransformHandle handle = 0; handle < size; handle++) {
+            if (hierarchy.IsValid(handle) != reference.alive[handle]) {
+                Fail("IsValid", round, handle);
+            }
+            if (!reference.alive[handle]) {
+                continue;
+            }
+            count++;
+            levelCount = Max(levelCount, reference.Depth(handle) + 1);
+            for (TransformHandle current = handle; current != None; current = reference.parents[current]) {
+                if (reference.changed[current]) {
+                    expectedUpdated++;
+                    break;
+                }
+            }
+
+            const Matrix4x4& expected = reference.World(handle, worlds, done);
+            if (memcmp(&hierarchy.GetWorld(handle), &expected, sizeof(Matrix4x4)) != 0) {
+                Fail("World matrix", round, handle);
+            }
+            if (hierarchy.GetParent(handle) != reference.parents[handle]) {
+                Fail("GetParent", round, handle);
+            }
+        }
+
+        if (hierarchy.GetCount() != count) {
+            Fail("GetCount", round, hierarchy.GetCount());
+        }
+        if (hierarchy.GetUpdatedCount() != expectedUpdated) {
+            Fail("GetUpdatedCount", round, hierarchy.GetUpdatedCount());
+        }
+        if (hierarchy.GetLevelCount() != levelCount) {
+            Fail("GetLevelCount", round, hierarchy.GetLevelCount());
+        }
+        std::fill(reference.changed.begin(), reference.changed.end(), false);
+    }
+
+    // Handles of live nodes
+    std::vector<TransformHandle> Alive(const Reference& reference) {
+        std::vector<TransformHandle> handles;
+        for (TransformHandle handle = 0; handle < reference.alive.size(); handle++) {
+            if (reference.alive[handle]) {
+                handles.push_back(handle);
+            }
+        }
+        return handles;
+    }
+}
+
+int main() {
+    Log& log = Log::GetInstance();
+    log.SetRateLimit(0, 0);
+    log.EnableColors(false);
+
+    Random random;
+    TransformHierarchy hierarchy;
+    Reference reference;
+
+    // A wide forest, parents created before their children, and one deep chain
+    for (uint32_t i = 0; i < NodeCount; i++) {
+        const TransformHandle parent = i == 0 || Abs(random.Next()) < 0.02f ? None : random.NextIndex(i);
+        const Transform local = RandomTransform(random);
+        reference.Set(hierarchy.Create(local, parent), local, parent);
+    }
+    TransformHandle chain = None;
+    for (uint32_t i = 0; i < ChainLength; i++) {
+        const Transform local = RandomTransform(random);
+        const TransformHandle handle = hierarchy.Create(local, chain);
+        reference.Set(handle, local, chain);
+        chain = handle;
+    }
+    hierarchy.Update(GrainSize);
+    Check(hierarchy, reference, 0);
+
+    for (uint32_t round = 1; round <= RoundCount; round++) {
+        std::vector<TransformHandle> handles = Alive(reference);
+        const auto pick = [&]() { return handles[random.NextIndex(static_cast<uint32_t>(handles.size()))]; };
+
+        // Local changes through every setter; every third round also
+        // changes the structure
+        const uint32_t moveCount = round % 4 == 0 ? static_cast<uint32_t>(handles.size()) / 2 : 100;
+        for (uint32_t i = 0; i < moveCount; i++) {
+            const TransformHandle handle = pick();
+            Transform local = reference.locals[handle];
+            const Transform target = RandomTransform(random);
+            switch (random.NextIndex(4)) {
+                case 0: local.translation = target.translation; hierarchy.SetTranslation(handle, local.translation); break;
+                case 1: local.rotation = target.rotation; hierarchy.SetRotation(handle, local.rotation); break;
+                case 2: local.scale = target.scale; hierarchy.SetScale(handle, local.scale); break;
+                default: local = target; hierarchy.SetLocal(handle, local); break;
+            }
+            reference.Set(handle, local, reference.parents[handle]);
+        }
+
+        if (round % 3 == 0) {
+            for (uint32_t i = 0; i < 50; i++) {
+                const TransformHandle handle = pick();
+                const TransformHandle parent = Abs(random.Next()) < 0.1f ? None : pick();
+                if (parent != None && reference.IsAncestor(handle, parent)) {
+                    continue;
+                }
+                hierarchy.SetParent(handle, parent);
+                reference.Set(handle, reference.locals[handle], parent);
+            }
+            for (uint32_t i = 0; i < 20; i++) {
+                const TransformHandle handle = pick();
+                if (!reference.alive[handle]) {
+                    continue;
+                }
+                hierarchy.Destroy(handle);
+                for (TransformHandle other = 0; other < reference.alive.size(); other++) {
+                    if (reference.alive[other] && reference.IsAncestor(handle, other)) {
+                        reference.alive[other] = false;
+                    }
+                }
+            }
+            handles = Alive(reference);
+            for (uint32_t i = 0; i < 200; i++) {
+                const TransformHandle parent = Abs(random.Next()) < 0.1f ? None : pick();
+                const Transform local = RandomTransform(random);
+                reference.Set(hierarchy.Create(local, parent), local, parent);
+            }
+        }
+
+        hierarchy.Update(GrainSize);
+        Check(hierarchy, reference, round);
+    }
+
+    // Nothing changed, nothing recomputed
+    hierarchy.Update(GrainSize);
+    Check(hierarchy, reference, RoundCount + 1);
+
+    RLOG_INFO("%u nodes over %u levels after %u rounds, %u mismatches", hierarchy.GetCount(), hierarchy.GetLevelCount(),
+              RoundCount, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+﻿#include <Reality.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+using namespace Reality;
+
+// Formats a binary log written with LogAsyncDesc::binaryFile into the same
+// text lines the console and file sinks print, or with --json into the
+// lines of LogAsyncDesc::jsonFile. It must run on a machine with the byte
+// order of the one that wrote the log.
+
+namespace {
+    class FileReader {
+    public:
+        FileReader(const std::vector<uint8_t>& data) : m_data(data) {}
+
+        template<typename T>
+        bool Read(T& value) {
+            if (m_data.size() - m_offset < sizeof(T)) {
+                return false;
+            }
+            memcpy(&value, m_data.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return true;
+        }
+
+        const uint8_t* ReadBytes(uint32_t size) {
+            if (m_data.size() - m_offset < size) {
+                return nullptr;
+            }
+            const uint8_t* bytes = m_data.data() + m_offset;
+            m_offset += size;
+            return bytes;
+        }
+
+        [[nodiscard]] bool IsAtEnd() const { return m_offset == m_data.size(); }
+
+    private:
+        const std::vector<uint8_t>& m_data;
+        size_t m_offset = 0;
+    };
+}
+
+int main(int argc, char** argv) {
+    // Usage: LogDecoder [--json] <binary log> [output.log]
+    const bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    if (json) {
+        argc--;
+        argv++;
+    }
+    if (argc < 2) {
+        RLOG_ERROR("Usage: LogDecoder [--json] <binary log> [output.log]");
+        return -1;
+    }
+
+    std::ifstream input(argv[1], std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        RLOG_ERROR("Failed to open %s", argv[1]);
+        return -1;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    FILE* output = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!output) {
+        RLOG_ERROR("Failed to write %s", argv[2]);
+        return -1;
+    }
+
+    FileReader reader(data);
+    const uint8_t* magic = reader.ReadBytes(sizeof(LogFileMagic));
+    if (!magic || memcmp(magic, LogFileMagic, sizeof(LogFileMagic)) != 0) {
+        RLOG_ERROR("%s is not a binary log", argv[1]);
+        return -1;
+    }
+
+    std::unordered_map<uint64_t, std::string> formats;
+    char text[Log::MessageCapacity];
+    char fieldsText[Log::MessageCapacity];
+    uint64_t messageCount = 0;
+    bool truncated = false;
+    while (!reader.IsAtEnd()) {
+        uint8_t kind;
+        reader.Read(kind);
+
+        if (kind == static_cast<uint8_t>(LogFileRecord::Format)) {
+            uint64_t id;
+            uint32_t length;
+            const uint8_t* text = nullptr;
+            if (!reader.Read(id) || !reader.Read(length) || !(text = reader.ReadBytes(length))) {
+                truncated = true;
+                break;
+            }
+            formats[id].assign(reinterpret_cast<const char*>(text), length);
+            continue;
+        }
+
+        int64_t nanoseconds;
+        uint8_t level;
+        uint64_t frame;
+        uint32_t thread;
+        uint64_t formatId;
+        uint32_t size;
+        uint32_t fieldOffset;
+        const uint8_t* payload = nullptr;
+        if (kind != static_cast<uint8_t>(LogFileRecord::Message) || !reader.Read(nanoseconds) || !reader.Read(level) ||
+            !reader.Read(frame) || !reader.Read(thread) || !reader.Read(formatId) || !reader.Read(size) ||
+            !reader.Read(fieldOffset) || !(payload = reader.ReadBytes(size))) {
+            // A crash can leave the last record half written
+            truncated = true;
+            break;
+        }
+
+        fieldOffset = std::min(fieldOffset, size);
+        std::string_view message(reinterpret_cast<const char*>(payload), fieldOffset);
+        if (formatId != 0) {
+            const auto format = formats.find(formatId);
+            if (format != formats.end()) {
+                message = std::string_view(text, FormatLogArguments(text, sizeof(text), format->second, payload, fieldOffset));
+            } else {
+                message = "<unknown format>";
+            }
+        }
+
+        const std::chrono::system_clock::time_point time{
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds))};
+        const uint8_t* fields = payload + fieldOffset;
+        const uint32_t fieldsSize = size - fieldOffset;
+        std::string_view line;
+        if (json) {
+            line = Log::FormatJsonLine(time, static_cast<LogLevel>(level), frame, thread, message, fields, fieldsSize);
+        } else {
+            if (fieldsSize != 0) {
+                const size_t length = std::min(message.size(), sizeof(fieldsText) - 1);
+                memcpy(fieldsText, message.data(), length);
+                message = std::string_view(fieldsText, length + FormatLogFields(fieldsText + length, static_cast<uint32_t>(sizeof(fieldsText) - length),
+                                                                                fields, fieldsSize, LogFieldStyle::Text));
+            }
+            line = Log::FormatLine(time, static_cast<LogLevel>(level), message);
+        }
+        fwrite(line.data(), 1, line.size(), output);
+        fputc('\n', output);
+        messageCount++;
+    }
+
+    if (output != stdout) {
+        fclose(output);
+    }
+    if (truncated) {
+        RLOG_WARNING("%s ends with an incomplete record, decoded %llu messages", argv[1],
+                     static_cast<unsigned long long>(messageCount));
+    }
+    return 0;
+}